@@ -0,0 +1,104 @@
+/**
+ * @file admit.h
+ * @author Nathan Lemma
+ * @brief Admission control for background jobs in the YASH shell
+ * @date 10-17-2026
+ * @details This header file contains the admission controller on the background launch path.
+ * While CPU pressure, memory pressure or the load average is at or above its threshold
+ * (`set -o admitcpu=PCT`, `admitmem=PCT`, `admitload=LOAD`), a new background job is not
+ * launched but added to the job table as Pending, and it is started once pressure has dropped.
+ * Pressure comes from /proc/pressure/cpu, /proc/pressure/memory and /proc/loadavg on Linux;
+ * elsewhere it reads as none, so nothing is ever held.
+ */
+
+#pragma once
+
+// ============================================================================
+// Includes
+// ============================================================================
+
+#include "yash.h"
+
+// ============================================================================
+// Data Structures
+// ============================================================================
+
+/**
+ * @brief One reading of the pressure figures
+ */
+typedef struct Pressure {
+   double cpu;    ///< % of the last 10 s in which some task waited for a CPU (PSI some avg10)
+   double memory; ///< % of the last 10 s in which some task stalled on memory (PSI some avg10)
+   double load;   ///< 1-minute load average
+} Pressure;
+
+// ============================================================================
+// Public Functions
+// ============================================================================
+
+/**
+ * @brief Read the current pressure figures; any that cannot be read are 0
+ * @param p
+ */
+void admit_sample(Pressure* p);
+
+/**
+ * @brief Whether a background job may start now
+ * @return 1 when no threshold is reached (or none is set), 0 otherwise
+ */
+int admit_ok(void);
+
+/**
+ * @brief Hold a background command that is about to be launched, if pressure is too high
+ *
+ * A held command becomes a Pending job; its line is parsed again from @p cmdline when it is
+ * started. Launches made by admit_start() and admit_launch() are never held.
+ *
+ * @param cmdline The whole line, as typed
+ * @return 1 if it was held (nothing must be launched), 0 to launch it now
+ */
+int admit_hold(const char* cmdline);
+
+/**
+ * @brief Start the oldest held job if pressure allows
+ *
+ * Pressure figures are averages that trail what has just been started, so at most one held job
+ * is let through per check.
+ *
+ * @return CLOCK_MONOTONIC seconds of the next check, 0 when nothing is waiting for one
+ */
+double admit_release(void);
+
+/**
+ * @brief Start a held job now, whatever the pressure
+ * @param job_id
+ * @return 0 if it started, -1 if it is not held or could not be started (it is then done)
+ */
+int admit_start(int job_id);
+
+/**
+ * @brief Drop a held job without starting it
+ * @param job_id
+ * @param exit_code Status it is reported with
+ * @return 0 on success, -1 if it is not held
+ */
+int admit_cancel(int job_id, int exit_code);
+
+/**
+ * @brief Run a line that has already been admitted by its caller (the batch queue)
+ * @param line
+ * @return As execute_line()
+ */
+int admit_launch(Line* line);
+
+/**
+ * @brief Held job that the background launch in progress starts
+ * @return Its job id, 0 when the launch is not for a held job
+ */
+int admit_releasing(void);
+
+/**
+ * @brief Number of jobs being held
+ * @return int
+ */
+int admit_held(void);
@@ -0,0 +1,70 @@
+/**
+ * @file arena.h
+ * @author Nathan Lemma
+ * @brief Bump allocator for per-line parser data in the YASH shell
+ * @date 10-17-2026
+ * @details This header file contains the arena that a parsed Line allocates its token list,
+ * argv vectors, stages and copy of the command line from. Allocation is a pointer bump; nothing
+ * is freed on its own. arena_reset() takes everything back at once for the next line.
+ */
+
+#pragma once
+
+// ============================================================================
+// Includes
+// ============================================================================
+
+#include <stddef.h>
+
+// ============================================================================
+// Data Structures
+// ============================================================================
+
+/** @brief One chunk of arena memory (defined in arena.c) */
+typedef struct ArenaBlock ArenaBlock;
+
+/**
+ * @brief A bump allocator; all zeros is a valid empty arena
+ */
+typedef struct Arena {
+   ArenaBlock* head; ///< Block allocations come from (the newest), NULL before the first one
+   size_t total;     ///< Bytes of all blocks together
+} Arena;
+
+// ============================================================================
+// Public Functions
+// ============================================================================
+
+/**
+ * @brief Allocate from an arena
+ * @param arena
+ * @param size
+ * @return Memory aligned for any object type, valid until the next arena_reset() or arena_free();
+ *         NULL if out of memory
+ */
+void* arena_alloc(Arena* arena, size_t size);
+
+/**
+ * @brief Copy the first @p len bytes of a string into an arena
+ * @param arena
+ * @param s
+ * @param len
+ * @return NUL-terminated copy, NULL if out of memory
+ */
+char* arena_strndup(Arena* arena, const char* s, size_t len);
+
+/**
+ * @brief Take back everything allocated, keeping the memory for reuse
+ *
+ * A line that needed more than one block leaves one block of the combined size behind, so the
+ * next line of that size is served without calling malloc().
+ *
+ * @param arena
+ */
+void arena_reset(Arena* arena);
+
+/**
+ * @brief Release all of an arena's memory; it is empty (and usable) afterwards
+ * @param arena
+ */
+void arena_free(Arena* arena);
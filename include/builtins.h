@@ -0,0 +1,107 @@
+/**
+ * @file builtins.h
+ * @author Nathan Lemma
+ * @brief Builtins that run inside the shell process for the YASH shell
+ * @date 10-17-2026
+ * @details This header file contains the builtin registry and the builtins that do their work in
+ * the shell itself instead of paying for a fork and exec.
+ */
+
+#pragma once
+
+// ============================================================================
+// Includes
+// ============================================================================
+
+#include "launch.h"
+#include "yash.h"
+
+// ============================================================================
+// Constants
+// ============================================================================
+
+/** @brief log2 of the number of slots in the builtin hash table */
+#define BUILTIN_SLOT_BITS 6
+
+/** @brief Number of slots in the builtin hash table */
+#define BUILTIN_SLOTS (1u << BUILTIN_SLOT_BITS)
+
+// ============================================================================
+// Data Structures
+// ============================================================================
+
+/**
+ * @brief Builtin entry point
+ *
+ * Runs with stdin, stdout and stderr already pointing at the command's redirections.
+ *
+ * @param argv NULL-terminated arguments, argv[0] is the builtin's name
+ * @return Exit status
+ */
+typedef int (*BuiltinFn)(char* const argv[]);
+
+/**
+ * @brief One registered builtin
+ */
+typedef struct Builtin {
+   const char* name; ///< Command name
+   BuiltinFn run;    ///< Implementation
+} Builtin;
+
+// ============================================================================
+// Public Functions
+// ============================================================================
+
+/**
+ * @brief Look up a builtin by name
+ *
+ * The table is laid out at compile time so that every builtin sits in its own hash slot; a
+ * lookup is one hash and at most one strcmp.
+ *
+ * @param name Command name (argv[0])
+ * @return The builtin, or NULL if @p name is not one
+ */
+const Builtin* builtin_find(const char* name);
+
+/**
+ * @brief Hash slot of a name in the builtin table
+ *
+ * @param name
+ * @return Slot in [0, BUILTIN_SLOTS)
+ */
+unsigned builtin_slot(const char* name);
+
+/**
+ * @brief Entry stored in a table slot
+ *
+ * @param slot Slot in [0, BUILTIN_SLOTS)
+ * @return The builtin in that slot, or NULL if the slot is empty
+ */
+const Builtin* builtin_at(unsigned slot);
+
+/**
+ * @brief Whether `cat` can run inside the shell for this command
+ *
+ * Only the plain form qualifies: no options, a foreground command, and input that comes from file
+ * operands or a `<` redirection rather than from the shell's own stdin. Anything else runs the
+ * external cat.
+ *
+ * @param cmd
+ * @return 1 if builtin_cat() should be used, 0 otherwise
+ */
+int builtin_cat_eligible(const Command* cmd);
+
+/**
+ * @brief Concatenate files to stdout without leaving the shell
+ *
+ * Bytes are moved with fd_copy(), so regular files and pipes never pass through user space. A
+ * reader that goes away ends the copy quietly and Ctrl-C stops it between chunks. Ctrl-Z stops
+ * it too: with @p rest the remainder goes to a stopped child (in the foreground group if there is
+ * one), so `fg` resumes the copy where the shell left off.
+ *
+ * @param argv `cat` followed by the files to copy (stdin when there are none)
+ * @param fds Descriptors standing in for stdin, stdout and stderr (-1 for the shell's own)
+ * @param rest Set to the stopped child finishing the copy after Ctrl-Z (may be NULL)
+ * @return 0 on success, 1 if any file failed, 128 + SIGINT if Ctrl-C stopped the copy
+ */
+int builtin_cat(char* const argv[], const Redirects* fds, pid_t* rest);
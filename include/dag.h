@@ -0,0 +1,130 @@
+/**
+ * @file dag.h
+ * @author Nathan Lemma
+ * @brief Dependency-graph task runner for the YASH shell
+ * @date 10-17-2026
+ * @details This header file contains the runner behind the `dag` builtin. A task file names
+ * tasks, the tasks each one depends on and the command line it runs, in a make-like layout:
+ *
+ *     # comment
+ *     link: compile assets
+ *         cc -o app main.o
+ *     compile:
+ *         cc -c main.c
+ *     assets:
+ *         cp -r static out
+ *     all: link
+ *
+ * A header line is `NAME: [DEP...]`; the indented line after it is the task's command, parsed
+ * with parse_line(), so pipelines, redirections and the `timeout`/`class` prefixes work. A task
+ * without a command only groups its dependencies. Tasks start as background jobs as soon as all
+ * of their dependencies have succeeded, at most N at a time.
+ */
+
+#pragma once
+
+// ============================================================================
+// Includes
+// ============================================================================
+
+#include "yash.h"
+
+// ============================================================================
+// Enums
+// ============================================================================
+
+/**
+ * @brief Where a task is in its life
+ */
+typedef enum {
+   DAG_WAITING,   ///< A dependency has not finished yet (or it is ready but has no slot)
+   DAG_RUNNING,   ///< Started as a background job
+   DAG_DONE,      ///< Exited with status 0
+   DAG_FAILED,    ///< Exited with another status, or could not be started
+   DAG_CANCELLED, ///< Not run: a dependency failed, or the run was interrupted
+} DagState;
+
+// ============================================================================
+// Data Structures
+// ============================================================================
+
+/**
+ * @brief One task of a graph
+ */
+typedef struct DagTask {
+   char* name;      ///< Task name (heap allocated)
+   char* cmdline;   ///< Command line, NULL for a task that only groups (heap allocated)
+   int* deps;       ///< Indexes of the tasks it depends on
+   int num_deps;    ///< Entries in deps
+   int unfinished;  ///< Dependencies that have not succeeded yet
+   DagState state;  ///< Waiting, running, done, failed or cancelled
+   int job_id;      ///< Its job while running
+   int exit_code;   ///< Exit status once finished, 127 if it could not be started
+   double started;  ///< CLOCK_MONOTONIC seconds at launch
+   double finished; ///< CLOCK_MONOTONIC seconds when its job was reaped
+   double path;     ///< Wall seconds of the longest chain of tasks that ends with this one
+   int path_prev;   ///< Dependency before it on that chain, -1 at the start of the chain
+} DagTask;
+
+/**
+ * @brief A task graph and the state of its run
+ */
+typedef struct Dag {
+   DagTask* tasks;  ///< Tasks in file order
+   int num_tasks;   ///< Entries in tasks
+   int* users;      ///< Indexes of dependent tasks, grouped by the task they depend on
+   int* users_at;   ///< num_tasks + 1 offsets into users; task i owns [users_at[i], users_at[i+1])
+   int* ready;      ///< FIFO of tasks whose dependencies have all succeeded
+   int ready_head;  ///< Next entry of ready to start
+   int ready_tail;  ///< Entries pushed onto ready
+   int* running;    ///< Tasks started and not yet finished
+   int num_running; ///< Entries in running
+   int counts[5];   ///< Tasks per DagState
+} Dag;
+
+// ============================================================================
+// Public Functions
+// ============================================================================
+
+/**
+ * @brief Read a task file and check it: unique names, known dependencies, no cycle, and commands
+ * that parse
+ *
+ * @param path
+ * @param dag Filled in; released with dag_free()
+ * @return 0 on success, -1 (with a message on stderr) otherwise
+ */
+int dag_load(const char* path, Dag* dag);
+
+/**
+ * @brief Run every task whose dependencies succeed, at most @p max at a time
+ *
+ * A task that fails cancels the tasks that depend on it, directly or not; the others still run.
+ * Ctrl-C sends SIGINT to the running tasks and starts no more.
+ *
+ * @param dag
+ * @param max
+ * @return 0 when every task succeeded, 1 when one failed or was cancelled, 130 when interrupted
+ */
+int dag_run(Dag* dag, int max);
+
+/**
+ * @brief Print each task's state and wall time, and the critical path, to stderr
+ * @param dag
+ * @param seconds Wall time of the whole run
+ */
+void dag_report(const Dag* dag, double seconds);
+
+/**
+ * @brief Release a graph
+ * @param dag
+ */
+void dag_free(Dag* dag);
+
+/**
+ * @brief `dag [-j N] FILE`: run a task file with at most N tasks at a time (default: CPU count)
+ * @param argv
+ * @return 0 on success, 1 if a task failed or was cancelled, 2 on usage or file errors, 130 if
+ *         interrupted
+ */
+int builtin_dag(char* const argv[]);
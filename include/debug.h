@@ -50,7 +50,7 @@
       DEBUG_PARSE("│  Output file: %s", (cmd)->out_file ? (cmd)->out_file : "stdout");             \
       DEBUG_PARSE("│  Error file: %s", (cmd)->err_file ? (cmd)->err_file : "stderr");              \
       fprintf(stderr, "[PARSE] │  Arguments: ");                                                   \
-      for (int i = 0; i < MAX_ARGS && (cmd)->argv[i]; i++) {                                       \
+      for (int i = 0; (cmd)->argv[i]; i++) {                                                       \
          fprintf(stderr, "\"%s\" ", (cmd)->argv[i]);                                               \
       }                                                                                            \
       fprintf(stderr, "\n");                                                                       \
@@ -0,0 +1,99 @@
+/**
+ * @file events.h
+ * @author Nathan Lemma
+ * @brief Event loop sources for the YASH shell
+ * @date 10-17-2026
+ * @details This header file contains the event sources the shell waits on between commands:
+ * input on the terminal, child state changes and a timer for job budgets. All are file
+ * descriptors, so one wait covers them and a background job finishing (or running out of time)
+ * is seen while the shell sits at the prompt.
+ */
+
+#pragma once
+
+// ============================================================================
+// Includes
+// ============================================================================
+
+#include <sys/types.h>
+
+// ============================================================================
+// Enums
+// ============================================================================
+
+/**
+ * @brief Sources reported ready by events_wait()
+ */
+typedef enum {
+   EVENT_INPUT = 1 << 0, ///< The input descriptor is readable (or at EOF)
+   EVENT_CHILD = 1 << 1, ///< At least one child changed state since the last wait
+   EVENT_TIMER = 1 << 2, ///< The deadline set with events_set_timer() has passed
+} EventKind;
+
+// ============================================================================
+// Public Functions
+// ============================================================================
+
+/**
+ * @brief Set up the event sources
+ *
+ * On Linux SIGCHLD is blocked and read from a signalfd, and both descriptors are watched with
+ * epoll. Elsewhere (or if signalfd fails) the SIGCHLD handler writes to a self-pipe that is
+ * watched with poll. Safe to call again; the previous sources are closed.
+ *
+ * @param input_fd Descriptor commands are read from
+ * @return 0 on success, -1 on failure
+ */
+int events_init(int input_fd);
+
+/**
+ * @brief Wait for input or a child state change
+ *
+ * Pending child notifications are consumed, so the caller must reap every changed child (see
+ * jobs_collect()) when EVENT_CHILD is returned. Interrupted waits are retried.
+ *
+ * @param timeout_ms Longest wait in milliseconds, -1 to wait forever, 0 to only check
+ * @return EventKind bits that are ready (0 on timeout), -1 on failure
+ */
+int events_wait(int timeout_ms);
+
+/**
+ * @brief Wait for a child state change or the timer, ignoring input (foreground jobs)
+ *
+ * Like events_wait(), but the wait is capped at a short tick so a missed notification only
+ * delays the caller's next look. A child event seen here is reported again by the next
+ * events_wait(), since the caller only reaps its own processes.
+ *
+ * @param timeout_ms Longest wait in milliseconds, -1 for the tick
+ * @return EventKind bits that are ready (0 on timeout), -1 on failure
+ */
+int events_wait_child(int timeout_ms);
+
+/**
+ * @brief Arm the one-shot timer reported as EVENT_TIMER
+ *
+ * On Linux this is a timerfd in the same epoll set as the input; elsewhere the waits are cut
+ * short at the deadline. Either way EVENT_TIMER is reported once and the timer is then disarmed.
+ *
+ * @param deadline CLOCK_MONOTONIC seconds, 0 to disarm
+ */
+void events_set_timer(double deadline);
+
+/**
+ * @brief Wait until one of some child processes exits, without reaping it
+ *
+ * On Linux each process gets a pidfd, so only these processes end the wait. Without pidfd_open
+ * (or when it fails) any child state change ends it, or a short tick at the latest, and the caller
+ * checks again. Either way the exit status is left for jobs_collect() to reap.
+ *
+ * @param pids
+ * @param n
+ * @param timeout_ms Longest wait in milliseconds, -1 to wait forever
+ * @return 1 when one of them may have exited, 0 on timeout, -1 on failure (EINTR on a signal)
+ */
+int events_wait_pids(const pid_t* pids, int n, int timeout_ms);
+
+/**
+ * @brief Wake events_wait() with EVENT_CHILD (the self-pipe end of the SIGCHLD handler)
+ */
+void events_notify_child(void);
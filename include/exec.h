@@ -14,13 +14,52 @@
 
 #include "yash.h"
 
+// ============================================================================
+// Enums
+// ============================================================================
+
+/**
+ * @brief Where execution goes after the command that just ran
+ */
+typedef enum {
+   FLOW_NEXT,     ///< On to the next command
+   FLOW_BREAK,    ///< Out of the enclosing loop (`break`)
+   FLOW_CONTINUE, ///< To the next iteration of the enclosing loop (`continue`)
+   FLOW_RETURN,   ///< Out of the running function (`return`)
+} Flow;
+
 // ============================================================================
 // Public Functions
 // ============================================================================
 
 /**
  * @brief Execute a line of input
+ *
+ * The elements of a command list run one after another. An element after `&&` runs only if `$?`
+ * is 0 and one after `||` only if it is not; an element that does not run leaves `$?` as it was.
+ * A command killed by Ctrl-C stops the rest of the list. Compound commands run in the shell,
+ * walking the lists they were parsed into.
+ *
  * @param line
  * @return int
  */
 int execute_line(Line* line);
+
+/**
+ * @brief Run a function body with @p argv as its positional parameters
+ *
+ * @param body
+ * @param argv argv[0] is the function's name
+ * @return Exit status of the body, or the one given to `return`
+ */
+int exec_function(const Line* body, char* const argv[]);
+
+/**
+ * @brief Leave the enclosing loops or function once the running builtin returns
+ *
+ * @param flow FLOW_BREAK, FLOW_CONTINUE or FLOW_RETURN
+ * @param levels Loops to leave (break) or skip to the end of (continue); capped at the number
+ *        running
+ * @return 0 on success, -1 if there is no loop (or function, for FLOW_RETURN) to leave
+ */
+int exec_jump(Flow flow, int levels);
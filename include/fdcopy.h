@@ -0,0 +1,51 @@
+/**
+ * @file fdcopy.h
+ * @author Nathan Lemma
+ * @brief Zero-copy descriptor to descriptor transfer for the YASH shell
+ * @date 10-17-2026
+ * @details This header file contains the copy engine behind the in-process `cat` builtin. It
+ * moves bytes between two descriptors inside the kernel whenever the descriptor types allow it.
+ */
+
+#pragma once
+
+// ============================================================================
+// Includes
+// ============================================================================
+
+#include <signal.h>
+
+// ============================================================================
+// Enums
+// ============================================================================
+
+/**
+ * @brief How fd_copy() moved the data
+ */
+typedef enum {
+   FDCOPY_NONE,            ///< Nothing copied yet
+   FDCOPY_COPY_FILE_RANGE, ///< copy_file_range (file to file)
+   FDCOPY_SPLICE,          ///< splice (either end is a pipe)
+   FDCOPY_SENDFILE,        ///< sendfile (file to anything else)
+   FDCOPY_READ_WRITE,      ///< Plain read/write through a user-space buffer
+} FdCopyMethod;
+
+// ============================================================================
+// Public Functions
+// ============================================================================
+
+/**
+ * @brief Copy everything from @p in_fd to @p out_fd until end of file
+ *
+ * Uses copy_file_range for file to file, splice when either end is a pipe and sendfile from a
+ * regular file to anything else, dropping to read/write only when the kernel refuses the faster
+ * call. Both descriptors' file offsets advance as with read/write.
+ *
+ * @param in_fd Source descriptor
+ * @param out_fd Destination descriptor
+ * @param cancel Checked between chunks and on every interrupted wait; the copy stops with EINTR
+ * when it becomes non-zero (may be NULL)
+ * @param method Set to the method that moved the last chunk (may be NULL)
+ * @return Bytes copied, or -1 on error with errno set
+ */
+long long fd_copy(int in_fd, int out_fd, volatile sig_atomic_t* cancel, FdCopyMethod* method);
@@ -0,0 +1,60 @@
+/**
+ * @file funcs.h
+ * @author Nathan Lemma
+ * @brief Shell functions for the YASH shell
+ * @date 10-17-2026
+ * @details This header file contains the table of functions defined with `NAME() { ... }` or
+ * `function NAME { ... }`. A function is parsed once, when it is defined; every call runs the
+ * parsed body.
+ */
+
+#pragma once
+
+// ============================================================================
+// Includes
+// ============================================================================
+
+#include "builtins.h"
+
+// ============================================================================
+// Public Functions
+// ============================================================================
+
+/**
+ * @brief Define a function, replacing any function of that name
+ *
+ * A function replaced while it runs finishes with its old body.
+ *
+ * @param name
+ * @param text The whole definition as typed, e.g. "f() { echo hi ; }"
+ * @return 0 on success, -1 if out of memory or @p text is not a definition
+ */
+int funcs_define(const char* name, const char* text);
+
+/**
+ * @brief Remove a function (`unset -f`)
+ * @param name
+ * @return 0 if it was defined, -1 otherwise
+ */
+int funcs_unset(const char* name);
+
+/**
+ * @brief Count of changes to the function table
+ *
+ * Bumped by every definition and removal, so anything derived from the set of functions can
+ * tell when it is out of date.
+ *
+ * @return unsigned long
+ */
+unsigned long funcs_generation(void);
+
+/**
+ * @brief Command entry for a function, run like a builtin
+ *
+ * Functions are looked up before builtins, so a function may wrap a builtin of the same name.
+ *
+ * @param name Command name (argv[0])
+ * @return A Builtin whose run() calls the function with its argv as the positional parameters,
+ *         NULL if no function has that name
+ */
+const Builtin* funcs_builtin(const char* name);
@@ -12,50 +12,189 @@
 // Includes
 // ============================================================================
 
+#include "rclass.h"
 #include "yash.h"
+#include <sys/resource.h>
 
 // ============================================================================
 // Enums
 // ============================================================================
 
 /**
- * @brief Represents the status of a job
+ * @brief Represents the status of a job (JOB_PENDING: held by admission control, not started)
  */
-typedef enum { JOB_RUNNING, JOB_STOPPED, JOB_DONE } JobStatus;
+typedef enum { JOB_RUNNING, JOB_STOPPED, JOB_DONE, JOB_PENDING } JobStatus;
+
+/**
+ * @brief Limit of a `timeout` budget that a job ran past
+ */
+typedef enum { BUDGET_OK, BUDGET_WALL, BUDGET_CPU } BudgetOverrun;
 
 // ============================================================================
 // Data Structures
 // ============================================================================
 
+/**
+ * @brief Resources used by a job, summed over every process that has exited so far
+ */
+typedef struct JobUsage {
+   double user;    ///< User CPU seconds
+   double sys;     ///< System CPU seconds
+   long max_rss;   ///< Largest resident set of any single process, in KB
+   long nvcsw;     ///< Voluntary context switches
+   long nivcsw;    ///< Involuntary context switches
+   double started; ///< CLOCK_MONOTONIC seconds when the job started, 0 if unknown
+} JobUsage;
+
+/**
+ * @brief A `timeout` budget and how far its enforcement has got
+ */
+typedef struct JobBudget {
+   Budget limit;          ///< Limits, all 0 for none
+   double started;        ///< CLOCK_MONOTONIC seconds the wall-clock limit counts from
+   double kill_at;        ///< When SIGKILL follows the SIGTERM, 0 when none is pending
+   BudgetOverrun overrun; ///< Limit that was exceeded, BUDGET_OK while within both
+} JobBudget;
+
+/**
+ * @brief One process of a job (a pipeline stage)
+ */
+typedef struct JobProc {
+   pid_t pid;                ///< Process ID
+   JobStatus status;         ///< JOB_RUNNING or JOB_STOPPED, JOB_DONE once reaped
+   struct Job* job;          ///< Job the process belongs to
+   struct JobProc* pid_next; ///< Next process in the same pid bucket
+} JobProc;
+
 /**
  * @brief Represents a job
+ *
+ * Jobs live on a list ordered by id and are indexed by pgid and by id; every unreaped process
+ * is indexed by pid. The links are owned by jobs.c.
  */
 typedef struct Job {
-   int id;                    ///< Job ID number
-   pid_t pgid;                ///< Process group ID
-   char cmdline[MAX_CMDLINE]; ///< Command line string
-   JobStatus status;          ///< Current job status
-   int is_background;         ///< Background flag: 0 = fg/stopped-in-fg; 1 = running in bg or bg'ed
+   int id;                        ///< Job ID number
+   pid_t pgid;                    ///< Process group ID
+   char* cmdline;                 ///< Command line string (heap allocated)
+   JobStatus status;              ///< Current job status
+   int is_background;             ///< Background flag: 0 = fg/stopped-in-fg; 1 = running in bg or
+                                  ///< bg'ed
+   JobUsage usage;                ///< Accounting for the stages that have been reaped
+   char rclass[RCLASS_LABEL_MAX]; ///< Resource class it runs under, empty for none
+   JobBudget budget;              ///< `timeout` budget (limits all 0 for none)
+   double held_since;             ///< CLOCK_MONOTONIC seconds it was held at, 0 if never held
+   double held;                   ///< Seconds it was held before it started
+   JobProc* procs;                ///< Member processes (heap allocated)
+   int num_procs;                 ///< Entries in procs
+   int num_stages;                ///< procs[0, num_stages) were started by the shell, the rest
+                                  ///< are orphans adopted in subreaper mode
+   int live;                      ///< Member processes not reaped yet
+   int exit_code;                 ///< Exit status of the last stage (128 + signal if killed,
+                                  ///< 124 if killed for overrunning its budget)
+   struct Job* prev;              ///< Previous job by id
+   struct Job* next;              ///< Next job by id
+   struct Job* pgid_next;         ///< Next job in the same pgid bucket
+   struct Job* id_next;           ///< Next job in the same id bucket
 } Job;
 
+/**
+ * @brief Called when a job's last process has been reaped
+ * @param pgid Process group of the job
+ * @param exit_code Exit status of the job, as in Job.exit_code
+ */
+typedef void (*JobDoneHook)(pid_t pgid, int exit_code);
+
 // ============================================================================
 // Public Functions
 // ============================================================================
 
 /**
- * @brief Initialize the job table
+ * @brief Initialize the job table, releasing any jobs it still holds
  *
  */
 void jobs_init(void);
 
 /**
  * @brief Add a job to the job table
+ *
+ * The table grows as needed. The new job's id is one more than the highest id still in the
+ * table, so ids only reuse numbers once every job above them is gone (as in bash).
+ *
  * @param pgid
+ * @param pids Processes of the job that have not exited (may be NULL when @p num_pids is 0)
+ * @param num_pids
  * @param cmdline
  * @param is_background
- * @return int
+ * @return The job id, or -1 if out of memory
+ */
+int jobs_add(pid_t pgid, const pid_t* pids, int num_pids, const char* cmdline, int is_background);
+
+/**
+ * @brief Add a background job that admission control holds back; it has no processes yet
+ * @param cmdline
+ * @return The job id, or -1 if out of memory
+ */
+int jobs_add_held(const char* cmdline);
+
+/**
+ * @brief Give a held job the processes it was started with
+ * @param job_id
+ * @param pgid
+ * @param pids
+ * @param num_pids
+ * @return 0 on success, -1 if the job is not held or out of memory
+ */
+int jobs_start_held(int job_id, pid_t pgid, const pid_t* pids, int num_pids);
+
+/**
+ * @brief Finish a held job without starting it
+ * @param job_id
+ * @param exit_code Status it is reported with
+ */
+void jobs_drop_held(int job_id, int exit_code);
+
+/**
+ * @brief Seconds a job has been (or was) held by admission control
+ * @param job_id
+ * @return double 0 for a job that was never held
+ */
+double jobs_held_seconds(int job_id);
+
+/**
+ * @brief Apply one wait status to the job owning @p pid
+ *
+ * A job stops when every live process has stopped, runs again when any continues and is done
+ * when its last process has been reaped. Processes that belong to no job are ignored.
+ *
+ * @param pid Process the status is for
+ * @param status Status from jobs_wait()
+ * @param usage Usage of the process if it exited (may be NULL)
+ */
+void jobs_process_event(pid_t pid, int status, const JobUsage* usage);
+
+/**
+ * @brief Reap every child that has changed state, without blocking, and update the jobs
  */
-int jobs_add(pid_t pgid, const char* cmdline, int is_background);
+void jobs_collect(void);
+
+/**
+ * @brief Adopt orphaned descendants of jobs that the kernel reparented to the shell
+ *
+ * Only meaningful in subreaper mode. Each child of the shell that no job owns is added to the
+ * job whose process group it is in (a finished job that has not been reported comes back to
+ * life), or becomes a job of its own if it left the group (a daemon calling setsid()).
+ * jobs_collect() calls this after reaping.
+ *
+ * @return Number of processes adopted
+ */
+int jobs_adopt_orphans(void);
+
+/**
+ * @brief Status of a job
+ * @param job_id
+ * @return JobStatus, JOB_DONE if there is no such job
+ */
+JobStatus jobs_get_status(int job_id);
 
 /**
  * @brief Mark a job as running or stopped
@@ -69,6 +208,96 @@ void jobs_mark(pid_t pgid, JobStatus status);
  */
 void jobs_print();
 
+/**
+ * @brief Print all jobs with their process group and resource usage (`jobs -l`)
+ */
+void jobs_print_long(void);
+
+/**
+ * @brief Add the usage of reaped processes to a job
+ *
+ * CPU time and context switches are summed, max RSS keeps the largest and the earlier start time
+ * wins.
+ *
+ * @param pgid
+ * @param usage
+ */
+void jobs_add_usage(pid_t pgid, const JobUsage* usage);
+
+/**
+ * @brief Record the resource class a job was started under, for `jobs -l`
+ * @param pgid
+ * @param label Class spec as typed (see ResourceClass.label)
+ */
+void jobs_set_rclass(pid_t pgid, const char* label);
+
+/**
+ * @brief Give a job the budget it was started under
+ * @param pgid
+ * @param budget
+ */
+void jobs_set_budget(pid_t pgid, const JobBudget* budget);
+
+/**
+ * @brief Start a budget's wall clock now
+ * @param budget
+ * @param limit Limits from the `timeout` prefix
+ */
+void jobs_budget_start(JobBudget* budget, const Budget* limit);
+
+/**
+ * @brief Enforce a budget: SIGTERM once a limit is exceeded, SIGKILL after the grace period
+ *
+ * Signals go to the process group and to each process (adopted ones may be in another group);
+ * a stopped job is continued so that it sees them. CPU time of live processes is read from /proc
+ * on Linux; elsewhere only exited processes count.
+ *
+ * @param budget
+ * @param pgid
+ * @param pids Processes that have not exited (entries <= 0 are skipped)
+ * @param n
+ * @param cpu_used CPU seconds of the job's processes that have exited
+ * @return CLOCK_MONOTONIC seconds when the budget must be checked again, 0 for never
+ */
+double jobs_budget_check(JobBudget* budget, pid_t pgid, const pid_t* pids, int n, double cpu_used);
+
+/**
+ * @brief Enforce the budget of every job in the table
+ * @return CLOCK_MONOTONIC seconds of the next check, 0 when no job has a budget left to enforce
+ */
+double jobs_enforce_budgets(void);
+
+/**
+ * @brief Start a usage record now
+ * @param usage
+ */
+void jobs_usage_start(JobUsage* usage);
+
+/**
+ * @brief Merge @p src into @p dst (same rules as jobs_add_usage())
+ * @param dst
+ * @param src
+ */
+void jobs_usage_merge(JobUsage* dst, const JobUsage* src);
+
+/**
+ * @brief Seconds since a usage record started
+ * @param usage
+ * @return double
+ */
+double jobs_usage_elapsed(const JobUsage* usage);
+
+/**
+ * @brief Wait for a child with wait4() and account for it if it has exited
+ *
+ * @param pid As for waitpid()
+ * @param status As for waitpid()
+ * @param options As for waitpid()
+ * @param usage Receives the child's rusage when it exited or was killed (may be NULL)
+ * @return pid_t As for waitpid()
+ */
+pid_t jobs_wait(pid_t pid, int* status, int options, JobUsage* usage);
+
 /**
  * @brief Pick the most recent job for foreground
  * @return int
@@ -93,6 +322,36 @@ pid_t jobs_get_pgid(int job_id);
  */
 void jobs_reap_done_and_print(void);
 
+/**
+ * @brief Drop a finished job without a Done notice (it has been waited for)
+ * @param job_id
+ * @return The job's exit status, or -1 if it is still running or stopped
+ */
+int jobs_reap_job(int job_id);
+
+/**
+ * @brief Pids of a job's processes that have not been reaped
+ * @param job_id
+ * @param pids Filled with up to @p max pids
+ * @param max
+ * @return Number of such processes (may exceed @p max), -1 if there is no such job
+ */
+int jobs_live_pids(int job_id, pid_t* pids, int max);
+
+/**
+ * @brief Ids of the background jobs, in id order
+ * @param ids Filled with up to @p max ids
+ * @param max
+ * @return Number of ids stored
+ */
+int jobs_background_ids(int* ids, int max);
+
+/**
+ * @brief Whether any job has finished and not been reaped yet
+ * @return 1 if jobs_reap_done_and_print() has work to do, 0 otherwise
+ */
+int jobs_has_done(void);
+
 /**
  * @brief Print a single job
  * @param job_id
@@ -106,6 +365,31 @@ void jobs_print_one(int job_id);
  */
 const char* jobs_get_cmdline(int job_id);
 
+/**
+ * @brief Number of jobs in the table, including finished ones not yet reported
+ * @return int
+ */
+int jobs_count(void);
+
+/**
+ * @brief Process group of the job most recently added to run in the background (what `$!` names)
+ * @return pid_t 0 if there has been none
+ */
+pid_t jobs_last_background(void);
+
+/**
+ * @brief Job that a process group belongs to, preferring an unfinished one
+ * @param pgid
+ * @return Job id, -1 if no job has that group
+ */
+int jobs_find_pgid(pid_t pgid);
+
+/**
+ * @brief Have @p hook called each time a job finishes (one hook at a time; NULL removes it)
+ * @param hook
+ */
+void jobs_set_done_hook(JobDoneHook hook);
+
 /**
  * @brief Set the background of a job
  * @param pgid
@@ -0,0 +1,75 @@
+/**
+ * @file launch.h
+ * @author Nathan Lemma
+ * @brief Process launch backends for the YASH shell
+ * @date 10-17-2026
+ * @details This header file contains the functions that turn a Command into a running child
+ * process, either through posix_spawn or through fork + exec.
+ */
+
+#pragma once
+
+// ============================================================================
+// Includes
+// ============================================================================
+
+#include "rclass.h"
+#include "yash.h"
+
+// ============================================================================
+// Data Structures
+// ============================================================================
+
+/**
+ * @brief Descriptors a child gets as its stdin, stdout and stderr
+ *
+ * The shell opens every redirection target itself (close-on-exec) before launching, so an open
+ * error is seen before anything is started and each file is opened exactly once.
+ */
+typedef struct Redirects {
+   int in_fd;  ///< New stdin (`<` target or pipe read end), -1 to inherit
+   int out_fd; ///< New stdout (`>` target or pipe write end), -1 to inherit
+   int err_fd; ///< New stderr (`2>` target), -1 to inherit
+} Redirects;
+
+// ============================================================================
+// Public Functions
+// ============================================================================
+
+/**
+ * @brief Open the `<`, `>` and `2>` targets of a command
+ *
+ * Every descriptor is opened close-on-exec. On failure the ones already opened are closed again.
+ *
+ * @param cmd Command whose redirections to open
+ * @param fds Filled with the opened descriptors, -1 where the command has no redirection
+ * @param failed Set to the file that could not be opened (may be NULL)
+ * @return 0 on success, -1 on failure with errno set
+ */
+int redirects_open(const Command* cmd, Redirects* fds, const char** failed);
+
+/**
+ * @brief Close every descriptor in @p fds and reset it to -1
+ *
+ * @param fds
+ */
+void redirects_close(Redirects* fds);
+
+/**
+ * @brief Launch a command as a child process using the configured backend
+ *
+ * The child joins process group @p pgid (or leads a new one when @p pgid is 0), gets default
+ * dispositions for SIGINT, SIGTSTP and SIGPIPE, and has @p fds moved onto its standard
+ * descriptors before exec. A resource class is applied after that, still before exec; if it
+ * cannot be applied the child exits with status 126 instead of running the command.
+ *
+ * @param cmd Command to run
+ * @param pgid Process group to join, 0 to create a new group
+ * @param fds Descriptors for stdin, stdout and stderr (NULL to inherit all three)
+ * @param rc Resource class for the child (NULL for none); forces the fork backend
+ * @return Child pid, or -1 on failure with errno set
+ */
+pid_t launch_command(const Command* cmd,
+                     pid_t pgid,
+                     const Redirects* fds,
+                     const ResourceClass* rc);
@@ -0,0 +1,75 @@
+/**
+ * @file lex.h
+ * @author Nathan Lemma
+ * @brief Vectorized lexer for the YASH shell
+ * @date 10-17-2026
+ * @details This header file contains the lexer behind tokenize_line() and parse_line(). One pass
+ * over the line finds where every blank-separated token starts and ends and which tokens start
+ * with an operator byte (`<`, `>`, `|`, `&`, `;`, a newline or the `2` of `2>`), so each token's
+ * kind is known when its end is found and no later stage has to look at its text again. On x86
+ * the blanks and operator bytes of 64 bytes at a time are found with SSE2 or AVX2 compares, picked
+ * at run time from what the CPU supports; elsewhere a byte-at-a-time loop does the same job.
+ */
+
+#pragma once
+
+// ============================================================================
+// Includes
+// ============================================================================
+
+#include "yash.h"
+#include <stddef.h>
+
+// ============================================================================
+// Enums
+// ============================================================================
+
+/**
+ * @brief Implementation used to scan a line
+ */
+typedef enum {
+   LEX_SCALAR, ///< One byte at a time, on every CPU
+   LEX_SSE2,   ///< 16-byte compares (x86)
+   LEX_AVX2,   ///< 32-byte compares (x86 with AVX2)
+} LexBackend;
+
+// ============================================================================
+// Public Functions
+// ============================================================================
+
+/**
+ * @brief Split a line into tokens in place and classify them
+ *
+ * Blanks (space and tab) after each token are overwritten with '\0'.
+ *
+ * @param line Mutable, NUL-terminated
+ * @param len strlen(line)
+ * @param tokens Receives the start of each token; room for lex_count() entries
+ * @param kinds Receives each token's kind, NULL if not wanted
+ * @return Number of tokens
+ */
+size_t lex_line(char* line, size_t len, char* tokens[], TokenKind kinds[]);
+
+/**
+ * @brief Count the tokens lex_line() will find, without changing the line
+ * @param line
+ * @param len strlen(line)
+ * @return Number of tokens
+ */
+size_t lex_count(const char* line, size_t len);
+
+/**
+ * @brief Select the implementation used from now on
+ *
+ * The fastest one the CPU supports is selected by default.
+ *
+ * @param backend
+ * @return 0 on success, -1 if the CPU (or the build) does not support it
+ */
+int lex_use(LexBackend backend);
+
+/**
+ * @brief Name of the implementation in use, e.g. "avx2"
+ * @return Static string
+ */
+const char* lex_name(void);
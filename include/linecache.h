@@ -0,0 +1,71 @@
+/**
+ * @file linecache.h
+ * @author Nathan Lemma
+ * @brief Parsed-line cache for the YASH shell
+ * @date 10-17-2026
+ * @details This header file contains the cache of parsed command lines. A line typed (or re-run
+ * with `!!`) again is found by a hash of its text and runs from the Line parsed the first time,
+ * without being tokenized or parsed again. The cache holds up to `set -o linecache=N` lines and
+ * drops the least recently used one to make room.
+ */
+
+#pragma once
+
+// ============================================================================
+// Includes
+// ============================================================================
+
+#include "yash.h"
+
+// ============================================================================
+// Constants
+// ============================================================================
+
+/** @brief Lines cached unless `set -o linecache=N` says otherwise */
+#define LINECACHE_DEFAULT_SIZE 64
+
+// ============================================================================
+// Data Structures
+// ============================================================================
+
+/**
+ * @brief Cache counters
+ */
+typedef struct LineCacheStats {
+   unsigned long hits;   ///< Lookups answered from the cache
+   unsigned long misses; ///< Lookups that had to parse (invalid lines included)
+   int lines;            ///< Lines cached now
+} LineCacheStats;
+
+// ============================================================================
+// Public Functions
+// ============================================================================
+
+/**
+ * @brief Parse a command line, or find it already parsed
+ *
+ * Entries cached before a function was defined or removed are parsed again.
+ *
+ * @param text Assume the string is properly null-terminated and shorter than parse_line_max()
+ * bytes
+ * @param out Receives the parsed line, owned by the cache and valid until the next call (or
+ * linecache_clear()); NULL unless the result is 0
+ * @return As parse_line(): 0, PARSE_INCOMPLETE or -1
+ */
+int linecache_parse(const char* text, Line** out);
+
+/**
+ * @brief Drop every cached line
+ */
+void linecache_clear(void);
+
+/**
+ * @brief Read the counters
+ * @param out
+ */
+void linecache_stats(LineCacheStats* out);
+
+/**
+ * @brief Print the cached lines, most recently used first, and the counters (`hash -l`)
+ */
+void linecache_print(void);
@@ -0,0 +1,66 @@
+/**
+ * @file options.h
+ * @author Nathan Lemma
+ * @brief Shell options for the YASH shell
+ * @date 10-17-2026
+ * @details This header file contains the shell option table and the `set` builtin helpers.
+ */
+
+#pragma once
+
+// ============================================================================
+// Enums
+// ============================================================================
+
+/**
+ * @brief Backend used to create child processes
+ */
+typedef enum {
+   LAUNCH_SPAWN, ///< posix_spawn (vfork-style, no page table copy)
+   LAUNCH_FORK,  ///< fork + exec fallback
+} LaunchBackend;
+
+// ============================================================================
+// Data Structures
+// ============================================================================
+
+/**
+ * @brief Runtime-tunable shell options (`set -o name[=value]`)
+ */
+typedef struct Options {
+   LaunchBackend launch; ///< Process launch backend
+   long pipe_size;       ///< Pipe capacity in bytes for pipelines, 0 = kernel default
+   int pipe_adaptive;    ///< Grow pipe capacity while a writer keeps hitting a full pipe
+   int notify;           ///< Report finished background jobs at once, not at the next prompt
+   int subreaper;        ///< Orphaned descendants of jobs are reparented to the shell (Linux)
+   int queue_limit;      ///< Batch queue entries running at once, 0 = number of online CPUs
+   double admit_cpu;     ///< Hold background jobs while CPU pressure (%) is this high, 0 = off
+   double admit_memory;  ///< Hold background jobs while memory pressure (%) is this high, 0 = off
+   double admit_load;    ///< Hold background jobs while the load average is this high, 0 = off
+   int line_cache;       ///< Parsed command lines kept for reuse, 0 = off
+} Options;
+
+// ============================================================================
+// Globals
+// ============================================================================
+
+/** @brief Current shell options */
+extern Options shell_options;
+
+// ============================================================================
+// Public Functions
+// ============================================================================
+
+/**
+ * @brief Apply one option assignment
+ *
+ * @param spec Option spec, either `name` or `name=value`
+ * @param enable 1 for `set -o`, 0 for `set +o`
+ * @return 0 on success, -1 on unknown option or bad value
+ */
+int options_set(const char* spec, int enable);
+
+/**
+ * @brief Print all options in `set -o` format
+ */
+void options_print(void);
@@ -0,0 +1,105 @@
+/**
+ * @file parallel.h
+ * @author Nathan Lemma
+ * @brief Bounded-concurrency fan-out of commands for the YASH shell
+ * @date 10-17-2026
+ * @details This header file contains the fan-out runner behind the `parallel` and `xargs`
+ * builtins. It keeps at most N children in flight, launching each through launch_command() and
+ * starting the next one as soon as a child event shows that a slot is free.
+ */
+
+#pragma once
+
+// ============================================================================
+// Includes
+// ============================================================================
+
+#include "yash.h"
+
+// ============================================================================
+// Data Structures
+// ============================================================================
+
+/**
+ * @brief Where the commands of a fan-out come from
+ */
+typedef struct FanoutSource {
+   /**
+    * @brief Produce the next task
+    * @param ctx
+    * @param task Number of the task, counting from 0 in launch order
+    * @param cmd Filled in; it only has to stay valid until the next call
+    * @return 1 when @p cmd was filled in, 0 when nothing can start until a running task ends,
+    *         -1 when there are no more tasks
+    */
+   int (*next)(void* ctx, int task, Command* cmd);
+
+   /**
+    * @brief A task has finished (may be NULL)
+    * @param ctx
+    * @param task
+    * @param status Exit status (128 + signal if killed, 127 if it could not be started)
+    * @param seconds Wall time of the task
+    */
+   void (*done)(void* ctx, int task, int status, double seconds);
+
+   void* ctx; ///< Passed to both callbacks
+} FanoutSource;
+
+/**
+ * @brief Totals of a fan-out, for the closing report
+ */
+typedef struct FanoutStats {
+   int started;    ///< Tasks produced by the source
+   int failed;     ///< Tasks that exited non-zero, were killed or could not start
+   double seconds; ///< Wall time of the whole run
+} FanoutStats;
+
+// ============================================================================
+// Public Functions
+// ============================================================================
+
+/**
+ * @brief Run every task of a source with at most @p max in flight
+ *
+ * Each task is launched in a process group of its own. Children are reaped in one loop that
+ * also hands state changes of the shell's background jobs to the job table, so nothing is lost
+ * while the fan-out runs. Ctrl-C stops new launches and interrupts the running tasks.
+ *
+ * @param src
+ * @param max Largest number of tasks running at once (>= 1)
+ * @param ordered Spool each task's stdout and write it out in task order
+ * @param stdin_fd Descriptor every task gets as stdin, -1 to inherit the shell's
+ * @param stats Filled in with the totals (may be NULL)
+ * @return 0 when every task ran, 130 if interrupted, -1 if out of memory
+ */
+int fanout_run(const FanoutSource* src, int max, int ordered, int stdin_fd, FanoutStats* stats);
+
+/**
+ * @brief `parallel [-j N] [-k] command [arg...] [::: value...]`
+ *
+ * Runs the command once per value, at most N at a time (default: the number of online CPUs).
+ * `{}` in the command's words is replaced by the value; without one the value is appended.
+ * Without `:::` the values are the lines of stdin. -k writes each run's output in value order.
+ * A summary of the runs goes to stderr; the exit status is the number of failed runs (at most
+ * 101).
+ *
+ * @param argv
+ * @return Exit status
+ */
+int builtin_parallel(char* const argv[]);
+
+/**
+ * @brief `xargs [-0] [-r] [-P N] [-n MAX] [-s SIZE] [command [arg...]]`
+ *
+ * Runs the command (default: echo) with the items read from stdin appended, packing as many
+ * items into each run as the exec argument area holds: sysconf(_SC_ARG_MAX) less the
+ * environment and 2 KiB of headroom, counting each string with its NUL and pointer as execve()
+ * does. -n caps the items per run and -s the bytes; -P runs up to N batches at once; -0 reads
+ * NUL-separated items; -r skips the run when there are none.
+ *
+ * @param argv
+ * @return 0 on success, 123 if a run failed, 127 if the command could not be started, 1 if an
+ *         item does not fit in one command or stdin could not be read, 130 if interrupted
+ */
+int builtin_xargs(char* const argv[]);
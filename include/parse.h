@@ -14,6 +14,13 @@
 
 #include "yash.h"
 
+// ============================================================================
+// Constants
+// ============================================================================
+
+/** @brief parse_line() result for a line that ends inside a compound command */
+#define PARSE_INCOMPLETE -2
+
 // ============================================================================
 // Public Functions
 // ============================================================================
@@ -21,21 +28,53 @@
 /**
  * @brief Parse a line of input and store the result in line_out
  *
- * @param line Assume the string is properly null-terminated, no newline characters and no more than
- * 2000 characters (i.e. no more than MAX_CMDLINE - 1 characters)
- * @param line_out
- * @return 0 on success, -1 on invalid
+ * A line of several commands separated by `;`, `&`, `&&`, `||` or newlines becomes a chain of
+ * elements starting at line_out (see Line.next). `for`, `while`, `until`, `if`, `case`, `{ }`
+ * and function definitions become elements whose Compound holds the lists they run, parsed here
+ * once however many times they run.
+ *
+ * The result points only into line_out's arena, which the next parse_line() into the same Line
+ * reuses; a shell loop parsing into one Line allocates nothing once its arena has grown to the
+ * longest line seen.
+ *
+ * @param line Assume the string is properly null-terminated and shorter than parse_line_max()
+ * bytes; left unchanged
+ * @param line_out Zeroed, or filled in by an earlier parse_line(); release it with line_free()
+ * when done. On failure it holds no memory
+ * @return 0 on success, PARSE_INCOMPLETE if the line ends inside a compound command (the caller
+ * reads another line and parses both), -1 on invalid
+ */
+int parse_line(const char* line, Line* line_out);
+
+/**
+ * @brief Longest command line the shell accepts, the system's ARG_MAX
+ * @return Length in bytes, terminator included
  */
-int parse_line(char* line, Line* line_out);
+size_t parse_line_max(void);
 
 /**
  * @brief Tokenize a line of input and store the result in tokens
  * @note Caller must pass a mutable buffer (i.e. not a string literal)
  *
- * @param line Assume the string is properly null-terminated, no newline characters and no more than
- * 2000 characters (i.e. no more than MAX_CMDLINE - 1 characters)
- * @param tokens
+ * @param line Assume the string is properly null-terminated, no newline characters
+ * @param tokens Room for (strlen(line) + 1) / 2 tokens, the most a line can hold
  * @param num_tokens
  * @return 0 on success, -1 on invalid
  */
 int tokenize_line(char* line, char* tokens[], int* num_tokens);
+
+/**
+ * @brief Parse a byte count with an optional K, M or G suffix (powers of 1024)
+ *
+ * @param s Size string, e.g. "65536", "256K", "1M"
+ * @return Size in bytes, or -1 if the string is not a valid size
+ */
+long parse_size(const char* s);
+
+/**
+ * @brief Parse a duration with an optional s, m, h or d suffix (seconds by default)
+ *
+ * @param s Duration string, e.g. "30", "1.5", "10m"
+ * @return Duration in seconds, or -1 if the string is not a valid duration
+ */
+double parse_duration(const char* s);
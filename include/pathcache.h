@@ -0,0 +1,51 @@
+/**
+ * @file pathcache.h
+ * @author Nathan Lemma
+ * @brief Command hash table for the YASH shell
+ * @date 10-17-2026
+ * @details This header file contains the bash-style command hash table that remembers where each
+ * command name was found on PATH, so launches can go straight to execve().
+ */
+
+#pragma once
+
+// ============================================================================
+// Public Functions
+// ============================================================================
+
+/**
+ * @brief Resolve a command name to an executable path
+ *
+ * Names containing a '/' are returned unchanged. Other names are looked up in the hash table and
+ * searched on PATH on a miss. Misses that are not found are remembered too (negative entries).
+ * The whole table is dropped when PATH changes.
+ *
+ * @param name Command name (argv[0])
+ * @return Path to execute, or NULL if the command is not on PATH. The pointer stays valid until
+ * the entry is forgotten or the table is cleared.
+ */
+const char* pathcache_lookup(const char* name);
+
+/**
+ * @brief Resolve a name on PATH right now and store it, replacing any existing entry
+ *
+ * @param name Command name
+ * @return 0 if found, -1 if not found (a negative entry is stored) or name contains '/'
+ */
+int pathcache_add(const char* name);
+
+/**
+ * @brief Drop the entry for one name, e.g. after exec reported ENOENT for it
+ * @param name Command name
+ */
+void pathcache_forget(const char* name);
+
+/**
+ * @brief Drop every entry (`hash -r`)
+ */
+void pathcache_clear(void);
+
+/**
+ * @brief Print the table in `hash` builtin format
+ */
+void pathcache_print(void);
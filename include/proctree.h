@@ -0,0 +1,54 @@
+/**
+ * @file proctree.h
+ * @author Nathan Lemma
+ * @brief Process tree walking for the YASH shell
+ * @date 10-17-2026
+ * @details This header file contains the helpers that find a process's children and whole
+ * subtree, for adopting orphaned descendants of jobs and for `kill -tree`, and read a live
+ * process's CPU time for job budgets. They read /proc on Linux and find nothing elsewhere.
+ */
+
+#pragma once
+
+// ============================================================================
+// Includes
+// ============================================================================
+
+#include <sys/types.h>
+
+// ============================================================================
+// Public Functions
+// ============================================================================
+
+/**
+ * @brief Direct children of a process
+ *
+ * Uses /proc/PID/task/TID/children when the kernel provides it, otherwise scans /proc/[pid]/stat
+ * for a matching parent.
+ *
+ * @param pid
+ * @param out Filled with up to @p max pids
+ * @param max
+ * @return Number of children (may exceed @p max), 0 where /proc is unavailable
+ */
+int proctree_children(pid_t pid, pid_t* out, int max);
+
+/**
+ * @brief Stop a set of processes and every descendant, top down
+ *
+ * Each process is sent SIGSTOP before its children are listed, so nothing in the tree can fork
+ * a new process that escapes the walk.
+ *
+ * @param roots
+ * @param n
+ * @param count Set to the number of pids returned
+ * @return The stopped processes, roots first (heap allocated), NULL if out of memory
+ */
+pid_t* proctree_freeze(const pid_t* roots, int n, int* count);
+
+/**
+ * @brief CPU time used so far by a live process, including the children it has waited for
+ * @param pid
+ * @return User plus system seconds, 0 if unknown (or where /proc is unavailable)
+ */
+double proctree_cpu_seconds(pid_t pid);
@@ -0,0 +1,119 @@
+/**
+ * @file queue.h
+ * @author Nathan Lemma
+ * @brief Batch job queue for the YASH shell
+ * @date 10-17-2026
+ * @details This header file contains the batch queue behind the `submit` and `queue` builtins.
+ * A submitted line waits in the queue until fewer than `set -o queuelimit` of the queue's entries
+ * are running, then starts as an ordinary background job, highest priority first. The entries
+ * stay in the queue after they finish, with their wall times, until `queue -c` drops them.
+ */
+
+#pragma once
+
+// ============================================================================
+// Includes
+// ============================================================================
+
+#include "yash.h"
+#include <sys/types.h>
+
+// ============================================================================
+// Enums
+// ============================================================================
+
+/**
+ * @brief Where a queue entry is in its life
+ */
+typedef enum {
+   QUEUE_PENDING,  ///< Waiting for a free slot
+   QUEUE_RUNNING,  ///< Started as a background job
+   QUEUE_FINISHED, ///< Its job is done (or it could not be started)
+} QueueState;
+
+// ============================================================================
+// Data Structures
+// ============================================================================
+
+/**
+ * @brief One submitted line
+ */
+typedef struct QueueEntry {
+   int id;                  ///< Entry number, counting from 1 in submission order
+   int priority;            ///< Higher starts first; equal priorities start in submission order
+   QueueState state;        ///< Pending, running or finished
+   char* cmdline;           ///< Line as submitted, without the `submit` prefix (heap allocated)
+   Line* line;              ///< Parsed line while pending (heap allocated), NULL afterwards
+   pid_t pgid;              ///< Process group of its job once started
+   int exit_code;           ///< Exit status once finished, 127 if it could not be started
+   double submitted;        ///< CLOCK_MONOTONIC seconds at `submit`
+   double started;          ///< CLOCK_MONOTONIC seconds at launch
+   double finished;         ///< CLOCK_MONOTONIC seconds when its job was reaped
+   struct QueueEntry* next; ///< Next entry by id
+} QueueEntry;
+
+// ============================================================================
+// Public Functions
+// ============================================================================
+
+/**
+ * @brief Queue the command of a line that has a `submit` prefix
+ *
+ * @param line Parsed line with submit_at set
+ * @return The new entry's id, or -1 (with a message on stderr) if it cannot be queued
+ */
+int queue_submit(const Line* line);
+
+/**
+ * @brief Start pending entries while fewer than the limit are running and admission control
+ * allows
+ *
+ * Each entry goes through execute_line() as a background job, so it shows up in `jobs` and is
+ * reaped like any other; the queue learns that it finished from the job table.
+ *
+ * @return Number of entries started
+ */
+int queue_schedule(void);
+
+/**
+ * @brief Number of entries in a state
+ * @param state
+ * @return int
+ */
+int queue_count(QueueState state);
+
+/**
+ * @brief Look up an entry
+ * @param id
+ * @return The entry, NULL if there is none with that id
+ */
+const QueueEntry* queue_find(int id);
+
+/**
+ * @brief Drop the finished entries
+ * @return Number of entries dropped
+ */
+int queue_clear_finished(void);
+
+/**
+ * @brief Print every entry with its state, waiting time and wall time
+ */
+void queue_print(void);
+
+/**
+ * @brief `submit [-p PRIORITY] command [arg...]`
+ *
+ * Queueing a command is a prefix handled by the parser; a line only gets here when the prefix was
+ * malformed, so this reports the usage error.
+ *
+ * @param argv
+ * @return 2
+ */
+int builtin_submit(char* const argv[]);
+
+/**
+ * @brief `queue [-c]`: list the batch queue, or drop its finished entries with -c
+ * @param argv
+ * @return Exit status
+ */
+int builtin_queue(char* const argv[]);
@@ -0,0 +1,118 @@
+/**
+ * @file rclass.h
+ * @author Nathan Lemma
+ * @brief Resource classes for jobs in the YASH shell
+ * @date 10-17-2026
+ * @details This header file contains resource classes: a scheduling priority, I/O priority, OOM
+ * score, resource limits and CPU affinity that the shell applies to a command between fork and
+ * exec, so background batch work can be kept out of the way of interactive jobs.
+ */
+
+#pragma once
+
+// ============================================================================
+// Includes
+// ============================================================================
+
+#include <sys/resource.h>
+
+// ============================================================================
+// Constants
+// ============================================================================
+
+/** @brief Most rlimits a class can set */
+#define RCLASS_MAX_LIMITS 10
+
+/** @brief Longest name given to `class -d` */
+#define RCLASS_NAME_MAX 30
+
+/** @brief Longest class label (as shown by `jobs -l`) */
+#define RCLASS_LABEL_MAX 96
+
+/** @brief Words per CPU mask (64 CPUs each) */
+#define RCLASS_CPU_WORDS 16
+
+// ============================================================================
+// Enums
+// ============================================================================
+
+/**
+ * @brief Settings present in a ResourceClass
+ */
+typedef enum {
+   RCLASS_NICE = 1 << 0,   ///< nice is set
+   RCLASS_IOPRIO = 1 << 1, ///< io_class / io_level are set
+   RCLASS_OOM = 1 << 2,    ///< oom_score_adj is set
+   RCLASS_CPUS = 1 << 3,   ///< cpus is set
+} RclassField;
+
+// ============================================================================
+// Data Structures
+// ============================================================================
+
+/**
+ * @brief One resource limit of a class
+ */
+typedef struct RclassLimit {
+   int resource; ///< RLIMIT_* constant
+   rlim_t value; ///< Soft and hard limit
+} RclassLimit;
+
+/**
+ * @brief A resource class: everything a child gets before exec
+ */
+typedef struct ResourceClass {
+   unsigned fields;                          ///< RclassField bits that are set
+   int nice;                                 ///< Nice value (setpriority)
+   int io_class;                             ///< 1 = realtime, 2 = best-effort, 3 = idle
+   int io_level;                             ///< 0 (highest) to 7 for realtime/best-effort
+   int oom_score_adj;                        ///< -1000 to 1000
+   unsigned long long cpus[RCLASS_CPU_WORDS]; ///< Allowed CPUs, one bit each
+   RclassLimit limits[RCLASS_MAX_LIMITS];    ///< Resource limits
+   int num_limits;                           ///< Entries used in limits
+   char label[RCLASS_LABEL_MAX];             ///< Spec words as typed, for display
+} ResourceClass;
+
+// ============================================================================
+// Public Functions
+// ============================================================================
+
+/**
+ * @brief Build a class from spec words
+ *
+ * Each word is `key=value` (nice, io, oom, cpus, or an rlimit: as, core, cpu, data, fsize,
+ * memlock, nofile, nproc, rss, stack). A first word without `=` names a class defined with
+ * rclass_define(); later words override it.
+ *
+ * @param words NULL-terminated spec words
+ * @param rc Filled in
+ * @param bad Set to the offending word on failure (may be NULL)
+ * @return 0 on success, -1 on an unknown class, key or bad value
+ */
+int rclass_parse(char* const words[], ResourceClass* rc, const char** bad);
+
+/**
+ * @brief Define (or redefine) a named class
+ *
+ * @param name Class name
+ * @param words NULL-terminated `key=value` words
+ * @param bad Set to the offending word, or to @p name, on failure (may be NULL)
+ * @return 0 on success, -1 on failure (errno EINVAL for a bad name, ENOSPC when the table is full)
+ */
+int rclass_define(const char* name, char* const words[], const char** bad);
+
+/**
+ * @brief Print every defined class as `name<TAB>spec`
+ */
+void rclass_print(void);
+
+/**
+ * @brief Apply a class to the calling process
+ *
+ * Meant for a forked child before exec. Limits go first and a limit that fails stops there;
+ * after them every setting is attempted. Failures are reported on stderr.
+ *
+ * @param rc
+ * @return 0 if everything applied, -1 if any setting failed
+ */
+int rclass_apply(const ResourceClass* rc);
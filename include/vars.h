@@ -0,0 +1,113 @@
+/**
+ * @file vars.h
+ * @author Nathan Lemma
+ * @brief Shell parameters and word expansion for the YASH shell
+ * @date 10-17-2026
+ * @details This header file contains the shell variables, the positional parameters of the
+ * function being run, the exit status kept from one command to the next (`$?`) and the expansion
+ * of `$` parameters in a command's words just before it runs. The parser only marks the commands
+ * that have a `$` somewhere (Command.expand); every other command runs with the words it was
+ * parsed into.
+ */
+
+#pragma once
+
+// ============================================================================
+// Includes
+// ============================================================================
+
+#include "arena.h"
+#include <stddef.h>
+
+// ============================================================================
+// Public Functions
+// ============================================================================
+
+/**
+ * @brief Record the exit status of the command that just ran
+ * @param status 0-255
+ */
+void vars_set_status(int status);
+
+/**
+ * @brief Exit status of the last command, `$?`
+ * @return int
+ */
+int vars_status(void);
+
+/**
+ * @brief Whether the first @p len bytes of @p s are a variable name (`[A-Za-z_][A-Za-z0-9_]*`)
+ * @param s
+ * @param len
+ * @return 1 if so, 0 otherwise
+ */
+int vars_is_name(const char* s, size_t len);
+
+/**
+ * @brief Set a shell variable
+ *
+ * A variable that is in the environment is updated there, so it stays exported.
+ *
+ * @param name
+ * @param value
+ * @return 0 on success, -1 if out of memory
+ */
+int vars_set(const char* name, const char* value);
+
+/**
+ * @brief Value of a shell variable, falling back to the environment
+ * @param name
+ * @return The value, NULL if unset; valid until the variable changes
+ */
+const char* vars_get(const char* name);
+
+/**
+ * @brief Remove a variable from the shell and the environment
+ * @param name
+ */
+void vars_unset(const char* name);
+
+/**
+ * @brief Move a shell variable into the environment (`export`)
+ * @param name
+ * @param value New value, NULL to keep the current one (or "" if unset)
+ * @return 0 on success, -1 on failure
+ */
+int vars_export(const char* name, const char* value);
+
+/**
+ * @brief Replace the positional parameters (`$0`, `$1`..., `$#`, `$@`)
+ * @param args NULL-terminated, args[0] is `$0`; must outlive its use. NULL for none
+ * @return The parameters in effect before, to put back with another call
+ */
+char* const* vars_set_args(char* const* args);
+
+/**
+ * @brief Positional parameters in effect
+ * @return NULL-terminated array starting at `$0`, NULL outside a function
+ */
+char* const* vars_args(void);
+
+/**
+ * @brief Expand the parameters in a word
+ *
+ * `$?`, `$#`, `$0`-`$9`, `$@`, `$*`, `$NAME` and `${NAME}` are replaced by their values (unset
+ * ones by nothing). A `$` followed by anything else is kept as typed.
+ *
+ * @param word
+ * @param arena Where an expanded copy is allocated
+ * @return word itself when it has no `$`, otherwise the expanded copy; NULL if out of memory
+ */
+char* vars_expand(char* word, Arena* arena);
+
+/**
+ * @brief Expand a list of words the way the words of a command are expanded
+ *
+ * Each word with a `$` is expanded and the result split at blanks into any number of words
+ * (none if it expands to nothing); words without one are kept as they are.
+ *
+ * @param words NULL-terminated
+ * @param arena Where the new list and expanded words are allocated
+ * @return NULL-terminated list, NULL if out of memory
+ */
+char** vars_expand_words(char* const words[], Arena* arena);
@@ -13,6 +13,7 @@
 // Includes
 // ============================================================================
 
+#include "arena.h"
 #include <signal.h>
 #include <sys/stat.h>
 #include <sys/types.h>
@@ -21,20 +22,14 @@
 // Configuration Constants
 // ============================================================================
 
-/** @brief Maximum command line length including null terminator */
-#define MAX_CMDLINE 2001
+/** @brief Most spec words in a `class` prefix */
+#define RCLASS_MAX_WORDS 16
 
-/** @brief Upper bound on number of tokens from max line length */
-#define MAX_TOKENS 2000
+/** @brief Seconds between SIGTERM and SIGKILL for a `timeout` without -k */
+#define TIMEOUT_GRACE_DEFAULT 5.0
 
-/** @brief Maximum length of a single token */
-#define MAX_TOKEN_LEN 30
-
-/** @brief Reasonable cap on arguments per command */
-#define MAX_ARGS 64
-
-/** @brief Maximum number of jobs to track */
-#define MAX_JOBS 20
+/** @brief Exit status of a command killed for overrunning its `timeout` budget (as GNU timeout) */
+#define BUDGET_EXIT_CODE 124
 
 /** @brief File creation mode */
 #define FILE_CREATE_MODE (S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH)
@@ -43,8 +38,11 @@
 // Globals
 // ============================================================================
 
-/** @brief Flag indicating that a child process status has changed */
-extern volatile sig_atomic_t child_status_changed;
+/** @brief Set by Ctrl-C; builtins running inside the shell poll it to stop early */
+extern volatile sig_atomic_t shell_interrupted;
+
+/** @brief SIGINT or SIGTSTP that last reached the shell, 0 once cleared; stops an in-shell copy */
+extern volatile sig_atomic_t shell_stop_signal;
 
 /** @brief Process group ID of the current foreground process */
 extern pid_t foreground_pgid;
@@ -59,10 +57,34 @@ typedef enum {
    TK_REDIR_IN,  ///< Identifies = `<`
    TK_REDIR_OUT, ///< Identifies = `>`
    TK_REDIR_ERR, ///< Identifies = `2>`
-   TK_PIPE,      ///< Identifies = `|`
+   TK_PIPE,      ///< Identifies = `|` or `|[SIZE]`
    TK_AMP,       ///< Identifies = `&`
+   TK_SEMI,      ///< Identifies = `;`
+   TK_AND,       ///< Identifies = `&&`
+   TK_OR,        ///< Identifies = `||`
+   TK_NEWLINE,   ///< Identifies = a newline between the lines of a compound command
+   TK_DSEMI,     ///< Identifies = `;;`
 } TokenKind;
 
+/** @brief How the next element of a command list follows the one before it */
+typedef enum {
+   LIST_END, ///< No next element
+   LIST_SEQ, ///< `;` or `&`: the next element always runs
+   LIST_AND, ///< `&&`: the next element runs if this one exited with 0
+   LIST_OR,  ///< `||`: the next element runs if this one exited with anything else
+} ListOp;
+
+/** @brief Kinds of compound command */
+typedef enum {
+   CC_FOR,   ///< `for NAME [in WORD...] ; do LIST ; done`
+   CC_WHILE, ///< `while LIST ; do LIST ; done`
+   CC_UNTIL, ///< `until LIST ; do LIST ; done`
+   CC_IF,    ///< `if LIST ; then LIST ; [elif LIST ; then LIST ;]... [else LIST ;] fi`
+   CC_CASE,  ///< `case WORD in [PATTERN [| PATTERN]...) LIST ;;]... esac`
+   CC_GROUP, ///< `{ LIST ; }`
+   CC_FUNC,  ///< `NAME() { LIST ; }` or `function NAME { LIST ; }`
+} CompoundKind;
+
 // ============================================================================
 // Data Structures
 // ============================================================================
@@ -75,33 +97,104 @@ typedef enum {
  * - argv[0] must exist for a valid command (cannot be empty).
  * - At most one of each redirection (in_file, out_file, err_file) may be set.
  * - Redirection fields are either a filename string or NULL.
- * - background == 1 is only valid if the containing Line.is_pipeline == 0.
- * - argv pointers reference the tokenized input buffer, which must outlive
- *   parsing and execution.
+ * - background == 1 is only valid if the containing Line.is_pipeline == 0,
+ *   except for the stages of a pipeline started by the batch queue or `dag`.
+ * - argv pointers reference a tokenized copy of the input line that, like
+ *   the argv vector itself, lives in the Line's arena; a parsed Line depends
+ *   on nothing else.
+ * - expand is set when some word or file name contains a `$`; only then are
+ *   they expanded (see vars_expand()) when the command runs.
+ * - assign is set when every word is a `NAME=value` assignment and there are
+ *   no redirections; such a command sets shell variables instead of running.
  */
 typedef struct Command {
-   char* argv[MAX_ARGS]; ///< Null-terminated array of arguments
-   char* in_file;        ///< Filename for input redirection
-   char* out_file;       ///< Filename for output redirection
-   char* err_file;       ///< Filename for error redirection
-   int background;       ///< Background execution flag
+   char** argv;    ///< Null-terminated array of arguments, any number of them
+   char* in_file;  ///< Filename for input redirection
+   char* out_file; ///< Filename for output redirection
+   char* err_file; ///< Filename for error redirection
+   int background; ///< Background execution flag
+   long pipe_size; ///< Capacity requested with `|[SIZE]` for the pipe after this stage
+   int expand;     ///< Has words with a `$` to expand before running
+   int assign;     ///< Only sets shell variables
 } Command;
 
 /**
- * @brief Represents a full line of user input.
+ * @brief Limits set by a `timeout` prefix
+ */
+typedef struct Budget {
+   double wall;  ///< Wall-clock seconds, 0 for no limit
+   double cpu;   ///< CPU seconds summed over every process of the job, 0 for no limit
+   double grace; ///< Seconds from SIGTERM to SIGKILL once a limit is exceeded
+} Budget;
+
+/**
+ * @brief One `PATTERN...) LIST ;;` arm of a case command
+ */
+typedef struct CaseArm {
+   char** patterns;      ///< NULL-terminated fnmatch() patterns
+   struct Line* body;    ///< List run on a match, NULL for an empty arm
+   struct CaseArm* next; ///< Next arm, NULL for the last
+} CaseArm;
+
+/**
+ * @brief A compound command, parsed once and run any number of times
+ *
+ * Every list in it is a chain of Line elements from the same arena as the element holding it.
+ */
+typedef struct Compound {
+   CompoundKind kind;   ///< Which compound command
+   char* name;          ///< Variable of `for`, name of a function
+   char** words;        ///< `for ... in` words or the `case` subject (words[0]), NULL-terminated
+   int expand;          ///< Some word in words has a `$`
+   struct Line* cond;   ///< Condition of while, until and if
+   struct Line* body;   ///< Body of for, while, until, a group or a function; then-part of if
+   struct Line* orelse; ///< else-part of if (an elif is an element holding another CC_IF)
+   CaseArm* arms;       ///< Arms of case, in order
+} Compound;
+
+/**
+ * @brief Represents a full line of user input: one pipeline, or a list of them separated by
+ * `;`, `&`, `&&` and `||`.
+ *
+ * The Line parse_line() fills in is the first element of the list; the others follow through
+ * next, and op says whether each next one runs. Everything but arena describes one element.
+ *
+ * An element can also be a compound command (compound != NULL), in which case it has no stages.
  *
  * Invariants:
- * - If is_pipeline == 0: left is valid, right is unused.
- * - If is_pipeline == 1: both left and right must have argv[0].
+ * - num_stages >= 1 and every stages[i] has argv[0], unless compound is set
+ *   (then num_stages == 0).
+ * - is_pipeline == (num_stages > 1).
  * - Background execution (&) is invalid when is_pipeline == 1.
- * - original always contains the raw command line string as typed,
- *   including & if present.
+ * - stages, their argv vectors, original and every later element are
+ *   allocated from the first element's arena by parse_line(); the next
+ *   parse_line() on the same Line reuses that memory and line_free() releases
+ *   it. The arena of a later element is unused.
+ * - op == LIST_END exactly when next == NULL.
+ * - A leading `time` keyword is not part of stages[0]; it only sets timed.
+ * - A `class [NAME] key=value...` prefix is not part of stages[0]; its words
+ *   are kept in rclass (NULL-terminated, rclass[0] == NULL when there is none).
+ * - A `timeout [-k GRACE] [-c CPU] DURATION` prefix is not part of stages[0];
+ *   it only sets budget (all 0 when there is none).
+ * - A `submit [-p PRIORITY]` prefix is not part of stages[0]; it only sets
+ *   submit_at (0 when there is none) and priority. Any other prefix follows it.
+ * - original always contains the element's text as typed, from its first
+ *   token through its last, including & if present.
  */
 typedef struct Line {
-   int is_pipeline;            ///< Flag indicating if the line is a pipeline
-   Command left;               ///< Left command
-   Command right;              ///< Right command
-   char original[MAX_CMDLINE]; ///< Original command line string
+   int is_pipeline;                    ///< Flag indicating if the line is a pipeline
+   int num_stages;                     ///< Number of commands in the pipeline
+   Command* stages;                    ///< Pipeline stages, left to right
+   int timed;                          ///< Prefixed with the `time` keyword
+   char* rclass[RCLASS_MAX_WORDS + 1]; ///< Spec words of a `class` prefix
+   Budget budget;                      ///< Limits of a `timeout` prefix
+   int submit_at;                      ///< Offset in original of the command after `submit`
+   int priority;                       ///< Priority given with `submit -p`, higher runs first
+   char* original;                     ///< Original command line string
+   Compound* compound;                 ///< The compound command this element is, NULL if none
+   ListOp op;                          ///< Whether next runs after this element
+   struct Line* next;                  ///< Next element of the list, NULL for the last
+   Arena arena;                        ///< Memory of everything above that parse_line() fills in
 } Line;
 
 // ============================================================================
@@ -113,3 +206,10 @@ typedef struct Line {
  * @param cmd Pointer to Command structure to initialize
  */
 void init_command(Command* cmd);
+
+/**
+ * @brief Release the stages and arena of a parsed Line
+ * @note Safe to call on a zeroed Line or one that failed to parse
+ * @param line Pointer to Line structure to release
+ */
+void line_free(Line* line);
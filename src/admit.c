@@ -0,0 +1,241 @@
+/**
+ * @file admit.c
+ * @author Nathan Lemma
+ * @brief Admission control for background jobs in the YASH shell
+ * @date 10-17-2026
+ * @details This file contains the admission controller. Held jobs wait in a first-in first-out
+ * list next to their Pending entries in the job table. Each keeps its own copy of the line, which
+ * is parsed again and run through execute_line() when the job is let through; the launch then
+ * fills in the Pending job instead of adding a new one, so the job keeps its number.
+ */
+
+// ============================================================================
+// Includes
+// ============================================================================
+
+#include "../include/admit.h"
+#include "../include/debug.h"
+#include "../include/exec.h"
+#include "../include/jobs.h"
+#include "../include/options.h"
+#include "../include/parse.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// ============================================================================
+// Constants
+// ============================================================================
+
+/** @brief Seconds between two checks while something waits for pressure to drop */
+#define ADMIT_CHECK_SECONDS 1.0
+
+/** @brief Exit status of a held job whose line could not be started */
+#define ADMIT_NOT_STARTED 127
+
+// ============================================================================
+// Data Structures
+// ============================================================================
+
+/**
+ * @brief A job being held
+ */
+typedef struct Held {
+   int job_id;        ///< Its Pending job
+   char* cmdline;     ///< Line as typed (heap allocated)
+   struct Held* next; ///< Next held job, in the order they were held
+} Held;
+
+// ============================================================================
+// Static Globals
+// ============================================================================
+
+static Held* held_head;   ///< Held longest
+static int held_count;    ///< Jobs on the list
+static int passing = -1;  ///< Job id of the launch in progress that must not be held, 0 for one
+                          ///< with no held job, -1 when there is none
+static int denied;        ///< The last admit_ok() said no
+static double next_check; ///< CLOCK_MONOTONIC seconds before which admit_release() does nothing
+
+// ============================================================================
+// Static Functions
+// ============================================================================
+
+/**
+ * @brief CLOCK_MONOTONIC in seconds
+ * @return double
+ */
+static double now_seconds(void) {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Whether any admission threshold is set
+ * @return int
+ */
+static int thresholds_set(void) {
+   return shell_options.admit_cpu > 0 || shell_options.admit_memory > 0 ||
+          shell_options.admit_load > 0;
+}
+
+#ifdef __linux__
+/**
+ * @brief The `some avg10` figure of a PSI file
+ * @param path
+ * @return Percent, 0 if the kernel does not provide it
+ */
+static double read_psi(const char* path) {
+   FILE* f = fopen(path, "re");
+   if (!f) return 0;
+   double avg10;
+   int n = fscanf(f, "some avg10=%lf", &avg10);
+   fclose(f);
+   return n == 1 ? avg10 : 0;
+}
+#endif
+
+/**
+ * @brief Take a held job off the list
+ * @param job_id
+ * @return The entry, NULL if the job is not held
+ */
+static Held* unlink_held(int job_id) {
+   for (Held** link = &held_head; *link; link = &(*link)->next) {
+      Held* h = *link;
+      if (h->job_id != job_id) continue;
+      *link = h->next;
+      held_count--;
+      return h;
+   }
+   return NULL;
+}
+
+// ============================================================================
+// Public Functions
+// ============================================================================
+
+void admit_sample(Pressure* p) {
+   memset(p, 0, sizeof(*p));
+#ifdef __linux__
+   p->cpu = read_psi("/proc/pressure/cpu");
+   p->memory = read_psi("/proc/pressure/memory");
+   FILE* f = fopen("/proc/loadavg", "re");
+   if (f) {
+      if (fscanf(f, "%lf", &p->load) != 1) p->load = 0;
+      fclose(f);
+   }
+#endif
+}
+
+int admit_ok(void) {
+   denied = 0;
+   if (!thresholds_set()) return 1;
+
+   Pressure p;
+   admit_sample(&p);
+   denied = (shell_options.admit_cpu > 0 && p.cpu >= shell_options.admit_cpu) ||
+            (shell_options.admit_memory > 0 && p.memory >= shell_options.admit_memory) ||
+            (shell_options.admit_load > 0 && p.load >= shell_options.admit_load);
+   if (denied) {
+      DEBUG_JOBS("pressure cpu %.2f%% memory %.2f%% load %.2f is too high",
+                 p.cpu,
+                 p.memory,
+                 p.load);
+   }
+   return !denied;
+}
+
+int admit_hold(const char* cmdline) {
+   // Jobs already waiting go first, so a new one is held behind them even if it could start
+   if (passing >= 0 || (!held_head && admit_ok())) return 0;
+
+   Held* h = malloc(sizeof(Held));
+   char* copy = strdup(cmdline);
+   int id = h && copy ? jobs_add_held(cmdline) : -1;
+   if (id == -1) {
+      // Out of memory: running it is better than losing it
+      free(h);
+      free(copy);
+      return 0;
+   }
+   h->job_id = id;
+   h->cmdline = copy;
+   h->next = NULL;
+   Held** link = &held_head;
+   while (*link) {
+      link = &(*link)->next;
+   }
+   *link = h;
+   held_count++;
+   DEBUG_JOBS("holding job %d: %s", id, cmdline);
+   return 1;
+}
+
+double admit_release(void) {
+   if (!held_head && !denied) return 0;
+   if (!thresholds_set()) {
+      // Thresholds turned off: nothing is held back any more
+      while (held_head) {
+         admit_start(held_head->job_id);
+      }
+      denied = 0;
+      return 0;
+   }
+
+   double now = now_seconds();
+   if (now < next_check) return next_check;
+   if (held_head && admit_ok()) admit_start(held_head->job_id);
+   next_check = now + ADMIT_CHECK_SECONDS;
+   return held_head || denied ? next_check : 0;
+}
+
+int admit_start(int job_id) {
+   Held* h = unlink_held(job_id);
+   if (!h) return -1;
+
+   Line line;
+   memset(&line, 0, sizeof(line));
+   if (parse_line(h->cmdline, &line) == 0) {
+      passing = job_id;
+      execute_line(&line);
+      passing = -1;
+   }
+   line_free(&line);
+   free(h->cmdline);
+   free(h);
+
+   // Nothing was launched (e.g. command not found)
+   if (jobs_get_status(job_id) == JOB_PENDING) {
+      jobs_drop_held(job_id, ADMIT_NOT_STARTED);
+      return -1;
+   }
+   return 0;
+}
+
+int admit_cancel(int job_id, int exit_code) {
+   Held* h = unlink_held(job_id);
+   if (!h) return -1;
+   jobs_drop_held(job_id, exit_code);
+   free(h->cmdline);
+   free(h);
+   return 0;
+}
+
+int admit_launch(Line* line) {
+   int saved = passing;
+   passing = 0;
+   int result = execute_line(line);
+   passing = saved;
+   return result;
+}
+
+int admit_releasing(void) {
+   return passing > 0 ? passing : 0;
+}
+
+int admit_held(void) {
+   return held_count;
+}
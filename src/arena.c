@@ -0,0 +1,113 @@
+/**
+ * @file arena.c
+ * @author Nathan Lemma
+ * @brief Bump allocator for per-line parser data in the YASH shell
+ * @date 10-17-2026
+ * @details This file contains the arena. Blocks are chained newest first and each one is at
+ * least twice the size of the one before, so a line of any length costs a logarithmic number of
+ * malloc() calls the first time and none afterwards.
+ */
+
+// ============================================================================
+// Includes
+// ============================================================================
+
+#include "../include/arena.h"
+#include <stdlib.h>
+#include <string.h>
+
+// ============================================================================
+// Constants
+// ============================================================================
+
+/** @brief Size of an arena's first block */
+#define ARENA_FIRST_BLOCK 4096
+
+/** @brief Alignment of every allocation (enough for any scalar type) */
+#define ARENA_ALIGN 16
+
+// ============================================================================
+// Data Structures
+// ============================================================================
+
+/**
+ * @brief One chunk of arena memory
+ */
+struct ArenaBlock {
+   ArenaBlock* next; ///< Older block
+   size_t size;      ///< Bytes in data
+   size_t used;      ///< Bytes of data handed out
+   union {
+      long double ld; ///< Aligns data
+      void* p;        ///< Aligns data
+   } align;
+   char data[]; ///< The memory
+};
+
+// ============================================================================
+// Static Functions
+// ============================================================================
+
+/**
+ * @brief Add a block that can hold at least @p size bytes
+ * @param arena
+ * @param size
+ * @return The new head, NULL if out of memory
+ */
+static ArenaBlock* add_block(Arena* arena, size_t size) {
+   size_t want = arena->head ? arena->head->size * 2 : ARENA_FIRST_BLOCK;
+   if (want < size) want = size;
+   ArenaBlock* b = malloc(sizeof(ArenaBlock) + want);
+   if (!b) return NULL;
+   b->next = arena->head;
+   b->size = want;
+   b->used = 0;
+   arena->head = b;
+   arena->total += want;
+   return b;
+}
+
+// ============================================================================
+// Public Functions
+// ============================================================================
+
+void* arena_alloc(Arena* arena, size_t size) {
+   size = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+   ArenaBlock* b = arena->head;
+   if (!b || b->size - b->used < size) {
+      b = add_block(arena, size);
+      if (!b) return NULL;
+   }
+   void* p = b->data + b->used;
+   b->used += size;
+   return p;
+}
+
+char* arena_strndup(Arena* arena, const char* s, size_t len) {
+   char* copy = arena_alloc(arena, len + 1);
+   if (!copy) return NULL;
+   memcpy(copy, s, len);
+   copy[len] = '\0';
+   return copy;
+}
+
+void arena_reset(Arena* arena) {
+   if (arena->head && arena->head->next) {
+      size_t total = arena->total;
+      arena_free(arena);
+      // One block of the combined size; if that fails the next allocation simply starts over
+      add_block(arena, total);
+   }
+   if (arena->head) arena->head->used = 0;
+}
+
+void arena_free(Arena* arena) {
+   ArenaBlock* b = arena->head;
+   while (b) {
+      ArenaBlock* next = b->next;
+      free(b);
+      b = next;
+   }
+   arena->head = NULL;
+   arena->total = 0;
+}
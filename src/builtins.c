@@ -0,0 +1,1376 @@
+/**
+ * @file builtins.c
+ * @author Nathan Lemma
+ * @brief Builtins that run inside the shell process for the YASH shell
+ * @date 10-17-2026
+ * @details This file contains the builtin registry and the builtins that do their work in the
+ * shell itself. Names are found through a perfect hash laid out at compile time, so dispatch is
+ * one hash and one strcmp instead of a strcmp chain. `cat` moves bytes between descriptors the
+ * shell already holds with splice, sendfile or copy_file_range, so `cat a > b` or
+ * `cat big.log | grep x` costs no fork, no exec and no user-space copy.
+ */
+
+// ============================================================================
+// Includes
+// ============================================================================
+
+#include "../include/builtins.h"
+#include "../include/admit.h"
+#include "../include/dag.h"
+#include "../include/debug.h"
+#include "../include/events.h"
+#include "../include/exec.h"
+#include "../include/fdcopy.h"
+#include "../include/funcs.h"
+#include "../include/jobs.h"
+#include "../include/linecache.h"
+#include "../include/options.h"
+#include "../include/parallel.h"
+#include "../include/pathcache.h"
+#include "../include/proctree.h"
+#include "../include/queue.h"
+#include "../include/rclass.h"
+#include "../include/vars.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+// ============================================================================
+// Constants
+// ============================================================================
+
+/**
+ * @brief Seed that makes builtin_slot() collision-free for the names in builtin_table
+ *
+ * After adding a builtin, run the tests: test_builtin_table_is_perfect reports a seed that works
+ * and the slots to move entries to.
+ */
+#define BUILTIN_HASH_SEED 1291u
+
+/** @brief `wait` exit status when the timeout expires (as timeout(1)) */
+#define WAIT_TIMED_OUT 124
+
+/** @brief Buffer size for the current directory */
+#define CWD_MAX 4096
+
+// ============================================================================
+// Static Functions
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Job control and shell state
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief `exit [N]`: N defaults to `$?`
+ */
+static int builtin_exit(char* const argv[]) {
+   fflush(stdout);
+   exit(argv[1] ? atoi(argv[1]) & 0xff : vars_status());
+}
+
+/**
+ * @brief `jobs [-l]`: -l adds process groups and resource usage
+ */
+static int builtin_jobs(char* const argv[]) {
+   if (argv[1] && strcmp(argv[1], "-l") == 0) {
+      jobs_print_long();
+   } else {
+      jobs_print();
+   }
+   return 0;
+}
+
+/**
+ * @brief `fg`: continue the most recent job in the foreground and wait for it (starting it first
+ * if admission control is holding it)
+ * @return The job's exit status once it is done, 128 + SIGTSTP if it stops again
+ */
+static int builtin_fg(char* const argv[]) {
+   (void)argv;
+   int jid = jobs_pick_most_recent_for_fg();
+   if (jid == -1) {
+      printf("fg: no current job\n");
+      return 1;
+   }
+   // A job held by admission control starts now
+   if (jobs_get_status(jid) == JOB_PENDING && admit_start(jid) == -1) {
+      printf("fg: job could not be started\n");
+      return 1;
+   }
+   pid_t pg = jobs_get_pgid(jid);
+   if (pg == -1) {
+      printf("fg: job not found\n");
+      return 1;
+   }
+   const char* s = jobs_get_cmdline(jid);
+   if (s) {
+      // Trim trailing " &" if present
+      size_t len = strlen(s);
+      // Remove trailing whitespace
+      while (len > 0 && (s[len - 1] == ' ' || s[len - 1] == '\t')) {
+         len--;
+      }
+      // Remove trailing & if present
+      if (len > 0 && s[len - 1] == '&') {
+         len--;
+      }
+      // Remove any remaining trailing whitespace
+      while (len > 0 && (s[len - 1] == ' ' || s[len - 1] == '\t')) {
+         len--;
+      }
+
+      printf("%.*s\n", (int)len, s);
+      fflush(stdout);
+   }
+   kill(-pg, SIGCONT);
+   jobs_mark(pg, JOB_RUNNING);
+   jobs_set_background(pg, 0);
+   foreground_pgid = pg;
+
+   // Until every stage has stopped or the last one has exited. Blocks in waitpid() unless a
+   // budget needs the shell awake at its deadline
+   int status;
+   JobUsage usage = {0};
+   while (jobs_get_status(jid) == JOB_RUNNING) {
+      double due = jobs_enforce_budgets();
+      pid_t pid = jobs_wait(-pg, &status, due > 0 ? WUNTRACED | WNOHANG : WUNTRACED, &usage);
+      if (pid < 0) break;
+      if (pid == 0) {
+         events_set_timer(due);
+         events_wait_child(-1);
+         continue;
+      }
+      jobs_process_event(pid, status, &usage);
+      memset(&usage, 0, sizeof(usage));
+   }
+   foreground_pgid = 0;
+
+   // Waited for in the foreground, a finished job leaves no Done notice behind
+   if (jobs_get_status(jid) == JOB_STOPPED) return 128 + SIGTSTP;
+   int code = jobs_reap_job(jid);
+   return code == -1 ? 0 : code;
+}
+
+/**
+ * @brief `bg`: continue the most recent stopped job in the background
+ */
+static int builtin_bg(char* const argv[]) {
+   (void)argv;
+   int jid = jobs_pick_most_recent_stopped_for_bg();
+   if (jid == -1) {
+      printf("bg: no current job\n");
+      return 1;
+   }
+   pid_t pg = jobs_get_pgid(jid);
+   if (pg == -1) {
+      printf("bg: job not found\n");
+      return 1;
+   }
+   kill(-pg, SIGCONT);
+   jobs_mark(pg, JOB_RUNNING);
+   jobs_set_background(pg, 1);
+
+   // Print the job info
+   jobs_print_one(jid);
+   return 0;
+}
+
+/**
+ * @brief Seconds on the monotonic clock
+ */
+static double monotonic_now(void) {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Wait for jobs to finish, reaping through the job table
+ *
+ * Each round reaps whatever has changed, then sleeps on the live processes of the jobs still
+ * outstanding until one of them exits, so no exit status is taken away from jobs_collect().
+ *
+ * @param ids Job ids; entries are set to 0 as their jobs finish
+ * @param n
+ * @param any Return as soon as one job finishes (`wait -n`)
+ * @param named The jobs were named, so the last one's status is reported
+ * @param timeout Seconds, negative for no limit
+ * @return Exit status of the last job in @p ids if @p named (or, with @p any, of the job that
+ *         finished), otherwise 0; WAIT_TIMED_OUT, or 130 on Ctrl-C
+ */
+static int wait_for_jobs(int* ids, int n, int any, int named, double timeout) {
+   double deadline = monotonic_now() + timeout;
+   int left = n;
+   int status = 0;
+   pid_t* pids = NULL;
+   int cap = 0;
+
+   shell_interrupted = 0;
+   while (1) {
+      jobs_collect();
+      for (int i = 0; i < n; i++) {
+         int code = ids[i] ? jobs_reap_job(ids[i]) : -1;
+         if (code == -1) continue;
+         ids[i] = 0;
+         left--;
+         if (any || (named && i == n - 1)) status = code;
+         if (any) break;
+      }
+      if (left == 0 || (any && left < n)) break;
+
+      // In a forked builtin the jobs are not our children; nothing would ever reap them
+      siginfo_t info;
+      if (admit_held() == 0 &&
+          waitid(P_ALL, 0, &info, WEXITED | WSTOPPED | WNOHANG | WNOWAIT) == -1 &&
+          errno == ECHILD) {
+         status = 127;
+         break;
+      }
+
+      // The live processes of every job still outstanding
+      int num_pids = 0;
+      for (int i = 0; i < n; i++) {
+         if (ids[i]) num_pids += jobs_live_pids(ids[i], NULL, 0);
+      }
+      if (num_pids > cap) {
+         pid_t* grown = realloc(pids, num_pids * sizeof(pid_t));
+         if (!grown) {
+            status = 1;
+            break;
+         }
+         pids = grown;
+         cap = num_pids;
+      }
+      for (int i = 0, filled = 0; i < n; i++) {
+         if (ids[i]) filled += jobs_live_pids(ids[i], pids + filled, num_pids - filled);
+      }
+
+      int ms = -1;
+      if (timeout >= 0) {
+         double remaining = deadline - monotonic_now();
+         if (remaining <= 0) {
+            status = WAIT_TIMED_OUT;
+            break;
+         }
+         ms = (int)(remaining * 1000) + 1;
+      }
+      // Wake up for the next budget deadline, or to start a held job, as well
+      double due = jobs_enforce_budgets();
+      double check = admit_release();
+      if (check > 0 && (due == 0 || check < due)) due = check;
+      if (due > 0) {
+         double remaining = due - monotonic_now();
+         int due_ms = remaining > 0 ? (int)(remaining * 1000) + 1 : 0;
+         if (ms < 0 || due_ms < ms) ms = due_ms;
+      }
+      if (events_wait_pids(pids, num_pids, ms) == -1 && errno == EINTR && shell_interrupted) {
+         status = 130;
+         break;
+      }
+   }
+   free(pids);
+   shell_interrupted = 0;
+   return status;
+}
+
+/**
+ * @brief `wait [-n] [-t SECONDS] [%JOB...]`: wait for background jobs to finish
+ *
+ * With no jobs named, waits for every background job. Exits with the status of the last job
+ * named (or, with -n, of the first to finish), 124 on timeout and 127 for an unknown job. Jobs
+ * that were waited for are dropped without a Done notice.
+ */
+static int builtin_wait(char* const argv[]) {
+   int any = 0;
+   double timeout = -1;
+   int i = 1;
+   for (; argv[i] && argv[i][0] == '-'; i++) {
+      char* end = NULL;
+      if (strcmp(argv[i], "-n") == 0) {
+         any = 1;
+      } else if (strcmp(argv[i], "-t") == 0 && argv[i + 1] &&
+                 (timeout = strtod(argv[i + 1], &end)) >= 0 && end != argv[i + 1] && !*end) {
+         i++;
+      } else {
+         fprintf(stderr, "wait: usage: wait [-n] [-t SECONDS] [%%JOB...]\n");
+         return 2;
+      }
+   }
+
+   int named = argv[i] != NULL;
+   int max = named ? 0 : jobs_count();
+   for (int k = i; argv[k]; k++) {
+      max++;
+   }
+   int* ids = malloc((max > 0 ? max : 1) * sizeof(int));
+   if (!ids) return 1;
+
+   int n = 0;
+   int status = 0;
+   if (!named) {
+      n = jobs_background_ids(ids, max);
+   }
+   for (; argv[i]; i++) {
+      const char* spec = argv[i][0] == '%' ? argv[i] + 1 : argv[i];
+      char* end;
+      long id = strtol(spec, &end, 10);
+      if (end == spec || *end || id <= 0 || id > INT_MAX || jobs_get_pgid((int)id) == -1) {
+         fprintf(stderr, "wait: %s: no such job\n", argv[i]);
+         status = 127;
+         continue;
+      }
+      ids[n++] = (int)id;
+   }
+
+   if (n > 0) {
+      status = wait_for_jobs(ids, n, any, named, timeout);
+   } else if (any) {
+      status = 127;
+   }
+   free(ids);
+   return status;
+}
+
+/**
+ * @brief Signal number for a name (`TERM`, `SIGTERM`) or a number
+ *
+ * @param name
+ * @return The signal, -1 if unknown
+ */
+static int signal_number(const char* name) {
+   static const struct {
+      const char* name;
+      int sig;
+   } signals[] = {{"HUP", SIGHUP},   {"INT", SIGINT},   {"QUIT", SIGQUIT}, {"KILL", SIGKILL},
+                  {"USR1", SIGUSR1}, {"USR2", SIGUSR2}, {"PIPE", SIGPIPE}, {"ALRM", SIGALRM},
+                  {"TERM", SIGTERM}, {"CHLD", SIGCHLD}, {"CONT", SIGCONT}, {"STOP", SIGSTOP},
+                  {"TSTP", SIGTSTP}, {"TTIN", SIGTTIN}, {"TTOU", SIGTTOU}, {"WINCH", SIGWINCH}};
+
+   char* end;
+   long n = strtol(name, &end, 10);
+   // kill() itself rejects numbers that are not signals
+   if (end != name && !*end) return n >= 0 && n <= INT_MAX ? (int)n : -1;
+   if (strncmp(name, "SIG", 3) == 0) name += 3;
+   for (size_t i = 0; i < sizeof(signals) / sizeof(signals[0]); i++) {
+      if (strcmp(name, signals[i].name) == 0) return signals[i].sig;
+   }
+   return -1;
+}
+
+/**
+ * @brief Signal a job's whole process tree, or a process and its descendants
+ *
+ * The tree is stopped top down first (see proctree_freeze()) so that nothing forks its way out,
+ * then every process gets the signal and is continued so that it can act on it.
+ *
+ * @param job_id Job to signal, 0 to start from @p pid instead
+ * @param pid
+ * @param sig
+ * @return 0 on success, -1 if no process could be signalled (errno set)
+ */
+static int kill_tree(int job_id, pid_t pid, int sig) {
+   pid_t* roots = &pid;
+   int n = 1;
+   if (job_id) {
+      // Orphans the kernel handed back since the last reap belong to the tree too
+      if (shell_options.subreaper) jobs_adopt_orphans();
+      n = jobs_live_pids(job_id, NULL, 0);
+      roots = malloc((n > 0 ? n : 1) * sizeof(pid_t));
+      if (!roots) return -1;
+      n = jobs_live_pids(job_id, roots, n);
+   }
+
+   int count = 0;
+   pid_t* tree = n > 0 ? proctree_freeze(roots, n, &count) : NULL;
+   if (roots != &pid) free(roots);
+   if (!tree) {
+      errno = n > 0 ? ENOMEM : ESRCH;
+      return -1;
+   }
+
+   int sent = 0;
+   for (int i = 0; i < count; i++) {
+      sent += kill(tree[i], sig) == 0;
+   }
+   if (sig != SIGSTOP && sig != SIGTSTP) {
+      for (int i = 0; i < count; i++) {
+         kill(tree[i], SIGCONT);
+      }
+   }
+   free(tree);
+   if (sent == 0) errno = ESRCH;
+   return sent > 0 ? 0 : -1;
+}
+
+/**
+ * @brief `kill [-SIGNAL | -s SIGNAL] [-tree] %JOB|PID...`: send a signal (TERM by default)
+ *
+ * A job is signalled through its process group. With -tree the signal goes to every process in
+ * the job's tree instead: its stages, orphans adopted in subreaper mode and all of their
+ * descendants, whatever process group or session they moved to. A job held by admission control
+ * has no processes yet: CONT starts it, and a signal that would end a process drops it.
+ */
+static int builtin_kill(char* const argv[]) {
+   int sig = SIGTERM;
+   int tree = 0;
+   int i = 1;
+   for (; argv[i] && argv[i][0] == '-' && argv[i][1]; i++) {
+      if (strcmp(argv[i], "-tree") == 0) {
+         tree = 1;
+      } else if (strcmp(argv[i], "-s") == 0 && argv[i + 1]) {
+         sig = signal_number(argv[++i]);
+      } else {
+         sig = signal_number(argv[i] + 1);
+      }
+      if (sig == -1) {
+         fprintf(stderr, "kill: %s: invalid signal\n", argv[i]);
+         return 2;
+      }
+   }
+   if (!argv[i]) {
+      fprintf(stderr, "kill: usage: kill [-SIGNAL | -s SIGNAL] [-tree] %%JOB|PID...\n");
+      return 2;
+   }
+
+   int status = 0;
+   for (; argv[i]; i++) {
+      const char* spec = argv[i][0] == '%' ? argv[i] + 1 : argv[i];
+      char* end;
+      long n = strtol(spec, &end, 10);
+      if (end == spec || *end || n <= 0 || n > INT_MAX) {
+         fprintf(stderr, "kill: %s: not a job or process id\n", argv[i]);
+         status = 1;
+         continue;
+      }
+
+      int job_id = argv[i][0] == '%' ? (int)n : 0;
+      pid_t pid = job_id ? jobs_get_pgid(job_id) : (pid_t)n;
+      if (pid == -1) {
+         fprintf(stderr, "kill: %s: no such job\n", argv[i]);
+         status = 1;
+         continue;
+      }
+
+      if (job_id && jobs_get_status(job_id) == JOB_PENDING) {
+         // A held job has no processes yet: CONT starts it now, a signal that would end it drops
+         // it as if it had been killed at once
+         switch (sig) {
+         case 0:
+         case SIGCHLD:
+         case SIGWINCH:
+         case SIGSTOP:
+         case SIGTSTP:
+         case SIGTTIN:
+         case SIGTTOU:
+            break;
+         case SIGCONT:
+            admit_start(job_id);
+            break;
+         default:
+            admit_cancel(job_id, 128 + sig);
+         }
+         continue;
+      }
+
+      int rc = tree ? kill_tree(job_id, pid, sig) : kill(job_id ? -pid : pid, sig);
+      if (rc == -1) {
+         fprintf(stderr, "kill: %s: %s\n", argv[i], strerror(errno));
+         status = 1;
+      }
+   }
+   return status;
+}
+
+/**
+ * @brief `hash`: list (no args), forget all (-r) or look up names now; `-l` lists the parsed-line
+ * cache instead
+ */
+static int builtin_hash(char* const argv[]) {
+   if (!argv[1]) {
+      pathcache_print();
+      return 0;
+   }
+   if (strcmp(argv[1], "-r") == 0) {
+      pathcache_clear();
+      return 0;
+   }
+   if (strcmp(argv[1], "-l") == 0) {
+      linecache_print();
+      return 0;
+   }
+   int status = 0;
+   for (int i = 1; argv[i]; i++) {
+      if (pathcache_add(argv[i]) == -1) {
+         printf("hash: %s: not found\n", argv[i]);
+         status = 1;
+      }
+   }
+   return status;
+}
+
+/**
+ * @brief `set`: list options (-o), enable / assign (-o name[=val]) or disable (+o name)
+ *
+ * `-b` and `+b` are the POSIX short forms of `-o notify` and `+o notify`.
+ */
+static int builtin_set(char* const argv[]) {
+   if (!argv[1] || (strcmp(argv[1], "-o") == 0 && !argv[2])) {
+      options_print();
+      return 0;
+   }
+   for (int i = 1; argv[i]; i += 2) {
+      if (strcmp(argv[i], "-b") == 0 || strcmp(argv[i], "+b") == 0) {
+         options_set("notify", argv[i][0] == '-');
+         i--; // Takes no operand
+         continue;
+      }
+      int enable = strcmp(argv[i], "-o") == 0;
+      if ((!enable && strcmp(argv[i], "+o") != 0) || !argv[i + 1]) {
+         printf("set: usage: set [-o|+o] option[=value]\n");
+         return 2;
+      }
+      if (options_set(argv[i + 1], enable) == -1) {
+         printf("set: invalid option: %s\n", argv[i + 1]);
+         return 1;
+      }
+   }
+   return 0;
+}
+
+/**
+ * @brief `class`: list classes (no args) or define one (`class -d NAME [BASE] key=value...`)
+ *
+ * Running a command under a class (`class NAME cmd`) is a prefix handled by the parser; a line
+ * only gets here when there is no command to run.
+ */
+static int builtin_class(char* const argv[]) {
+   if (!argv[1]) {
+      rclass_print();
+      return 0;
+   }
+   if (strcmp(argv[1], "-d") != 0 || !argv[2] || !argv[3]) {
+      fprintf(stderr, "class: usage: class -d NAME key=value... | class NAME|key=value... cmd\n");
+      return 2;
+   }
+
+   const char* bad;
+   if (rclass_define(argv[2], argv + 3, &bad) == -1) {
+      const char* why = "no such class";
+      if (bad == argv[2]) {
+         why = errno == ENOSPC ? "too many classes" : "invalid class name";
+      } else if (strchr(bad, '=')) {
+         why = "invalid setting";
+      }
+      fprintf(stderr, "class: %s: %s\n", bad, why);
+      return 1;
+   }
+   return 0;
+}
+
+/**
+ * @brief `cd [DIR|-]`: change directory (HOME by default, OLDPWD for `-`) and update PWD
+ */
+static int builtin_cd(char* const argv[]) {
+   const char* dir = argv[1];
+   int print = 0;
+   if (!dir) {
+      dir = getenv("HOME");
+      if (!dir) {
+         fprintf(stderr, "cd: HOME not set\n");
+         return 1;
+      }
+   } else if (strcmp(dir, "-") == 0) {
+      dir = getenv("OLDPWD");
+      if (!dir) {
+         fprintf(stderr, "cd: OLDPWD not set\n");
+         return 1;
+      }
+      print = 1;
+   }
+
+   char old[CWD_MAX];
+   int have_old = getcwd(old, sizeof(old)) != NULL;
+   if (chdir(dir) < 0) {
+      fprintf(stderr, "cd: %s: %s\n", dir, strerror(errno));
+      return 1;
+   }
+
+   char cwd[CWD_MAX];
+   if (have_old) setenv("OLDPWD", old, 1);
+   if (getcwd(cwd, sizeof(cwd))) {
+      setenv("PWD", cwd, 1);
+      if (print) printf("%s\n", cwd);
+   }
+   return 0;
+}
+
+/**
+ * @brief `pwd`
+ */
+static int builtin_pwd(char* const argv[]) {
+   (void)argv;
+   char cwd[CWD_MAX];
+   if (!getcwd(cwd, sizeof(cwd))) {
+      fprintf(stderr, "pwd: %s\n", strerror(errno));
+      return 1;
+   }
+   printf("%s\n", cwd);
+   return 0;
+}
+
+// ----------------------------------------------------------------------------
+// Variables, loops and functions
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief `break [N]` and `continue [N]`: leave (or go on with the next iteration of) the N
+ * innermost loops
+ */
+static int builtin_break(char* const argv[]) {
+   int levels = 1;
+   if (argv[1]) {
+      char* end;
+      long n = strtol(argv[1], &end, 10);
+      if (*end || n < 1 || n > INT_MAX) {
+         fprintf(stderr, "%s: %s: loop count out of range\n", argv[0], argv[1]);
+         return 1;
+      }
+      levels = (int)n;
+   }
+   Flow flow = strcmp(argv[0], "break") == 0 ? FLOW_BREAK : FLOW_CONTINUE;
+   if (exec_jump(flow, levels) == -1) {
+      fprintf(stderr, "%s: only meaningful in a loop\n", argv[0]);
+      return 1;
+   }
+   return 0;
+}
+
+/**
+ * @brief `return [N]`: leave the running function with status N (`$?` by default)
+ */
+static int builtin_return(char* const argv[]) {
+   int status = argv[1] ? atoi(argv[1]) & 0xff : vars_status();
+   if (exec_jump(FLOW_RETURN, 1) == -1) {
+      fprintf(stderr, "return: can only return from a function\n");
+      return 1;
+   }
+   return status;
+}
+
+/**
+ * @brief `export [NAME[=VALUE]...]`: put variables in the environment of later commands; with no
+ * arguments, list the environment
+ */
+static int builtin_export(char* const argv[]) {
+   extern char** environ;
+   if (!argv[1]) {
+      for (char** e = environ; *e; e++) {
+         printf("export %s\n", *e);
+      }
+      return 0;
+   }
+
+   int status = 0;
+   for (int i = 1; argv[i]; i++) {
+      char* eq = strchr(argv[i], '=');
+      size_t len = eq ? (size_t)(eq - argv[i]) : strlen(argv[i]);
+      if (!vars_is_name(argv[i], len)) {
+         fprintf(stderr, "export: %s: not a valid name\n", argv[i]);
+         status = 1;
+         continue;
+      }
+      if (eq) *eq = '\0';
+      if (vars_export(argv[i], eq ? eq + 1 : NULL) == -1) {
+         fprintf(stderr, "export: %s: %s\n", argv[i], strerror(errno));
+         status = 1;
+      }
+      if (eq) *eq = '=';
+   }
+   return status;
+}
+
+/**
+ * @brief `unset [-f|-v] NAME...`: remove variables, or functions with -f
+ */
+static int builtin_unset(char* const argv[]) {
+   int i = 1;
+   int functions = 0;
+   if (argv[i] && (strcmp(argv[i], "-f") == 0 || strcmp(argv[i], "-v") == 0)) {
+      functions = argv[i][1] == 'f';
+      i++;
+   }
+   for (; argv[i]; i++) {
+      if (functions) {
+         funcs_unset(argv[i]);
+      } else {
+         vars_unset(argv[i]);
+      }
+   }
+   return 0;
+}
+
+// ----------------------------------------------------------------------------
+// Utilities
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief `true` and `:`
+ */
+static int builtin_true(char* const argv[]) {
+   (void)argv;
+   return 0;
+}
+
+/**
+ * @brief `false`
+ */
+static int builtin_false(char* const argv[]) {
+   (void)argv;
+   return 1;
+}
+
+/**
+ * @brief `echo [-n] [ARG...]`
+ */
+static int builtin_echo(char* const argv[]) {
+   int i = 1;
+   int newline = 1;
+   while (argv[i] && strcmp(argv[i], "-n") == 0) {
+      newline = 0;
+      i++;
+   }
+   for (int first = i; argv[i]; i++) {
+      if (i > first) putchar(' ');
+      fputs(argv[i], stdout);
+   }
+   if (newline) putchar('\n');
+   return 0;
+}
+
+/**
+ * @brief Print one backslash escape from a printf format
+ *
+ * @param p Points just past the backslash
+ * @return const char* First character after the escape
+ */
+static const char* put_escape(const char* p) {
+   switch (*p) {
+   case 'a':
+      putchar('\a');
+      return p + 1;
+   case 'b':
+      putchar('\b');
+      return p + 1;
+   case 'f':
+      putchar('\f');
+      return p + 1;
+   case 'n':
+      putchar('\n');
+      return p + 1;
+   case 'r':
+      putchar('\r');
+      return p + 1;
+   case 't':
+      putchar('\t');
+      return p + 1;
+   case 'v':
+      putchar('\v');
+      return p + 1;
+   case '\\':
+      putchar('\\');
+      return p + 1;
+   case '\0':
+      putchar('\\');
+      return p;
+   default:
+      break;
+   }
+   if (*p >= '0' && *p <= '7') {
+      // \NNN octal, at most three digits
+      int value = 0;
+      for (int n = 0; n < 3 && *p >= '0' && *p <= '7'; n++, p++) {
+         value = value * 8 + (*p - '0');
+      }
+      putchar(value);
+      return p;
+   }
+   putchar('\\');
+   putchar(*p);
+   return p + 1;
+}
+
+/**
+ * @brief Convert a printf numeric argument
+ *
+ * A leading quote gives the character's value, as in POSIX printf.
+ *
+ * @param arg Argument (NULL counts as 0)
+ * @param status Set to 1 when the argument is not a number
+ * @return long long
+ */
+static long long printf_number(const char* arg, int* status) {
+   if (!arg || !*arg) return 0;
+   if (arg[0] == '\'' || arg[0] == '"') return (unsigned char)arg[1];
+   char* end;
+   errno = 0;
+   long long v = strtoll(arg, &end, 0);
+   if (*end || errno) {
+      fprintf(stderr, "printf: %s: invalid number\n", arg);
+      *status = 1;
+   }
+   return v;
+}
+
+/**
+ * @brief `printf FORMAT [ARG...]`
+ *
+ * Supports %s %b %c %d %i %u %o %x %X %% with flags, width and precision (including `*`), and
+ * reuses the format until every argument has been consumed.
+ */
+static int builtin_printf(char* const argv[]) {
+   if (!argv[1]) {
+      fprintf(stderr, "printf: usage: printf format [arguments]\n");
+      return 2;
+   }
+   const char* format = argv[1];
+   char* const* args = argv + 2;
+   int status = 0;
+
+   do {
+      char* const* start = args;
+      for (const char* p = format; *p; p++) {
+         if (*p == '\\') {
+            p = put_escape(p + 1) - 1;
+            continue;
+         }
+         if (*p != '%') {
+            putchar(*p);
+            continue;
+         }
+         if (p[1] == '%') {
+            putchar('%');
+            p++;
+            continue;
+         }
+
+         // Rebuild the directive as "%[flags][width][.precision]" plus the conversion
+         char spec[64] = "%";
+         size_t len = 1;
+         const char* q = p + 1;
+         while (*q && strchr("-+ #0", *q) && len < 8) {
+            spec[len++] = *q++;
+         }
+         for (int part = 0; part < 2; part++) {
+            if (part == 1) {
+               if (*q != '.') break;
+               spec[len++] = *q++;
+            }
+            if (*q == '*') {
+               len += snprintf(spec + len, 16, "%d", (int)printf_number(*args, &status));
+               if (*args) args++;
+               q++;
+            }
+            while (*q >= '0' && *q <= '9' && len < 40) {
+               spec[len++] = *q++;
+            }
+         }
+
+         const char* arg = *args;
+         if (arg) args++;
+         switch (*q) {
+         case 's':
+            strcpy(spec + len, "s");
+            printf(spec, arg ? arg : "");
+            break;
+         case 'b':
+            for (const char* b = arg ? arg : ""; *b; b++) {
+               if (*b == '\\') {
+                  b = put_escape(b + 1) - 1;
+               } else {
+                  putchar(*b);
+               }
+            }
+            break;
+         case 'c':
+            strcpy(spec + len, "c");
+            if (arg && *arg) printf(spec, arg[0]);
+            break;
+         case 'd':
+         case 'i':
+            strcpy(spec + len, "lld");
+            printf(spec, printf_number(arg, &status));
+            break;
+         case 'u':
+         case 'o':
+         case 'x':
+         case 'X':
+            snprintf(spec + len, 4, "ll%c", *q);
+            printf(spec, (unsigned long long)printf_number(arg, &status));
+            break;
+         default:
+            fprintf(stderr, "printf: %%%c: invalid directive\n", *q ? *q : ' ');
+            return 1;
+         }
+         p = q;
+      }
+      // Nothing consumed: the format has no directives, so stop
+      if (args == start) break;
+   } while (*args);
+
+   return status;
+}
+
+// ----------------------------------------------------------------------------
+// test / [
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Parser state for a `test` expression
+ */
+typedef struct TestState {
+   char* const* argv; ///< Operands (without the command name and the closing `]`)
+   int argc;          ///< Number of operands
+   int pos;           ///< Next operand
+   int error;         ///< Set on a syntax or operand error
+} TestState;
+
+/**
+ * @brief Whether @p op is a binary `test` operator
+ */
+static int test_is_binary(const char* op) {
+   static const char* const ops[] = {
+       "=", "!=", "-eq", "-ne", "-lt", "-le", "-gt", "-ge", "-nt", "-ot", "-ef", NULL};
+   for (int i = 0; op && ops[i]; i++) {
+      if (strcmp(op, ops[i]) == 0) return 1;
+   }
+   return 0;
+}
+
+/**
+ * @brief Whether @p op is a unary `test` operator
+ */
+static int test_is_unary(const char* op) {
+   return op && op[0] == '-' && op[1] && !op[2] && strchr("bcdefghLnprSstuwxz", op[1]);
+}
+
+/**
+ * @brief Integer operand of a `test` comparison
+ */
+static long long test_integer(TestState* t, const char* s) {
+   char* end;
+   errno = 0;
+   long long v = strtoll(s, &end, 10);
+   if (!*s || *end || errno) {
+      fprintf(stderr, "test: %s: integer expression expected\n", s);
+      t->error = 1;
+   }
+   return v;
+}
+
+/**
+ * @brief Evaluate a unary primary such as `-f FILE`
+ */
+static int test_unary(TestState* t, char op, const char* arg) {
+   struct stat st;
+   switch (op) {
+   case 'n':
+      return arg[0] != '\0';
+   case 'z':
+      return arg[0] == '\0';
+   case 't':
+      return isatty((int)test_integer(t, arg));
+   case 'r':
+      return access(arg, R_OK) == 0;
+   case 'w':
+      return access(arg, W_OK) == 0;
+   case 'x':
+      return access(arg, X_OK) == 0;
+   case 'h':
+   case 'L':
+      return lstat(arg, &st) == 0 && S_ISLNK(st.st_mode);
+   default:
+      break;
+   }
+   if (stat(arg, &st) < 0) return 0;
+   switch (op) {
+   case 'b':
+      return S_ISBLK(st.st_mode);
+   case 'c':
+      return S_ISCHR(st.st_mode);
+   case 'd':
+      return S_ISDIR(st.st_mode);
+   case 'f':
+      return S_ISREG(st.st_mode);
+   case 'g':
+      return (st.st_mode & S_ISGID) != 0;
+   case 'p':
+      return S_ISFIFO(st.st_mode);
+   case 'S':
+      return S_ISSOCK(st.st_mode);
+   case 's':
+      return st.st_size > 0;
+   case 'u':
+      return (st.st_mode & S_ISUID) != 0;
+   default: // 'e'
+      return 1;
+   }
+}
+
+/**
+ * @brief Evaluate a binary primary such as `A -lt B`
+ */
+static int test_binary(TestState* t, const char* a, const char* op, const char* b) {
+   if (strcmp(op, "=") == 0) return strcmp(a, b) == 0;
+   if (strcmp(op, "!=") == 0) return strcmp(a, b) != 0;
+
+   if (op[1] == 'n' || op[1] == 'o' || strcmp(op, "-ef") == 0) {
+      struct stat sa, sb;
+      int ha = stat(a, &sa) == 0;
+      int hb = stat(b, &sb) == 0;
+      if (strcmp(op, "-ef") == 0) {
+         return ha && hb && sa.st_dev == sb.st_dev && sa.st_ino == sb.st_ino;
+      }
+      if (strcmp(op, "-nt") == 0) return ha && (!hb || sa.st_mtime > sb.st_mtime);
+      return hb && (!ha || sa.st_mtime < sb.st_mtime); // -ot
+   }
+
+   long long x = test_integer(t, a);
+   long long y = test_integer(t, b);
+   if (strcmp(op, "-eq") == 0) return x == y;
+   if (strcmp(op, "-ne") == 0) return x != y;
+   if (strcmp(op, "-lt") == 0) return x < y;
+   if (strcmp(op, "-le") == 0) return x <= y;
+   if (strcmp(op, "-gt") == 0) return x > y;
+   return x >= y; // -ge
+}
+
+static int test_or(TestState* t);
+
+/**
+ * @brief primary: `( expr )` | unary-op ARG | ARG binary-op ARG | ARG
+ */
+static int test_primary(TestState* t) {
+   if (t->pos >= t->argc) {
+      fprintf(stderr, "test: argument expected\n");
+      t->error = 1;
+      return 0;
+   }
+   char* const* a = t->argv + t->pos;
+   int left = t->argc - t->pos;
+
+   if (left >= 3 && test_is_binary(a[1])) {
+      t->pos += 3;
+      return test_binary(t, a[0], a[1], a[2]);
+   }
+   if (strcmp(a[0], "(") == 0 && left >= 2) {
+      t->pos++;
+      int v = test_or(t);
+      if (t->pos >= t->argc || strcmp(t->argv[t->pos], ")") != 0) {
+         fprintf(stderr, "test: `)' expected\n");
+         t->error = 1;
+         return 0;
+      }
+      t->pos++;
+      return v;
+   }
+   if (left >= 2 && test_is_unary(a[0])) {
+      t->pos += 2;
+      return test_unary(t, a[0][1], a[1]);
+   }
+   t->pos++;
+   return a[0][0] != '\0';
+}
+
+/**
+ * @brief not: `!` not | primary
+ */
+static int test_not(TestState* t) {
+   // `! = x` compares "!" with "x"; only a leading `!` that is not an operand negates
+   if (t->pos < t->argc && strcmp(t->argv[t->pos], "!") == 0 &&
+       !(t->argc - t->pos == 3 && test_is_binary(t->argv[t->pos + 1])) && t->argc - t->pos > 1) {
+      t->pos++;
+      return !test_not(t);
+   }
+   return test_primary(t);
+}
+
+/**
+ * @brief and: not { `-a` not }
+ */
+static int test_and(TestState* t) {
+   int v = test_not(t);
+   while (t->pos < t->argc && strcmp(t->argv[t->pos], "-a") == 0) {
+      t->pos++;
+      int rhs = test_not(t);
+      v = v && rhs;
+   }
+   return v;
+}
+
+/**
+ * @brief or: and { `-o` and }
+ */
+static int test_or(TestState* t) {
+   int v = test_and(t);
+   while (t->pos < t->argc && strcmp(t->argv[t->pos], "-o") == 0) {
+      t->pos++;
+      int rhs = test_and(t);
+      v = v || rhs;
+   }
+   return v;
+}
+
+/**
+ * @brief `test EXPR` and `[ EXPR ]`
+ *
+ * @return 0 if true, 1 if false, 2 on error
+ */
+static int builtin_test(char* const argv[]) {
+   int argc = 0;
+   while (argv[argc]) {
+      argc++;
+   }
+   if (strcmp(argv[0], "[") == 0) {
+      if (strcmp(argv[argc - 1], "]") != 0) {
+         fprintf(stderr, "[: missing `]'\n");
+         return 2;
+      }
+      argc--;
+   }
+
+   TestState t = {argv + 1, argc - 1, 0, 0};
+   if (t.argc == 0) return 1;
+   int v = test_or(&t);
+   if (!t.error && t.pos < t.argc) {
+      fprintf(stderr, "test: %s: unexpected operator\n", t.argv[t.pos]);
+      t.error = 1;
+   }
+   if (t.error) return 2;
+   return v ? 0 : 1;
+}
+
+// ----------------------------------------------------------------------------
+// cat
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Copy one open input to the output
+ *
+ * @param in_fd
+ * @param name Name for error messages
+ * @param out_fd
+ * @param err_fd
+ * @return int 0 on success, 1 on error, -1 when the copy must stop (reader gone, Ctrl-C or Ctrl-Z)
+ */
+static int cat_one(int in_fd, const char* name, int out_fd, int err_fd) {
+   struct stat in_st, out_st;
+   if (fstat(in_fd, &in_st) == 0 && fstat(out_fd, &out_st) == 0 && S_ISREG(in_st.st_mode) &&
+       S_ISREG(out_st.st_mode) && in_st.st_dev == out_st.st_dev && in_st.st_ino == out_st.st_ino) {
+      dprintf(err_fd, "cat: %s: input file is output file\n", name);
+      return 1;
+   }
+
+   FdCopyMethod method;
+   long long n = fd_copy(in_fd, out_fd, &shell_stop_signal, &method);
+   if (n < 0) {
+      if (errno == EPIPE || errno == EINTR) return -1;
+      dprintf(err_fd, "cat: %s: %s\n", name, strerror(errno));
+      return 1;
+   }
+   DEBUG_EXEC("cat: %s: %lld bytes (method %d)", name, n, method);
+   return 0;
+}
+
+/**
+ * @brief Fork a child to finish a copy stopped by Ctrl-Z
+ *
+ * The child joins the stopped foreground group, or leads a group of its own when the copy was the
+ * whole command. It shares the open input, and with it the file offset, so it carries on from the
+ * byte the shell stopped at once `fg` continues it.
+ *
+ * @return pid_t 0 in the child once it is continued, the child's pid in the shell, -1 on error
+ */
+static pid_t cat_handoff(void) {
+   pid_t pgid = foreground_pgid;
+   pid_t pid = fork();
+   if (pid < 0) {
+      DEBUG_EXEC("fork() failed (cat_handoff): %s", strerror(errno));
+      return -1;
+   }
+
+   if (pid == 0) {
+      setpgid(0, pgid);
+      signal(SIGINT, SIG_DFL);
+      signal(SIGTSTP, SIG_DFL);
+      signal(SIGPIPE, SIG_DFL);
+      sigset_t empty;
+      sigemptyset(&empty);
+      sigprocmask(SIG_SETMASK, &empty, NULL);
+      shell_stop_signal = 0;
+
+      // Stay stopped, as a cat sent the same Ctrl-Z would, until the job is continued
+      kill(getpid(), SIGTSTP);
+      return 0;
+   }
+
+   // Both sides set the group so the job's pgid is right whichever runs first
+   setpgid(pid, pgid);
+   return pid;
+}
+
+/**
+ * @brief Copy each file operand in turn, or @p in_fd when there are none
+ *
+ * @param in_fd Input standing in for stdin
+ * @param operands Files to copy, NULL-terminated
+ * @param out_fd
+ * @param err_fd
+ * @param rest Set to the child finishing the copy when Ctrl-Z stops it (NULL to just stop)
+ * @return int 0 on success, 1 if any file failed, 128 + SIGINT after Ctrl-C; never returns in the
+ * child
+ */
+static int cat_inputs(int in_fd, char* const operands[], int out_fd, int err_fd, pid_t* rest) {
+   int count = 0;
+   while (operands[count]) count++;
+
+   int status = 0;
+   int child = 0;
+   for (int i = 0; i < (count ? count : 1); i++) {
+      const char* name = count ? operands[i] : "-";
+      int fd = count ? open(operands[i], O_RDONLY | O_CLOEXEC) : in_fd;
+      if (fd < 0) {
+         dprintf(err_fd, "cat: %s: %s\n", name, strerror(errno));
+         status = 1;
+         continue;
+      }
+      int rc = cat_one(fd, name, out_fd, err_fd);
+      if (rc == -1 && rest && shell_stop_signal == SIGTSTP) {
+         pid_t pid = cat_handoff();
+         if (pid == 0) {
+            // Pick the copy up again from the same offset, and the remaining files after it
+            child = 1;
+            rest = NULL;
+            rc = cat_one(fd, name, out_fd, err_fd);
+         } else {
+            *rest = pid;
+         }
+      }
+      if (count) close(fd);
+      if (rc == -1) {
+         // Stopped by Ctrl-C the copy fails the way a killed cat would
+         if (shell_stop_signal == SIGINT) status = 128 + SIGINT;
+         break;
+      }
+      if (rc == 1) status = 1;
+   }
+   if (child) _exit(status);
+   return status;
+}
+
+// ============================================================================
+// Static Globals
+// ============================================================================
+
+/** @brief Builtins at their perfect-hash slots (see BUILTIN_HASH_SEED) */
+static const Builtin builtin_table[BUILTIN_SLOTS] = {
+    [4] = {"submit", builtin_submit},
+    [5] = {"class", builtin_class},
+    [6] = {"return", builtin_return},
+    [9] = {"continue", builtin_break},
+    [10] = {"dag", builtin_dag},
+    [11] = {"bg", builtin_bg},
+    [13] = {":", builtin_true},
+    [14] = {"jobs", builtin_jobs},
+    [16] = {"set", builtin_set},
+    [18] = {"break", builtin_break},
+    [20] = {"cd", builtin_cd},
+    [23] = {"fg", builtin_fg},
+    [27] = {"queue", builtin_queue},
+    [32] = {"printf", builtin_printf},
+    [35] = {"unset", builtin_unset},
+    [37] = {"test", builtin_test},
+    [39] = {"false", builtin_false},
+    [44] = {"echo", builtin_echo},
+    [46] = {"hash", builtin_hash},
+    [47] = {"pwd", builtin_pwd},
+    [49] = {"exit", builtin_exit},
+    [51] = {"parallel", builtin_parallel},
+    [52] = {"export", builtin_export},
+    [53] = {"[", builtin_test},
+    [56] = {"true", builtin_true},
+    [58] = {"xargs", builtin_xargs},
+    [59] = {"wait", builtin_wait},
+    [60] = {"kill", builtin_kill},
+};
+
+// ============================================================================
+// Public Functions
+// ============================================================================
+
+unsigned builtin_slot(const char* name) {
+   // FNV-1a with a seeded offset basis
+   uint32_t h = 2166136261u ^ BUILTIN_HASH_SEED;
+   for (const unsigned char* p = (const unsigned char*)name; *p; p++) {
+      h ^= *p;
+      h *= 16777619u;
+   }
+   // The top bits: the low bits of FNV-1a only ever see the low bits of the seed
+   return h >> (32 - BUILTIN_SLOT_BITS);
+}
+
+const Builtin* builtin_at(unsigned slot) {
+   if (slot >= BUILTIN_SLOTS || !builtin_table[slot].name) return NULL;
+   return &builtin_table[slot];
+}
+
+const Builtin* builtin_find(const char* name) {
+   if (!name) return NULL;
+   const Builtin* b = &builtin_table[builtin_slot(name)];
+   return b->name && strcmp(b->name, name) == 0 ? b : NULL;
+}
+
+int builtin_cat_eligible(const Command* cmd) {
+   if (!cmd || !cmd->argv[0] || strcmp(cmd->argv[0], "cat") != 0 || cmd->background) return 0;
+   for (int i = 1; cmd->argv[i]; i++) {
+      // Options (and `-` for stdin) are left to the real cat
+      if (cmd->argv[i][0] == '-') return 0;
+   }
+   // With no operands cat reads stdin, which must not be the shell's own input
+   return cmd->argv[1] || cmd->in_file;
+}
+
+int builtin_cat(char* const argv[], const Redirects* fds, pid_t* rest) {
+   int in_fd = fds->in_fd != -1 ? fds->in_fd : STDIN_FILENO;
+   int out_fd = fds->out_fd != -1 ? fds->out_fd : STDOUT_FILENO;
+   int err_fd = fds->err_fd != -1 ? fds->err_fd : STDERR_FILENO;
+
+   // Anything the shell printed must come out before the copied bytes
+   fflush(stdout);
+
+   // A reader that exits early must not take the shell down with SIGPIPE
+   struct sigaction ignore, saved;
+   memset(&ignore, 0, sizeof(ignore));
+   ignore.sa_handler = SIG_IGN;
+   sigemptyset(&ignore.sa_mask);
+   sigaction(SIGPIPE, &ignore, &saved);
+   shell_interrupted = 0;
+   shell_stop_signal = 0;
+
+   int status = cat_inputs(in_fd, &argv[1], out_fd, err_fd, rest);
+
+   // shell_interrupted stays set after Ctrl-C so the rest of the list and any loop stop as well
+   sigaction(SIGPIPE, &saved, NULL);
+   shell_stop_signal = 0;
+   return status;
+}
@@ -0,0 +1,582 @@
+/**
+ * @file dag.c
+ * @author Nathan Lemma
+ * @brief Dependency-graph task runner for the YASH shell
+ * @date 10-17-2026
+ * @details This file contains the task-file reader, the scheduler and the `dag` builtin. Tasks
+ * are kept in file order with their dependencies as indexes, and the reverse edges in one array
+ * grouped by task, so finishing a task touches only the tasks that wait for it. A task whose
+ * last dependency succeeds goes on a FIFO of ready tasks; the scheduler starts them through
+ * execute_line() as background jobs, sleeps on child events like `parallel` and reaps each
+ * task's job from the job table when it is done. Tasks behind a failure are never made ready.
+ */
+
+// ============================================================================
+// Includes
+// ============================================================================
+
+#include "../include/dag.h"
+#include "../include/admit.h"
+#include "../include/debug.h"
+#include "../include/events.h"
+#include "../include/exec.h"
+#include "../include/jobs.h"
+#include "../include/parse.h"
+#include "../include/queue.h"
+#include <errno.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// ============================================================================
+// Constants
+// ============================================================================
+
+/** @brief Exit status of a task whose command could not be started */
+#define DAG_NOT_STARTED 127
+
+/** @brief Widest task name column in the report */
+#define DAG_NAME_WIDTH 32
+
+// ============================================================================
+// Data Structures
+// ============================================================================
+
+/**
+ * @brief State of dag_load() while the dependencies are still names
+ */
+typedef struct Loader {
+   const char* path; ///< Task file, for messages
+   int cap;          ///< Entries allocated in the task and deps arrays
+   char** deps;      ///< Per task, the text after its colon (heap allocated)
+} Loader;
+
+// ============================================================================
+// Static Functions
+// ============================================================================
+
+/**
+ * @brief CLOCK_MONOTONIC in seconds
+ * @return double
+ */
+static double now_seconds(void) {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Report a task-file error on stderr
+ * @param l
+ * @param lineno Line of the file it is on, 0 for one about the file as a whole
+ * @param fmt
+ * @return -1
+ */
+static int load_error(const Loader* l, int lineno, const char* fmt, ...) {
+   va_list ap;
+   va_start(ap, fmt);
+   if (lineno > 0) {
+      fprintf(stderr, "dag: %s:%d: ", l->path, lineno);
+   } else {
+      fprintf(stderr, "dag: %s: ", l->path);
+   }
+   vfprintf(stderr, fmt, ap);
+   fputc('\n', stderr);
+   va_end(ap);
+   return -1;
+}
+
+/**
+ * @brief Order tasks by name
+ * @param a DagTask**
+ * @param b DagTask**
+ * @return int
+ */
+static int by_name(const void* a, const void* b) {
+   return strcmp((*(DagTask* const*)a)->name, (*(DagTask* const*)b)->name);
+}
+
+/**
+ * @brief Add a task from a header line
+ * @param dag
+ * @param l
+ * @param name
+ * @param deps Text after the colon
+ * @return 0 on success, -1 if out of memory
+ */
+static int add_task(Dag* dag, Loader* l, const char* name, const char* deps) {
+   if (dag->num_tasks == l->cap) {
+      int cap = l->cap ? l->cap * 2 : 16;
+      DagTask* tasks = realloc(dag->tasks, cap * sizeof(DagTask));
+      if (tasks) dag->tasks = tasks;
+      char** texts = realloc(l->deps, cap * sizeof(char*));
+      if (texts) l->deps = texts;
+      if (!tasks || !texts) return -1;
+      l->cap = cap;
+   }
+   DagTask* t = &dag->tasks[dag->num_tasks];
+   memset(t, 0, sizeof(*t));
+   t->name = strdup(name);
+   l->deps[dag->num_tasks] = strdup(deps);
+   dag->num_tasks++;
+   return t->name && l->deps[dag->num_tasks - 1] ? 0 : -1;
+}
+
+/**
+ * @brief Read the header and command lines of a task file
+ * @param dag
+ * @param l
+ * @param f
+ * @return 0 on success, -1 (reported) otherwise
+ */
+static int read_tasks(Dag* dag, Loader* l, FILE* f) {
+   char* buf = NULL;
+   size_t size = 0;
+   int lineno = 0;
+   int result = 0;
+   while (result == 0 && getline(&buf, &size, f) != -1) {
+      lineno++;
+      buf[strcspn(buf, "\r\n")] = '\0';
+      char* text = buf + strspn(buf, " \t");
+      if (!*text || *text == '#') continue;
+
+      if (text != buf) {
+         // Indented: the command of the task above
+         DagTask* t = dag->num_tasks ? &dag->tasks[dag->num_tasks - 1] : NULL;
+         if (!t) {
+            result = load_error(l, lineno, "command line outside a task");
+         } else if (t->cmdline) {
+            result = load_error(l, lineno, "task %s has more than one command line", t->name);
+         } else if (!(t->cmdline = strdup(text))) {
+            result = load_error(l, lineno, "%s", strerror(ENOMEM));
+         }
+         continue;
+      }
+
+      char* colon = strchr(text, ':');
+      if (!colon) {
+         result = load_error(l, lineno, "expected NAME: [DEPENDENCY...]");
+         continue;
+      }
+      *colon = '\0';
+      size_t len = strlen(text);
+      while (len > 0 && (text[len - 1] == ' ' || text[len - 1] == '\t')) {
+         text[--len] = '\0';
+      }
+      if (len == 0 || strpbrk(text, " \t")) {
+         result = load_error(l, lineno, "invalid task name '%s'", text);
+      } else if (add_task(dag, l, text, colon + 1) == -1) {
+         result = load_error(l, lineno, "%s", strerror(ENOMEM));
+      }
+   }
+   free(buf);
+   if (result == 0 && ferror(f)) result = load_error(l, 0, "%s", strerror(errno));
+   if (result == 0 && dag->num_tasks == 0) result = load_error(l, 0, "no tasks");
+   return result;
+}
+
+/**
+ * @brief Turn each task's dependency names into indexes and build the reverse edges
+ * @param dag
+ * @param l
+ * @return 0 on success, -1 (reported) otherwise
+ */
+static int link_tasks(Dag* dag, Loader* l) {
+   int n = dag->num_tasks;
+   DagTask** sorted = malloc(n * sizeof(DagTask*));
+   dag->users_at = calloc(n + 1, sizeof(int));
+   if (!sorted || !dag->users_at) {
+      free(sorted);
+      return load_error(l, 0, "%s", strerror(ENOMEM));
+   }
+   for (int i = 0; i < n; i++) {
+      sorted[i] = &dag->tasks[i];
+   }
+   qsort(sorted, n, sizeof(DagTask*), by_name);
+
+   int result = 0;
+   for (int i = 1; i < n && result == 0; i++) {
+      if (strcmp(sorted[i - 1]->name, sorted[i]->name) == 0) {
+         result = load_error(l, 0, "duplicate task %s", sorted[i]->name);
+      }
+   }
+
+   for (int i = 0; i < n && result == 0; i++) {
+      DagTask* t = &dag->tasks[i];
+      int words = 0;
+      for (const char* p = l->deps[i]; *p; p++) {
+         words += (*p != ' ' && *p != '\t') && (p[1] == ' ' || p[1] == '\t' || !p[1]);
+      }
+      t->deps = malloc((words ? words : 1) * sizeof(int));
+      if (!t->deps) {
+         result = load_error(l, 0, "%s", strerror(ENOMEM));
+         break;
+      }
+      char* save = NULL;
+      for (char* name = strtok_r(l->deps[i], " \t", &save); name && result == 0;
+           name = strtok_r(NULL, " \t", &save)) {
+         DagTask key = {.name = name};
+         DagTask* keyp = &key;
+         DagTask** found = bsearch(&keyp, sorted, n, sizeof(DagTask*), by_name);
+         if (!found) {
+            result = load_error(l, 0, "task %s: unknown dependency %s", t->name, name);
+            break;
+         }
+         int dep = (int)(*found - dag->tasks);
+         t->deps[t->num_deps++] = dep;
+         dag->users_at[dep + 1]++;
+      }
+   }
+   free(sorted);
+   if (result == -1) return -1;
+
+   // Prefix sums give each task's slice of users; fill them in with a moving cursor per task
+   for (int i = 0; i < n; i++) {
+      dag->users_at[i + 1] += dag->users_at[i];
+   }
+   dag->users = malloc((dag->users_at[n] ? dag->users_at[n] : 1) * sizeof(int));
+   int* cursor = malloc(n * sizeof(int));
+   if (!dag->users || !cursor) {
+      free(cursor);
+      return load_error(l, 0, "%s", strerror(ENOMEM));
+   }
+   memcpy(cursor, dag->users_at, n * sizeof(int));
+   for (int i = 0; i < n; i++) {
+      for (int k = 0; k < dag->tasks[i].num_deps; k++) {
+         dag->users[cursor[dag->tasks[i].deps[k]]++] = i;
+      }
+   }
+   free(cursor);
+   return 0;
+}
+
+/**
+ * @brief Check that the graph has no cycle (Kahn's algorithm, dry run) and every command parses
+ * @param dag
+ * @param l
+ * @return 0 on success, -1 (reported) otherwise
+ */
+static int check_tasks(Dag* dag, Loader* l) {
+   int n = dag->num_tasks;
+   int* order = dag->ready;
+   int head = 0;
+   int tail = 0;
+   for (int i = 0; i < n; i++) {
+      dag->tasks[i].unfinished = dag->tasks[i].num_deps;
+      if (dag->tasks[i].unfinished == 0) order[tail++] = i;
+   }
+   while (head < tail) {
+      int i = order[head++];
+      for (int k = dag->users_at[i]; k < dag->users_at[i + 1]; k++) {
+         if (--dag->tasks[dag->users[k]].unfinished == 0) order[tail++] = dag->users[k];
+      }
+   }
+   if (tail < n) {
+      for (int i = 0; i < n; i++) {
+         if (dag->tasks[i].unfinished > 0) {
+            return load_error(l, 0, "dependency cycle through %s", dag->tasks[i].name);
+         }
+      }
+   }
+
+   // One Line for every check, so its arena is reused
+   Line line;
+   memset(&line, 0, sizeof(line));
+   int result = 0;
+   for (int i = 0; i < n && result == 0; i++) {
+      DagTask* t = &dag->tasks[i];
+      if (!t->cmdline) continue;
+      // A task runs as one job, which a command list or compound command is not
+      if (parse_line(t->cmdline, &line) != 0 || line.submit_at || line.next || line.compound) {
+         result = load_error(l, 0, "task %s: invalid command line: %s", t->name, t->cmdline);
+      }
+   }
+   line_free(&line);
+   return result;
+}
+
+/**
+ * @brief Move a task to another state, keeping the counts in step
+ * @param dag
+ * @param t
+ * @param state
+ */
+static void set_state(Dag* dag, DagTask* t, DagState state) {
+   dag->counts[t->state]--;
+   dag->counts[state]++;
+   t->state = state;
+}
+
+/**
+ * @brief Record that a task has finished and make ready the tasks it was the last one to hold up
+ * @param dag
+ * @param i
+ * @param exit_code
+ * @param now
+ */
+static void finish_task(Dag* dag, int i, int exit_code, double now) {
+   DagTask* t = &dag->tasks[i];
+   t->exit_code = exit_code;
+   t->finished = now;
+   set_state(dag, t, exit_code == 0 ? DAG_DONE : DAG_FAILED);
+   DEBUG_JOBS("dag task %s finished with %d", t->name, exit_code);
+
+   // Every dependency succeeded, so each one's chain is known
+   t->path_prev = -1;
+   double longest = 0;
+   for (int k = 0; k < t->num_deps; k++) {
+      const DagTask* dep = &dag->tasks[t->deps[k]];
+      if (t->path_prev == -1 || dep->path > longest) {
+         t->path_prev = t->deps[k];
+         longest = dep->path;
+      }
+   }
+   t->path = longest + (t->finished - t->started);
+
+   if (t->state != DAG_DONE) return;
+   for (int k = dag->users_at[i]; k < dag->users_at[i + 1]; k++) {
+      int u = dag->users[k];
+      if (--dag->tasks[u].unfinished == 0) dag->ready[dag->ready_tail++] = u;
+   }
+}
+
+/**
+ * @brief Launch a ready task as a background job (a task without a command finishes at once)
+ * @param dag
+ * @param i
+ */
+static void start_task(Dag* dag, int i) {
+   DagTask* t = &dag->tasks[i];
+   t->started = now_seconds();
+   if (!t->cmdline) {
+      finish_task(dag, i, 0, t->started);
+      return;
+   }
+
+   Line line;
+   memset(&line, 0, sizeof(line));
+   // A launch that adds no background job (command not found, bad class) never ran
+   pid_t before = jobs_last_background();
+   pid_t pgid = before;
+   if (parse_line(t->cmdline, &line) == 0) {
+      line.timed = 0;
+      for (int k = 0; k < line.num_stages; k++) {
+         line.stages[k].background = 1;
+      }
+      admit_launch(&line);
+      pgid = jobs_last_background();
+   }
+   line_free(&line);
+
+   if (pgid == before) {
+      finish_task(dag, i, DAG_NOT_STARTED, now_seconds());
+      return;
+   }
+   t->job_id = jobs_find_pgid(pgid);
+   set_state(dag, t, DAG_RUNNING);
+   dag->running[dag->num_running++] = i;
+   DEBUG_JOBS("dag task %s started as group %d", t->name, (int)pgid);
+}
+
+/**
+ * @brief Pick up child events and finish the tasks whose jobs are done
+ * @param dag
+ * @return Number of tasks finished
+ */
+static int reap_tasks(Dag* dag) {
+   jobs_collect();
+   int reaped = 0;
+   for (int k = 0; k < dag->num_running;) {
+      int i = dag->running[k];
+      int job_id = dag->tasks[i].job_id;
+      if (jobs_get_status(job_id) != JOB_DONE) {
+         k++;
+         continue;
+      }
+      dag->running[k] = dag->running[--dag->num_running];
+      int code = jobs_reap_job(job_id);
+      finish_task(dag, i, code < 0 ? DAG_NOT_STARTED : code, now_seconds());
+      reaped++;
+   }
+   return reaped;
+}
+
+// ============================================================================
+// Public Functions
+// ============================================================================
+
+int dag_load(const char* path, Dag* dag) {
+   memset(dag, 0, sizeof(*dag));
+   Loader l = {path, 0, NULL};
+   FILE* f = fopen(path, "re");
+   if (!f) return load_error(&l, 0, "%s", strerror(errno));
+
+   int result = read_tasks(dag, &l, f);
+   fclose(f);
+   if (result == 0) {
+      dag->ready = malloc(dag->num_tasks * sizeof(int));
+      dag->running = malloc(dag->num_tasks * sizeof(int));
+      if (!dag->ready || !dag->running) result = load_error(&l, 0, "%s", strerror(ENOMEM));
+   }
+   if (result == 0) result = link_tasks(dag, &l);
+   if (result == 0) result = check_tasks(dag, &l);
+
+   for (int i = 0; i < dag->num_tasks; i++) {
+      free(l.deps[i]);
+   }
+   free(l.deps);
+   if (result == -1) {
+      dag_free(dag);
+      return -1;
+   }
+
+   // Every task starts out waiting; those with no dependencies are ready at once
+   dag->counts[DAG_WAITING] = dag->num_tasks;
+   for (int i = 0; i < dag->num_tasks; i++) {
+      DagTask* t = &dag->tasks[i];
+      t->state = DAG_WAITING;
+      t->unfinished = t->num_deps;
+      t->path_prev = -1;
+      if (t->num_deps == 0) dag->ready[dag->ready_tail++] = i;
+   }
+   return 0;
+}
+
+int dag_run(Dag* dag, int max) {
+   int interrupted = 0;
+   shell_interrupted = 0;
+   while (1) {
+      while (!shell_interrupted && dag->num_running < max && dag->ready_head < dag->ready_tail) {
+         start_task(dag, dag->ready[dag->ready_head++]);
+      }
+      if (dag->num_running == 0) break;
+
+      if (shell_interrupted && !interrupted) {
+         // Each task leads its own group, out of reach of the shell's forwarding
+         for (int k = 0; k < dag->num_running; k++) {
+            pid_t pgid = jobs_get_pgid(dag->tasks[dag->running[k]].job_id);
+            if (pgid > 0) kill(-pgid, SIGINT);
+         }
+         interrupted = 1;
+      }
+      int reaped = reap_tasks(dag);
+      queue_schedule();
+      if (reaped == 0) {
+         events_set_timer(jobs_enforce_budgets());
+         events_wait_child(-1);
+      }
+   }
+   if (shell_interrupted) interrupted = 1;
+   shell_interrupted = 0;
+
+   // What never became ready sits behind a failure (or Ctrl-C stopped the run)
+   for (int i = 0; i < dag->num_tasks; i++) {
+      if (dag->tasks[i].state == DAG_WAITING) set_state(dag, &dag->tasks[i], DAG_CANCELLED);
+   }
+   if (interrupted) return 130;
+   return dag->counts[DAG_DONE] == dag->num_tasks ? 0 : 1;
+}
+
+void dag_report(const Dag* dag, double seconds) {
+   int n = dag->num_tasks;
+
+   // The critical path is the chain of tasks with the longest total wall time
+   int end = -1;
+   for (int i = 0; i < n; i++) {
+      const DagTask* t = &dag->tasks[i];
+      if (t->state != DAG_DONE && t->state != DAG_FAILED) continue;
+      if (end == -1 || t->path > dag->tasks[end].path) end = i;
+   }
+   int* chain = malloc(n * sizeof(int));
+   char* on_path = calloc(n, 1);
+   int length = 0;
+   for (int i = end; chain && on_path && i != -1; i = dag->tasks[i].path_prev) {
+      chain[length++] = i;
+      on_path[i] = 1;
+   }
+
+   int width = 4;
+   for (int i = 0; i < n; i++) {
+      int len = (int)strlen(dag->tasks[i].name);
+      if (len > width) width = len < DAG_NAME_WIDTH ? len : DAG_NAME_WIDTH;
+   }
+   fprintf(stderr, "  %-*s  %-9s %9s\n", width, "TASK", "STATUS", "WALL");
+   for (int i = 0; i < n; i++) {
+      const DagTask* t = &dag->tasks[i];
+      char state[16] = "cancelled";
+      char wall[16] = "-";
+      if (t->state == DAG_DONE || t->state == DAG_FAILED) {
+         if (t->state == DAG_DONE) {
+            snprintf(state, sizeof(state), "done");
+         } else {
+            snprintf(state, sizeof(state), "exit %d", t->exit_code);
+         }
+         snprintf(wall, sizeof(wall), "%.3fs", t->finished - t->started);
+      }
+      fprintf(stderr,
+              "%c %-*s  %-9s %9s\n",
+              on_path && on_path[i] ? '*' : ' ',
+              width,
+              t->name,
+              state,
+              wall);
+   }
+
+   fprintf(stderr,
+           "dag: %d tasks, %d done, %d failed, %d cancelled in %.3fs\n",
+           n,
+           dag->counts[DAG_DONE],
+           dag->counts[DAG_FAILED],
+           dag->counts[DAG_CANCELLED],
+           seconds);
+   if (length > 0) {
+      fprintf(stderr, "dag: critical path %.3fs:", dag->tasks[end].path);
+      for (int k = length - 1; k >= 0; k--) {
+         fprintf(stderr, "%s%s", k == length - 1 ? " " : " -> ", dag->tasks[chain[k]].name);
+      }
+      fputc('\n', stderr);
+   }
+   free(chain);
+   free(on_path);
+}
+
+void dag_free(Dag* dag) {
+   for (int i = 0; i < dag->num_tasks; i++) {
+      free(dag->tasks[i].name);
+      free(dag->tasks[i].cmdline);
+      free(dag->tasks[i].deps);
+   }
+   free(dag->tasks);
+   free(dag->users);
+   free(dag->users_at);
+   free(dag->ready);
+   free(dag->running);
+   memset(dag, 0, sizeof(*dag));
+}
+
+int builtin_dag(char* const argv[]) {
+   long jobs = sysconf(_SC_NPROCESSORS_ONLN);
+   int i = 1;
+   char* end = NULL;
+   if (argv[i] && strcmp(argv[i], "-j") == 0 && argv[i + 1] &&
+       (jobs = strtol(argv[i + 1], &end, 10)) > 0 && !*end) {
+      i += 2;
+   }
+   if (!argv[i] || argv[i][0] == '-' || argv[i + 1]) {
+      fprintf(stderr, "dag: usage: dag [-j N] FILE\n");
+      return 2;
+   }
+   if (jobs <= 0) jobs = 1;
+
+   Dag dag;
+   if (dag_load(argv[i], &dag) == -1) return 2;
+   double start = now_seconds();
+   int result = dag_run(&dag, (int)jobs);
+   dag_report(&dag, now_seconds() - start);
+   dag_free(&dag);
+   return result;
+}
@@ -0,0 +1,356 @@
+/**
+ * @file events.c
+ * @author Nathan Lemma
+ * @brief Event loop sources for the YASH shell
+ * @date 10-17-2026
+ * @details This file contains the event sources the shell waits on between commands. On Linux
+ * SIGCHLD is blocked and delivered through a signalfd, and the input descriptor and the signalfd
+ * share one epoll set, so a child event can never arrive between a check and a blocking read.
+ * Other systems (and a failed signalfd) use the classic self-pipe: the SIGCHLD handler writes a
+ * byte and poll() watches the read end next to the input. Waiting for particular processes (the
+ * `wait` builtin) uses pidfds where the kernel has them. Job budgets wake the shell through a
+ * timerfd in the same set, or by cutting each wait short at the deadline.
+ */
+
+#define _DEFAULT_SOURCE // syscall() on glibc
+
+// ============================================================================
+// Includes
+// ============================================================================
+
+#include "../include/events.h"
+#include "../include/debug.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/syscall.h>
+#include <sys/timerfd.h>
+#endif
+
+// ============================================================================
+// Constants
+// ============================================================================
+
+/** @brief Longest events_wait_pids() sleeps without pidfds before the caller checks again */
+#define EVENTS_CHILD_TICK_MS 100
+
+// ============================================================================
+// Globals
+// ============================================================================
+
+static int input;             ///< Descriptor commands are read from
+static int input_pollable;    ///< 0 when epoll refuses the input (a regular file is always ready)
+static int child_fd = -1;     ///< signalfd, or the read end of the self-pipe
+static int wake_fd = -1;      ///< Write end of the self-pipe, -1 when using a signalfd
+static int use_signalfd;      ///< child_fd is a signalfd
+static int epoll_fd = -1;     ///< epoll set (Linux only)
+static int timer_fd = -1;     ///< timerfd in the epoll set (Linux only)
+static double timer_deadline; ///< When EVENT_TIMER is due, 0 when disarmed
+static int child_seen;        ///< A child event was drained outside events_wait()
+
+// ============================================================================
+// Static Functions
+// ============================================================================
+
+/**
+ * @brief Make a descriptor non-blocking and close-on-exec
+ * @param fd
+ */
+static void set_flags(int fd) {
+   fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+   fcntl(fd, F_SETFD, FD_CLOEXEC);
+}
+
+/**
+ * @brief Close every source and unblock SIGCHLD
+ */
+static void close_sources(void) {
+   if (use_signalfd) {
+      sigset_t mask;
+      sigemptyset(&mask);
+      sigaddset(&mask, SIGCHLD);
+      sigprocmask(SIG_UNBLOCK, &mask, NULL);
+   }
+   if (child_fd != -1) close(child_fd);
+   if (wake_fd != -1) close(wake_fd);
+   if (epoll_fd != -1) close(epoll_fd);
+   if (timer_fd != -1) close(timer_fd);
+   child_fd = wake_fd = epoll_fd = timer_fd = -1;
+   use_signalfd = 0;
+}
+
+/**
+ * @brief CLOCK_MONOTONIC in seconds
+ * @return double
+ */
+static double now_seconds(void) {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Shorten a wait so that it ends at the timer deadline when no timerfd will end it
+ * @param timeout_ms
+ * @return The timeout to use
+ */
+static int clamp_to_timer(int timeout_ms) {
+   if (timer_deadline <= 0 || timer_fd != -1) return timeout_ms;
+   double left = timer_deadline - now_seconds();
+   int ms = left > 0 ? (int)(left * 1000) + 1 : 0;
+   return timeout_ms < 0 || ms < timeout_ms ? ms : timeout_ms;
+}
+
+/**
+ * @brief Report EVENT_TIMER once the deadline has passed, and disarm the timer
+ * @return EVENT_TIMER or 0
+ */
+static int check_timer(void) {
+   if (timer_deadline <= 0 || now_seconds() < timer_deadline) return 0;
+   if (timer_fd != -1) {
+      unsigned long long expirations;
+      ssize_t n = read(timer_fd, &expirations, sizeof(expirations));
+      (void)n; // Not readable yet when the clock beat the timerfd by a hair
+   }
+   timer_deadline = 0;
+   return EVENT_TIMER;
+}
+
+/**
+ * @brief Read everything pending on the child source
+ */
+static void drain_child(void) {
+   char buf[256]; // Room for two signalfd_siginfo records
+   while (read(child_fd, buf, sizeof(buf)) > 0) {
+      // Intentionally empty - the caller reaps with waitpid
+   }
+}
+
+#ifdef __linux__
+/**
+ * @brief Switch SIGCHLD to a signalfd watched by epoll together with the input
+ * @return 0 on success, -1 to fall back to the self-pipe
+ */
+static int init_signalfd(void) {
+   sigset_t mask;
+   sigemptyset(&mask);
+   sigaddset(&mask, SIGCHLD);
+   int fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+   int ep = epoll_create1(EPOLL_CLOEXEC);
+   if (fd == -1 || ep == -1) {
+      DEBUG_PRINT("signalfd/epoll unavailable: %s", strerror(errno));
+      if (fd != -1) close(fd);
+      if (ep != -1) close(ep);
+      return -1;
+   }
+
+   struct epoll_event ev = {.events = EPOLLIN, .data.u32 = EVENT_CHILD};
+   epoll_ctl(ep, EPOLL_CTL_ADD, fd, &ev);
+
+   // Without a timerfd the waits are cut short at the deadline instead
+   timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+   ev.data.u32 = EVENT_TIMER;
+   if (timer_fd != -1 && epoll_ctl(ep, EPOLL_CTL_ADD, timer_fd, &ev) == -1) {
+      close(timer_fd);
+      timer_fd = -1;
+   }
+   ev.data.u32 = EVENT_INPUT;
+   // epoll refuses regular files (EPERM); they never block, so they are simply always ready
+   input_pollable = epoll_ctl(ep, EPOLL_CTL_ADD, input, &ev) == 0;
+
+   // Blocked only now, so a failure above leaves the handler in charge
+   sigprocmask(SIG_BLOCK, &mask, NULL);
+   child_fd = fd;
+   epoll_fd = ep;
+   use_signalfd = 1;
+   return 0;
+}
+
+/**
+ * @brief epoll_wait on the input and the signalfd
+ * @param timeout_ms
+ * @return EventKind bits, -1 on failure
+ */
+static int wait_epoll(int timeout_ms) {
+   struct epoll_event evs[3];
+   int n = epoll_wait(epoll_fd, evs, 3, input_pollable ? clamp_to_timer(timeout_ms) : 0);
+   if (n == -1) return -1;
+
+   int ready = input_pollable ? 0 : EVENT_INPUT;
+   for (int i = 0; i < n; i++) {
+      // The timer is reported through check_timer(), which also drains it
+      ready |= (int)evs[i].data.u32 & ~EVENT_TIMER;
+   }
+   return ready;
+}
+#endif
+
+#ifdef SYS_pidfd_open
+/**
+ * @brief poll() on a pidfd per process
+ * @param pids
+ * @param n
+ * @param timeout_ms
+ * @return As events_wait_pids(), or -2 when pidfds are unavailable
+ */
+static int wait_pidfds(const pid_t* pids, int n, int timeout_ms) {
+   struct pollfd* fds = malloc(n * sizeof(struct pollfd));
+   if (!fds) return -2;
+
+   int opened = 0;
+   int ready = 0;
+   for (; opened < n; opened++) {
+      int fd = (int)syscall(SYS_pidfd_open, pids[opened], 0);
+      if (fd == -1) {
+         // Already reaped: nothing to wait for
+         ready = errno == ESRCH ? 1 : -2;
+         break;
+      }
+      fds[opened] = (struct pollfd){fd, POLLIN, 0};
+   }
+   if (ready == 0) {
+      ready = poll(fds, n, timeout_ms);
+      if (ready > 0) ready = 1;
+   }
+
+   int saved = errno;
+   for (int i = 0; i < opened; i++) {
+      close(fds[i].fd);
+   }
+   free(fds);
+   errno = saved;
+   return ready;
+}
+#endif
+
+/**
+ * @brief poll() on the input and the self-pipe
+ * @param timeout_ms
+ * @return EventKind bits, -1 on failure
+ */
+static int wait_poll(int timeout_ms) {
+   struct pollfd fds[2] = {{input, POLLIN, 0}, {child_fd, POLLIN, 0}};
+   if (poll(fds, 2, clamp_to_timer(timeout_ms)) == -1) return -1;
+
+   // Hang-ups and errors are reported as input so the reader sees the EOF or the error
+   int ready = 0;
+   if (fds[0].revents) ready |= EVENT_INPUT;
+   if (fds[1].revents) ready |= EVENT_CHILD;
+   return ready;
+}
+
+// ============================================================================
+// Public Functions
+// ============================================================================
+
+int events_init(int input_fd) {
+   close_sources();
+   input = input_fd;
+   input_pollable = 1;
+
+#ifdef __linux__
+   if (init_signalfd() == 0) return 0;
+#endif
+
+   int fds[2];
+   if (pipe(fds) == -1) {
+      DEBUG_PRINT("self-pipe failed: %s", strerror(errno));
+      return -1;
+   }
+   set_flags(fds[0]);
+   set_flags(fds[1]);
+   child_fd = fds[0];
+   wake_fd = fds[1];
+   return 0;
+}
+
+int events_wait(int timeout_ms) {
+   // A child event consumed by a foreground wait is still news to the prompt
+   if (child_seen) timeout_ms = 0;
+   int ready;
+   do {
+#ifdef __linux__
+      ready = use_signalfd ? wait_epoll(timeout_ms) : wait_poll(timeout_ms);
+#else
+      ready = wait_poll(timeout_ms);
+#endif
+      // A signal (Ctrl-C at the prompt, or SIGCHLD on the self-pipe) only cuts the wait short
+   } while (ready == -1 && errno == EINTR);
+
+   if (ready == -1) return -1;
+   if (ready & EVENT_CHILD) drain_child();
+   if (child_seen) ready |= EVENT_CHILD;
+   child_seen = 0;
+   return ready | check_timer();
+}
+
+int events_wait_child(int timeout_ms) {
+   if (timeout_ms < 0 || timeout_ms > EVENTS_CHILD_TICK_MS) timeout_ms = EVENTS_CHILD_TICK_MS;
+   struct pollfd fds[2] = {{child_fd, POLLIN, 0}, {timer_fd, POLLIN, 0}};
+   int n;
+   do {
+      n = poll(fds, 2, clamp_to_timer(timeout_ms));
+   } while (n == -1 && errno == EINTR);
+
+   if (n == -1) return -1;
+   int ready = 0;
+   if (fds[0].revents) {
+      drain_child();
+      child_seen = 1;
+      ready |= EVENT_CHILD;
+   }
+   return ready | check_timer();
+}
+
+void events_set_timer(double deadline) {
+   timer_deadline = deadline;
+#ifdef __linux__
+   if (timer_fd == -1) return;
+   struct itimerspec its = {{0, 0}, {0, 0}};
+   if (deadline > 0) {
+      its.it_value.tv_sec = (time_t)deadline;
+      its.it_value.tv_nsec = (long)((deadline - (double)its.it_value.tv_sec) * 1e9);
+   }
+   timerfd_settime(timer_fd, TFD_TIMER_ABSTIME, &its, NULL);
+#endif
+}
+
+int events_wait_pids(const pid_t* pids, int n, int timeout_ms) {
+#ifdef SYS_pidfd_open
+   if (n > 0) {
+      int ready = wait_pidfds(pids, n, timeout_ms);
+      if (ready != -2) return ready;
+   }
+#else
+   (void)pids;
+   (void)n;
+#endif
+
+   // Any child event will do; the caller reaps and looks again. The wait is capped so that a
+   // notification that never comes (no events_init(), SIGCHLD unblocked) only costs a tick
+   if (timeout_ms < 0 || timeout_ms > EVENTS_CHILD_TICK_MS) timeout_ms = EVENTS_CHILD_TICK_MS;
+   struct pollfd fd = {child_fd, POLLIN, 0};
+   int n_ready = poll(&fd, 1, timeout_ms);
+   if (n_ready > 0) {
+      drain_child();
+      child_seen = 1;
+   }
+   return n_ready > 0 ? 1 : n_ready;
+}
+
+void events_notify_child(void) {
+   if (wake_fd == -1) return;
+   int saved = errno; // Called from the SIGCHLD handler
+   ssize_t n = write(wake_fd, "", 1);
+   (void)n; // A full pipe already has a wake-up pending
+   errno = saved;
+}
@@ -10,98 +10,450 @@
 // Includes
 // ============================================================================
 
+#define _GNU_SOURCE // F_SETPIPE_SZ / F_GETPIPE_SZ on Linux
+
 #include "../include/exec.h"
+#include "../include/admit.h"
+#include "../include/builtins.h"
 #include "../include/debug.h"
+#include "../include/events.h"
+#include "../include/funcs.h"
 #include "../include/jobs.h"
+#include "../include/launch.h"
+#include "../include/options.h"
+#include "../include/queue.h"
+#include "../include/rclass.h"
+#include "../include/vars.h"
 #include <errno.h>
 #include <fcntl.h>
+#include <fnmatch.h>
 #include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
 #include <sys/types.h>
 #include <sys/wait.h>
+#include <time.h>
 #include <unistd.h>
 
+// ============================================================================
+// Constants
+// ============================================================================
+
+/** @brief Consecutive "pipe full" samples before adaptive mode doubles a pipe */
+#define PIPE_GROW_STREAK 3
+
+/** @brief Longest pause between adaptive pipe samples, in nanoseconds */
+#define PIPE_SAMPLE_MAX_NS 20000000L
+
+// ============================================================================
+// Static Globals
+// ============================================================================
+
+static Flow flow = FLOW_NEXT; ///< Set by break, continue and return; FLOW_NEXT otherwise
+static int flow_levels;       ///< Loops break or continue still has to leave
+static int loop_depth;        ///< Loops running in the current function (or at top level)
+static int func_depth;        ///< Function calls running
+static int list_depth;        ///< execute_list() calls running
+static int sigint_death;      ///< A foreground stage was killed by SIGINT during this line
+
 // ============================================================================
 // Static Functions
 // ============================================================================
 
 /**
- * @brief Checks if the inputs work.
- * @note Didn't want to change setup_redirections()
+ * @brief Largest pipe capacity an unprivileged process may set
+ * @return long Value of /proc/sys/fs/pipe-max-size (1 MiB if unavailable)
+ */
+static long pipe_max_size(void) {
+   static long cached = 0;
+   if (cached == 0) {
+      cached = 1L << 20;
+      FILE* f = fopen("/proc/sys/fs/pipe-max-size", "r");
+      if (f) {
+         long v;
+         if (fscanf(f, "%ld", &v) == 1 && v > 0) cached = v;
+         fclose(f);
+      }
+   }
+   return cached;
+}
+
+/**
+ * @brief Set a pipe's capacity, capped at pipe-max-size
  *
- * @param c
- * @return int
+ * @param fd Either end of the pipe
+ * @param size Requested capacity in bytes (<= 0 leaves the pipe alone)
  */
-static int check_input_exists(const Command* c) {
-   if (!c || !c->in_file) return 0;
-   int fd = open(c->in_file, O_RDONLY);
-   if (fd < 0) return -1;
+static void set_pipe_capacity(int fd, long size) {
+#ifdef F_SETPIPE_SZ
+   if (size <= 0) return;
+   long max = pipe_max_size();
+   if (size > max) size = max;
+   if (fcntl(fd, F_SETPIPE_SZ, (int)size) < 0) {
+      DEBUG_EXEC("F_SETPIPE_SZ(%ld) failed: %s", size, strerror(errno));
+   }
+#else
+   (void)fd;
+   (void)size;
+#endif
+}
+
+#ifdef F_SETPIPE_SZ
+/**
+ * @brief Check whether a pipe is backing up and grow it if it has stayed so for a while
+ *
+ * The parent has already closed its copies of the pipe, so it is reopened through the reading
+ * stage's /proc/PID/fd/0 and matched against the inode recorded when it was created.
+ *
+ * @param reader Pid of the stage reading from the pipe
+ * @param ino Inode of the pipe
+ * @param streak Consecutive full samples so far (updated)
+ */
+static void sample_pipe(pid_t reader, ino_t ino, int* streak) {
+   char path[64];
+   snprintf(path, sizeof(path), "/proc/%d/fd/0", (int)reader);
+   int fd = open(path, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+   if (fd < 0) return;
+
+   struct stat st;
+   int queued = 0;
+   int cap = fcntl(fd, F_GETPIPE_SZ);
+   if (fstat(fd, &st) == 0 && st.st_ino == ino && cap > 0 &&
+       ioctl(fd, FIONREAD, &queued) == 0 && queued >= cap / 2) {
+      // The reader is falling behind, so the writer keeps running into a full pipe
+      if (++*streak >= PIPE_GROW_STREAK && cap < pipe_max_size()) {
+         DEBUG_EXEC("Growing pipe %lu from %d bytes", (unsigned long)ino, cap);
+         set_pipe_capacity(fd, (long)cap * 2);
+         *streak = 0;
+      }
+   } else {
+      *streak = 0;
+   }
    close(fd);
+}
+#endif
+
+/**
+ * @brief Exit status the way `$?` reports it
+ * @param status From waitpid()
+ * @return The exit code, or 128 plus the signal that killed or stopped the process
+ */
+static int exit_status(int status) {
+   if (WIFEXITED(status)) return WEXITSTATUS(status);
+   if (WIFSIGNALED(status)) return 128 + WTERMSIG(status);
+   if (WIFSTOPPED(status)) return 128 + WSTOPSIG(status);
    return 0;
 }
 
 /**
- * @brief Set up redirections. Didn't wanna rewrite it 3 times
+ * @brief Note a foreground stage that Ctrl-C killed, for interrupted()
+ * @param status From waitpid()
+ */
+static void note_sigint(int status) {
+   if (WIFSIGNALED(status) && WTERMSIG(status) == SIGINT) sigint_death = 1;
+}
+
+/**
+ * @brief Earlier of two budget deadlines
+ * @param a CLOCK_MONOTONIC seconds, 0 for none
+ * @param b CLOCK_MONOTONIC seconds, 0 for none
+ * @return double
+ */
+static double earliest(double a, double b) {
+   return a == 0 || (b != 0 && b < a) ? b : a;
+}
+
+/**
+ * @brief Enforce every budget the shell is responsible for while a foreground pipeline runs
  *
- * @param cmd
- * @param p_in_fd
- * @param p_out_fd
+ * @param pids Stage pids (-1 for stages that have exited)
+ * @param n
+ * @param pgid
+ * @param usage Usage of the stages that have exited
+ * @param budget Budget of the pipeline, NULL for none
+ * @return CLOCK_MONOTONIC seconds of the next check, 0 for none
  */
-static void setup_redirections(const Command* cmd, int p_in_fd, int p_out_fd) {
+static double enforce_budgets(const pid_t* pids,
+                              int n,
+                              pid_t pgid,
+                              const JobUsage* usage,
+                              JobBudget* budget) {
+   double due = jobs_enforce_budgets();
+   if (!budget) return due;
+   return earliest(due, jobs_budget_check(budget, pgid, pids, n, usage->user + usage->sys));
+}
 
-   // Restore the regular signals so that the child process can be cancelled
-   signal(SIGINT, SIG_DFL);
-   signal(SIGTSTP, SIG_DFL); // Child should handle SIGTSTP with default behavior
-   signal(SIGPIPE, SIG_DFL);
+/**
+ * @brief Reap the children that are not stages of the foreground pipeline and update their jobs
+ *
+ * Each child is looked at with WNOWAIT first, so a stage is left for the caller to reap.
+ *
+ * @param pids Stage pids (-1 for stages that have exited)
+ * @param n
+ */
+static void collect_background(const pid_t* pids, int n) {
+   while (1) {
+      siginfo_t info;
+      info.si_pid = 0;
+      if (waitid(P_ALL, 0, &info, WEXITED | WSTOPPED | WCONTINUED | WNOHANG | WNOWAIT) == -1 ||
+          info.si_pid == 0) {
+         return;
+      }
+      for (int i = 0; i < n; i++) {
+         if (pids[i] == info.si_pid) return;
+      }
+      int status = 0;
+      JobUsage usage = {0};
+      if (jobs_wait(info.si_pid, &status, WNOHANG | WUNTRACED | WCONTINUED, &usage) <= 0) return;
+      jobs_process_event(info.si_pid, status, &usage);
+   }
+}
 
-   if (p_in_fd != -1) {
-      dup2(p_in_fd, STDIN_FILENO);
-      close(p_in_fd);
+/**
+ * @brief Wait for every stage of a foreground pipeline while budgets, the batch queue or held
+ * jobs need the shell
+ *
+ * Rather than blocking in waitpid() the shell sleeps in events_wait_child() until a child changes
+ * state or the next budget deadline, so a `timeout` on this pipeline or on a background job is
+ * acted on in time, a batch queue entry that finishes is replaced at once and held background
+ * jobs are started as soon as pressure allows.
+ *
+ * @param pids As for wait_pipeline()
+ * @param n
+ * @param pgid
+ * @param usage
+ * @param budget Budget of the pipeline, NULL for none
+ * @param last As for wait_pipeline()
+ * @return 1 if any stage stopped, 0 otherwise, -1 if out of memory (nothing was waited for)
+ */
+static int wait_watched(pid_t* pids,
+                        int n,
+                        pid_t pgid,
+                        JobUsage* usage,
+                        JobBudget* budget,
+                        int* last) {
+   int* live = calloc(n, sizeof(int));
+   if (!live) return -1;
+   int remaining = 0;
+   for (int i = 0; i < n; i++) {
+      live[i] = pids[i] > 0;
+      remaining += live[i];
    }
-   if (p_out_fd != -1) {
-      dup2(p_out_fd, STDOUT_FILENO);
-      close(p_out_fd);
+
+   int stopped = 0;
+   while (remaining > 0) {
+      for (int i = 0; i < n; i++) {
+         int status = 0;
+         if (live[i] && jobs_wait(pids[i], &status, WNOHANG | WUNTRACED, usage) == pids[i]) {
+            if (WIFSTOPPED(status)) {
+               stopped = 1;
+            } else {
+               pids[i] = -1;
+            }
+            note_sigint(status);
+            if (i == n - 1) *last = exit_status(status);
+            live[i] = 0;
+            remaining--;
+         }
+      }
+      if (remaining == 0) break;
+
+      if (queue_count(QUEUE_RUNNING) > 0) {
+         collect_background(pids, n);
+         queue_schedule();
+      }
+      double check = admit_release();
+      events_set_timer(earliest(check, enforce_budgets(pids, n, pgid, usage, budget)));
+      events_wait_child(-1);
    }
+   free(live);
+   return stopped;
+}
+
+/**
+ * @brief Wait for every stage of a foreground pipeline
+ *
+ * In adaptive pipe mode the wait polls instead of blocking so that it can sample the pipes
+ * between stages while data is flowing. While any budget is being enforced it waits for child
+ * events and budget deadlines instead, as it does while batch queue entries run (see
+ * wait_watched()).
+ *
+ * @param pids Stage pids (-1 for stages that failed to launch); stages that exit are set to -1
+ * @param inos Inode of pipe i (between stage i and i + 1), NULL when not sampling
+ * @param n Number of stages
+ * @param pgid Process group of the stages
+ * @param usage Accumulates the usage of every stage that exits
+ * @param budget Budget of the pipeline, NULL for none
+ * @param last Set to the exit status of the last stage (127 if it never started)
+ * @return 1 if any stage stopped, 0 otherwise
+ */
+static int wait_pipeline(pid_t* pids,
+                         const ino_t* inos,
+                         int n,
+                         pid_t pgid,
+                         JobUsage* usage,
+                         JobBudget* budget,
+                         int* last) {
+   int stopped = 0;
+   *last = pids[n - 1] > 0 ? 0 : 127;
+   if (!inos && (budget || jobs_enforce_budgets() > 0 || queue_count(QUEUE_RUNNING) > 0 ||
+                 admit_held() > 0)) {
+      stopped = wait_watched(pids, n, pgid, usage, budget, last);
+      if (stopped != -1) return stopped;
+      stopped = 0;
+   }
+
+#ifdef F_SETPIPE_SZ
+   if (inos) {
+      int* live = calloc(n, sizeof(int));
+      int* streak = calloc(n, sizeof(int));
+      if (live && streak) {
+         int remaining = 0;
+         for (int i = 0; i < n; i++) {
+            live[i] = pids[i] > 0;
+            remaining += live[i];
+         }
 
-   if (cmd->in_file) {
-      int fd = open(cmd->in_file, O_RDONLY);
-      if (fd < 0) {
-         DEBUG_EXEC("Opening file failed: %s", strerror(errno));
-         _exit(errno);
+         struct timespec tick = {0, 1000000L};
+         while (remaining > 0) {
+            for (int i = 0; i < n; i++) {
+               int status = 0;
+               if (live[i] && jobs_wait(pids[i], &status, WNOHANG | WUNTRACED, usage) == pids[i]) {
+                  if (WIFSTOPPED(status)) {
+                     stopped = 1;
+                  } else {
+                     pids[i] = -1;
+                  }
+                  note_sigint(status);
+                  if (i == n - 1) *last = exit_status(status);
+                  live[i] = 0;
+                  remaining--;
+               }
+            }
+            if (remaining == 0) break;
+
+            for (int i = 0; i < n - 1; i++) {
+               if (inos[i] && live[i] && live[i + 1]) sample_pipe(pids[i + 1], inos[i], &streak[i]);
+            }
+            enforce_budgets(pids, n, pgid, usage, budget);
+
+            // The tick is capped, so an exit is noticed within PIPE_SAMPLE_MAX_NS
+            nanosleep(&tick, NULL);
+            tick.tv_nsec *= 2;
+            if (tick.tv_nsec > PIPE_SAMPLE_MAX_NS) tick.tv_nsec = PIPE_SAMPLE_MAX_NS;
+         }
+         free(live);
+         free(streak);
+         return stopped;
       }
-      dup2(fd, STDIN_FILENO);
-      close(fd);
-   }
-   if (cmd->out_file) {
-      int fd = open(cmd->out_file, O_WRONLY | O_CREAT | O_TRUNC, FILE_CREATE_MODE);
-      if (fd < 0) {
-         DEBUG_EXEC("Opening file failed: %s", strerror(errno));
-         _exit(errno);
+      free(live);
+      free(streak);
+   }
+#else
+   (void)inos;
+#endif
+
+   for (int i = 0; i < n; i++) {
+      if (pids[i] < 0) continue;
+      int status = 0;
+      jobs_wait(pids[i], &status, WUNTRACED, usage);
+      if (WIFSTOPPED(status)) {
+         stopped = 1;
+      } else {
+         pids[i] = -1;
       }
-      dup2(fd, STDOUT_FILENO);
-      close(fd);
-   }
-   if (cmd->err_file) {
-      int fd = open(cmd->err_file, O_WRONLY | O_CREAT | O_TRUNC, FILE_CREATE_MODE);
-      if (fd < 0) {
-         DEBUG_EXEC("Opening file failed: %s", strerror(errno));
-         _exit(errno);
+      note_sigint(status);
+      if (i == n - 1) *last = exit_status(status);
+   }
+   return stopped;
+}
+
+/**
+ * @brief Open a command's redirection targets, reporting a failure before anything is launched
+ *
+ * @param cmd
+ * @param fds Opened descriptors (out)
+ * @return int 0 on success, -1 if a target could not be opened
+ */
+static int open_redirects(const Command* cmd, Redirects* fds) {
+   const char* failed;
+   if (redirects_open(cmd, fds, &failed) == 0) return 0;
+
+   if (failed == cmd->in_file) {
+      // A missing input file just prints an empty line
+      putchar('\n');
+   } else {
+      printf("yash: %s: %s\n", failed, strerror(errno));
+   }
+   fflush(stdout);
+   return -1;
+}
+
+/**
+ * @brief Run a builtin in the shell process with the command's redirections
+ *
+ * Each redirected standard descriptor is saved (close-on-exec) and pointed at its target for the
+ * duration of the builtin, then put back.
+ *
+ * @param b
+ * @param cmd
+ * @return int 0 (builtin failures are reported by the builtin itself and in its exit status)
+ */
+static int run_builtin(const Builtin* b, const Command* cmd) {
+   Redirects fds;
+   if (open_redirects(cmd, &fds) == -1) {
+      vars_set_status(1);
+      return 0;
+   }
+
+   const int targets[3] = {fds.in_fd, fds.out_fd, fds.err_fd};
+   int saved[3] = {-1, -1, -1};
+   fflush(stdout);
+   fflush(stderr);
+   for (int i = 0; i < 3; i++) {
+      if (targets[i] == -1) continue;
+      saved[i] = fcntl(i, F_DUPFD_CLOEXEC, 10);
+      dup2(targets[i], i);
+   }
+
+   vars_set_status(b->run(cmd->argv));
+
+   fflush(stdout);
+   fflush(stderr);
+   for (int i = 0; i < 3; i++) {
+      if (targets[i] == -1) continue;
+      if (saved[i] == -1) {
+         // The shell had nothing open there before
+         close(i);
+         continue;
       }
-      dup2(fd, STDERR_FILENO);
-      close(fd);
+      dup2(saved[i], i);
+      close(saved[i]);
    }
+   redirects_close(&fds);
+   return 0;
 }
 
 /**
  * @brief Executes non-piped commands
  *
+ * A background command goes through admission control first and may be held (see admit_hold()).
+ *
  * @param cmd
  * @param original Original command line string for job tracking
+ * @param usage Accumulates the usage of a foreground command
+ * @param rc Resource class to run under, NULL for none
+ * @param budget `timeout` budget to run under, NULL for none
  * @return int
  */
-static int execute_command(const Command* cmd, const char* original) {
+static int execute_command(const Command* cmd,
+                           const char* original,
+                           JobUsage* usage,
+                           const ResourceClass* rc,
+                           JobBudget* budget) {
 
    DEBUG_EXEC("Executing the command!!!");
 
@@ -110,196 +462,608 @@ static int execute_command(const Command* cmd, const char* original) {
       return -1;
    }
 
-   if (check_input_exists(cmd) == -1) {
-      putchar('\n');
-      fflush(stdout);
+   // Under pressure a background job is held as Pending, before its redirections truncate anything
+   if (cmd->background && admit_hold(original)) {
+      vars_set_status(0);
       return 0;
    }
 
-   if (cmd->background) {
-      pid_t pid = fork();
+   Redirects fds;
+   if (open_redirects(cmd, &fds) == -1) {
+      vars_set_status(1);
+      return 0;
+   }
 
-      if (pid < 0) { // fork() failed
-         DEBUG_EXEC("fork() failed (execute_command): %s", strerror(errno));
-         return -1;
+   pid_t pid;
+   if (!rc && !budget && builtin_cat_eligible(cmd)) {
+      // After Ctrl-Z the rest of the copy is a stopped child, waited for like any other command
+      pid_t rest = -1;
+      vars_set_status(builtin_cat(cmd->argv, &fds, &rest));
+      redirects_close(&fds);
+      if (rest <= 0) return 0;
+      pid = rest;
+   } else {
+      pid = launch_command(cmd, 0, &fds, rc);
+      redirects_close(&fds);
+      if (pid < 0) {
+         // Nothing was started (e.g. command not found); treat like a failed exec
+         DEBUG_EXEC("launch_command failed (execute_command): %s", strerror(errno));
+         vars_set_status(errno == ENOENT ? 127 : 126);
+         return 0;
       }
+   }
+
+   if (cmd->background) {
+      vars_set_status(0);
+      // Parent (No wait); a held job being let through keeps its Pending entry and number
+      int held = admit_releasing();
+      if (!held || jobs_start_held(held, pid, &pid, 1) == -1) jobs_add(pid, &pid, 1, original, 1);
+      if (rc) jobs_set_rclass(pid, rc->label);
+      if (budget) jobs_set_budget(pid, budget);
+      return 0;
+   }
 
-      if (pid == 0) {
-         // Child
-         DEBUG_EXEC("Child process starting, PID: %d", getpid());
-         setpgid(0, 0);
-         DEBUG_EXEC("Child process set process group to %d", getpgid(0));
-         setup_redirections(cmd, -1, -1);
+   foreground_pgid = pid;
+   DEBUG_EXEC("Parent process, child PID: %d, foreground_pgid set to %d. Waiting...",
+              pid,
+              foreground_pgid);
 
-         DEBUG_EXEC("Child process executing command");
-         execvp(cmd->argv[0], cmd->argv);
+   pid_t waited = pid;
+   int status;
+   int stopped = wait_pipeline(&waited, NULL, 1, pid, usage, budget, &status);
+   DEBUG_EXEC("Child process finished, clearing foreground_pgid");
+   foreground_pgid = 0;
+   vars_set_status(status);
 
-         // You shouldn't be here :(
-         DEBUG_EXEC("execvp failed: %s", strerror(errno));
-         if (errno == ENOENT) _exit(127);
-         _exit(126);
-      } else {
-         // Parent (No wait)
-         setpgid(pid, pid);
-         jobs_add(pid, original, 1); // Add background job to job table
+   if (stopped) {
+      // Add stopped job to job table
+      jobs_add(pid, &pid, 1, original, 0);
+      jobs_add_usage(pid, usage);
+      if (rc) jobs_set_rclass(pid, rc->label);
+      if (budget) jobs_set_budget(pid, budget);
+      return 0;
+   }
+   // Don't print extra newlines - let commands handle their own output formatting
+   // The shell should not add newlines to command output
 
+   return 0;
+}
+
+/**
+ * @brief Execute an N-stage pipeline
+ *
+ * All pipes are created up front and marked close-on-exec; the parent closes each end as soon as
+ * the stage that uses it has been launched. Every stage joins the first stage's process group and
+ * the group is recorded in the job table once if it stops, or at once for a background pipeline
+ * (which only the batch queue starts).
+ * A first stage that builtin_cat_eligible() accepts is not launched; the shell copies its files
+ * into the first pipe itself after the other stages have started.
+ *
+ * @param line Parsed line with num_stages >= 2
+ * @param usage Accumulates the usage of every stage
+ * @param rc Resource class for every stage, NULL for none
+ * @param budget `timeout` budget for the whole pipeline, NULL for none
+ * @return int
+ */
+static int execute_pipeline(const Line* line,
+                            JobUsage* usage,
+                            const ResourceClass* rc,
+                            JobBudget* budget) {
+   int n = line->num_stages;
+
+   DEBUG_EXEC("Executing %d-stage pipeline", n);
+
+   // pipes[i] connects stage i (write end) to stage i + 1 (read end)
+   int(*pipes)[2] = malloc(sizeof(int[2]) * (n - 1));
+   pid_t* pids = malloc(sizeof(pid_t) * n);
+   Redirects* fds = malloc(sizeof(Redirects) * n);
+   ino_t* inos = shell_options.pipe_adaptive ? calloc(n, sizeof(ino_t)) : NULL;
+   if (!pipes || !pids || !fds || (shell_options.pipe_adaptive && !inos)) {
+      free(pipes);
+      free(pids);
+      free(fds);
+      free(inos);
+      return -1;
+   }
+
+   // Every redirection target is opened before any stage starts
+   for (int i = 0; i < n; i++) {
+      if (open_redirects(&line->stages[i], &fds[i]) == -1) {
+         for (int j = 0; j < i; j++) {
+            redirects_close(&fds[j]);
+         }
+         free(pipes);
+         free(pids);
+         free(fds);
+         free(inos);
+         vars_set_status(1);
          return 0;
       }
+   }
+   for (int i = 0; i < n - 1; i++) {
+      if (pipe(pipes[i]) < 0) {
+         DEBUG_EXEC("pipe() failed: %s", strerror(errno));
+         for (int j = 0; j < i; j++) {
+            close(pipes[j][0]);
+            close(pipes[j][1]);
+         }
+         for (int j = 0; j < n; j++) {
+            redirects_close(&fds[j]);
+         }
+         free(pipes);
+         free(pids);
+         free(fds);
+         free(inos);
+         return -1;
+      }
+      // No child may keep another stage's pipe end open past exec
+      fcntl(pipes[i][0], F_SETFD, FD_CLOEXEC);
+      fcntl(pipes[i][1], F_SETFD, FD_CLOEXEC);
 
-   } else {
+      // `|[SIZE]` wins over `set -o pipesize=SIZE`; adaptive mode only grows unsized pipes
+      long size = line->stages[i].pipe_size ? line->stages[i].pipe_size : shell_options.pipe_size;
+      set_pipe_capacity(pipes[i][1], size);
+      if (inos && !line->stages[i].pipe_size) {
+         struct stat st;
+         if (fstat(pipes[i][0], &st) == 0) inos[i] = st.st_ino;
+      }
+   }
 
-      pid_t pid = fork();
+   // A plain `cat FILE` feeding the pipeline is copied by the shell once every reader is running,
+   // unless a function named cat takes its place
+   int background = line->stages[0].background;
+   int inline_cat = !background && !rc && !budget && builtin_cat_eligible(&line->stages[0]) &&
+                    !funcs_builtin(line->stages[0].argv[0]);
+   Redirects first = {-1, -1, -1};
 
-      if (pid < 0) { // fork() failed
-         DEBUG_EXEC("fork() failed (execute_command): %s", strerror(errno));
-         return -1;
+   pid_t pgid = 0;
+   for (int i = 0; i < n; i++) {
+      int in_fd = i > 0 ? pipes[i - 1][0] : -1;
+      int out_fd = i < n - 1 ? pipes[i][1] : -1;
+
+      // File redirections override the pipe ends
+      Redirects stage = fds[i];
+      if (stage.in_fd == -1) stage.in_fd = in_fd;
+      if (stage.out_fd == -1) stage.out_fd = out_fd;
+
+      if (i == 0 && inline_cat) {
+         first = stage;
+         pids[0] = -1;
+         continue;
+      }
+
+      DEBUG_COMMAND(&line->stages[i]);
+      pids[i] = launch_command(&line->stages[i], pgid, &stage, rc);
+      if (pids[i] < 0) {
+         DEBUG_EXEC("launch_command failed (stage %d): %s", i, strerror(errno));
+      } else if (pgid == 0) {
+         // The first stage that starts leads the group
+         pgid = pids[i];
       }
 
-      if (pid == 0) {
-         // Child process
-         DEBUG_EXEC("Child process starting, PID: %d", getpid());
-         setpgid(0, 0);
-         DEBUG_EXEC("Child process set process group to %d", getpgid(0));
-         setup_redirections(cmd, -1, -1);
+      // This stage owns its ends now; drop the parent's copies
+      if (in_fd != -1) close(in_fd);
+      if (out_fd != -1) close(out_fd);
+      redirects_close(&fds[i]);
+   }
 
-         DEBUG_EXEC("Child process executing command");
-         execvp(cmd->argv[0], cmd->argv);
+   if (inline_cat) {
+      // Ctrl-C reaches the readers and stops the copy; Ctrl-Z leaves a stopped child to finish it
+      foreground_pgid = pgid;
+      builtin_cat(line->stages[0].argv, &first, &pids[0]);
+      foreground_pgid = 0;
+      redirects_close(&fds[0]);
+      close(pipes[0][1]);
+   }
+   free(pipes);
+   free(fds);
 
-         // You shouldn't be here :(
-         DEBUG_EXEC("execvp failed: %s", strerror(errno));
-         if (errno == ENOENT) _exit(127);
-         _exit(126);
-      } else {
-         // Parent process
-         setpgid(pid, pid);
-         foreground_pgid = pid;
-         DEBUG_EXEC("Parent process, child PID: %d, foreground_pgid set to %d. Waiting...",
-                    pid,
-                    foreground_pgid);
-
-         int status;
-         waitpid(pid, &status, WUNTRACED);
-         DEBUG_EXEC("Child process finished, clearing foreground_pgid");
-         foreground_pgid = 0;
-
-         if (WIFSTOPPED(status)) {
-            // Add stopped job to job table
-            jobs_add(pid, original, 0);
-            return 0;
-         }
-         // Don't print extra newlines - let commands handle their own output formatting
-         // The shell should not add newlines to command output
+   if (pgid == 0) {
+      free(pids);
+      free(inos);
+      vars_set_status(127);
+      return 0;
+   }
 
-         // TODO: For now I ignored stopped/continue
+   if (background) {
+      // Only the batch queue and `dag` start pipelines in the background
+      int live = 0;
+      for (int i = 0; i < n; i++) {
+         if (pids[i] > 0) pids[live++] = pids[i];
       }
+      jobs_add(pgid, pids, live, line->original, 1);
+      if (rc) jobs_set_rclass(pgid, rc->label);
+      if (budget) jobs_set_budget(pgid, budget);
+      free(pids);
+      free(inos);
+      vars_set_status(0);
+      return 0;
    }
 
+   foreground_pgid = pgid;
+   int status;
+   int stopped = wait_pipeline(pids, inos, n, pgid, usage, budget, &status);
+   foreground_pgid = 0;
+   free(inos);
+   vars_set_status(status);
+
+   if (stopped) {
+      // Whole group is stopped; add it as a stopped job made of the stages that have not exited
+      int live = 0;
+      for (int i = 0; i < n; i++) {
+         if (pids[i] > 0) pids[live++] = pids[i];
+      }
+      jobs_add(pgid, pids, live, line->original, 0);
+      jobs_add_usage(pgid, usage);
+      if (rc) jobs_set_rclass(pgid, rc->label);
+      if (budget) jobs_set_budget(pgid, budget);
+   }
+   free(pids);
+
+   // Don't print extra newlines - let commands handle their own output formatting
+   // The shell should not add newlines to command output
    return 0;
 }
 
 /**
- * @brief Execute piped commands
+ * @brief Difference between two timevals in seconds
  *
- * @param left
- * @param right
- * @param original Original command line string for job tracking
- * @return int
+ * @param end
+ * @param start
+ * @return double
  */
-static int execute_pipeline(const Command* left, const Command* right, const char* original) {
-   // Can assume:
-   // - left is not NULL and left->argv[0] exists
-   // both left and right are guaranteed validright->argv[0] for pipelines
-   if (!left || !right) {
-      DEBUG_EXEC("Parser error: left or right is NULL");
-      return -1;
+static double tv_diff(struct timeval end, struct timeval start) {
+   return (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_usec - start.tv_usec) / 1e6;
+}
+
+/**
+ * @brief Print one `time` line in bash's `%dm%.3fs` format
+ *
+ * @param label
+ * @param seconds
+ */
+static void print_time_line(const char* label, double seconds) {
+   int minutes = (int)(seconds / 60);
+   fprintf(stderr, "%s\t%dm%.3fs\n", label, minutes, seconds - minutes * 60);
+}
+
+/**
+ * @brief Report a timed line the way bash's `time` keyword does
+ *
+ * @param usage Usage of the line's child processes
+ * @param self_before Shell's own usage when the line started (for builtins)
+ */
+static void print_time(const JobUsage* usage, const struct rusage* self_before) {
+   struct rusage self;
+   getrusage(RUSAGE_SELF, &self);
+   fflush(stdout);
+   fputc('\n', stderr);
+   print_time_line("real", jobs_usage_elapsed(usage));
+   print_time_line("user", usage->user + tv_diff(self.ru_utime, self_before->ru_utime));
+   print_time_line("sys", usage->sys + tv_diff(self.ru_stime, self_before->ru_stime));
+}
+
+/**
+ * @brief Expand the `$` parameters of an element's commands into a copy of it
+ *
+ * Only commands marked by the parser are copied; the rest are shared with @p line. Arguments are
+ * split into words at blanks, except in an assignment, where each word stays one value.
+ *
+ * @param line
+ * @param out Receives the copy
+ * @param arena Where the copied commands and expanded words are allocated
+ * @return 0 on success, -1 if out of memory
+ */
+static int expand_element(const Line* line, Line* out, Arena* arena) {
+   *out = *line;
+   out->stages = arena_alloc(arena, sizeof(Command) * line->num_stages);
+   if (!out->stages) return -1;
+   for (int s = 0; s < line->num_stages; s++) {
+      const Command* in = &line->stages[s];
+      Command* cmd = &out->stages[s];
+      *cmd = *in;
+      if (!in->expand) continue;
+
+      if (in->assign) {
+         int argc = 0;
+         while (in->argv[argc]) {
+            argc++;
+         }
+         cmd->argv = arena_alloc(arena, sizeof(char*) * (argc + 1));
+         if (!cmd->argv) return -1;
+         for (int i = 0; i < argc; i++) {
+            cmd->argv[i] = vars_expand(in->argv[i], arena);
+            if (!cmd->argv[i]) return -1;
+         }
+         cmd->argv[argc] = NULL;
+      } else if (!(cmd->argv = vars_expand_words(in->argv, arena))) {
+         return -1;
+      }
+      if (in->in_file && !(cmd->in_file = vars_expand(in->in_file, arena))) return -1;
+      if (in->out_file && !(cmd->out_file = vars_expand(in->out_file, arena))) return -1;
+      if (in->err_file && !(cmd->err_file = vars_expand(in->err_file, arena))) return -1;
    }
+   return 0;
+}
 
-   if (check_input_exists(left) == -1 || check_input_exists(right) == -1) {
-      putchar('\n');
-      fflush(stdout);
+/**
+ * @brief Execute one element of a command list
+ *
+ * Sets the exit status (`$?`) of the element.
+ *
+ * @param line Element whose stages have been expanded
+ * @return int
+ */
+static int execute_element(const Line* line) {
+   // `submit` only queues the element; the queue runs it later through execute_line() again
+   if (line->submit_at) {
+      vars_set_status(queue_submit(line) == -1 ? 1 : 0);
       return 0;
    }
 
-   DEBUG_EXEC("Executing pipeline");
-   DEBUG_EXEC("Left command:");
-   DEBUG_COMMAND(left);
-   DEBUG_EXEC("Right command:");
-   DEBUG_COMMAND(right);
+   const Command* first = &line->stages[0];
 
-   int p_fd[2]; // 0 = read, 1 = write
-   if (pipe(p_fd) < 0) {
-      DEBUG_EXEC("pipe() failed: %s", strerror(errno));
-      return -1;
+   // `NAME=value...` sets shell variables and runs nothing
+   if (first->assign && !line->is_pipeline) {
+      int status = 0;
+      for (int i = 0; first->argv[i]; i++) {
+         char* eq = strchr(first->argv[i], '=');
+         *eq = '\0';
+         if (vars_set(first->argv[i], eq + 1) == -1) status = 1;
+         *eq = '=';
+      }
+      vars_set_status(status);
+      return 0;
    }
 
-   pid_t left_pid = fork();
-   if (left_pid < 0) { // fork() failed
-      DEBUG_EXEC("fork() failed (execute_pipeline left): %s", strerror(errno));
-      return -1;
+   // A word that expanded to nothing at all leaves no command to run
+   if (!first->argv[0]) {
+      vars_set_status(0);
+      return 0;
    }
 
-   // Left Process
-   if (left_pid == 0) {
-      DEBUG_EXEC("Left child running.");
-      setpgid(0, 0);
+   // A class is resolved once for the whole line; every stage gets the same one
+   ResourceClass rclass;
+   const ResourceClass* rc = NULL;
+   if (line->rclass[0]) {
+      const char* bad;
+      if (rclass_parse(line->rclass, &rclass, &bad) == -1) {
+         fprintf(stderr,
+                 "class: %s: %s\n",
+                 bad,
+                 strchr(bad, '=') ? "invalid setting" : "no such class");
+         vars_set_status(1);
+         return 0;
+      }
+      rc = &rclass;
+   }
 
-      close(p_fd[0]);
-      setup_redirections(left, -1, p_fd[1]);
+   // Children are accounted through wait4(); builtins and `cat` show up in the shell's own usage
+   JobUsage usage = {0};
+   jobs_usage_start(&usage);
+   struct rusage self_before;
+   if (line->timed) getrusage(RUSAGE_SELF, &self_before);
 
-      DEBUG_EXEC("Child process executing command");
-      execvp(left->argv[0], left->argv);
+   // The budget's clock starts before anything is launched
+   JobBudget budget;
+   JobBudget* bp = NULL;
+   if (line->budget.wall > 0 || line->budget.cpu > 0) {
+      jobs_budget_start(&budget, &line->budget);
+      bp = &budget;
+   }
 
-      // You shouldn't be here :(
-      DEBUG_EXEC("execvp failed: %s", strerror(errno));
-      if (errno == ENOENT) _exit(127);
-      _exit(126);
+   // Foreground builtins and functions run in the shell; in a pipeline, in the background, under a
+   // class or with a budget they are forked (without exec) by launch_command()
+   const Builtin* b = NULL;
+   if (!line->is_pipeline && !first->background && !rc && !bp) {
+      b = funcs_builtin(first->argv[0]);
+      if (!b) b = builtin_find(first->argv[0]);
    }
 
-   pid_t right_pid = fork();
-   if (right_pid < 0) { // fork() failed
-      DEBUG_EXEC("fork() failed (execute_pipeline left): %s", strerror(errno));
-      return -1;
+   int result;
+   if (b) {
+      result = run_builtin(b, first);
+   } else if (line->is_pipeline) {
+      result = execute_pipeline(line, &usage, rc, bp);
+   } else {
+      DEBUG_EXEC("No pipeline - executing single command");
+      result = execute_command(first, line->original, &usage, rc, bp);
    }
 
-   // Right Process
-   if (right_pid == 0) {
-      DEBUG_EXEC("Right child running.");
-      setpgid(0, left_pid);
+   if (bp && budget.overrun != BUDGET_OK) {
+      fprintf(stderr,
+              "timeout: %s: %s budget of %gs exceeded\n",
+              first->argv[0],
+              budget.overrun == BUDGET_WALL ? "wall-clock" : "CPU",
+              budget.overrun == BUDGET_WALL ? budget.limit.wall : budget.limit.cpu);
+      vars_set_status(BUDGET_EXIT_CODE);
+   }
+   if (line->timed) print_time(&usage, &self_before);
+   return result;
+}
 
-      close(p_fd[1]);
-      setup_redirections(right, p_fd[0], -1);
+/**
+ * @brief Whether Ctrl-C has stopped the command that just ran
+ *
+ * Only an actual SIGINT counts: `exit 130` leaves the same `$?` without stopping anything.
+ */
+static int interrupted(void) {
+   return shell_interrupted || sigint_death;
+}
+
+/**
+ * @brief Whether a loop stops after its body ran, consuming a break or continue meant for it
+ * @return 1 to leave the loop, 0 to go on with its next iteration
+ */
+static int loop_done(void) {
+   if (flow == FLOW_BREAK || flow == FLOW_CONTINUE) {
+      // Loops further out see the jump only if it covers them too
+      Flow jump = flow;
+      if (--flow_levels == 0) flow = FLOW_NEXT;
+      return jump == FLOW_BREAK || flow != FLOW_NEXT;
+   }
+   return flow != FLOW_NEXT || interrupted();
+}
 
-      DEBUG_EXEC("Child process executing command");
-      execvp(right->argv[0], right->argv);
+static int execute_list(const Line* list, Arena* scratch);
 
-      // You shouldn't be here :(
-      DEBUG_EXEC("execvp failed: %s", strerror(errno));
-      if (errno == ENOENT) _exit(127);
-      _exit(126);
+/**
+ * @brief Run a compound command in the shell
+ *
+ * Sets the exit status (`$?`) the way POSIX does: that of the last command of the body that ran,
+ * 0 if none did.
+ *
+ * @param c
+ * @param text The command as typed (function definitions keep it)
+ * @param scratch For the words the command expands, valid while it runs
+ */
+static void execute_compound(const Compound* c, const char* text, Arena* scratch) {
+   // Each body gets an arena of its own, reused by every iteration
+   Arena body = {0};
+   int status = 0;
+
+   switch (c->kind) {
+   case CC_FOR: {
+      char* const* words = c->words;
+      if (!words) {
+         // `for NAME` goes over the positional parameters
+         char* const* args = vars_args();
+         static char* const none[] = {NULL};
+         words = args ? args + 1 : none;
+      } else if (c->expand && !(words = vars_expand_words(c->words, scratch))) {
+         fprintf(stderr, "yash: %s\n", strerror(ENOMEM));
+         status = 1;
+         break;
+      }
+      loop_depth++;
+      for (int i = 0; words[i]; i++) {
+         if (vars_set(c->name, words[i]) == -1) {
+            status = 1;
+            break;
+         }
+         execute_list(c->body, &body);
+         status = vars_status();
+         if (loop_done()) break;
+      }
+      loop_depth--;
+      // A loop that Ctrl-C ended fails as the command it interrupted would have
+      if (interrupted()) status = 128 + SIGINT;
+      break;
+   }
+   case CC_WHILE:
+   case CC_UNTIL:
+      loop_depth++;
+      while (1) {
+         execute_list(c->cond, &body);
+         if (flow != FLOW_NEXT || interrupted()) {
+            // A break or continue in the condition still applies to this loop
+            if (loop_done()) break;
+            continue;
+         }
+         if ((vars_status() == 0) != (c->kind == CC_WHILE)) break;
+         execute_list(c->body, &body);
+         status = vars_status();
+         if (loop_done()) break;
+      }
+      loop_depth--;
+      if (interrupted()) status = 128 + SIGINT;
+      break;
+   case CC_IF:
+      execute_list(c->cond, &body);
+      if (flow != FLOW_NEXT || interrupted()) {
+         status = vars_status();
+      } else if (vars_status() == 0) {
+         execute_list(c->body, &body);
+         status = vars_status();
+      } else if (c->orelse) {
+         execute_list(c->orelse, &body);
+         status = vars_status();
+      }
+      break;
+   case CC_CASE: {
+      const char* subject = vars_expand(c->words[0], scratch);
+      const CaseArm* match = NULL;
+      for (const CaseArm* arm = c->arms; arm && subject && !match; arm = arm->next) {
+         for (int i = 0; arm->patterns[i] && !match; i++) {
+            const char* pattern = vars_expand(arm->patterns[i], scratch);
+            if (pattern && fnmatch(pattern, subject, 0) == 0) match = arm;
+         }
+      }
+      if (match && match->body) {
+         execute_list(match->body, &body);
+         status = vars_status();
+      }
+      break;
+   }
+   case CC_GROUP:
+      execute_list(c->body, &body);
+      status = vars_status();
+      break;
+   case CC_FUNC:
+   default:
+      if (funcs_define(c->name, text) == -1) {
+         fprintf(stderr, "yash: %s: cannot define function\n", c->name);
+         status = 1;
+      }
+      break;
    }
 
-   // Parent Process
-   close(p_fd[0]);
-   close(p_fd[1]);
-   setpgid(left_pid, left_pid);
-   setpgid(right_pid, left_pid);
+   arena_free(&body);
+   vars_set_status(status);
+}
 
-   foreground_pgid = left_pid;
+/**
+ * @brief Run a chain of list elements
+ *
+ * Stops early at Ctrl-C and at a break, continue or return.
+ *
+ * @param list
+ * @param scratch Where expanded words go; reset for every element that expands any
+ * @return -1 if an element failed internally (pipe, fork...), 0 otherwise
+ */
+static int execute_list(const Line* list, Arena* scratch) {
+   int result = 0;
+   list_depth++;
+   ListOp op = LIST_SEQ;
+   for (const Line* e = list; e; e = e->next) {
+      // A skipped element leaves $? alone, so `false && a || b` still runs b
+      int status = vars_status();
+      if ((op == LIST_AND && status != 0) || (op == LIST_OR && status == 0)) {
+         op = e->op;
+         continue;
+      }
+      op = e->op;
 
-   int stL = 0, stR = 0;
-   waitpid(left_pid, &stL, WUNTRACED);
-   waitpid(right_pid, &stR, WUNTRACED);
-   foreground_pgid = 0;
+      if (e->compound) {
+         arena_reset(scratch);
+         execute_compound(e->compound, e->original, scratch);
+         result = 0;
+      } else {
+         int needs_expand = 0;
+         for (int s = 0; s < e->num_stages; s++) {
+            needs_expand |= e->stages[s].expand;
+         }
+         if (!needs_expand) {
+            result = execute_element(e);
+         } else {
+            // Expanded words only live while the element runs
+            Line expanded;
+            arena_reset(scratch);
+            if (expand_element(e, &expanded, scratch) == -1) {
+               fprintf(stderr, "yash: %s\n", strerror(ENOMEM));
+               vars_set_status(1);
+               result = -1;
+            } else {
+               result = execute_element(&expanded);
+            }
+         }
+      }
 
-   if (WIFSTOPPED(stL) || WIFSTOPPED(stR)) {
-      // Whole group is stopped; add it as a stopped job
-      jobs_add(left_pid, original, 0);
-      return 0;
+      // Ctrl-C stops the rest of the list along with the command it interrupted
+      if (flow != FLOW_NEXT || interrupted()) break;
    }
-
-   // Don't print extra newlines - let commands handle their own output formatting
-   // The shell should not add newlines to command output
-   return 0;
+   list_depth--;
+   return result;
 }
 
 // ============================================================================
@@ -309,92 +1073,49 @@ static int execute_pipeline(const Command* left, const Command* right, const cha
 int execute_line(Line* line) {
    // Can assume:
    // - line is not NULL
-   // - line->is_pipeline is correctly set
-   // - line->left is always valid
-   // - line->right is valid if is_pipeline==1, or NULL-initialized if is_pipeline==0
-
-   // Handle built-in commands (only for non-pipeline commands)
-   if (!line->is_pipeline && line->left.argv[0]) {
-      if (strcmp(line->left.argv[0], "exit") == 0) {
-         exit(0);
-      } else if (strcmp(line->left.argv[0], "jobs") == 0) {
-         jobs_print();
-         return 0;
-      } else if (strcmp(line->left.argv[0], "fg") == 0) {
-         int jid = jobs_pick_most_recent_for_fg();
-         if (jid == -1) {
-            printf("fg: no current job\n");
-            return 0;
-         }
-         pid_t pg = jobs_get_pgid(jid);
-         if (pg == -1) {
-            printf("fg: job not found\n");
-            return 0;
-         }
-         const char* s = jobs_get_cmdline(jid);
-         if (s) {
-            // Trim trailing " &" if present
-            char trimmed[MAX_CMDLINE];
-            strncpy(trimmed, s, MAX_CMDLINE - 1);
-            trimmed[MAX_CMDLINE - 1] = '\0';
-
-            size_t len = strlen(trimmed);
-            // Remove trailing whitespace
-            while (len > 0 && (trimmed[len - 1] == ' ' || trimmed[len - 1] == '\t')) {
-               len--;
-            }
-            // Remove trailing & if present
-            if (len > 0 && trimmed[len - 1] == '&') {
-               len--;
-            }
-            // Remove any remaining trailing whitespace
-            while (len > 0 && (trimmed[len - 1] == ' ' || trimmed[len - 1] == '\t')) {
-               len--;
-            }
-            trimmed[len] = '\0';
+   // - every element's is_pipeline is correctly set
+   // - every element's stages[0 .. num_stages) are all valid
 
-            puts(trimmed);
-            fflush(stdout);
-         }
-         kill(-pg, SIGCONT);
-         foreground_pgid = pg;
-         int status;
-         while (waitpid(-pg, &status, WUNTRACED) > 0) {
-            // Handle each process in the group
-         }
-         foreground_pgid = 0;
+   // A Ctrl-C at the prompt must not stop the first loop of this line
+   if (list_depth == 0) {
+      shell_interrupted = 0;
+      sigint_death = 0;
+   }
 
-         if (WIFSTOPPED(status)) {
-            jobs_mark(pg, JOB_STOPPED);
-         } else if (WIFEXITED(status) || WIFSIGNALED(status)) {
-            jobs_mark(pg, JOB_DONE);
-         }
-         return 0;
-      } else if (strcmp(line->left.argv[0], "bg") == 0) {
-         int jid = jobs_pick_most_recent_stopped_for_bg();
-         if (jid == -1) {
-            printf("bg: no current job\n");
-            return 0;
-         }
-         pid_t pg = jobs_get_pgid(jid);
-         if (pg == -1) {
-            printf("bg: job not found\n");
-            return 0;
-         }
-         kill(-pg, SIGCONT);
-         jobs_mark(pg, JOB_RUNNING);
-         jobs_set_background(pg, 1);
+   Arena scratch = {0};
+   int result = execute_list(line, &scratch);
+   arena_free(&scratch);
 
-         // Print the job info
-         jobs_print_one(jid);
-         return 0;
-      }
-   }
+   // Nothing is left to break out of or return from
+   if (list_depth == 0) flow = FLOW_NEXT;
+   return result;
+}
 
-   if (line->is_pipeline) {
-      return execute_pipeline(&line->left, &line->right, line->original);
-   } else {
-      DEBUG_EXEC("No pipeline - executing single command");
-      return execute_command(&line->left, line->original);
+int exec_function(const Line* body, char* const argv[]) {
+   char* const* saved_args = vars_set_args(argv);
+   int saved_loops = loop_depth;
+   loop_depth = 0;
+   func_depth++;
+
+   Arena scratch = {0};
+   execute_list(body, &scratch);
+   arena_free(&scratch);
+   if (flow == FLOW_RETURN) flow = FLOW_NEXT;
+
+   func_depth--;
+   loop_depth = saved_loops;
+   vars_set_args(saved_args);
+   return vars_status();
+}
+
+int exec_jump(Flow to, int levels) {
+   if (to == FLOW_RETURN) {
+      if (func_depth == 0) return -1;
+      flow = FLOW_RETURN;
+      return 0;
    }
+   if (loop_depth == 0) return -1;
+   flow = to;
+   flow_levels = levels < loop_depth ? levels : loop_depth;
+   return 0;
 }
@@ -0,0 +1,212 @@
+/**
+ * @file fdcopy.c
+ * @author Nathan Lemma
+ * @brief Zero-copy descriptor to descriptor transfer for the YASH shell
+ * @date 10-17-2026
+ * @details This file contains the copy engine behind the in-process `cat` builtin. On Linux it
+ * picks copy_file_range, splice or sendfile from the descriptor types so the bytes never pass
+ * through user space; everywhere else, and whenever the kernel says no, it uses read/write.
+ */
+
+#define _GNU_SOURCE
+
+// ============================================================================
+// Includes
+// ============================================================================
+
+#include "../include/fdcopy.h"
+#include "../include/debug.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
+
+// ============================================================================
+// Constants
+// ============================================================================
+
+/** @brief Bytes requested per kernel copy call */
+#define FDCOPY_CHUNK (1L << 20)
+
+/** @brief Size of the read/write fallback buffer */
+#define FDCOPY_BUFFER (128 * 1024)
+
+// ============================================================================
+// Static Functions
+// ============================================================================
+
+/**
+ * @brief Whether a descriptor may block indefinitely (pipe, FIFO, socket or terminal)
+ *
+ * @param st
+ * @return int
+ */
+static int is_stream(const struct stat* st) {
+   return S_ISFIFO(st->st_mode) || S_ISSOCK(st->st_mode) || S_ISCHR(st->st_mode);
+}
+
+/**
+ * @brief Wait until @p fd is ready, giving the cancel flag a chance to stop the copy
+ *
+ * poll() is never restarted after a signal handler runs, so Ctrl-C lands here even though the
+ * shell installs its handlers with SA_RESTART.
+ *
+ * @param fd
+ * @param events POLLIN or POLLOUT
+ * @param cancel
+ * @return int 0 when ready, -1 with errno set when cancelled or on error
+ */
+static int wait_ready(int fd, short events, volatile sig_atomic_t* cancel) {
+   struct pollfd p = {.fd = fd, .events = events, .revents = 0};
+   while (poll(&p, 1, -1) < 0) {
+      if (errno != EINTR) return -1;
+      if (cancel && *cancel) return -1;
+   }
+   return 0;
+}
+
+#ifdef __linux__
+/**
+ * @brief Move one chunk with the given kernel method
+ *
+ * @param method
+ * @param in_fd
+ * @param out_fd
+ * @return ssize_t Bytes moved, 0 at end of file, -1 on error
+ */
+static ssize_t kernel_chunk(FdCopyMethod method, int in_fd, int out_fd) {
+   switch (method) {
+   case FDCOPY_COPY_FILE_RANGE:
+      return copy_file_range(in_fd, NULL, out_fd, NULL, FDCOPY_CHUNK, 0);
+   case FDCOPY_SPLICE:
+      // Non-blocking on the pipe side only; waits happen in poll() where Ctrl-C can reach us
+      return splice(in_fd,
+                    NULL,
+                    out_fd,
+                    NULL,
+                    FDCOPY_CHUNK,
+                    SPLICE_F_MOVE | SPLICE_F_MORE | SPLICE_F_NONBLOCK);
+   case FDCOPY_SENDFILE:
+      return sendfile(out_fd, in_fd, NULL, FDCOPY_CHUNK);
+   default:
+      errno = EINVAL;
+      return -1;
+   }
+}
+
+/**
+ * @brief Pick the kernel method for a pair of descriptors
+ *
+ * @param in
+ * @param out
+ * @return FdCopyMethod FDCOPY_READ_WRITE when no kernel method applies
+ */
+static FdCopyMethod pick_method(const struct stat* in, const struct stat* out) {
+   if (S_ISREG(in->st_mode) && S_ISREG(out->st_mode)) return FDCOPY_COPY_FILE_RANGE;
+   if (S_ISFIFO(in->st_mode) || S_ISFIFO(out->st_mode)) return FDCOPY_SPLICE;
+   if (S_ISREG(in->st_mode)) return FDCOPY_SENDFILE;
+   return FDCOPY_READ_WRITE;
+}
+#endif
+
+/**
+ * @brief Copy the rest of the input through a user-space buffer
+ *
+ * @param in_fd
+ * @param out_fd
+ * @param in_stream Input may block (wait in poll first)
+ * @param cancel
+ * @return long long Bytes copied, -1 on error
+ */
+static long long
+copy_read_write(int in_fd, int out_fd, int in_stream, volatile sig_atomic_t* cancel) {
+   static char buffer[FDCOPY_BUFFER];
+   long long total = 0;
+
+   while (1) {
+      if (cancel && *cancel) {
+         errno = EINTR;
+         return -1;
+      }
+      if (in_stream && wait_ready(in_fd, POLLIN, cancel) < 0) return -1;
+
+      ssize_t n = read(in_fd, buffer, sizeof(buffer));
+      if (n < 0 && (errno == EINTR || errno == EAGAIN)) continue;
+      if (n < 0) return -1;
+      if (n == 0) return total;
+
+      for (ssize_t done = 0; done < n;) {
+         ssize_t w = write(out_fd, buffer + done, n - done);
+         if (w < 0 && errno == EINTR && !(cancel && *cancel)) continue;
+         if (w < 0 && errno == EAGAIN) {
+            if (wait_ready(out_fd, POLLOUT, cancel) < 0) return -1;
+            continue;
+         }
+         if (w < 0) return -1;
+         done += w;
+      }
+      total += n;
+   }
+}
+
+// ============================================================================
+// Public Functions
+// ============================================================================
+
+long long fd_copy(int in_fd, int out_fd, volatile sig_atomic_t* cancel, FdCopyMethod* method) {
+   struct stat in_st, out_st;
+   if (fstat(in_fd, &in_st) < 0 || fstat(out_fd, &out_st) < 0) return -1;
+   if (method) *method = FDCOPY_NONE;
+
+   long long total = 0;
+
+#ifdef __linux__
+   FdCopyMethod m = pick_method(&in_st, &out_st);
+   while (m != FDCOPY_READ_WRITE) {
+      if (cancel && *cancel) {
+         errno = EINTR;
+         return -1;
+      }
+
+      ssize_t n = kernel_chunk(m, in_fd, out_fd);
+      if (n > 0) {
+         total += n;
+         if (method) *method = m;
+         continue;
+      }
+      if (n == 0) return total;
+
+      if (errno == EINTR) continue;
+      if (errno == EAGAIN && m == FDCOPY_SPLICE) {
+         // Input pipe empty or output pipe full: wait on the side that is holding us up
+         int queued = 0;
+         int in_empty = S_ISFIFO(in_st.st_mode) &&
+                        (!S_ISFIFO(out_st.st_mode) ||
+                         (ioctl(in_fd, FIONREAD, &queued) == 0 && queued == 0));
+         int ready = in_empty ? wait_ready(in_fd, POLLIN, cancel)
+                              : wait_ready(out_fd, POLLOUT, cancel);
+         if (ready < 0) return -1;
+         continue;
+      }
+      if (errno == EXDEV || errno == EINVAL || errno == ENOSYS || errno == EOPNOTSUPP ||
+          errno == EBADF) {
+         // Filesystem or descriptor type the kernel will not copy for us; continue by hand
+         DEBUG_PRINT("fd_copy: method %d unsupported (%s), using read/write", m, strerror(errno));
+         break;
+      }
+      return -1;
+   }
+#endif
+
+   long long rest = copy_read_write(in_fd, out_fd, is_stream(&in_st), cancel);
+   if (rest < 0) return -1;
+   if (method && rest > 0) *method = FDCOPY_READ_WRITE;
+   return total + rest;
+}
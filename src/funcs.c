@@ -0,0 +1,137 @@
+/**
+ * @file funcs.c
+ * @author Nathan Lemma
+ * @brief Shell functions for the YASH shell
+ * @date 10-17-2026
+ * @details This file contains the function table. The Line a definition was parsed into is
+ * reused by the next line the shell reads, so a definition is parsed once more from its own text
+ * into a Line the function keeps; calls run that Line's body with no parsing at all. A count of
+ * running calls keeps a function that redefines or unsets itself alive until it returns.
+ */
+
+// ============================================================================
+// Includes
+// ============================================================================
+
+#include "../include/funcs.h"
+#include "../include/exec.h"
+#include "../include/parse.h"
+#include <stdlib.h>
+#include <string.h>
+
+// ============================================================================
+// Data Structures
+// ============================================================================
+
+/**
+ * @brief One defined function
+ */
+typedef struct Function {
+   char* name;            ///< Function name
+   Line line;             ///< Parsed definition; line.compound->body is the body
+   int refs;              ///< Calls running now
+   int removed;           ///< Replaced or unset; freed when the last call returns
+   struct Function* next; ///< Next defined function
+} Function;
+
+// ============================================================================
+// Static Globals
+// ============================================================================
+
+static Function* functions;  ///< Every defined function
+static unsigned long changes; ///< funcs_generation()
+
+// ============================================================================
+// Static Functions
+// ============================================================================
+
+/**
+ * @brief Find a defined function
+ * @param name
+ * @param link Receives the link pointing at it, if not NULL
+ * @return The function, NULL if there is none
+ */
+static Function* find_function(const char* name, Function*** link) {
+   for (Function** l = &functions; *l; l = &(*l)->next) {
+      if (strcmp((*l)->name, name) == 0) {
+         if (link) *link = l;
+         return *l;
+      }
+   }
+   return NULL;
+}
+
+/**
+ * @brief Release a function no call is running
+ * @param f
+ */
+static void free_function(Function* f) {
+   line_free(&f->line);
+   free(f->name);
+   free(f);
+}
+
+/**
+ * @brief Take a function out of the table, freeing it unless a call is running
+ * @param link Link pointing at it
+ */
+static void remove_function(Function** link) {
+   Function* f = *link;
+   *link = f->next;
+   f->removed = 1;
+   if (f->refs == 0) free_function(f);
+}
+
+/**
+ * @brief BuiltinFn behind every function: run the body named by argv[0]
+ */
+static int run_function(char* const argv[]) {
+   Function* f = find_function(argv[0], NULL);
+   if (!f) return 127;
+
+   f->refs++;
+   int status = exec_function(f->line.compound->body, argv);
+   if (--f->refs == 0 && f->removed) free_function(f);
+   return status;
+}
+
+// ============================================================================
+// Public Functions
+// ============================================================================
+
+int funcs_define(const char* name, const char* text) {
+   Function* f = calloc(1, sizeof(Function));
+   if (!f || !(f->name = strdup(name))) {
+      free(f);
+      return -1;
+   }
+   if (parse_line(text, &f->line) != 0 || !f->line.compound ||
+       f->line.compound->kind != CC_FUNC || f->line.next) {
+      free_function(f);
+      return -1;
+   }
+
+   Function** link;
+   if (find_function(name, &link)) remove_function(link);
+   f->next = functions;
+   functions = f;
+   changes++;
+   return 0;
+}
+
+int funcs_unset(const char* name) {
+   Function** link;
+   if (!find_function(name, &link)) return -1;
+   remove_function(link);
+   changes++;
+   return 0;
+}
+
+unsigned long funcs_generation(void) {
+   return changes;
+}
+
+const Builtin* funcs_builtin(const char* name) {
+   static const Builtin call = {"function", run_function};
+   return functions && find_function(name, NULL) ? &call : NULL;
+}
@@ -3,231 +3,908 @@
  * @author Nathan Lemma
  * @brief Job control functions for the YASH shell
  * @date 09-16-2025
- * @details This file contains the job control functions for the YASH shell.
+ * @details This file contains the job control functions for the YASH shell. Jobs are kept on a
+ * doubly linked list in id order and indexed by chained hash tables keyed by pgid and by job id,
+ * and every process that has not been reaped is indexed by pid. Adding, finding and removing a
+ * job, and applying a wait status to the right job, do not depend on how many jobs there are.
+ * Jobs started under `timeout` carry a budget that is checked at its deadlines, not polled.
  */
 
+#define _DEFAULT_SOURCE  // wait4() on glibc
+#define _DARWIN_C_SOURCE // wait4() on macOS
+
 // ============================================================================
 // Includes
 // ============================================================================
 
 #include "../include/jobs.h"
+#include "../include/debug.h"
+#include "../include/options.h"
+#include "../include/proctree.h"
 #include "../include/yash.h"
+#include <signal.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+// ============================================================================
+// Constants
+// ============================================================================
+
+/** @brief log2 of the initial number of hash buckets */
+#define JOB_INDEX_MIN_BITS 6
+
+/** @brief Shortest pause between two checks of a CPU budget, in seconds */
+#define BUDGET_CPU_TICK 0.02
 
 // ============================================================================
 // Static Globals
 // ============================================================================
 
-static Job job_table[MAX_JOBS];
-static int job_count;
+static Job* job_head;         ///< Lowest id
+static Job* job_tail;         ///< Highest id
+static int job_count;         ///< Jobs on the list
+static int done_count;        ///< Jobs on the list that are JOB_DONE
+static Job** by_pgid;         ///< pgid index buckets
+static Job** by_id;           ///< id index buckets
+static unsigned index_bits;   ///< log2 of the bucket count (0 before the first job)
+static JobProc** by_pid;      ///< pid index buckets
+static unsigned pid_bits;     ///< log2 of the pid bucket count (0 before the first process)
+static int pid_count;         ///< Processes in the pid index
+static int budget_count;      ///< Jobs on the list with a budget
+static pid_t last_bg_pgid;    ///< Group of the newest background job
+static JobDoneHook done_hook; ///< Told about every job that finishes
+
+// ============================================================================
+// Static Functions
+// ============================================================================
+
+/**
+ * @brief CLOCK_MONOTONIC in seconds
+ * @return double
+ */
+static double now_seconds(void) {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Seconds in a timeval
+ * @param tv
+ * @return double
+ */
+static double tv_seconds(struct timeval tv) {
+   return (double)tv.tv_sec + (double)tv.tv_usec / 1e6;
+}
+
+/**
+ * @brief Status word printed by jobs
+ * @param status
+ * @return const char*
+ */
+static const char* status_name(JobStatus status) {
+   switch (status) {
+   case JOB_RUNNING:
+      return "Running";
+   case JOB_STOPPED:
+      return "Stopped";
+   case JOB_PENDING:
+      return "Pending";
+   default:
+      return "Unknown";
+   }
+}
+
+/**
+ * @brief Note after the status word of a job that ran past its budget
+ * @param job
+ * @return const char* Empty for a job within its budget
+ */
+static const char* overrun_note(const Job* job) {
+   switch (job->budget.overrun) {
+   case BUDGET_WALL:
+      return " (over wall-clock budget)";
+   case BUDGET_CPU:
+      return " (over CPU budget)";
+   default:
+      return "";
+   }
+}
+
+/**
+ * @brief Whether a budget has any limit
+ * @param budget
+ * @return int
+ */
+static int has_budget(const JobBudget* budget) {
+   return budget->limit.wall > 0 || budget->limit.cpu > 0;
+}
+
+/**
+ * @brief Send a signal to a process group and to each of some processes
+ * @param pgid Group to signal, <= 0 for none
+ * @param pids Entries <= 0 are skipped
+ * @param n
+ * @param sig
+ */
+static void signal_members(pid_t pgid, const pid_t* pids, int n, int sig) {
+   if (pgid > 0) kill(-pgid, sig);
+   for (int i = 0; i < n; i++) {
+      if (pids[i] > 0) kill(pids[i], sig);
+   }
+}
+
+/**
+ * @brief Bucket of a key in a table of 2^bits buckets (multiplicative hashing)
+ * @param key pgid, job id or pid
+ * @param bits
+ * @return size_t
+ */
+static size_t hash_key(int key, unsigned bits) {
+   return (uint32_t)((uint32_t)key * 2654435761u) >> (32 - bits);
+}
+
+/**
+ * @brief Bucket of a pgid or job id
+ * @param key
+ * @return size_t
+ */
+static size_t bucket_of(int key) {
+   return hash_key(key, index_bits);
+}
+
+/**
+ * @brief Put a job at the head of its pgid and id buckets
+ * @param job
+ */
+static void index_insert(Job* job) {
+   size_t b = bucket_of(job->pgid);
+   job->pgid_next = by_pgid[b];
+   by_pgid[b] = job;
+
+   b = bucket_of(job->id);
+   job->id_next = by_id[b];
+   by_id[b] = job;
+}
+
+/**
+ * @brief Take a job out of both indexes
+ * @param job
+ */
+static void index_remove(Job* job) {
+   Job** p = &by_pgid[bucket_of(job->pgid)];
+   while (*p != job) {
+      p = &(*p)->pgid_next;
+   }
+   *p = job->pgid_next;
+
+   p = &by_id[bucket_of(job->id)];
+   while (*p != job) {
+      p = &(*p)->id_next;
+   }
+   *p = job->id_next;
+}
+
+/**
+ * @brief Double the buckets (or create them) and rehash every job
+ * @return 0 on success, -1 if out of memory
+ */
+static int index_grow(void) {
+   unsigned bits = index_bits ? index_bits + 1 : JOB_INDEX_MIN_BITS;
+   Job** pgids = calloc((size_t)1 << bits, sizeof(Job*));
+   Job** ids = calloc((size_t)1 << bits, sizeof(Job*));
+   if (!pgids || !ids) {
+      free(pgids);
+      free(ids);
+      return -1;
+   }
+
+   free(by_pgid);
+   free(by_id);
+   by_pgid = pgids;
+   by_id = ids;
+   index_bits = bits;
+   for (Job* j = job_head; j; j = j->next) {
+      index_insert(j);
+   }
+   return 0;
+}
+
+/**
+ * @brief Put an unreaped process into the pid index
+ * @param proc
+ */
+static void pid_index_insert(JobProc* proc) {
+   size_t b = hash_key(proc->pid, pid_bits);
+   proc->pid_next = by_pid[b];
+   by_pid[b] = proc;
+   pid_count++;
+}
+
+/**
+ * @brief Double the pid buckets (or create them) and rehash every live process
+ * @return 0 on success, -1 if out of memory
+ */
+static int pid_index_grow(void) {
+   unsigned bits = pid_bits ? pid_bits + 1 : JOB_INDEX_MIN_BITS;
+   JobProc** buckets = calloc((size_t)1 << bits, sizeof(JobProc*));
+   if (!buckets) return -1;
+
+   free(by_pid);
+   by_pid = buckets;
+   pid_bits = bits;
+   pid_count = 0;
+   for (Job* j = job_head; j; j = j->next) {
+      for (int i = 0; i < j->num_procs; i++) {
+         if (j->procs[i].status != JOB_DONE) pid_index_insert(&j->procs[i]);
+      }
+   }
+   return 0;
+}
+
+/**
+ * @brief Take a reaped (or abandoned) process out of the pid index
+ * @param proc
+ */
+static void pid_index_remove(JobProc* proc) {
+   JobProc** p = &by_pid[hash_key(proc->pid, pid_bits)];
+   while (*p != proc) {
+      p = &(*p)->pid_next;
+   }
+   *p = proc->pid_next;
+   pid_count--;
+}
+
+/**
+ * @brief Find the unreaped process with a pid
+ * @param pid
+ * @return JobProc*, NULL if no job owns it
+ */
+static JobProc* find_by_pid(pid_t pid) {
+   if (!pid_bits) return NULL;
+   for (JobProc* p = by_pid[hash_key(pid, pid_bits)]; p; p = p->pid_next) {
+      if (p->pid == pid) return p;
+   }
+   return NULL;
+}
+
+/**
+ * @brief Set a job's status, keeping done_count in step
+ * @param job
+ * @param status
+ */
+static void set_status(Job* job, JobStatus status) {
+   if (status == JOB_DONE && job->status != JOB_DONE) done_count++;
+   job->status = status;
+}
+
+/**
+ * @brief Find the unfinished job with a process group
+ * @param pgid
+ * @return Job*, NULL if none
+ */
+static Job* find_by_pgid(pid_t pgid) {
+   if (!index_bits) return NULL;
+   for (Job* j = by_pgid[bucket_of(pgid)]; j; j = j->pgid_next) {
+      if (j->pgid == pgid && j->status != JOB_DONE) return j;
+   }
+   return NULL;
+}
+
+/**
+ * @brief Find a job by id, finished or not
+ * @param job_id
+ * @return Job*, NULL if none
+ */
+static Job* find_by_id(int job_id) {
+   if (!index_bits) return NULL;
+   for (Job* j = by_id[bucket_of(job_id)]; j; j = j->id_next) {
+      if (j->id == job_id) return j;
+   }
+   return NULL;
+}
+
+/**
+ * @brief Find the job with a process group, finished or not, preferring an unfinished one
+ * @param pgid
+ * @return Job*, NULL if none
+ */
+static Job* find_by_pgid_any(pid_t pgid) {
+   Job* done = NULL;
+   for (Job* j = by_pgid[bucket_of(pgid)]; j; j = j->pgid_next) {
+      if (j->pgid != pgid) continue;
+      if (j->status != JOB_DONE) return j;
+      done = j;
+   }
+   return done;
+}
+
+/**
+ * @brief Add an adopted process to a job
+ *
+ * The procs array moves when it grows, so the job's live entries leave the pid index first and
+ * go back in afterwards.
+ *
+ * @param job
+ * @param pid
+ * @return 0 on success, -1 if out of memory
+ */
+static int job_adopt(Job* job, pid_t pid) {
+   if ((size_t)(pid_count + 1) > ((size_t)1 << pid_bits) / 2 && pid_index_grow() == -1) return -1;
+   JobProc* procs = malloc((job->num_procs + 1) * sizeof(JobProc));
+   if (!procs) return -1;
+
+   for (int i = 0; i < job->num_procs; i++) {
+      if (job->procs[i].status != JOB_DONE) pid_index_remove(&job->procs[i]);
+   }
+   if (job->num_procs > 0) memcpy(procs, job->procs, job->num_procs * sizeof(JobProc));
+   free(job->procs);
+   job->procs = procs;
+   for (int i = 0; i < job->num_procs; i++) {
+      if (procs[i].status != JOB_DONE) pid_index_insert(&procs[i]);
+   }
+
+   JobProc* p = &procs[job->num_procs++];
+   p->pid = pid;
+   p->status = JOB_RUNNING;
+   p->job = job;
+   pid_index_insert(p);
+   job->live++;
+   if (job->status == JOB_DONE) done_count--;
+   job->status = JOB_RUNNING;
+   return 0;
+}
+
+/**
+ * @brief Unlink a job from the list and indexes and free it
+ * @param job
+ */
+static void job_remove(Job* job) {
+   index_remove(job);
+   for (int i = 0; i < job->num_procs; i++) {
+      if (job->procs[i].status != JOB_DONE) pid_index_remove(&job->procs[i]);
+   }
+   if (job->prev) {
+      job->prev->next = job->next;
+   } else {
+      job_head = job->next;
+   }
+   if (job->next) {
+      job->next->prev = job->prev;
+   } else {
+      job_tail = job->prev;
+   }
+   if (job->status == JOB_DONE) done_count--;
+   if (has_budget(&job->budget)) budget_count--;
+   job_count--;
+   free(job->procs);
+   free(job->cmdline);
+   free(job);
+}
+
+/**
+ * @brief The "+" job: the unfinished job with the highest id
+ * @return int Its id, -1 if there is none
+ */
+static int plus_id(void) {
+   for (const Job* j = job_tail; j; j = j->prev) {
+      if (j->status != JOB_DONE) return j->id;
+   }
+   return -1;
+}
 
 // ============================================================================
 // Public Functions
 // ============================================================================
 
 void jobs_init(void) {
-   // Zero the table
-   for (int i = 0; i < MAX_JOBS; i++) {
-      job_table[i].id = 0;
-      job_table[i].pgid = 0;
-      job_table[i].cmdline[0] = '\0';
-      job_table[i].status = JOB_DONE;
-      job_table[i].is_background = 0;
+   while (job_head) {
+      job_remove(job_head);
    }
+   free(by_pgid);
+   free(by_id);
+   free(by_pid);
+   by_pgid = NULL;
+   by_id = NULL;
+   by_pid = NULL;
+   index_bits = 0;
+   pid_bits = 0;
+   pid_count = 0;
 
    // Reset counters
    job_count = 0;
+   done_count = 0;
+   budget_count = 0;
 }
 
-int jobs_add(pid_t pgid, const char* cmdline, int is_background) {
-   // Check capacity limit
-   if (job_count >= MAX_JOBS) {
-      return -1; // Refuse to add - at capacity
+int jobs_add(pid_t pgid, const pid_t* pids, int num_pids, const char* cmdline, int is_background) {
+   // Keep the load factors at or below one half
+   if ((size_t)job_count >= ((size_t)1 << index_bits) / 2 && index_grow() == -1) return -1;
+   while ((size_t)(pid_count + num_pids) > ((size_t)1 << pid_bits) / 2) {
+      if (pid_index_grow() == -1) return -1;
    }
 
-   // Find the current maximum ID among active jobs
-   int max_id = 0;
-   for (int i = 0; i < MAX_JOBS; i++) {
-      if (job_table[i].status != JOB_DONE && job_table[i].id > max_id) {
-         max_id = job_table[i].id;
-      }
+   Job* job = calloc(1, sizeof(Job));
+   char* copy = strdup(cmdline);
+   JobProc* procs = num_pids > 0 ? calloc(num_pids, sizeof(JobProc)) : NULL;
+   if (!job || !copy || (num_pids > 0 && !procs)) {
+      free(job);
+      free(copy);
+      free(procs);
+      return -1;
    }
-   int new_id = max_id + 1;
-
-   // Find empty slot
-   for (int i = 0; i < MAX_JOBS; i++) {
-      if (job_table[i].status == JOB_DONE) {
-         // Bash-style numbering: new job number = max current ID + 1
-         job_table[i].id = new_id;
-         job_table[i].pgid = pgid;
-         snprintf(job_table[i].cmdline, MAX_CMDLINE, "%s", cmdline);
-         job_table[i].status = is_background ? JOB_RUNNING : JOB_STOPPED;
-         job_table[i].is_background = is_background;
-         job_count++;
-         return job_table[i].id;
-      }
+
+   // Bash-style numbering: new job number = max current ID + 1, and the tail has the max ID
+   job->id = job_tail ? job_tail->id + 1 : 1;
+   job->pgid = pgid;
+   job->cmdline = copy;
+   job->status = is_background ? JOB_RUNNING : JOB_STOPPED;
+   job->is_background = is_background;
+   jobs_usage_start(&job->usage);
+   job->procs = procs;
+   job->num_procs = num_pids;
+   job->num_stages = num_pids;
+   job->live = num_pids;
+   for (int i = 0; i < num_pids; i++) {
+      JobProc* p = &procs[i];
+      p->pid = pids[i];
+      p->status = job->status;
+      p->job = job;
+      pid_index_insert(p);
    }
 
-   // No empty slots available (shouldn't happen if job_count < MAX_JOBS)
-   return -1;
+   job->prev = job_tail;
+   if (job_tail) {
+      job_tail->next = job;
+   } else {
+      job_head = job;
+   }
+   job_tail = job;
+   index_insert(job);
+   job_count++;
+   if (is_background && pgid > 0) last_bg_pgid = pgid;
+   return job->id;
+}
+
+int jobs_add_held(const char* cmdline) {
+   int id = jobs_add(0, NULL, 0, cmdline, 1);
+   if (id == -1) return -1;
+   Job* j = find_by_id(id);
+   j->status = JOB_PENDING;
+   j->held_since = now_seconds();
+   return id;
+}
+
+int jobs_start_held(int job_id, pid_t pgid, const pid_t* pids, int num_pids) {
+   Job* j = find_by_id(job_id);
+   if (!j || j->status != JOB_PENDING) return -1;
+   while ((size_t)(pid_count + num_pids) > ((size_t)1 << pid_bits) / 2) {
+      if (pid_index_grow() == -1) return -1;
+   }
+   JobProc* procs = calloc(num_pids, sizeof(JobProc));
+   if (!procs) return -1;
+
+   // The pgid index is keyed on the group, which only exists now
+   index_remove(j);
+   j->pgid = pgid;
+   index_insert(j);
+   j->procs = procs;
+   j->num_procs = num_pids;
+   j->num_stages = num_pids;
+   j->live = num_pids;
+   j->status = JOB_RUNNING;
+   for (int i = 0; i < num_pids; i++) {
+      procs[i].pid = pids[i];
+      procs[i].status = JOB_RUNNING;
+      procs[i].job = j;
+      pid_index_insert(&procs[i]);
+   }
+   j->held = now_seconds() - j->held_since;
+   jobs_usage_start(&j->usage);
+   last_bg_pgid = pgid;
+   DEBUG_JOBS("held job %d started as pgid %d after %.3fs", job_id, (int)pgid, j->held);
+   return 0;
+}
+
+void jobs_drop_held(int job_id, int exit_code) {
+   Job* j = find_by_id(job_id);
+   if (!j || j->status != JOB_PENDING) return;
+   j->held = now_seconds() - j->held_since;
+   j->exit_code = exit_code;
+   set_status(j, JOB_DONE);
+}
+
+double jobs_held_seconds(int job_id) {
+   const Job* j = find_by_id(job_id);
+   if (!j || j->held_since == 0) return 0;
+   return j->status == JOB_PENDING ? now_seconds() - j->held_since : j->held;
 }
 
 void jobs_mark(pid_t pgid, JobStatus status) {
-   for (int i = 0; i < MAX_JOBS; i++) {
-      if (job_table[i].pgid == pgid && job_table[i].status != JOB_DONE) {
-         job_table[i].status = status;
-         break;
+   Job* j = find_by_pgid(pgid);
+   if (!j) return;
+   // Signalling the group (fg, bg) moves every live member along with the job
+   for (int i = 0; status != JOB_DONE && i < j->num_procs; i++) {
+      if (j->procs[i].status != JOB_DONE) j->procs[i].status = status;
+   }
+   set_status(j, status);
+}
+
+void jobs_process_event(pid_t pid, int status, const JobUsage* usage) {
+   JobProc* p = find_by_pid(pid);
+   if (!p) return;
+   Job* j = p->job;
+
+   if (WIFSTOPPED(status)) {
+      p->status = JOB_STOPPED;
+   } else if (WIFCONTINUED(status)) {
+      p->status = JOB_RUNNING;
+      set_status(j, JOB_RUNNING);
+      return;
+   } else if (WIFEXITED(status) || WIFSIGNALED(status)) {
+      p->status = JOB_DONE;
+      pid_index_remove(p);
+      j->live--;
+      if (p - j->procs == j->num_stages - 1) {
+         j->exit_code = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+      }
+      if (j->budget.overrun != BUDGET_OK) j->exit_code = BUDGET_EXIT_CODE;
+      if (usage) jobs_usage_merge(&j->usage, usage);
+      if (j->live == 0) {
+         set_status(j, JOB_DONE);
+         if (done_hook) done_hook(j->pgid, j->exit_code);
+         return;
       }
+   } else {
+      return;
    }
+
+   // The job is stopped once nothing in it is still running
+   for (int i = 0; i < j->num_procs; i++) {
+      if (j->procs[i].status == JOB_RUNNING) return;
+   }
+   set_status(j, JOB_STOPPED);
 }
 
-void jobs_print() {
-   // Find the highest ID among active jobs (the "+" job)
-   int plus_id = -1;
-   for (int i = 0; i < MAX_JOBS; i++) {
-      if (job_table[i].status != JOB_DONE && job_table[i].id > plus_id) {
-         plus_id = job_table[i].id;
+void jobs_collect(void) {
+   pid_t pid;
+   int status;
+   JobUsage usage = {0};
+   while ((pid = jobs_wait(-1, &status, WNOHANG | WUNTRACED | WCONTINUED, &usage)) > 0) {
+      jobs_process_event(pid, status, &usage);
+      memset(&usage, 0, sizeof(usage));
+   }
+   if (shell_options.subreaper) jobs_adopt_orphans();
+}
+
+int jobs_adopt_orphans(void) {
+   int n = proctree_children(getpid(), NULL, 0);
+   if (n <= 0) return 0;
+   pid_t* kids = malloc(n * sizeof(pid_t));
+   if (!kids) return 0;
+   n = proctree_children(getpid(), kids, n);
+
+   int adopted = 0;
+   for (int i = 0; i < n; i++) {
+      if (find_by_pid(kids[i])) continue;
+      pid_t pgid = getpgid(kids[i]);
+      if (pgid == -1) continue; // Exited since the listing
+
+      Job* j = index_bits ? find_by_pgid_any(pgid) : NULL;
+      if (j) {
+         if (job_adopt(j, kids[i]) == -1) break;
+      } else {
+         char cmdline[48];
+         snprintf(cmdline, sizeof(cmdline), "(adopted pid %d)", (int)kids[i]);
+         int id = jobs_add(pgid, &kids[i], 1, cmdline, 1);
+         if (id == -1) break;
+         // Started by someone else, so there is no stage of ours to take an exit status from
+         find_by_id(id)->num_stages = 0;
       }
+      DEBUG_JOBS("adopted orphan %d (pgid %d)", (int)kids[i], (int)pgid);
+      adopted++;
    }
+   free(kids);
+   return adopted;
+}
+
+JobStatus jobs_get_status(int job_id) {
+   const Job* j = find_by_id(job_id);
+   return j ? j->status : JOB_DONE;
+}
+
+void jobs_print() {
+   int plus = plus_id();
 
    // Print each active job
-   for (int i = 0; i < MAX_JOBS; i++) {
-      if (job_table[i].status != JOB_DONE) {
+   for (const Job* j = job_head; j; j = j->next) {
+      if (j->status != JOB_DONE) {
          // Determine the sign: + for highest ID, - for others
-         char sign = (job_table[i].id == plus_id) ? '+' : '-';
-
-         // Status string
-         const char* status_str;
-         switch (job_table[i].status) {
-         case JOB_RUNNING:
-            status_str = "Running";
-            break;
-         case JOB_STOPPED:
-            status_str = "Stopped";
-            break;
-         default:
-            status_str = "Unknown";
-            break;
-         }
+         char sign = (j->id == plus) ? '+' : '-';
 
          // Print: [id] sign status cmdline
-         printf("[%d] %c %s %s\n", job_table[i].id, sign, status_str, job_table[i].cmdline);
+         printf("[%d] %c %s%s %s\n",
+                j->id,
+                sign,
+                status_name(j->status),
+                overrun_note(j),
+                j->cmdline);
       }
    }
 }
 
-int jobs_pick_most_recent_for_fg(void) {
-   int highest_id = -1;
-
-   for (int i = 0; i < MAX_JOBS; i++) {
-      if ((job_table[i].status == JOB_RUNNING || job_table[i].status == JOB_STOPPED) &&
-          job_table[i].id > highest_id) {
-         highest_id = job_table[i].id;
+void jobs_print_long(void) {
+   int plus = plus_id();
+
+   for (const Job* j = job_head; j; j = j->next) {
+      if (j->status == JOB_DONE) continue;
+      char sign = (j->id == plus) ? '+' : '-';
+      printf("[%d] %c %d %s%s %s\n",
+             j->id,
+             sign,
+             (int)j->pgid,
+             status_name(j->status),
+             overrun_note(j),
+             j->cmdline);
+      if (j->status == JOB_PENDING) {
+         printf("      held %.3fs\n", now_seconds() - j->held_since);
+         continue;
+      }
+      printf("      user %.3fs sys %.3fs maxrss %ldK ctxsw %ld/%ld wall %.3fs\n",
+             j->usage.user,
+             j->usage.sys,
+             j->usage.max_rss,
+             j->usage.nvcsw,
+             j->usage.nivcsw,
+             jobs_usage_elapsed(&j->usage));
+      if (j->held_since > 0) printf("      held %.3fs before it started\n", j->held);
+      if (j->rclass[0]) printf("      class %s\n", j->rclass);
+      if (has_budget(&j->budget)) {
+         printf("      budget wall %gs cpu %gs grace %gs\n",
+                j->budget.limit.wall,
+                j->budget.limit.cpu,
+                j->budget.limit.grace);
+      }
+      if (j->num_stages > 0 && j->num_procs > j->num_stages) {
+         printf("      adopted");
+         for (int i = j->num_stages; i < j->num_procs; i++) {
+            if (j->procs[i].status != JOB_DONE) printf(" %d", (int)j->procs[i].pid);
+         }
+         printf("\n");
       }
    }
+}
 
-   return highest_id;
+void jobs_set_rclass(pid_t pgid, const char* label) {
+   Job* j = find_by_pgid(pgid);
+   if (j) snprintf(j->rclass, sizeof(j->rclass), "%s", label);
 }
 
-int jobs_pick_most_recent_stopped_for_bg(void) {
-   int highest_id = -1;
+void jobs_set_budget(pid_t pgid, const JobBudget* budget) {
+   Job* j = find_by_pgid(pgid);
+   if (!j || !has_budget(budget)) return;
+   if (!has_budget(&j->budget)) budget_count++;
+   j->budget = *budget;
+}
 
-   for (int i = 0; i < MAX_JOBS; i++) {
-      if (job_table[i].status == JOB_STOPPED && job_table[i].id > highest_id) {
-         highest_id = job_table[i].id;
-      }
+void jobs_budget_start(JobBudget* budget, const Budget* limit) {
+   memset(budget, 0, sizeof(*budget));
+   budget->limit = *limit;
+   budget->started = now_seconds();
+}
+
+double jobs_budget_check(JobBudget* budget, pid_t pgid, const pid_t* pids, int n, double cpu_used) {
+   double now = now_seconds();
+   if (budget->overrun != BUDGET_OK) {
+      if (budget->kill_at == 0 || now < budget->kill_at) return budget->kill_at;
+      DEBUG_JOBS("budget grace over, killing pgid %d", (int)pgid);
+      signal_members(pgid, pids, n, SIGKILL);
+      budget->kill_at = 0;
+      return 0;
    }
 
-   return highest_id;
+   double next = 0;
+   if (budget->limit.wall > 0) {
+      next = budget->started + budget->limit.wall;
+      if (now >= next) budget->overrun = BUDGET_WALL;
+   }
+   if (budget->overrun == BUDGET_OK && budget->limit.cpu > 0) {
+      for (int i = 0; i < n; i++) {
+         if (pids[i] > 0) cpu_used += proctree_cpu_seconds(pids[i]);
+      }
+      double left = budget->limit.cpu - cpu_used;
+      if (left <= 0) {
+         budget->overrun = BUDGET_CPU;
+      } else {
+         // Every CPU busy is the fastest the rest can be used up, so nothing is missed until then
+         static long cpus = 0;
+         if (cpus == 0) cpus = sysconf(_SC_NPROCESSORS_ONLN);
+         if (cpus <= 0) cpus = 1;
+         double wait = left / (double)cpus;
+         if (wait < BUDGET_CPU_TICK) wait = BUDGET_CPU_TICK;
+         if (next == 0 || now + wait < next) next = now + wait;
+      }
+   }
+   if (budget->overrun == BUDGET_OK) return next;
+
+   // A stopped job is continued so that it can act on the SIGTERM
+   DEBUG_JOBS("pgid %d over its %s budget",
+              (int)pgid,
+              budget->overrun == BUDGET_WALL ? "wall" : "cpu");
+   signal_members(pgid, pids, n, budget->limit.grace > 0 ? SIGTERM : SIGKILL);
+   signal_members(pgid, pids, n, SIGCONT);
+   budget->kill_at = budget->limit.grace > 0 ? now + budget->limit.grace : 0;
+   return budget->kill_at;
 }
 
-pid_t jobs_get_pgid(int job_id) {
-   for (int i = 0; i < MAX_JOBS; i++) {
-      if (job_table[i].id == job_id) {
-         return job_table[i].pgid;
+double jobs_enforce_budgets(void) {
+   if (budget_count == 0) return 0;
+
+   double next = 0;
+   for (Job* j = job_head; j; j = j->next) {
+      if (j->status == JOB_DONE || !has_budget(&j->budget)) continue;
+      pid_t* pids = malloc(j->num_procs * sizeof(pid_t));
+      if (!pids) continue;
+      int n = 0;
+      for (int i = 0; i < j->num_procs; i++) {
+         if (j->procs[i].status != JOB_DONE) pids[n++] = j->procs[i].pid;
       }
+      double due = jobs_budget_check(&j->budget, j->pgid, pids, n, j->usage.user + j->usage.sys);
+      free(pids);
+      if (due > 0 && (next == 0 || due < next)) next = due;
    }
+   return next;
+}
 
-   return -1; // Job not found
+void jobs_add_usage(pid_t pgid, const JobUsage* usage) {
+   Job* j = find_by_pgid(pgid);
+   if (j) jobs_usage_merge(&j->usage, usage);
 }
 
-void jobs_reap_done_and_print(void) {
-   // First pass: print "Done" messages for completed background jobs only
-   for (int i = 0; i < MAX_JOBS; i++) {
-      if (job_table[i].status == JOB_DONE && job_table[i].id != 0 && job_table[i].is_background) {
-         // [id] - Done <cmdline>
-         printf("[%d] - Done %s\n", job_table[i].id, job_table[i].cmdline);
-         fflush(stdout);
-      }
+void jobs_usage_start(JobUsage* usage) {
+   usage->started = now_seconds();
+}
+
+void jobs_usage_merge(JobUsage* dst, const JobUsage* src) {
+   dst->user += src->user;
+   dst->sys += src->sys;
+   if (src->max_rss > dst->max_rss) dst->max_rss = src->max_rss;
+   dst->nvcsw += src->nvcsw;
+   dst->nivcsw += src->nivcsw;
+   if (src->started > 0 && (dst->started == 0 || src->started < dst->started)) {
+      dst->started = src->started;
    }
+}
 
-   // Second pass: compact the array by removing done jobs
-   int write_pos = 0;
-   for (int read_pos = 0; read_pos < MAX_JOBS; read_pos++) {
-      if (job_table[read_pos].status != JOB_DONE) {
-         // Keep this job - copy to write position if different
-         if (write_pos != read_pos) {
-            job_table[write_pos] = job_table[read_pos];
-         }
-         write_pos++;
-      } else {
-         // This job is done - clear it
-         job_table[read_pos].id = 0;
-         job_table[read_pos].pgid = 0;
-         job_table[read_pos].cmdline[0] = '\0';
-         job_table[read_pos].status = JOB_DONE;
-         job_table[read_pos].is_background = 0;
-      }
+double jobs_usage_elapsed(const JobUsage* usage) {
+   return usage->started > 0 ? now_seconds() - usage->started : 0;
+}
+
+pid_t jobs_wait(pid_t pid, int* status, int options, JobUsage* usage) {
+   struct rusage ru;
+   pid_t r = wait4(pid, status, options, &ru);
+   // A stop reports usage so far, which would be counted again at exit; only count exits
+   if (r > 0 && usage && (WIFEXITED(*status) || WIFSIGNALED(*status))) {
+      usage->user += tv_seconds(ru.ru_utime);
+      usage->sys += tv_seconds(ru.ru_stime);
+#ifdef __APPLE__
+      long rss = ru.ru_maxrss / 1024; // bytes on macOS
+#else
+      long rss = ru.ru_maxrss; // KB on Linux and the BSDs
+#endif
+      if (rss > usage->max_rss) usage->max_rss = rss;
+      usage->nvcsw += ru.ru_nvcsw;
+      usage->nivcsw += ru.ru_nivcsw;
    }
+   return r;
+}
+
+int jobs_pick_most_recent_for_fg(void) {
+   // Every unfinished job is running or stopped
+   return plus_id();
+}
 
-   // Clear any remaining slots after compaction
-   for (int i = write_pos; i < MAX_JOBS; i++) {
-      job_table[i].id = 0;
-      job_table[i].pgid = 0;
-      job_table[i].cmdline[0] = '\0';
-      job_table[i].status = JOB_DONE;
-      job_table[i].is_background = 0;
+int jobs_pick_most_recent_stopped_for_bg(void) {
+   for (const Job* j = job_tail; j; j = j->prev) {
+      if (j->status == JOB_STOPPED) return j->id;
    }
+   return -1;
+}
 
-   // Update job count
-   job_count = write_pos;
+pid_t jobs_get_pgid(int job_id) {
+   const Job* j = find_by_id(job_id);
+   return j ? j->pgid : -1; // -1: job not found
 }
 
-void jobs_print_one(int job_id) {
-   // Find the highest ID among active jobs (the "+" job)
-   int plus_id = -1;
-   for (int i = 0; i < MAX_JOBS; i++) {
-      if (job_table[i].status != JOB_DONE && job_table[i].id > plus_id) {
-         plus_id = job_table[i].id;
+void jobs_reap_done_and_print(void) {
+   if (done_count == 0) return;
+
+   // Print "Done" messages for completed background jobs only, then drop every done job
+   Job* j = job_head;
+   while (j) {
+      Job* next = j->next;
+      if (j->status == JOB_DONE) {
+         if (j->is_background) {
+            // [id] - Done <cmdline>
+            printf("[%d] - Done%s %s\n", j->id, overrun_note(j), j->cmdline);
+            fflush(stdout);
+         }
+         job_remove(j);
       }
+      j = next;
    }
+}
 
-   // Find and print the specific job
-   for (int i = 0; i < MAX_JOBS; i++) {
-      if (job_table[i].id == job_id) {
-         // Determine the sign: + for highest ID, - for others
-         char sign = (job_table[i].id == plus_id) ? '+' : '-';
-         printf("[%d] %c Running %s &\n", job_table[i].id, sign, job_table[i].cmdline);
-         break;
-      }
+int jobs_reap_job(int job_id) {
+   Job* j = find_by_id(job_id);
+   if (!j || j->status != JOB_DONE) return -1;
+   int code = j->exit_code;
+   job_remove(j);
+   return code;
+}
+
+int jobs_live_pids(int job_id, pid_t* pids, int max) {
+   const Job* j = find_by_id(job_id);
+   if (!j) return -1;
+   int n = 0;
+   for (int i = 0; i < j->num_procs; i++) {
+      if (j->procs[i].status == JOB_DONE) continue;
+      if (n < max) pids[n] = j->procs[i].pid;
+      n++;
    }
+   return n;
 }
 
-const char* jobs_get_cmdline(int job_id) {
-   for (int i = 0; i < MAX_JOBS; i++) {
-      if (job_table[i].id == job_id) {
-         return job_table[i].cmdline;
-      }
+int jobs_background_ids(int* ids, int max) {
+   int n = 0;
+   for (const Job* j = job_head; j && n < max; j = j->next) {
+      if (j->is_background) ids[n++] = j->id;
    }
-   return NULL;
+   return n;
+}
+
+int jobs_has_done(void) {
+   return done_count > 0;
+}
+
+void jobs_print_one(int job_id) {
+   const Job* j = find_by_id(job_id);
+   if (!j) return;
+
+   // Determine the sign: + for the highest unfinished ID, - for others
+   char sign = (j->id == plus_id()) ? '+' : '-';
+   printf("[%d] %c Running %s &\n", j->id, sign, j->cmdline);
+}
+
+const char* jobs_get_cmdline(int job_id) {
+   const Job* j = find_by_id(job_id);
+   return j ? j->cmdline : NULL;
+}
+
+int jobs_count(void) {
+   return job_count;
 }
 
 void jobs_set_background(pid_t pgid, int is_bg) {
-   for (int i = 0; i < MAX_JOBS; i++) {
-      if (job_table[i].pgid == pgid && job_table[i].status != JOB_DONE) {
-         job_table[i].is_background = is_bg;
-         break;
-      }
-   }
+   Job* j = find_by_pgid(pgid);
+   if (j) j->is_background = is_bg;
+}
+
+pid_t jobs_last_background(void) {
+   return last_bg_pgid;
+}
+
+int jobs_find_pgid(pid_t pgid) {
+   const Job* j = index_bits ? find_by_pgid_any(pgid) : NULL;
+   return j ? j->id : -1;
+}
+
+void jobs_set_done_hook(JobDoneHook hook) {
+   done_hook = hook;
 }
@@ -0,0 +1,285 @@
+/**
+ * @file launch.c
+ * @author Nathan Lemma
+ * @brief Process launch backends for the YASH shell
+ * @date 10-17-2026
+ * @details This file contains the posix_spawn launch path and the fork + exec fallback. The
+ * spawn path expresses the process group, signal defaults and redirections as spawn attributes
+ * and file actions, so the shell never has to copy its own page tables to start a command.
+ * Redirection targets are opened by the shell once, before launch, by either backend.
+ */
+
+// ============================================================================
+// Includes
+// ============================================================================
+
+#include "../include/launch.h"
+#include "../include/builtins.h"
+#include "../include/debug.h"
+#include "../include/funcs.h"
+#include "../include/options.h"
+#include "../include/pathcache.h"
+#include "../include/rclass.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+extern char** environ;
+
+// ============================================================================
+// Static Functions
+// ============================================================================
+
+/**
+ * @brief Move one descriptor onto a standard descriptor in a forked child
+ *
+ * @param fd Source descriptor, -1 for none
+ * @param target STDIN_FILENO, STDOUT_FILENO or STDERR_FILENO
+ */
+static void move_fd(int fd, int target) {
+   if (fd == -1) return;
+   if (fd == target) {
+      // dup2 would be a no-op and leave close-on-exec set
+      fcntl(fd, F_SETFD, 0);
+      return;
+   }
+   dup2(fd, target);
+}
+
+/**
+ * @brief Set up signals and redirections in a forked child. Didn't wanna rewrite it 3 times
+ *
+ * The sources are all close-on-exec, so only the standard descriptors survive exec.
+ *
+ * @param fds
+ */
+static void setup_redirections(const Redirects* fds) {
+
+   // Restore the regular signals so that the child process can be cancelled
+   signal(SIGINT, SIG_DFL);
+   signal(SIGTSTP, SIG_DFL); // Child should handle SIGTSTP with default behavior
+   signal(SIGPIPE, SIG_DFL);
+
+   // The shell keeps SIGCHLD blocked for its signalfd; a command starts with nothing blocked
+   sigset_t empty;
+   sigemptyset(&empty);
+   sigprocmask(SIG_SETMASK, &empty, NULL);
+
+   move_fd(fds->in_fd, STDIN_FILENO);
+   move_fd(fds->out_fd, STDOUT_FILENO);
+   move_fd(fds->err_fd, STDERR_FILENO);
+}
+
+/**
+ * @brief Run a builtin in a forked child (a pipeline stage or a background job)
+ *
+ * @param b
+ * @param cmd
+ * @param pgid
+ * @param fds
+ * @param rc Resource class to apply, NULL for none
+ * @return pid_t
+ */
+static pid_t launch_builtin(const Builtin* b,
+                            const Command* cmd,
+                            pid_t pgid,
+                            const Redirects* fds,
+                            const ResourceClass* rc) {
+   // Buffered shell output must not be written twice
+   fflush(stdout);
+   fflush(stderr);
+
+   pid_t pid = fork();
+   if (pid < 0) {
+      DEBUG_EXEC("fork() failed (launch_builtin): %s", strerror(errno));
+      return -1;
+   }
+
+   if (pid == 0) {
+      setpgid(0, pgid);
+      setup_redirections(fds);
+      if (rc && rclass_apply(rc) == -1) _exit(126);
+      int status = b->run(cmd->argv);
+      fflush(stdout);
+      fflush(stderr);
+      _exit(status);
+   }
+
+   setpgid(pid, pgid ? pgid : pid);
+   return pid;
+}
+
+/**
+ * @brief Launch with fork + exec
+ *
+ * @param cmd
+ * @param pgid
+ * @param fds
+ * @param rc Resource class to apply, NULL for none
+ * @return pid_t
+ */
+static pid_t launch_fork(const Command* cmd,
+                         pid_t pgid,
+                         const Redirects* fds,
+                         const ResourceClass* rc) {
+   // Resolve in the parent so the table outlives the child
+   const char* path = pathcache_lookup(cmd->argv[0]);
+   if (!path) {
+      errno = ENOENT;
+      return -1;
+   }
+
+   pid_t pid = fork();
+
+   if (pid < 0) { // fork() failed
+      DEBUG_EXEC("fork() failed (launch_fork): %s", strerror(errno));
+      return -1;
+   }
+
+   if (pid == 0) {
+      // Child
+      DEBUG_EXEC("Child process starting, PID: %d", getpid());
+      setpgid(0, pgid);
+      setup_redirections(fds);
+      if (rc && rclass_apply(rc) == -1) _exit(126);
+
+      execve(path, cmd->argv, environ);
+
+      // A stale hash entry: fall back to a full PATH search
+      if (errno == ENOENT && path != cmd->argv[0]) execvp(cmd->argv[0], cmd->argv);
+
+      // You shouldn't be here :(
+      DEBUG_EXEC("exec failed: %s", strerror(errno));
+      if (errno == ENOENT) _exit(127);
+      _exit(126);
+   }
+
+   // Parent: set the group too so there is no race with the child
+   setpgid(pid, pgid ? pgid : pid);
+   return pid;
+}
+
+/**
+ * @brief Launch with posix_spawn
+ *
+ * @param cmd
+ * @param pgid
+ * @param fds
+ * @return pid_t
+ */
+static pid_t launch_spawn(const Command* cmd, pid_t pgid, const Redirects* fds) {
+   posix_spawn_file_actions_t fa;
+   posix_spawnattr_t attr;
+   sigset_t defaults, empty;
+   pid_t pid = -1;
+   int rc;
+
+   if ((rc = posix_spawn_file_actions_init(&fa)) != 0) {
+      errno = rc;
+      return -1;
+   }
+   if ((rc = posix_spawnattr_init(&attr)) != 0) {
+      posix_spawn_file_actions_destroy(&fa);
+      errno = rc;
+      return -1;
+   }
+
+   // Process group and signal state, same as setup_redirections() does after fork
+   sigemptyset(&defaults);
+   sigaddset(&defaults, SIGINT);
+   sigaddset(&defaults, SIGTSTP);
+   sigaddset(&defaults, SIGPIPE);
+   sigemptyset(&empty);
+   posix_spawnattr_setflags(
+       &attr, POSIX_SPAWN_SETPGROUP | POSIX_SPAWN_SETSIGDEF | POSIX_SPAWN_SETSIGMASK);
+   posix_spawnattr_setpgroup(&attr, pgid);
+   posix_spawnattr_setsigdefault(&attr, &defaults);
+   posix_spawnattr_setsigmask(&attr, &empty);
+
+   // The sources are close-on-exec, so the dup2s are the only file actions needed
+   if (fds->in_fd != -1) posix_spawn_file_actions_adddup2(&fa, fds->in_fd, STDIN_FILENO);
+   if (fds->out_fd != -1) posix_spawn_file_actions_adddup2(&fa, fds->out_fd, STDOUT_FILENO);
+   if (fds->err_fd != -1) posix_spawn_file_actions_adddup2(&fa, fds->err_fd, STDERR_FILENO);
+
+   const char* path = pathcache_lookup(cmd->argv[0]);
+   rc = path ? posix_spawn(&pid, path, &fa, &attr, cmd->argv, environ) : ENOENT;
+   if (rc == ENOENT && path && path != cmd->argv[0] && access(path, F_OK) != 0) {
+      // The hashed binary went away; forget it and search PATH once more
+      pathcache_forget(cmd->argv[0]);
+      path = pathcache_lookup(cmd->argv[0]);
+      if (path) rc = posix_spawn(&pid, path, &fa, &attr, cmd->argv, environ);
+   }
+
+   posix_spawnattr_destroy(&attr);
+   posix_spawn_file_actions_destroy(&fa);
+
+   if (rc != 0) {
+      DEBUG_EXEC("posix_spawn failed: %s", strerror(rc));
+      errno = rc;
+      return -1;
+   }
+   return pid;
+}
+
+// ============================================================================
+// Public Functions
+// ============================================================================
+
+int redirects_open(const Command* cmd, Redirects* fds, const char** failed) {
+   const int out_flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+   const char* files[3] = {cmd->in_file, cmd->out_file, cmd->err_file};
+   const int flags[3] = {O_RDONLY | O_CLOEXEC, out_flags, out_flags};
+   int* slots[3] = {&fds->in_fd, &fds->out_fd, &fds->err_fd};
+
+   fds->in_fd = fds->out_fd = fds->err_fd = -1;
+   if (failed) *failed = NULL;
+
+   for (int i = 0; i < 3; i++) {
+      if (!files[i]) continue;
+      *slots[i] = open(files[i], flags[i], FILE_CREATE_MODE);
+      if (*slots[i] < 0) {
+         int saved = errno;
+         DEBUG_EXEC("Opening %s failed: %s", files[i], strerror(saved));
+         redirects_close(fds);
+         if (failed) *failed = files[i];
+         errno = saved;
+         return -1;
+      }
+   }
+   return 0;
+}
+
+void redirects_close(Redirects* fds) {
+   if (fds->in_fd != -1) close(fds->in_fd);
+   if (fds->out_fd != -1) close(fds->out_fd);
+   if (fds->err_fd != -1) close(fds->err_fd);
+   fds->in_fd = fds->out_fd = fds->err_fd = -1;
+}
+
+pid_t launch_command(const Command* cmd,
+                     pid_t pgid,
+                     const Redirects* fds,
+                     const ResourceClass* rc) {
+   static const Redirects inherit = {-1, -1, -1};
+   if (!cmd || !cmd->argv[0]) {
+      errno = EINVAL;
+      return -1;
+   }
+   if (!fds) fds = &inherit;
+
+   const Builtin* b = funcs_builtin(cmd->argv[0]);
+   if (!b) b = builtin_find(cmd->argv[0]);
+   if (b) return launch_builtin(b, cmd, pgid, fds, rc);
+
+   // posix_spawn has no hook to run code before exec, so a class always takes the fork path
+   if (rc || shell_options.launch == LAUNCH_FORK) {
+      return launch_fork(cmd, pgid, fds, rc);
+   }
+   return launch_spawn(cmd, pgid, fds);
+}
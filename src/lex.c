@@ -0,0 +1,327 @@
+/**
+ * @file lex.c
+ * @author Nathan Lemma
+ * @brief Vectorized lexer for the YASH shell
+ * @date 10-17-2026
+ * @details This file contains the lexer. The vector paths turn each 64-byte block of the line
+ * into two bitmasks, one of blanks and one of operator bytes. A token starts at a non-blank whose
+ * previous byte is blank and ends at a blank whose previous byte is not, so shifting the blank
+ * mask by one (carrying the last bit into the next block) gives every start and end in the block
+ * at once; only those bits are visited. Tokens whose first byte is an operator byte are the only
+ * ones classified by looking at their text.
+ */
+
+// ============================================================================
+// Includes
+// ============================================================================
+
+#include "../include/lex.h"
+#include <stdint.h>
+#include <string.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define LEX_X86 1
+#include <immintrin.h>
+#endif
+
+// ============================================================================
+// Constants
+// ============================================================================
+
+/** @brief Bytes the vector paths classify per step, one bit each in a uint64_t */
+#define LEX_BLOCK 64
+
+// ============================================================================
+// Static Globals
+// ============================================================================
+
+static LexBackend backend; ///< Implementation in use
+static int selected;       ///< backend has been chosen
+
+// ============================================================================
+// Static Functions
+// ============================================================================
+
+/**
+ * @brief Blank test shared by every implementation
+ */
+static inline int is_blank(char c) {
+   return c == ' ' || c == '\t';
+}
+
+/**
+ * @brief Whether a token starting with @p c may be an operator
+ */
+static inline int is_operator_start(char c) {
+   return c == '<' || c == '>' || c == '|' || c == '&' || c == ';' || c == '\n' || c == '2';
+}
+
+/**
+ * @brief Kind of a token that starts with an operator byte
+ *
+ * @param t Token start
+ * @param n Token length
+ * @return TokenKind enum
+ */
+static TokenKind span_kind(const char* t, size_t n) {
+   if (n == 1) {
+      switch (t[0]) {
+      case '<':
+         return TK_REDIR_IN;
+      case '>':
+         return TK_REDIR_OUT;
+      case '|':
+         return TK_PIPE;
+      case '&':
+         return TK_AMP;
+      case ';':
+         return TK_SEMI;
+      case '\n':
+         return TK_NEWLINE;
+      default:
+         return TK_WORD;
+      }
+   }
+   if (n == 2) {
+      if (t[0] == '2' && t[1] == '>') return TK_REDIR_ERR;
+      if (t[0] == '&' && t[1] == '&') return TK_AND;
+      if (t[0] == '|' && t[1] == '|') return TK_OR;
+      if (t[0] == ';' && t[1] == ';') return TK_DSEMI;
+   }
+   if (t[0] == '|' && t[1] == '[') return TK_PIPE;
+   return TK_WORD;
+}
+
+/**
+ * @brief Byte-at-a-time lexer
+ *
+ * @param line
+ * @param len
+ * @param tokens NULL to only count (the line is then left alone)
+ * @param kinds NULL if not wanted
+ * @return Number of tokens
+ */
+static size_t lex_scalar(char* line, size_t len, char* tokens[], TokenKind kinds[]) {
+   char* p = line;
+   char* end = line + len;
+   size_t n = 0;
+
+   while (p < end) {
+      while (p < end && is_blank(*p)) {
+         p++;
+      }
+      if (p == end) break;
+
+      char* start = p;
+      while (p < end && !is_blank(*p)) {
+         p++;
+      }
+      if (tokens) {
+         tokens[n] = start;
+         if (kinds) kinds[n] = is_operator_start(*start) ? span_kind(start, p - start) : TK_WORD;
+         if (p < end) *p++ = '\0';
+      }
+      n++;
+   }
+   return n;
+}
+
+#ifdef LEX_X86
+
+/**
+ * @brief Blank and operator-byte masks of 64 bytes
+ */
+typedef void (*BlockScan)(const char* p, uint64_t* blank, uint64_t* op);
+
+/**
+ * @brief BlockScan with SSE2, 16 bytes per compare
+ */
+__attribute__((target("sse2"))) static void scan_sse2(const char* p,
+                                                      uint64_t* blank,
+                                                      uint64_t* op) {
+   const __m128i space = _mm_set1_epi8(' ');
+   const __m128i tab = _mm_set1_epi8('\t');
+   const __m128i lt = _mm_set1_epi8('<');
+   const __m128i gt = _mm_set1_epi8('>');
+   const __m128i bar = _mm_set1_epi8('|');
+   const __m128i amp = _mm_set1_epi8('&');
+   const __m128i semi = _mm_set1_epi8(';');
+   const __m128i nl = _mm_set1_epi8('\n');
+   const __m128i two = _mm_set1_epi8('2');
+   uint64_t b = 0;
+   uint64_t o = 0;
+
+   for (int k = 0; k < LEX_BLOCK / 16; k++) {
+      __m128i v = _mm_loadu_si128((const __m128i*)(p + 16 * k));
+      __m128i is_b = _mm_or_si128(_mm_cmpeq_epi8(v, space), _mm_cmpeq_epi8(v, tab));
+      __m128i is_o = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, lt), _mm_cmpeq_epi8(v, gt)),
+                                  _mm_or_si128(_mm_cmpeq_epi8(v, bar), _mm_cmpeq_epi8(v, amp)));
+      __m128i is_s = _mm_or_si128(_mm_cmpeq_epi8(v, semi), _mm_cmpeq_epi8(v, nl));
+      is_o = _mm_or_si128(is_o, _mm_or_si128(is_s, _mm_cmpeq_epi8(v, two)));
+      b |= (uint64_t)(uint16_t)_mm_movemask_epi8(is_b) << (16 * k);
+      o |= (uint64_t)(uint16_t)_mm_movemask_epi8(is_o) << (16 * k);
+   }
+   *blank = b;
+   *op = o;
+}
+
+/**
+ * @brief BlockScan with AVX2, 32 bytes per compare
+ */
+__attribute__((target("avx2"))) static void scan_avx2(const char* p,
+                                                      uint64_t* blank,
+                                                      uint64_t* op) {
+   const __m256i space = _mm256_set1_epi8(' ');
+   const __m256i tab = _mm256_set1_epi8('\t');
+   const __m256i lt = _mm256_set1_epi8('<');
+   const __m256i gt = _mm256_set1_epi8('>');
+   const __m256i bar = _mm256_set1_epi8('|');
+   const __m256i amp = _mm256_set1_epi8('&');
+   const __m256i semi = _mm256_set1_epi8(';');
+   const __m256i nl = _mm256_set1_epi8('\n');
+   const __m256i two = _mm256_set1_epi8('2');
+   uint64_t b = 0;
+   uint64_t o = 0;
+
+   for (int k = 0; k < LEX_BLOCK / 32; k++) {
+      __m256i v = _mm256_loadu_si256((const __m256i*)(p + 32 * k));
+      __m256i is_b = _mm256_or_si256(_mm256_cmpeq_epi8(v, space), _mm256_cmpeq_epi8(v, tab));
+      __m256i is_o =
+          _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, lt), _mm256_cmpeq_epi8(v, gt)),
+                          _mm256_or_si256(_mm256_cmpeq_epi8(v, bar), _mm256_cmpeq_epi8(v, amp)));
+      __m256i is_s = _mm256_or_si256(_mm256_cmpeq_epi8(v, semi), _mm256_cmpeq_epi8(v, nl));
+      is_o = _mm256_or_si256(is_o, _mm256_or_si256(is_s, _mm256_cmpeq_epi8(v, two)));
+      b |= (uint64_t)(uint32_t)_mm256_movemask_epi8(is_b) << (32 * k);
+      o |= (uint64_t)(uint32_t)_mm256_movemask_epi8(is_o) << (32 * k);
+   }
+   *blank = b;
+   *op = o;
+}
+
+/**
+ * @brief Lexer over the masks of one BlockScan
+ *
+ * @param line
+ * @param len
+ * @param tokens NULL to only count (the line is then left alone)
+ * @param kinds NULL if not wanted
+ * @param scan
+ * @return Number of tokens
+ */
+static size_t lex_blocks(char* line,
+                         size_t len,
+                         char* tokens[],
+                         TokenKind kinds[],
+                         BlockScan scan) {
+   char tail[LEX_BLOCK];
+   uint64_t carry = 1; // The byte before the line counts as a blank
+   char* start = NULL;
+   int start_op = 0;
+   size_t n = 0;
+
+   for (size_t base = 0; base < len; base += LEX_BLOCK) {
+      uint64_t blank, op;
+      if (len - base >= LEX_BLOCK) {
+         scan(line + base, &blank, &op);
+      } else {
+         // The last partial block, padded with blanks so the final token ends inside it
+         memset(tail, ' ', sizeof(tail));
+         memcpy(tail, line + base, len - base);
+         scan(tail, &blank, &op);
+      }
+      uint64_t after_blank = (blank << 1) | carry;
+      uint64_t starts = ~blank & after_blank;
+      uint64_t ends = blank & ~after_blank;
+      carry = blank >> (LEX_BLOCK - 1);
+
+      if (!tokens) {
+         n += (size_t)__builtin_popcountll(starts);
+         continue;
+      }
+
+      // Starts and ends alternate; visit them in order
+      for (uint64_t edges = starts | ends; edges; edges &= edges - 1) {
+         int i = __builtin_ctzll(edges);
+         char* p = line + base + i;
+         if (starts >> i & 1) {
+            start = p;
+            start_op = (int)(op >> i & 1);
+            tokens[n] = p;
+         } else {
+            if (kinds) kinds[n] = start_op ? span_kind(start, p - start) : TK_WORD;
+            if (base + i < len) *p = '\0';
+            n++;
+            start = NULL;
+         }
+      }
+   }
+   // A line whose length is a multiple of LEX_BLOCK has no padding to end its last token
+   if (tokens && start) {
+      if (kinds) kinds[n] = start_op ? span_kind(start, line + len - start) : TK_WORD;
+      n++;
+   }
+   return n;
+}
+
+#endif
+
+/**
+ * @brief Pick the fastest implementation the CPU supports, once
+ */
+static void select_default(void) {
+   if (selected) return;
+   selected = 1;
+   backend = LEX_SCALAR;
+   if (lex_use(LEX_AVX2) == 0) return;
+   lex_use(LEX_SSE2);
+}
+
+/**
+ * @brief Run the selected implementation
+ */
+static size_t lex_run(char* line, size_t len, char* tokens[], TokenKind kinds[]) {
+   select_default();
+#ifdef LEX_X86
+   if (backend == LEX_AVX2) return lex_blocks(line, len, tokens, kinds, scan_avx2);
+   if (backend == LEX_SSE2) return lex_blocks(line, len, tokens, kinds, scan_sse2);
+#endif
+   return lex_scalar(line, len, tokens, kinds);
+}
+
+// ============================================================================
+// Public Functions
+// ============================================================================
+
+size_t lex_line(char* line, size_t len, char* tokens[], TokenKind kinds[]) {
+   return lex_run(line, len, tokens, kinds);
+}
+
+size_t lex_count(const char* line, size_t len) {
+   // Counting writes nothing
+   return lex_run((char*)line, len, NULL, NULL);
+}
+
+int lex_use(LexBackend which) {
+   int ok = which == LEX_SCALAR;
+#ifdef LEX_X86
+   __builtin_cpu_init();
+   if (which == LEX_SSE2) ok = __builtin_cpu_supports("sse2");
+   if (which == LEX_AVX2) ok = __builtin_cpu_supports("avx2");
+#endif
+   if (!ok) return -1;
+   backend = which;
+   selected = 1;
+   return 0;
+}
+
+const char* lex_name(void) {
+   select_default();
+   switch (backend) {
+   case LEX_SSE2:
+      return "sse2";
+   case LEX_AVX2:
+      return "avx2";
+   default:
+      return "scalar";
+   }
+}
@@ -0,0 +1,247 @@
+/**
+ * @file linecache.c
+ * @author Nathan Lemma
+ * @brief Parsed-line cache for the YASH shell
+ * @date 10-17-2026
+ * @details This file contains the parsed-line cache. A parsed Line needs nothing outside its own
+ * arena, so each entry keeps the Line it was parsed into and runs it as it is on a hit. The key is
+ * a hash of the whole text, eight bytes per multiply, and a hit is confirmed with one memcmp();
+ * both together cost a small fraction of tokenizing and parsing the line again. Entries sit in
+ * hash chains for lookup and in a list ordered by last use for eviction.
+ */
+
+// ============================================================================
+// Includes
+// ============================================================================
+
+#include "../include/linecache.h"
+#include "../include/funcs.h"
+#include "../include/options.h"
+#include "../include/parse.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ============================================================================
+// Constants
+// ============================================================================
+
+/** @brief Number of hash buckets (power of two) */
+#define LINECACHE_BUCKETS 256
+
+/** @brief Odd multiplier of the line hash (the 64-bit golden ratio) */
+#define LINE_HASH_K 0x9e3779b97f4a7c15ull
+
+// ============================================================================
+// Data Structures
+// ============================================================================
+
+/**
+ * @brief One cached line
+ */
+typedef struct CachedLine {
+   char* text;               ///< Line as typed (key)
+   size_t len;               ///< strlen(text)
+   uint64_t hash;            ///< line_hash(text)
+   unsigned long generation; ///< funcs_generation() when it was parsed
+   unsigned long hits;       ///< Lookups this entry answered
+   Line line;                ///< The parsed line
+   struct CachedLine* chain; ///< Next entry in the bucket chain
+   struct CachedLine* newer; ///< Entry used after this one, NULL for the newest
+   struct CachedLine* older; ///< Entry used before this one, NULL for the oldest
+} CachedLine;
+
+// ============================================================================
+// Static Globals
+// ============================================================================
+
+static CachedLine* buckets[LINECACHE_BUCKETS];
+static CachedLine* newest;   ///< Most recently used entry
+static CachedLine* oldest;   ///< Least recently used entry, evicted first
+static int num_lines;        ///< Entries cached
+static unsigned long hits;   ///< Lookups answered from the cache
+static unsigned long misses; ///< Lookups that parsed
+static Line uncached;        ///< Lines parsed with the cache turned off
+
+// ============================================================================
+// Static Functions
+// ============================================================================
+
+/**
+ * @brief Hash of a line, eight bytes at a time
+ *
+ * @param s
+ * @param len
+ * @return uint64_t
+ */
+static uint64_t line_hash(const char* s, size_t len) {
+   uint64_t h = len * LINE_HASH_K;
+   size_t i = 0;
+   for (; i + 8 <= len; i += 8) {
+      uint64_t w;
+      memcpy(&w, s + i, 8);
+      h = (((h << 5) | (h >> 59)) ^ w) * LINE_HASH_K;
+   }
+   if (i < len) {
+      uint64_t w = 0;
+      memcpy(&w, s + i, len - i);
+      h = (((h << 5) | (h >> 59)) ^ w) * LINE_HASH_K;
+   }
+   // The bucket comes from the low bits, which the multiplies alone mix poorly
+   return h ^ (h >> 32);
+}
+
+/**
+ * @brief Take an entry out of the use order
+ * @param e
+ */
+static void unlink_use(CachedLine* e) {
+   if (e->newer) {
+      e->newer->older = e->older;
+   } else {
+      newest = e->older;
+   }
+   if (e->older) {
+      e->older->newer = e->newer;
+   } else {
+      oldest = e->newer;
+   }
+   e->newer = e->older = NULL;
+}
+
+/**
+ * @brief Put an entry at the newest end of the use order
+ * @param e
+ */
+static void mark_used(CachedLine* e) {
+   e->older = newest;
+   e->newer = NULL;
+   if (newest) newest->newer = e;
+   newest = e;
+   if (!oldest) oldest = e;
+}
+
+/**
+ * @brief Remove an entry from the cache and free it
+ * @param e
+ */
+static void drop_entry(CachedLine* e) {
+   for (CachedLine** link = &buckets[e->hash & (LINECACHE_BUCKETS - 1)]; *link;
+        link = &(*link)->chain) {
+      if (*link == e) {
+         *link = e->chain;
+         break;
+      }
+   }
+   unlink_use(e);
+   line_free(&e->line);
+   free(e->text);
+   free(e);
+   num_lines--;
+}
+
+/**
+ * @brief Evict the least recently used entries until at most @p limit are left
+ * @param limit
+ */
+static void trim(int limit) {
+   while (num_lines > limit && oldest) {
+      drop_entry(oldest);
+   }
+}
+
+/**
+ * @brief Find the entry for a line
+ * @return The entry, NULL if the line is not cached
+ */
+static CachedLine* find_entry(const char* text, size_t len, uint64_t hash) {
+   for (CachedLine* e = buckets[hash & (LINECACHE_BUCKETS - 1)]; e; e = e->chain) {
+      if (e->hash == hash && e->len == len && memcmp(e->text, text, len) == 0) return e;
+   }
+   return NULL;
+}
+
+// ============================================================================
+// Public Functions
+// ============================================================================
+
+int linecache_parse(const char* text, Line** out) {
+   *out = NULL;
+   if (!text) return -1;
+
+   // A smaller limit takes effect here, never while a cached line may still be running
+   int limit = shell_options.line_cache;
+   trim(limit);
+   if (limit == 0) {
+      int result = parse_line(text, &uncached);
+      if (result == 0) *out = &uncached;
+      return result;
+   }
+
+   size_t len = strlen(text);
+   uint64_t hash = line_hash(text, len);
+   CachedLine* e = find_entry(text, len, hash);
+   if (e && e->generation == funcs_generation()) {
+      hits++;
+      e->hits++;
+      unlink_use(e);
+      mark_used(e);
+      *out = &e->line;
+      return 0;
+   }
+   // Parsed before the functions changed
+   if (e) drop_entry(e);
+   misses++;
+
+   e = calloc(1, sizeof(CachedLine));
+   if (!e || !(e->text = malloc(len + 1))) {
+      free(e);
+      // Out of memory for the entry: the line still runs, uncached
+      int result = parse_line(text, &uncached);
+      if (result == 0) *out = &uncached;
+      return result;
+   }
+   int result = parse_line(text, &e->line);
+   if (result != 0) {
+      free(e->text);
+      free(e);
+      return result;
+   }
+
+   memcpy(e->text, text, len + 1);
+   e->len = len;
+   e->hash = hash;
+   e->generation = funcs_generation();
+   CachedLine** bucket = &buckets[hash & (LINECACHE_BUCKETS - 1)];
+   e->chain = *bucket;
+   *bucket = e;
+   mark_used(e);
+   num_lines++;
+   trim(limit);
+   *out = &e->line;
+   return 0;
+}
+
+void linecache_clear(void) {
+   trim(0);
+   line_free(&uncached);
+}
+
+void linecache_stats(LineCacheStats* out) {
+   out->hits = hits;
+   out->misses = misses;
+   out->lines = num_lines;
+}
+
+void linecache_print(void) {
+   if (newest) printf("hits\tline\n");
+   for (const CachedLine* e = newest; e; e = e->older) {
+      printf("%4lu\t%s\n", e->hits, e->text);
+   }
+   printf("linecache: %d of %d lines, %lu hits, %lu misses\n",
+          num_lines,
+          shell_options.line_cache,
+          hits,
+          misses);
+}
@@ -3,25 +3,201 @@
  * @brief Main function for the YASH shell
  * @author Nathan Lemma
  * @date 09-16-2025
- * @details This file contains the main function for the YASH shell.
+ * @details This file contains the main function for the YASH shell. Between commands the shell
+ * sits in one wait on both its input and child state changes, so background jobs are updated (and,
+ * with `set -b`, reported) the moment they change rather than when the next line is entered. A
+ * timer in the same wait enforces the budgets of `timeout` jobs and rechecks pressure for held
+ * background jobs, and every child event lets the batch queue start its next entries.
  */
 
 // ============================================================================
 // Includes
 // ============================================================================
 
+#include "../include/admit.h"
 #include "../include/debug.h"
+#include "../include/events.h"
 #include "../include/exec.h"
 #include "../include/jobs.h"
+#include "../include/linecache.h"
+#include "../include/options.h"
 #include "../include/parse.h"
+#include "../include/queue.h"
 #include "../include/signals.h"
 #include "../include/yash.h"
+#include <errno.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <sys/types.h>
-#include <sys/wait.h>
 #include <unistd.h>
 
+// ============================================================================
+// Constants
+// ============================================================================
+
+/** @brief Starting size of the input buffer; it doubles up to parse_line_max() as needed */
+#define INPUT_BUFFER_INITIAL 4096
+
+// ============================================================================
+// Globals
+// ============================================================================
+
+static char* pending;       ///< Input read but not yet returned as a line
+static size_t pending_cap;  ///< Bytes allocated for pending
+static size_t pending_len;  ///< Bytes used in pending
+static size_t pending_used; ///< Bytes at the front of pending taken by the last line returned
+static int input_eof;       ///< read() hit end of input (or failed)
+static char* held;          ///< Lines of a compound command still missing its end, or NULL
+static char* last_line;     ///< Last command read, which `!!` runs again
+
+// ============================================================================
+// Static Functions
+// ============================================================================
+
+/**
+ * @brief Reap the children behind a child event and, with `set -b`, report finished jobs at once
+ * @param at_prompt The prompt is showing and must be redrawn after a report
+ */
+static void handle_children(int at_prompt) {
+   jobs_collect();
+   // Slots freed by finished queue entries are refilled before the report
+   queue_schedule();
+   if (!shell_options.notify || !at_prompt || !jobs_has_done()) return;
+   printf("\n");
+   jobs_reap_done_and_print();
+   printf("# ");
+   fflush(stdout);
+}
+
+/**
+ * @brief Act on whatever is due (held jobs, the batch queue, budgets) and arm the timer for the
+ * next check
+ */
+static void handle_timer(void) {
+   queue_schedule();
+   double check = admit_release();
+   double due = jobs_enforce_budgets();
+   events_set_timer(due == 0 || (check != 0 && check < due) ? check : due);
+}
+
+/**
+ * @brief Make room in the input buffer for more input
+ * @return 0 on success, -1 when the buffer holds parse_line_max() - 1 bytes without a newline
+ */
+static int grow_pending(void) {
+   if (pending_cap >= parse_line_max()) return -1;
+   size_t cap = pending_cap ? pending_cap * 2 : INPUT_BUFFER_INITIAL;
+   if (cap > parse_line_max()) cap = parse_line_max();
+   char* grown = realloc(pending, cap);
+   if (!grown) return -1;
+   pending = grown;
+   pending_cap = cap;
+   return 0;
+}
+
+/**
+ * @brief Read one command line, handling child events while waiting for it
+ *
+ * Input is read with read() into a buffer of our own rather than through stdio, so a complete
+ * line is never hidden in a stdio buffer while the shell blocks in the event wait. The buffer
+ * grows to fit the longest line; lines of parse_line_max() bytes or more are discarded whole.
+ *
+ * @return The line without its newline, inside the input buffer and valid until the next call;
+ *         NULL at end of input
+ */
+static char* read_line(void) {
+   int discarding = 0;
+
+   // Drop the line returned last time
+   if (pending_used) {
+      pending_len -= pending_used;
+      memmove(pending, pending + pending_used, pending_len);
+      pending_used = 0;
+   }
+
+   while (1) {
+      char* nl = pending ? memchr(pending, '\n', pending_len) : NULL;
+      if (nl || (input_eof && pending_len > 0)) {
+         // A final line without a newline still counts
+         size_t len = nl ? (size_t)(nl - pending) : pending_len;
+         pending[len] = '\0';
+         pending_used = nl ? len + 1 : len;
+         if (!discarding) return pending;
+         discarding = 0;
+         pending_len -= pending_used;
+         memmove(pending, pending + pending_used, pending_len);
+         pending_used = 0;
+         continue;
+      }
+      if (input_eof) return NULL;
+      if (pending_len + 1 >= pending_cap && grow_pending() == -1) {
+         DEBUG_PRINT("Command too long\n");
+         discarding = 1;
+         pending_len = 0;
+      }
+
+      int ready = events_wait(-1);
+      if (ready == -1) {
+         input_eof = 1;
+         continue;
+      }
+      if (ready & EVENT_CHILD) handle_children(1);
+      if (ready & EVENT_TIMER) handle_timer();
+      if (ready & EVENT_INPUT) {
+         ssize_t n = read(STDIN_FILENO, pending + pending_len, pending_cap - 1 - pending_len);
+         if (n > 0) {
+            pending_len += n;
+         } else if (n == 0 || (errno != EINTR && errno != EAGAIN)) {
+            input_eof = 1;
+         }
+      }
+   }
+}
+
+/**
+ * @brief Add a line to the compound command being read
+ *
+ * Lines are kept joined by a newline token, which separates commands the way the line break did.
+ *
+ * @param line
+ * @return The whole command so far (held), NULL if it no longer fits parse_line_max()
+ */
+static char* hold_line(const char* line) {
+   size_t have = held ? strlen(held) : 0;
+   size_t len = strlen(line);
+   if (have + len + 4 > parse_line_max()) return NULL;
+   char* grown = realloc(held, have + len + 4);
+   if (!grown) return NULL;
+   held = grown;
+   if (have) {
+      memcpy(held + have, " \n ", 3);
+      have += 3;
+   }
+   memcpy(held + have, line, len + 1);
+   return held;
+}
+
+/**
+ * @brief Drop a partly read compound command
+ */
+static void drop_held(void) {
+   free(held);
+   held = NULL;
+}
+
+/**
+ * @brief Keep a complete command for `!!`
+ * @param line
+ */
+static void remember_line(const char* line) {
+   if (line == last_line) return;
+   char* copy = strdup(line);
+   if (!copy) return;
+   free(last_line);
+   last_line = copy;
+}
+
 // ============================================================================
 // Main Function
 // ============================================================================
@@ -34,92 +210,78 @@ int main() {
 
    setup_signal_handlers();
    jobs_init();
+   if (events_init(STDIN_FILENO) == -1) return 1;
+
+   // Like `set -b` in an interactive shell; scripts keep the report-at-prompt order
+   shell_options.notify = isatty(STDIN_FILENO);
 
    DEBUG_PRINT("YASH shell starting");
 
    while (1) {
-      // Check for any background job state changes first
-      if (child_status_changed) {
-         child_status_changed = 0;
-         pid_t pid;
-         int status;
-         while ((pid = waitpid(-1, &status, WNOHANG | WUNTRACED | WCONTINUED)) > 0) {
-            pid_t pg = getpgid(pid);
-            pid_t key = (pg == -1) ? pid : pg; // fallback to PID if getpgid fails
-            if (WIFSTOPPED(status)) {
-               jobs_mark(key, JOB_STOPPED);
-            } else if (WIFCONTINUED(status)) {
-               jobs_mark(key, JOB_RUNNING);
-            } else if (WIFEXITED(status) || WIFSIGNALED(status)) {
-               jobs_mark(key, JOB_DONE);
-            }
-            DEBUG_PRINT("Background child %d changed state", pid);
-         }
-      }
+      // Children that changed state while the last command ran (or while lines were buffered)
+      int ready = events_wait(0);
+      if (ready > 0 && (ready & EVENT_CHILD)) handle_children(0);
+      handle_timer();
 
       // Reap done jobs and print "Done" messages before prompt
       jobs_reap_done_and_print();
 
-      printf("# ");
+      // `> ` while a compound command is missing its end
+      printf(held ? "> " : "# ");
       fflush(stdout);
 
-      char buffer[MAX_CMDLINE];
-      if (!fgets(buffer, sizeof(buffer), stdin)) {
+      char* buffer = read_line();
+      if (!buffer) {
          DEBUG_PRINT("EOF received, exiting shell");
          break;
       }
 
-      size_t len = strlen(buffer);
-      if (len == MAX_CMDLINE - 1 && buffer[len - 1] != '\n') {
-         int c;
-         while ((c = getchar()) != EOF && c != '\n') {
-            // Intentionally empty - consume remaining characters
-         }
-         DEBUG_PRINT("Command too long\n");
-         continue;
-      }
-
-      // Remove the newline character
-      if (len > 0 && buffer[len - 1] == '\n') buffer[len - 1] = '\0';
-
       // If the buffer is empty, reprompt
       if (buffer[0] == '\0') continue;
 
-      Line line;
-      memset(&line, 0, sizeof(line));
+      if (held) {
+         buffer = hold_line(buffer);
+         if (!buffer) {
+            DEBUG_PRINT("Command too long");
+            drop_held();
+            continue;
+         }
+      } else if (strcmp(buffer, "!!") == 0) {
+         // The last command again, shown first as bash shows it
+         if (!last_line) {
+            fprintf(stderr, "yash: !!: event not found\n");
+            continue;
+         }
+         printf("%s\n", last_line);
+         buffer = last_line;
+      }
 
-      int result = parse_line(buffer, &line);
+      // A line seen before runs from the Line it was parsed into then
+      Line* line;
+      int result = linecache_parse(buffer, &line);
+      if (result == PARSE_INCOMPLETE) {
+         // The first line is still in the input buffer, which the next read reuses
+         if (!held && !hold_line(buffer)) {
+            DEBUG_PRINT("Command too long");
+         }
+         continue;
+      }
+      remember_line(buffer);
+      drop_held();
       if (result == 0) {
          DEBUG_PRINT("Parsing successful, executing command");
-         int exec_result = execute_line(&line);
+         int exec_result = execute_line(line);
          if (exec_result == -1) {
             // Internal error (pipe/fork/etc). Log only, no user newline here.
             DEBUG_PRINT("Execution internal error");
          }
-         // Check if any child processes changed state
-         if (child_status_changed) {
-            child_status_changed = 0; // Reset the flag
-            pid_t pid;
-            int status;
-            // Wait for any child that changed state (died, stopped, continued)
-            while ((pid = waitpid(-1, &status, WNOHANG | WUNTRACED | WCONTINUED)) > 0) {
-               // Child process changed state - update job table
-               pid_t pg = getpgid(pid);
-               pid_t key = (pg == -1) ? pid : pg; // fallback to PID if getpgid fails
-               if (WIFSTOPPED(status)) {
-                  jobs_mark(key, JOB_STOPPED);
-               } else if (WIFCONTINUED(status)) {
-                  jobs_mark(key, JOB_RUNNING);
-               } else if (WIFEXITED(status) || WIFSIGNALED(status)) {
-                  jobs_mark(key, JOB_DONE);
-               }
-               DEBUG_PRINT("Child %d changed state", pid);
-            }
-         }
       } else if (result == -1) {
          DEBUG_PRINT("Parsing failed, invalid command");
          fflush(stdout);
       }
    }
+   drop_held();
+   free(last_line);
+   linecache_clear();
    return 0;
 }
@@ -0,0 +1,246 @@
+/**
+ * @file options.c
+ * @author Nathan Lemma
+ * @brief Shell options for the YASH shell
+ * @date 10-17-2026
+ * @details This file contains the shell option table and the `set` builtin helpers.
+ */
+
+// ============================================================================
+// Includes
+// ============================================================================
+
+#include "../include/options.h"
+#include "../include/debug.h"
+#include "../include/linecache.h"
+#include "../include/parse.h"
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef __linux__
+#include <sys/prctl.h>
+#endif
+
+// ============================================================================
+// Globals
+// ============================================================================
+
+Options shell_options = {
+    .launch = LAUNCH_SPAWN,
+    .pipe_size = 0,
+    .pipe_adaptive = 0,
+    .notify = 0,
+    .subreaper = 0,
+    .queue_limit = 0,
+    .admit_cpu = 0,
+    .admit_memory = 0,
+    .admit_load = 0,
+    .line_cache = LINECACHE_DEFAULT_SIZE,
+};
+
+// ============================================================================
+// Static Functions
+// ============================================================================
+
+/**
+ * @brief Parse the value of the `launch` option
+ *
+ * @param value "spawn" or "fork"
+ * @return 0 on success, -1 on invalid
+ */
+static int set_launch(const char* value) {
+   if (strcmp(value, "spawn") == 0) {
+      shell_options.launch = LAUNCH_SPAWN;
+   } else if (strcmp(value, "fork") == 0) {
+      shell_options.launch = LAUNCH_FORK;
+   } else {
+      return -1;
+   }
+   return 0;
+}
+
+/**
+ * @brief Parse the value of the `pipesize` option
+ *
+ * @param value "default", "adaptive" or a size such as 1M
+ * @return 0 on success, -1 on invalid
+ */
+static int set_pipe_size(const char* value) {
+   if (strcmp(value, "default") == 0) {
+      shell_options.pipe_size = 0;
+      shell_options.pipe_adaptive = 0;
+   } else if (strcmp(value, "adaptive") == 0) {
+      shell_options.pipe_size = 0;
+      shell_options.pipe_adaptive = 1;
+   } else {
+      long size = parse_size(value);
+      if (size <= 0) return -1;
+      shell_options.pipe_size = size;
+      shell_options.pipe_adaptive = 0;
+   }
+   return 0;
+}
+
+/**
+ * @brief Turn subreaper mode on or off
+ *
+ * @param enable
+ * @return 0 on success, -1 where the kernel has no child subreapers
+ */
+static int set_subreaper(int enable) {
+#ifdef PR_SET_CHILD_SUBREAPER
+   if (prctl(PR_SET_CHILD_SUBREAPER, enable ? 1 : 0, 0, 0, 0) == -1) return -1;
+   shell_options.subreaper = enable;
+   return 0;
+#else
+   (void)enable;
+   return -1;
+#endif
+}
+
+/**
+ * @brief Parse an admission threshold
+ *
+ * @param value A positive number, or NULL to turn the threshold off
+ * @param enable 1 for `set -o`, which needs a value
+ * @param out
+ * @return 0 on success, -1 on invalid
+ */
+static int set_threshold(const char* value, int enable, double* out) {
+   if (!value) {
+      if (enable) return -1;
+      *out = 0;
+      return 0;
+   }
+   char* end;
+   double threshold = strtod(value, &end);
+   if (end == value || *end || !(threshold > 0 && threshold < 1e6)) return -1;
+   *out = threshold;
+   return 0;
+}
+
+/**
+ * @brief Print an admission threshold in `set -o` format
+ * @param name
+ * @param threshold
+ */
+static void print_threshold(const char* name, double threshold) {
+   if (threshold > 0) {
+      printf("%s\t%g\n", name, threshold);
+   } else {
+      printf("%s\toff\n", name);
+   }
+}
+
+/**
+ * @brief Check whether the option name part of a spec matches @p name
+ *
+ * @param spec
+ * @param len Length of the name part of spec
+ * @param name
+ * @return 1 on match, 0 otherwise
+ */
+static int name_is(const char* spec, size_t len, const char* name) {
+   return strlen(name) == len && strncmp(spec, name, len) == 0;
+}
+
+// ============================================================================
+// Public Functions
+// ============================================================================
+
+int options_set(const char* spec, int enable) {
+   if (!spec) return -1;
+
+   const char* eq = strchr(spec, '=');
+   size_t name_len = eq ? (size_t)(eq - spec) : strlen(spec);
+   const char* value = eq ? eq + 1 : NULL;
+
+   if (name_is(spec, name_len, "launch")) {
+      // `set +o launch` falls back to fork, `set -o launch` restores spawn
+      if (!value) value = enable ? "spawn" : "fork";
+      return set_launch(value);
+   }
+   if (name_is(spec, name_len, "pipesize")) {
+      // `set +o pipesize` restores the kernel default, `set -o pipesize` turns on adaptive mode
+      if (!value) value = enable ? "adaptive" : "default";
+      return set_pipe_size(value);
+   }
+   if (name_is(spec, name_len, "notify")) {
+      // A boolean: `set -o notify` (or `set -b`) turns it on, `set +o notify` off
+      if (value) return -1;
+      shell_options.notify = enable;
+      return 0;
+   }
+   if (name_is(spec, name_len, "subreaper")) {
+      // Orphans of jobs come back to the shell instead of init, so jobs can keep track of them
+      if (value) return -1;
+      return set_subreaper(enable);
+   }
+
+   if (name_is(spec, name_len, "queuelimit")) {
+      // `set +o queuelimit` goes back to one running entry per online CPU
+      if (!value) {
+         if (enable) return -1;
+         shell_options.queue_limit = 0;
+         return 0;
+      }
+      char* end;
+      long limit = strtol(value, &end, 10);
+      if (end == value || *end || limit <= 0 || limit > INT_MAX) return -1;
+      shell_options.queue_limit = (int)limit;
+      return 0;
+   }
+
+   // Admission control: `set -o admitcpu=PCT`, `set +o admitcpu` turns the threshold off
+   if (name_is(spec, name_len, "admitcpu")) {
+      return set_threshold(value, enable, &shell_options.admit_cpu);
+   }
+   if (name_is(spec, name_len, "admitmem")) {
+      return set_threshold(value, enable, &shell_options.admit_memory);
+   }
+   if (name_is(spec, name_len, "admitload")) {
+      return set_threshold(value, enable, &shell_options.admit_load);
+   }
+
+   if (name_is(spec, name_len, "linecache")) {
+      // `set -o linecache` restores the default size, `set +o linecache` turns the cache off
+      if (!value) {
+         shell_options.line_cache = enable ? LINECACHE_DEFAULT_SIZE : 0;
+         return 0;
+      }
+      char* end;
+      long size = strtol(value, &end, 10);
+      if (end == value || *end || size < 0 || size > INT_MAX) return -1;
+      shell_options.line_cache = (int)size;
+      return 0;
+   }
+   DEBUG_PRINT("Unknown option: %s", spec);
+   return -1;
+}
+
+void options_print(void) {
+   printf("launch\t%s\n", shell_options.launch == LAUNCH_SPAWN ? "spawn" : "fork");
+   if (shell_options.pipe_adaptive) {
+      printf("pipesize\tadaptive\n");
+   } else if (shell_options.pipe_size > 0) {
+      printf("pipesize\t%ld\n", shell_options.pipe_size);
+   } else {
+      printf("pipesize\tdefault\n");
+   }
+   printf("notify\t%s\n", shell_options.notify ? "on" : "off");
+   printf("subreaper\t%s\n", shell_options.subreaper ? "on" : "off");
+   if (shell_options.queue_limit > 0) {
+      printf("queuelimit\t%d\n", shell_options.queue_limit);
+   } else {
+      printf("queuelimit\tcpus\n");
+   }
+   print_threshold("admitcpu", shell_options.admit_cpu);
+   print_threshold("admitmem", shell_options.admit_memory);
+   print_threshold("admitload", shell_options.admit_load);
+   if (shell_options.line_cache > 0) {
+      printf("linecache\t%d\n", shell_options.line_cache);
+   } else {
+      printf("linecache\toff\n");
+   }
+}
@@ -0,0 +1,756 @@
+/**
+ * @file parallel.c
+ * @author Nathan Lemma
+ * @brief Bounded-concurrency fan-out of commands for the YASH shell
+ * @date 10-17-2026
+ * @details This file contains the fan-out runner and the `parallel` and `xargs` builtins built
+ * on it. Tasks are launched with launch_command() like any other command, each in a process group
+ * of its own, and a fixed array of slots tracks the ones in flight. The runner sleeps on child
+ * events, reaps with one WNOHANG loop and refills each freed slot at once. With ordered output
+ * every task writes to an unlinked spool file, copied out (fd_copy) as soon as all earlier tasks
+ * are done. `xargs` sizes each batch against the exec argument area itself, so a generated
+ * argument list is split instead of failing with E2BIG.
+ */
+
+// ============================================================================
+// Includes
+// ============================================================================
+
+#include "../include/parallel.h"
+#include "../include/debug.h"
+#include "../include/events.h"
+#include "../include/fdcopy.h"
+#include "../include/jobs.h"
+#include "../include/launch.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+extern char** environ;
+
+// ============================================================================
+// Constants
+// ============================================================================
+
+/** @brief Largest exit status of `parallel`, however many runs failed (as GNU parallel) */
+#define PARALLEL_MAX_STATUS 101
+
+/** @brief Placeholder replaced by the value in the command's words */
+#define PARALLEL_PLACEHOLDER "{}"
+
+/** @brief Bytes of the exec argument area left unused by `xargs`, as POSIX asks of xargs */
+#define XARGS_HEADROOM 2048
+
+#ifdef __linux__
+/** @brief Longest single argument string Linux accepts (MAX_ARG_STRLEN: 32 pages) */
+#define XARGS_MAX_STRLEN (32 * 4096)
+#endif
+
+/** @brief Exit status of `xargs` when a batch failed (as GNU and POSIX xargs) */
+#define XARGS_FAILED 123
+
+// ============================================================================
+// Data Structures
+// ============================================================================
+
+/**
+ * @brief A task in flight
+ */
+typedef struct Slot {
+   pid_t pid;      ///< Child running the task, 0 when the slot is free
+   int task;       ///< Task number
+   double started; ///< CLOCK_MONOTONIC seconds at launch
+} Slot;
+
+/**
+ * @brief Spooled output of one task, for ordered mode
+ */
+typedef struct Spool {
+   FILE* file;   ///< Unlinked temporary file, NULL if it could not be created
+   int finished; ///< The task is done, so the file is complete
+} Spool;
+
+/**
+ * @brief State of one fan-out
+ */
+typedef struct Fanout {
+   const FanoutSource* src; ///< Task source
+   Slot* slots;             ///< max entries
+   int max;                 ///< Slots
+   int running;             ///< Slots in use
+   FanoutStats stats;       ///< Totals so far
+   Spool* spools;           ///< Per task, in ordered mode (NULL otherwise)
+   int spool_cap;           ///< Entries allocated in spools
+   int flushed;             ///< Tasks whose output has been written out
+} Fanout;
+
+/**
+ * @brief The `parallel` builtin's task source
+ */
+typedef struct ParallelArgs {
+   char* const* words; ///< Command words
+   int num_words;      ///< Entries in words
+   char** values;      ///< One per run
+   int num_values;     ///< Entries in values
+   char** argv;        ///< Argument list of the current run (num_words + 2 entries)
+   char** owned;       ///< Words built for the current run, freed on the next (num_words entries)
+   int num_owned;      ///< Entries in owned
+} ParallelArgs;
+
+/**
+ * @brief The `xargs` builtin's task source
+ */
+typedef struct XargsArgs {
+   char* const* words; ///< Command words
+   int num_words;      ///< Entries in words
+   char** items;       ///< Arguments read from stdin
+   int num_items;      ///< Entries in items
+   int next_item;      ///< First item of the next batch
+   size_t limit;       ///< Bytes a batch's strings and pointers may take, as execve counts them
+   int max_items;      ///< Most items per batch (-n), 0 for no limit
+   int run_empty;      ///< Run the command once even when stdin has no items
+   char** argv;        ///< Argument list of the current batch
+   int not_found;      ///< A batch could not be started
+} XargsArgs;
+
+// ============================================================================
+// Static Functions
+// ============================================================================
+
+/**
+ * @brief CLOCK_MONOTONIC in seconds
+ * @return double
+ */
+static double now_seconds(void) {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Write out the spooled output of every finished task that has no unfinished one before it
+ * @param f
+ */
+static void flush_spools(Fanout* f) {
+   if (!f->spools) return;
+   fflush(stdout);
+   while (f->flushed < f->stats.started && f->spools[f->flushed].finished) {
+      FILE* file = f->spools[f->flushed].file;
+      if (file) {
+         // The child advanced the shared offset to the end
+         lseek(fileno(file), 0, SEEK_SET);
+         if (fd_copy(fileno(file), STDOUT_FILENO, NULL, NULL) < 0) {
+            DEBUG_EXEC("parallel: spool %d: %s", f->flushed, strerror(errno));
+         }
+         fclose(file);
+      }
+      f->flushed++;
+   }
+}
+
+/**
+ * @brief Account for a finished task
+ * @param f
+ * @param task
+ * @param status Exit status
+ * @param seconds Wall time
+ */
+static void finish_task(Fanout* f, int task, int status, double seconds) {
+   if (status != 0) f->stats.failed++;
+   if (f->src->done) f->src->done(f->src->ctx, task, status, seconds);
+   if (f->spools) {
+      f->spools[task].finished = 1;
+      flush_spools(f);
+   }
+}
+
+/**
+ * @brief Launch task number f->stats.started
+ * @param f
+ * @param cmd
+ * @param stdin_fd
+ * @return 0 on success (a task that could not start counts as finished), -1 if out of memory
+ */
+static int launch_task(Fanout* f, const Command* cmd, int stdin_fd) {
+   int task = f->stats.started;
+   Redirects fds = {stdin_fd, -1, -1};
+
+   if (f->spools) {
+      if (task == f->spool_cap) {
+         int cap = f->spool_cap ? f->spool_cap * 2 : 64;
+         Spool* grown = realloc(f->spools, cap * sizeof(Spool));
+         if (!grown) return -1;
+         f->spools = grown;
+         f->spool_cap = cap;
+      }
+      // Without a spool the task writes straight through, still in the right place if it is next
+      FILE* file = tmpfile();
+      if (file) {
+         fcntl(fileno(file), F_SETFD, FD_CLOEXEC);
+         fds.out_fd = fileno(file);
+      }
+      f->spools[task] = (Spool){file, 0};
+   }
+   f->stats.started++;
+
+   pid_t pid = launch_command(cmd, 0, &fds, NULL);
+   if (pid < 0) {
+      DEBUG_EXEC("parallel: task %d did not start: %s", task, strerror(errno));
+      finish_task(f, task, 127, 0);
+      return 0;
+   }
+   for (int i = 0; i < f->max; i++) {
+      if (f->slots[i].pid == 0) {
+         f->slots[i] = (Slot){pid, task, now_seconds()};
+         break;
+      }
+   }
+   f->running++;
+   return 0;
+}
+
+/**
+ * @brief Reap every child that has changed state without blocking
+ *
+ * The shell's background jobs are children too; their events go to the job table.
+ *
+ * @param f
+ * @return Number of tasks that finished
+ */
+static int reap(Fanout* f) {
+   int finished = 0;
+   pid_t pid;
+   int status;
+   JobUsage usage = {0};
+   while ((pid = jobs_wait(-1, &status, WNOHANG | WUNTRACED | WCONTINUED, &usage)) > 0) {
+      Slot* s = NULL;
+      for (int i = 0; i < f->max && !s; i++) {
+         if (f->slots[i].pid == pid) s = &f->slots[i];
+      }
+      if (!s) {
+         jobs_process_event(pid, status, &usage);
+      } else if (WIFEXITED(status) || WIFSIGNALED(status)) {
+         int code = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+         s->pid = 0;
+         f->running--;
+         finish_task(f, s->task, code, now_seconds() - s->started);
+         finished++;
+      }
+      memset(&usage, 0, sizeof(usage));
+   }
+   return finished;
+}
+
+/**
+ * @brief Release the words built for the previous run
+ * @param args
+ */
+static void free_owned(ParallelArgs* args) {
+   for (int i = 0; i < args->num_owned; i++) {
+      free(args->owned[i]);
+   }
+   args->num_owned = 0;
+}
+
+/**
+ * @brief A word with every placeholder replaced by @p value
+ * @param word
+ * @param value
+ * @return Heap allocated string, NULL if out of memory
+ */
+static char* substitute(const char* word, const char* value) {
+   size_t hole = strlen(PARALLEL_PLACEHOLDER);
+   size_t len = strlen(word);
+   size_t vlen = strlen(value);
+   size_t count = 0;
+   for (const char* p = word; (p = strstr(p, PARALLEL_PLACEHOLDER)); p += hole) {
+      count++;
+   }
+
+   char* out = malloc(len + count * vlen + 1);
+   if (!out) return NULL;
+   char* o = out;
+   const char* p = word;
+   const char* at;
+   while ((at = strstr(p, PARALLEL_PLACEHOLDER))) {
+      memcpy(o, p, at - p);
+      o += at - p;
+      memcpy(o, value, vlen);
+      o += vlen;
+      p = at + hole;
+   }
+   strcpy(o, p);
+   return out;
+}
+
+/**
+ * @brief FanoutSource.next for `parallel`: the command with the task's value filled in
+ */
+static int parallel_next(void* ctx, int task, Command* cmd) {
+   ParallelArgs* args = ctx;
+   free_owned(args);
+   if (task >= args->num_values) return -1;
+
+   const char* value = args->values[task];
+   int n = 0;
+   int placed = 0;
+   for (int i = 0; i < args->num_words; i++) {
+      const char* word = args->words[i];
+      if (strstr(word, PARALLEL_PLACEHOLDER)) {
+         char* filled = substitute(word, value);
+         if (!filled) return -1;
+         args->owned[args->num_owned++] = filled;
+         args->argv[n++] = filled;
+         placed = 1;
+      } else {
+         args->argv[n++] = (char*)word;
+      }
+   }
+   if (!placed) args->argv[n++] = (char*)value;
+   args->argv[n] = NULL;
+   cmd->argv = args->argv;
+   return 1;
+}
+
+/**
+ * @brief Read all of a descriptor
+ * @param fd
+ * @param len Set to the number of bytes read
+ * @return Heap allocated, NUL-terminated contents, NULL on error
+ */
+static char* read_all(int fd, size_t* len) {
+   size_t cap = 4096;
+   size_t used = 0;
+   char* buf = malloc(cap);
+   while (buf) {
+      if (used + 1 == cap) {
+         char* grown = realloc(buf, cap * 2);
+         if (!grown) break;
+         buf = grown;
+         cap *= 2;
+      }
+      ssize_t n = read(fd, buf + used, cap - 1 - used);
+      if (n == 0) {
+         buf[used] = '\0';
+         *len = used;
+         return buf;
+      }
+      if (n < 0 && errno != EINTR) break;
+      if (n > 0) used += n;
+   }
+   free(buf);
+   return NULL;
+}
+
+/**
+ * @brief Split text into its non-empty lines, in place
+ * @param text
+ * @param len
+ * @param count Set to the number of lines
+ * @return Heap allocated array of pointers into @p text, NULL if out of memory
+ */
+static char** split_lines(char* text, size_t len, int* count) {
+   int n = 0;
+   for (size_t i = 0; i < len; i++) {
+      n += text[i] == '\n';
+   }
+   char** lines = malloc((n + 1) * sizeof(char*));
+   if (!lines) return NULL;
+
+   int k = 0;
+   char* save = NULL;
+   for (char* line = strtok_r(text, "\n", &save); line; line = strtok_r(NULL, "\n", &save)) {
+      size_t l = strlen(line);
+      if (l > 0 && line[l - 1] == '\r') line[l - 1] = '\0';
+      if (*line) lines[k++] = line;
+   }
+   *count = k;
+   return lines;
+}
+
+/**
+ * @brief Size of one argument string in the exec argument area
+ * @param arg
+ * @return Its bytes, NUL and pointer included
+ */
+static size_t arg_size(const char* arg) {
+   return strlen(arg) + 1 + sizeof(char*);
+}
+
+/**
+ * @brief Size of the environment in the exec argument area
+ * @return size_t
+ */
+static size_t environ_size(void) {
+   size_t size = sizeof(char*);
+   for (char** e = environ; *e; e++) {
+      size += arg_size(*e);
+   }
+   return size;
+}
+
+/**
+ * @brief Split text into xargs items, in place
+ *
+ * Items are separated by blanks and newlines; single and double quotes group blanks into an
+ * item and a backslash escapes the next character. With @p nul they are separated by NUL bytes
+ * instead, with no quoting at all (`find -print0`).
+ *
+ * @param text NUL-terminated
+ * @param len
+ * @param nul
+ * @param items Set to a heap allocated array of pointers into @p text
+ * @param count Set to the number of items
+ * @return 0 on success, -1 on an unmatched quote (errno 0) or if out of memory (errno ENOMEM)
+ */
+static int split_items(char* text, size_t len, int nul, char*** items, int* count) {
+   int cap = 64;
+   int n = 0;
+   char** list = malloc(cap * sizeof(char*));
+   char* r = text;
+   char* w = text;
+   char* end = text + len;
+   while (list) {
+      if (nul) {
+         while (r < end && !*r) {
+            r++;
+         }
+      } else {
+         r += strspn(r, " \t\n");
+      }
+      if (r >= end) {
+         *items = list;
+         *count = n;
+         return 0;
+      }
+      if (n == cap) {
+         char** grown = realloc(list, cap * 2 * sizeof(char*));
+         if (!grown) break;
+         list = grown;
+         cap *= 2;
+      }
+      list[n++] = w;
+
+      if (nul) {
+         size_t l = strlen(r);
+         memmove(w, r, l + 1);
+         r += l + 1;
+         w += l + 1;
+         continue;
+      }
+      char quote = 0;
+      while (r < end && (quote || !strchr(" \t\n", *r))) {
+         if (quote && *r == quote) {
+            quote = 0;
+         } else if (!quote && (*r == '\'' || *r == '"')) {
+            quote = *r;
+         } else if (!quote && *r == '\\' && r + 1 < end) {
+            *w++ = *++r;
+         } else {
+            *w++ = *r;
+         }
+         r++;
+      }
+      if (quote) {
+         free(list);
+         errno = 0;
+         return -1;
+      }
+      // The separator (or the terminating NUL) has been read, so this cannot overwrite input
+      *w++ = '\0';
+      if (r < end) r++;
+   }
+   free(list);
+   errno = ENOMEM;
+   return -1;
+}
+
+/**
+ * @brief FanoutSource.next for `xargs`: the command with as many items as fit in one exec
+ *
+ * Items are taken in order, so filling each batch to the limit gives the fewest batches.
+ */
+static int xargs_next(void* ctx, int task, Command* cmd) {
+   XargsArgs* x = ctx;
+   if (x->next_item >= x->num_items && (task > 0 || x->num_items > 0 || !x->run_empty)) return -1;
+
+   size_t used = sizeof(char*);
+   int n = 0;
+   for (; n < x->num_words; n++) {
+      x->argv[n] = x->words[n];
+      used += arg_size(x->words[n]);
+   }
+   while (x->next_item < x->num_items && (!x->max_items || n - x->num_words < x->max_items)) {
+      size_t size = arg_size(x->items[x->next_item]);
+      if (n > x->num_words && used + size > x->limit) break;
+      used += size;
+      x->argv[n++] = x->items[x->next_item++];
+   }
+   x->argv[n] = NULL;
+   cmd->argv = x->argv;
+   return 1;
+}
+
+/**
+ * @brief FanoutSource.done for `xargs`: note a batch that could not be started
+ */
+static void xargs_done(void* ctx, int task, int status, double seconds) {
+   XargsArgs* x = ctx;
+   (void)task;
+   (void)seconds;
+   if (status == 127) x->not_found = 1;
+}
+
+// ============================================================================
+// Public Functions
+// ============================================================================
+
+int fanout_run(const FanoutSource* src, int max, int ordered, int stdin_fd, FanoutStats* stats) {
+   Fanout f = {0};
+   f.src = src;
+   f.max = max;
+   f.slots = calloc(max, sizeof(Slot));
+   if (!f.slots) return -1;
+   if (ordered) {
+      f.spool_cap = 64;
+      f.spools = malloc(f.spool_cap * sizeof(Spool));
+      if (!f.spools) {
+         free(f.slots);
+         return -1;
+      }
+   }
+
+   double start = now_seconds();
+   int result = 0;
+   int exhausted = 0;
+   shell_interrupted = 0;
+   while (1) {
+      // Fill every free slot
+      while (!exhausted && !shell_interrupted && f.running < max) {
+         Command cmd;
+         init_command(&cmd);
+         int got = src->next(src->ctx, f.stats.started, &cmd);
+         if (got == -1) exhausted = 1;
+         if (got != 1) break;
+         if (launch_task(&f, &cmd, stdin_fd) == -1) {
+            exhausted = 1;
+            result = -1;
+         }
+      }
+      // A source waiting for a task to finish gets nowhere with none running
+      if (f.running == 0) break;
+
+      if (shell_interrupted && result != 130) {
+         // Each task leads its own group, out of reach of the shell's forwarding
+         for (int i = 0; i < max; i++) {
+            if (f.slots[i].pid) kill(-f.slots[i].pid, SIGINT);
+         }
+         result = 130;
+      }
+      if (reap(&f) == 0) {
+         events_set_timer(jobs_enforce_budgets());
+         events_wait_child(-1);
+      }
+   }
+   if (shell_interrupted) result = 130;
+   shell_interrupted = 0;
+
+   // Tasks that never started (Ctrl-C) leave no gap in the output
+   for (int i = f.flushed; f.spools && i < f.stats.started; i++) {
+      f.spools[i].finished = 1;
+   }
+   flush_spools(&f);
+   f.stats.seconds = now_seconds() - start;
+   if (stats) *stats = f.stats;
+   free(f.spools);
+   free(f.slots);
+   return result;
+}
+
+int builtin_parallel(char* const argv[]) {
+   long jobs = sysconf(_SC_NPROCESSORS_ONLN);
+   int ordered = 0;
+   int i = 1;
+   for (; argv[i] && argv[i][0] == '-'; i++) {
+      char* end = NULL;
+      if (strcmp(argv[i], "-k") == 0) {
+         ordered = 1;
+      } else if (strcmp(argv[i], "-j") == 0 && argv[i + 1] &&
+                 (jobs = strtol(argv[i + 1], &end, 10)) > 0 && !*end) {
+         i++;
+      } else {
+         break;
+      }
+   }
+   if (jobs <= 0) jobs = 1;
+
+   ParallelArgs args = {0};
+   args.words = argv + i;
+   while (argv[i] && strcmp(argv[i], ":::") != 0) {
+      args.num_words++;
+      i++;
+   }
+   if (args.num_words == 0 || args.words[0][0] == '-') {
+      fprintf(stderr, "parallel: usage: parallel [-j N] [-k] command [arg...] [::: value...]\n");
+      return 2;
+   }
+
+   // Values after `:::`, or else the lines of stdin (and then the runs must not share it)
+   char* text = NULL;
+   int stdin_fd = -1;
+   if (argv[i]) {
+      args.values = (char**)argv + i + 1;
+      while (args.values[args.num_values]) {
+         args.num_values++;
+      }
+   } else {
+      size_t len = 0;
+      text = read_all(STDIN_FILENO, &len);
+      args.values = text ? split_lines(text, len, &args.num_values) : NULL;
+      if (!args.values) {
+         fprintf(stderr, "parallel: cannot read stdin: %s\n", strerror(errno));
+         free(text);
+         return 1;
+      }
+      stdin_fd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+   }
+
+   FanoutSource src = {parallel_next, NULL, &args};
+   FanoutStats stats = {0};
+   int result = -1;
+   args.argv = malloc((args.num_words + 2) * sizeof(char*));
+   args.owned = malloc(args.num_words * sizeof(char*));
+   if (args.argv && args.owned) result = fanout_run(&src, (int)jobs, ordered, stdin_fd, &stats);
+   free_owned(&args);
+   free(args.argv);
+   free(args.owned);
+   if (text) {
+      free(args.values);
+      free(text);
+   }
+   if (stdin_fd != -1) close(stdin_fd);
+
+   fprintf(stderr,
+           "parallel: %d runs, %d failed in %.3fs (%.1f runs/s)\n",
+           stats.started,
+           stats.failed,
+           stats.seconds,
+           stats.seconds > 0 ? stats.started / stats.seconds : 0.0);
+   if (result == -1) {
+      fprintf(stderr, "parallel: out of memory\n");
+      return 1;
+   }
+   if (result == 130) return 130;
+   return stats.failed < PARALLEL_MAX_STATUS ? stats.failed : PARALLEL_MAX_STATUS;
+}
+
+int builtin_xargs(char* const argv[]) {
+   XargsArgs x = {0};
+   x.run_empty = 1;
+   long jobs = 1;
+   long size = 0;
+   int nul = 0;
+   int i = 1;
+   for (; argv[i] && argv[i][0] == '-'; i++) {
+      char* end = NULL;
+      if (strcmp(argv[i], "-0") == 0) {
+         nul = 1;
+      } else if (strcmp(argv[i], "-r") == 0) {
+         x.run_empty = 0;
+      } else if (strcmp(argv[i], "-P") == 0 && argv[i + 1] &&
+                 (jobs = strtol(argv[i + 1], &end, 10)) > 0 && !*end) {
+         i++;
+      } else if (strcmp(argv[i], "-n") == 0 && argv[i + 1] &&
+                 (x.max_items = (int)strtol(argv[i + 1], &end, 10)) > 0 && !*end) {
+         i++;
+      } else if (strcmp(argv[i], "-s") == 0 && argv[i + 1] &&
+                 (size = strtol(argv[i + 1], &end, 10)) > 0 && !*end) {
+         i++;
+      } else {
+         fprintf(stderr,
+                 "xargs: usage: xargs [-0] [-r] [-P N] [-n MAX] [-s SIZE] [command [arg...]]\n");
+         return 2;
+      }
+   }
+
+   // The command's own words count against the limit like the items do; `echo` by default
+   static char* const default_words[] = {"echo", NULL};
+   x.words = argv[i] ? argv + i : default_words;
+   while (x.words[x.num_words]) {
+      x.num_words++;
+   }
+
+   // What execve() accepts, less the environment every batch carries and some headroom
+   long arg_max = sysconf(_SC_ARG_MAX);
+   if (arg_max <= 0) arg_max = _POSIX_ARG_MAX;
+   size_t env = environ_size();
+   x.limit = (size_t)arg_max > env + XARGS_HEADROOM ? (size_t)arg_max - env - XARGS_HEADROOM : 0;
+   if (size > 0 && (size_t)size < x.limit) x.limit = (size_t)size;
+   size_t fixed = sizeof(char*);
+   for (int k = 0; k < x.num_words; k++) {
+      fixed += arg_size(x.words[k]);
+   }
+
+   size_t len = 0;
+   char* text = read_all(STDIN_FILENO, &len);
+   if (!text || split_items(text, len, nul, &x.items, &x.num_items) == -1) {
+      if (text && errno == 0) {
+         fprintf(stderr, "xargs: unmatched quote\n");
+      } else {
+         fprintf(stderr, "xargs: cannot read stdin: %s\n", strerror(errno));
+      }
+      free(text);
+      return 1;
+   }
+
+   // An item that cannot fit even on its own would fail with E2BIG in the child
+   int result = 0;
+   for (int k = 0; k < x.num_items && result == 0; k++) {
+      size_t item = arg_size(x.items[k]);
+      int too_long = fixed + item > x.limit;
+#ifdef __linux__
+      too_long = too_long || item - sizeof(char*) > XARGS_MAX_STRLEN;
+#endif
+      if (too_long) {
+         fprintf(stderr,
+                 "xargs: argument %d of %zu bytes does not fit in one command\n",
+                 k + 1,
+                 item - sizeof(char*) - 1);
+         result = 1;
+      }
+   }
+
+   x.argv = malloc((x.num_words + x.num_items + 1) * sizeof(char*));
+   if (result == 0 && !x.argv) {
+      fprintf(stderr, "xargs: out of memory\n");
+      result = 1;
+   }
+   if (result == 0) {
+      // Batches must not read the rest of the items
+      int stdin_fd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+      FanoutSource src = {xargs_next, xargs_done, &x};
+      FanoutStats stats = {0};
+      result = fanout_run(&src, (int)jobs, 0, stdin_fd, &stats);
+      if (stdin_fd != -1) close(stdin_fd);
+      DEBUG_EXEC("xargs: %d items in %d batches", x.num_items, stats.started);
+
+      if (result == -1) {
+         fprintf(stderr, "xargs: out of memory\n");
+         result = 1;
+      } else if (result != 130) {
+         result = x.not_found ? 127 : stats.failed ? XARGS_FAILED : 0;
+      }
+   }
+   free(x.argv);
+   free(x.items);
+   free(text);
+   return result;
+}
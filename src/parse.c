@@ -12,48 +12,160 @@
 
 #include "../include/parse.h"
 #include "../include/debug.h"
+#include "../include/lex.h"
+#include "../include/vars.h"
 #include "../include/yash.h"
+#include <errno.h>
+#include <limits.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
+
+// ============================================================================
+// Constants
+// ============================================================================
+
+/** @brief Longest SIZE of a `|[SIZE]` pipe annotation */
+#define PIPE_SIZE_MAX_LEN 31
+
+// ============================================================================
+// Data Structures
+// ============================================================================
+
+/**
+ * @brief The tokens of a line being parsed and where parsing has got to
+ */
+typedef struct Parser {
+   char** tokens;    ///< Every token of the line
+   TokenKind* kinds; ///< Kind of each token
+   int num_tokens;   ///< Length of tokens
+   int pos;          ///< Next token to parse
+   const char* line; ///< Tokenized line the tokens point into
+   const char* text; ///< Copy of the line as typed (same offsets as line)
+   Arena* arena;     ///< Where everything parsed is allocated
+} Parser;
 
 // ============================================================================
 // Static Functions
 // ============================================================================
 
 /**
- * @brief Get the kind of a token
+ * @brief Recognize a `timeout [-k GRACE] [-c CPU] [DURATION]` prefix
+ *
+ * DURATION may only be left out when -c is given. Anything else starting with `timeout` (bad
+ * durations included) is left alone and runs as an ordinary command.
+ *
+ * @param words
+ * @param num_words
+ * @param budget Filled in when the prefix is recognized
+ * @return Number of prefix words, 0 when there is no prefix
+ */
+static int parse_timeout_prefix(char** words, int num_words, Budget* budget) {
+   if (num_words < 3 || strcmp(words[0], "timeout") != 0) return 0;
+
+   Budget b = {0, 0, TIMEOUT_GRACE_DEFAULT};
+   int k = 1;
+   while (k < num_words - 1 && (strcmp(words[k], "-k") == 0 || strcmp(words[k], "-c") == 0)) {
+      double value = parse_duration(words[k + 1]);
+      if (value < 0) return 0;
+      if (words[k][1] == 'k') {
+         b.grace = value;
+      } else {
+         b.cpu = value;
+      }
+      k += 2;
+   }
+   if (k >= num_words) return 0;
+   b.wall = parse_duration(words[k]);
+   if (b.wall >= 0) {
+      k++;
+   } else {
+      b.wall = 0;
+   }
+   if (k >= num_words || (b.wall == 0 && b.cpu == 0)) return 0;
+
+   *budget = b;
+   return k;
+}
+
+/**
+ * @brief Recognize a `submit [-p PRIORITY]` prefix
  *
- * @param t Token string
- * @return TokenKind enum
+ * @param words
+ * @param kinds Kind of each word
+ * @param num_words
+ * @param priority Set when the prefix is recognized
+ * @return Number of prefix words, 0 when there is no prefix
  */
-static inline TokenKind kind_of(const char* t) {
-   if (t[0] == '2' && t[1] == '>' && t[2] == '\0') return TK_REDIR_ERR;
-   if (t[0] == '<' && t[1] == '\0') return TK_REDIR_IN;
-   if (t[0] == '>' && t[1] == '\0') return TK_REDIR_OUT;
-   if (t[0] == '|' && t[1] == '\0') return TK_PIPE;
-   if (t[0] == '&' && t[1] == '\0') return TK_AMP;
-   return TK_WORD;
+static int parse_submit_prefix(char** words, const TokenKind* kinds, int num_words, int* priority) {
+   if (num_words < 2 || strcmp(words[0], "submit") != 0) return 0;
+
+   long p = 0;
+   int k = 1;
+   if (strcmp(words[1], "-p") == 0) {
+      char* end;
+      if (num_words < 4) return 0;
+      errno = 0;
+      p = strtol(words[2], &end, 10);
+      if (end == words[2] || *end || errno || p < INT_MIN || p > INT_MAX) return 0;
+      k = 3;
+   }
+   if (kinds[k] != TK_WORD) return 0;
+
+   *priority = (int)p;
+   return k;
+}
+
+/**
+ * @brief Get the pipe capacity requested by a pipe token
+ *
+ * A plain `|` uses the shell default; `|[SIZE]` (e.g. `|[1M]`) asks for a specific capacity for
+ * that pipe.
+ *
+ * @param t Token string of kind TK_PIPE
+ * @return 0 for the default, the size in bytes, or -1 if the annotation is malformed
+ */
+static long pipe_token_size(const char* t) {
+   if (t[1] == '\0') return 0;
+
+   size_t len = strlen(t);
+   if (len < 4 || t[len - 1] != ']') return -1;
+
+   char buf[PIPE_SIZE_MAX_LEN + 1];
+   if (len - 3 > PIPE_SIZE_MAX_LEN) return -1;
+   snprintf(buf, sizeof(buf), "%.*s", (int)(len - 3), t + 2);
+   long size = parse_size(buf);
+   return size > 0 ? size : -1;
 }
 
 /**
  * @brief Analyze the structure of a line of tokens
  *
  * @param tokens
+ * @param kinds Kind of each token
  * @param n Length
- * @param pipe_idx (-1 if none)
+ * @param num_pipes Number of `|` tokens
  * @param has_amp (0/1)
  * @return 0 on success, -1 on invalid
  */
-static int analyze_structure(char* tokens[], int n, int* pipe_idx, int* has_amp) {
-   if (n == 0 || kind_of(tokens[0]) != TK_WORD) return -1;
-
-   *pipe_idx = -1;
+static int analyze_structure(char* tokens[],
+                             const TokenKind kinds[],
+                             int n,
+                             int* num_pipes,
+                             int* has_amp) {
+   if (n == 0 || kinds[0] != TK_WORD) return -1;
+
+   *num_pipes = 0;
    *has_amp = 0;
    for (int i = 1; i < n; i++) {
-      switch (kind_of(tokens[i])) {
+      switch (kinds[i]) {
       case TK_PIPE:
-         if (*pipe_idx != -1 || *has_amp) return -1;
-         *pipe_idx = i;
+         if (*has_amp) return -1;
+         // Every stage needs at least one token: no `| |` and no trailing `|`
+         if (i == n - 1 || kinds[i - 1] == TK_PIPE) return -1;
+         if (pipe_token_size(tokens[i]) == -1) return -1;
+         (*num_pipes)++;
          break;
       case TK_AMP:
          if (i != n - 1 || *has_amp) return -1;
@@ -63,7 +175,7 @@ static int analyze_structure(char* tokens[], int n, int* pipe_idx, int* has_amp)
          break;
       }
    }
-   if (*pipe_idx != -1 && *has_amp) return -1;
+   if (*num_pipes > 0 && *has_amp) return -1;
    return 0;
 }
 
@@ -72,187 +184,775 @@ static int analyze_structure(char* tokens[], int n, int* pipe_idx, int* has_amp)
  *
  * @param cmd
  * @param tokens
+ * @param kinds Kind of each token
  * @param lo
  * @param hi
+ * @param arena Where the argv vector is allocated
  * @return 0 on success, -1 on invalid
  */
-static int fill_command(Command* cmd, char* tokens[], int lo, int hi) {
+static int fill_command(Command* cmd,
+                        char* tokens[],
+                        const TokenKind kinds[],
+                        int lo,
+                        int hi,
+                        Arena* arena) {
 
    int args_closed = 0;
 
    init_command(cmd);
+   // Every token could be a word, plus the terminator
+   cmd->argv = arena_alloc(arena, sizeof(char*) * (hi - lo + 1));
+   if (!cmd->argv) return -1;
 
    int k = 0;
    for (int i = lo; i < hi; i++) {
-      switch (kind_of(tokens[i])) {
+      switch (kinds[i]) {
       case TK_WORD:
          if (args_closed == 1) return -1;
-         if (k >= MAX_ARGS - 1) return -1;
+         if (strchr(tokens[i], '$')) cmd->expand = 1;
          cmd->argv[k++] = tokens[i];
          break;
       case TK_REDIR_IN:
          args_closed = 1;
-         if (i + 1 >= hi || cmd->in_file || kind_of(tokens[i + 1]) != TK_WORD) return -1;
+         if (i + 1 >= hi || cmd->in_file || kinds[i + 1] != TK_WORD) return -1;
          cmd->in_file = tokens[i + 1];
+         if (strchr(cmd->in_file, '$')) cmd->expand = 1;
          i++;
          break;
       case TK_REDIR_OUT:
          args_closed = 1;
-         if (i + 1 >= hi || cmd->out_file || kind_of(tokens[i + 1]) != TK_WORD) return -1;
+         if (i + 1 >= hi || cmd->out_file || kinds[i + 1] != TK_WORD) return -1;
          cmd->out_file = tokens[i + 1];
+         if (strchr(cmd->out_file, '$')) cmd->expand = 1;
          i++;
          break;
       case TK_REDIR_ERR:
          args_closed = 1;
-         if (i + 1 >= hi || cmd->err_file || kind_of(tokens[i + 1]) != TK_WORD) return -1;
+         if (i + 1 >= hi || cmd->err_file || kinds[i + 1] != TK_WORD) return -1;
          cmd->err_file = tokens[i + 1];
+         if (strchr(cmd->err_file, '$')) cmd->expand = 1;
          i++;
          break;
       default:
          return -1;
       }
    }
-   if (cmd->argv[0] == NULL) return -1;
    cmd->argv[k] = NULL;
+   if (k == 0) return -1;
+
+   // `NAME=value...` on its own sets variables
+   cmd->assign = !cmd->in_file && !cmd->out_file && !cmd->err_file;
+   for (int i = 0; i < k && cmd->assign; i++) {
+      char* eq = strchr(cmd->argv[i], '=');
+      cmd->assign = eq && vars_is_name(cmd->argv[i], eq - cmd->argv[i]);
+   }
 
    return 0;
 }
 
-// ============================================================================
-// Public Functions
-// ============================================================================
+/**
+ * @brief Whether a token ends an element of a command list
+ */
+static int is_separator(TokenKind kind) {
+   return kind == TK_SEMI || kind == TK_AMP || kind == TK_AND || kind == TK_OR ||
+          kind == TK_NEWLINE || kind == TK_DSEMI;
+}
 
-void init_command(Command* cmd) {
-   if (!cmd) return;
+/**
+ * @brief Whether the next token is the word @p keyword
+ */
+static int at_keyword(const Parser* p, const char* keyword) {
+   return p->pos < p->num_tokens && p->kinds[p->pos] == TK_WORD &&
+          strcmp(p->tokens[p->pos], keyword) == 0;
+}
 
-   cmd->in_file = NULL;
-   cmd->out_file = NULL;
-   cmd->err_file = NULL;
-   cmd->background = 0;
-   for (int j = 0; j < MAX_ARGS; j++) {
-      cmd->argv[j] = NULL;
+/**
+ * @brief Whether the next token ends the list being parsed (end of line, `;;` or a keyword that
+ * closes or continues a compound command)
+ */
+static int at_list_end(const Parser* p) {
+   static const char* const closers[] = {"then", "elif", "else", "fi", "do", "done", "esac", "}"};
+   if (p->pos == p->num_tokens || p->kinds[p->pos] == TK_DSEMI) return 1;
+   for (size_t i = 0; i < sizeof(closers) / sizeof(closers[0]); i++) {
+      if (at_keyword(p, closers[i])) return 1;
    }
+   return 0;
 }
 
-int parse_line(char* line, Line* line_out) {
-   // Check for NULL input
-   if (!line || !line_out) {
+/**
+ * @brief Skip the newlines between the lines of a compound command
+ */
+static void skip_newlines(Parser* p) {
+   while (p->pos < p->num_tokens && p->kinds[p->pos] == TK_NEWLINE) {
+      p->pos++;
+   }
+}
+
+/**
+ * @brief Consume the keyword @p keyword
+ * @return 0 on success, PARSE_INCOMPLETE at the end of the line, -1 on anything else
+ */
+static int expect(Parser* p, const char* keyword) {
+   skip_newlines(p);
+   if (p->pos == p->num_tokens) return PARSE_INCOMPLETE;
+   if (!at_keyword(p, keyword)) {
+      DEBUG_PARSE("Expected \"%s\" at token %d", keyword, p->pos);
       return -1;
    }
+   p->pos++;
+   return 0;
+}
 
-   DEBUG_PARSE("Parsing line: \"%s\"", line);
+/**
+ * @brief A zeroed Line from the parser's arena
+ * @return NULL if out of memory
+ */
+static Line* new_line(Parser* p) {
+   Line* e = arena_alloc(p->arena, sizeof(Line));
+   if (e) memset(e, 0, sizeof(Line));
+   return e;
+}
 
-   // Parse the line
-   if (strnlen(line, MAX_CMDLINE) == MAX_CMDLINE) {
-      // Means the input filled the buffer without room for '\0' or is more than 2000 characters
-      DEBUG_PARSE("Line too long (>= %d characters)", MAX_CMDLINE);
-      return -1;
+static int parse_list(Parser* p, Line* first, int nested);
+
+/**
+ * @brief Parse a list inside a compound command into a new chain
+ *
+ * @param p
+ * @param out Receives the chain
+ * @return 0 on success, PARSE_INCOMPLETE or -1
+ */
+static int parse_body(Parser* p, Line** out) {
+   *out = new_line(p);
+   if (!*out) return -1;
+   return parse_list(p, *out, 1);
+}
+
+/**
+ * @brief Collect words up to the next separator into a NULL-terminated array
+ *
+ * @param p
+ * @param c Marked when a word has a `$`
+ * @return The array, NULL if out of memory or if a non-word comes first
+ */
+static char** parse_words(Parser* p, Compound* c) {
+   int lo = p->pos;
+   while (p->pos < p->num_tokens && p->kinds[p->pos] == TK_WORD) {
+      if (strchr(p->tokens[p->pos], '$')) c->expand = 1;
+      p->pos++;
    }
+   if (p->pos < p->num_tokens && !is_separator(p->kinds[p->pos])) return NULL;
 
-   snprintf(line_out->original, MAX_CMDLINE, "%s", line);
+   char** words = arena_alloc(p->arena, sizeof(char*) * (p->pos - lo + 1));
+   if (!words) return NULL;
+   memcpy(words, p->tokens + lo, sizeof(char*) * (p->pos - lo));
+   words[p->pos - lo] = NULL;
+   return words;
+}
 
-   char* tokens[MAX_TOKENS];
-   int num_tokens = 0;
-   int result = tokenize_line(line, tokens, &num_tokens);
-   if (result == -1) {
-      DEBUG_PARSE("Tokenization failed");
-      return -1;
+/**
+ * @brief Parse `NAME [in WORD...] ; do LIST ; done` after `for`
+ */
+static int parse_for(Parser* p, Compound* c) {
+   if (p->pos == p->num_tokens) return PARSE_INCOMPLETE;
+   c->name = p->tokens[p->pos++];
+   if (!vars_is_name(c->name, strlen(c->name))) return -1;
+
+   skip_newlines(p);
+   if (at_keyword(p, "in")) {
+      p->pos++;
+      c->words = parse_words(p, c);
+      if (!c->words) return -1;
    }
+   // The word list ends with `;` or a newline; without `in` either may come before `do`
+   if (p->pos < p->num_tokens && (p->kinds[p->pos] == TK_SEMI || p->kinds[p->pos] == TK_NEWLINE)) {
+      p->pos++;
+   } else if (c->words) {
+      return p->pos == p->num_tokens ? PARSE_INCOMPLETE : -1;
+   }
+
+   int r = expect(p, "do");
+   if (r == 0) r = parse_body(p, &c->body);
+   if (r == 0) r = expect(p, "done");
+   return r;
+}
+
+/**
+ * @brief Parse `LIST ; do LIST ; done` after `while` or `until`
+ */
+static int parse_loop(Parser* p, Compound* c) {
+   int r = parse_body(p, &c->cond);
+   if (r == 0) r = expect(p, "do");
+   if (r == 0) r = parse_body(p, &c->body);
+   if (r == 0) r = expect(p, "done");
+   return r;
+}
 
+/**
+ * @brief Parse `LIST ; then LIST ; ... fi` after `if` or `elif`
+ */
+static int parse_if(Parser* p, Compound* c) {
+   int r = parse_body(p, &c->cond);
+   if (r == 0) r = expect(p, "then");
+   if (r == 0) r = parse_body(p, &c->body);
+   if (r != 0) return r;
+
+   if (at_keyword(p, "elif")) {
+      // The rest of the chain is an if of its own, sharing this one's `fi`
+      p->pos++;
+      c->orelse = new_line(p);
+      Compound* next = arena_alloc(p->arena, sizeof(Compound));
+      if (!c->orelse || !next) return -1;
+      memset(next, 0, sizeof(Compound));
+      next->kind = CC_IF;
+      c->orelse->compound = next;
+      return parse_if(p, next);
+   }
+   if (at_keyword(p, "else")) {
+      p->pos++;
+      r = parse_body(p, &c->orelse);
+      if (r != 0) return r;
+   }
+   return expect(p, "fi");
+}
+
+/**
+ * @brief Parse `WORD in [PATTERN [| PATTERN]...) LIST ;;]... esac` after `case`
+ */
+static int parse_case(Parser* p, Compound* c) {
+   if (p->pos == p->num_tokens) return PARSE_INCOMPLETE;
+   if (p->kinds[p->pos] != TK_WORD) return -1;
+   c->words = arena_alloc(p->arena, sizeof(char*) * 2);
+   if (!c->words) return -1;
+   c->words[0] = p->tokens[p->pos++];
+   c->words[1] = NULL;
+   int r = expect(p, "in");
+   if (r != 0) return r;
+
+   CaseArm** tail = &c->arms;
+   while (1) {
+      skip_newlines(p);
+      if (p->pos == p->num_tokens) return PARSE_INCOMPLETE;
+      if (at_keyword(p, "esac")) {
+         p->pos++;
+         return 0;
+      }
+
+      // PATTERN [| PATTERN]... with `)` closing the last one, as `a)` or as its own token
+      if (at_keyword(p, "(")) {
+         p->pos++;
+      } else if (p->kinds[p->pos] == TK_WORD && p->tokens[p->pos][0] == '(') {
+         p->tokens[p->pos]++;
+      }
+      int lo = p->pos;
+      int closed = 0;
+      while (!closed && p->pos < p->num_tokens) {
+         if (p->kinds[p->pos] != TK_WORD) return -1;
+         char* t = p->tokens[p->pos++];
+         size_t len = strlen(t);
+         if (strcmp(t, ")") == 0) {
+            closed = 1;
+         } else if (t[len - 1] == ')') {
+            t[len - 1] = '\0';
+            closed = 1;
+         } else if (p->pos < p->num_tokens && p->kinds[p->pos] == TK_PIPE) {
+            p->pos++;
+         } else if (!at_keyword(p, ")")) {
+            return -1;
+         }
+      }
+      if (!closed) return PARSE_INCOMPLETE;
+
+      CaseArm* arm = arena_alloc(p->arena, sizeof(CaseArm));
+      if (!arm) return -1;
+      arm->patterns = arena_alloc(p->arena, sizeof(char*) * (p->pos - lo + 1));
+      if (!arm->patterns) return -1;
+      int n = 0;
+      for (int i = lo; i < p->pos; i++) {
+         if (p->kinds[i] == TK_WORD && p->tokens[i][0] != '\0' && strcmp(p->tokens[i], ")") != 0) {
+            arm->patterns[n++] = p->tokens[i];
+         }
+      }
+      arm->patterns[n] = NULL;
+      arm->body = NULL;
+      arm->next = NULL;
+      *tail = arm;
+      tail = &arm->next;
+      if (n == 0) return -1;
+
+      skip_newlines(p);
+      if (p->pos == p->num_tokens) return PARSE_INCOMPLETE;
+      if (p->kinds[p->pos] != TK_DSEMI && !at_keyword(p, "esac")) {
+         r = parse_body(p, &arm->body);
+         if (r != 0) return r;
+      }
+      // The last arm may leave out its `;;`
+      skip_newlines(p);
+      if (p->pos == p->num_tokens) return PARSE_INCOMPLETE;
+      if (p->kinds[p->pos] == TK_DSEMI) {
+         p->pos++;
+      } else if (!at_keyword(p, "esac")) {
+         return -1;
+      }
+   }
+}
+
+/**
+ * @brief Parse `{ LIST ; }` starting at the `{`
+ */
+static int parse_group(Parser* p, Compound* c) {
+   int r = expect(p, "{");
+   if (r == 0) r = parse_body(p, &c->body);
+   if (r == 0) r = expect(p, "}");
+   return r;
+}
+
+/**
+ * @brief Parse a compound command if one starts at the parser's position
+ *
+ * @param p
+ * @param e Element the compound command becomes
+ * @return 0 on success, 1 if no compound command starts here, PARSE_INCOMPLETE or -1
+ */
+static int parse_compound(Parser* p, Line* e) {
+   if (p->kinds[p->pos] != TK_WORD) return 1;
+   const char* w = p->tokens[p->pos];
+   size_t len = strlen(w);
+   int has_next = p->pos + 1 < p->num_tokens;
+
+   CompoundKind kind;
+   if (strcmp(w, "for") == 0) {
+      kind = CC_FOR;
+   } else if (strcmp(w, "while") == 0) {
+      kind = CC_WHILE;
+   } else if (strcmp(w, "until") == 0) {
+      kind = CC_UNTIL;
+   } else if (strcmp(w, "if") == 0) {
+      kind = CC_IF;
+   } else if (strcmp(w, "case") == 0) {
+      kind = CC_CASE;
+   } else if (strcmp(w, "{") == 0) {
+      kind = CC_GROUP;
+   } else if (strcmp(w, "function") == 0 && has_next) {
+      kind = CC_FUNC;
+   } else if (len > 2 && strcmp(w + len - 2, "()") == 0) {
+      kind = CC_FUNC;
+   } else if (has_next && p->kinds[p->pos + 1] == TK_WORD &&
+              strcmp(p->tokens[p->pos + 1], "()") == 0) {
+      kind = CC_FUNC;
+   } else {
+      return 1;
+   }
+
+   Compound* c = arena_alloc(p->arena, sizeof(Compound));
+   if (!c) return -1;
+   memset(c, 0, sizeof(Compound));
+   c->kind = kind;
+   e->compound = c;
+
+   switch (kind) {
+   case CC_FOR:
+      p->pos++;
+      return parse_for(p, c);
+   case CC_WHILE:
+   case CC_UNTIL:
+      p->pos++;
+      return parse_loop(p, c);
+   case CC_IF:
+      p->pos++;
+      return parse_if(p, c);
+   case CC_CASE:
+      p->pos++;
+      return parse_case(p, c);
+   case CC_GROUP:
+      return parse_group(p, c);
+   case CC_FUNC:
+   default:
+      // `function NAME [()]`, `NAME()` or `NAME ()`, then the body
+      if (strcmp(w, "function") == 0) {
+         p->pos++;
+         c->name = p->tokens[p->pos++];
+         if (at_keyword(p, "()")) p->pos++;
+      } else if (len > 2 && strcmp(w + len - 2, "()") == 0) {
+         c->name = p->tokens[p->pos++];
+         c->name[len - 2] = '\0';
+      } else {
+         c->name = p->tokens[p->pos];
+         p->pos += 2;
+      }
+      if (!vars_is_name(c->name, strlen(c->name))) return -1;
+      skip_newlines(p);
+      if (p->pos == p->num_tokens) return PARSE_INCOMPLETE;
+      return parse_group(p, c);
+   }
+}
+
+/**
+ * @brief Parse the list element starting at the parser's position, up to its separator
+ *
+ * A `&` separator stays part of a pipeline element (it makes it a background job); any other
+ * separator is left for the caller.
+ *
+ * @param p
+ * @param e Line to fill in (its arena is left alone)
+ * @return 0 on success, PARSE_INCOMPLETE or -1 on invalid
+ */
+static int parse_element(Parser* p, Line* e) {
+   e->stages = NULL;
+   e->num_stages = 0;
+   e->is_pipeline = 0;
+   e->timed = 0;
+   e->rclass[0] = NULL;
+   memset(&e->budget, 0, sizeof(e->budget));
+   e->submit_at = 0;
+   e->priority = 0;
+   e->compound = NULL;
+   e->op = LIST_END;
+   e->next = NULL;
+
+   int lo = p->pos;
+   int r = parse_compound(p, e);
+   if (r != 1) {
+      if (r != 0) return r;
+      // Its text from the keyword to the closing one, for a function to be parsed again from
+      size_t from = (size_t)(p->tokens[lo] - p->line);
+      size_t to = (size_t)(p->tokens[p->pos - 1] - p->line) + strlen(p->tokens[p->pos - 1]);
+      e->original = arena_strndup(p->arena, p->text + from, to - from);
+      if (!e->original) return -1;
+      // Compound commands run in the shell; they can't be piped or put in the background
+      if (p->pos < p->num_tokens && !is_separator(p->kinds[p->pos])) return -1;
+      if (p->pos < p->num_tokens && p->kinds[p->pos] == TK_AMP) return -1;
+      return 0;
+   }
+
+   int hi = lo;
+   while (hi < p->num_tokens && !is_separator(p->kinds[hi])) {
+      hi++;
+   }
+   int num_tokens = hi - lo;
+   if (hi < p->num_tokens && p->kinds[hi] == TK_AMP) num_tokens++;
+   p->pos = hi;
    if (num_tokens == 0) {
-      DEBUG_PARSE("No tokens found");
+      DEBUG_PARSE("Empty command before token %d", hi);
       return -1;
    }
 
-   DEBUG_PARSE("┌─ Tokenization Results (%d tokens)", num_tokens);
-   for (int i = 0; i < num_tokens; i++) {
-      DEBUG_PARSE("│  [%d] \"%s\"", i, tokens[i]);
+   // The element's own text, so a job or a queue entry shows just this part of the line
+   char** words = p->tokens + lo;
+   TokenKind* kinds = p->kinds + lo;
+   size_t from = (size_t)(words[0] - p->line);
+   size_t to = (size_t)(words[num_tokens - 1] - p->line) + strlen(words[num_tokens - 1]);
+   e->original = arena_strndup(p->arena, p->text + from, to - from);
+   if (!e->original) {
+      DEBUG_PARSE("Out of memory for a %zu character command", to - from);
+      return -1;
+   }
+
+   // `submit [-p N] ...` queues the rest of the element; it is still parsed here, so errors show
+   int submit_words = parse_submit_prefix(words, kinds, num_tokens, &e->priority);
+   if (submit_words) {
+      e->submit_at = (int)(words[submit_words] - words[0]);
+      words += submit_words;
+      kinds += submit_words;
+      num_tokens -= submit_words;
+   }
+
+   // `time` is a keyword covering the whole pipeline, not a command
+   if (num_tokens > 1 && strcmp(words[0], "time") == 0) {
+      e->timed = 1;
+      words++;
+      kinds++;
+      num_tokens--;
+   }
+
+   // `timeout ... DURATION cmd` runs cmd with a budget, and may itself be under a class
+   int budget_words = parse_timeout_prefix(words, num_tokens, &e->budget);
+   words += budget_words;
+   kinds += budget_words;
+   num_tokens -= budget_words;
+
+   // `class [NAME] key=value... cmd` runs cmd under a resource class; `class -d` is the builtin
+   if (num_tokens > 2 && strcmp(words[0], "class") == 0 && strcmp(words[1], "-d") != 0) {
+      int k = 1;
+      if (!strchr(words[k], '=')) k++;
+      while (k < num_tokens - 1 && kinds[k] == TK_WORD && strchr(words[k], '=')) {
+         k++;
+      }
+      if (k < num_tokens) {
+         if (k - 1 > RCLASS_MAX_WORDS) {
+            DEBUG_PARSE("Too many class words (%d)", k - 1);
+            return -1;
+         }
+         for (int i = 1; i < k; i++) {
+            e->rclass[i - 1] = words[i];
+         }
+         e->rclass[k - 1] = NULL;
+         words += k;
+         kinds += k;
+         num_tokens -= k;
+      }
    }
-   DEBUG_PARSE("└─ End Tokenization");
 
    // Match the tokens
-   int pipe_idx = -1;
+   int num_pipes = 0;
    int has_amp = 0;
-   if (analyze_structure(tokens, num_tokens, &pipe_idx, &has_amp) == -1) {
+   if (analyze_structure(words, kinds, num_tokens, &num_pipes, &has_amp) == -1) {
       DEBUG_PARSE("Invalid command structure");
       return -1;
    }
 
-   line_out->is_pipeline = (pipe_idx != -1);
-   DEBUG_PARSE("Command type: %s", line_out->is_pipeline ? "pipeline" : "simple");
-
-   if (pipe_idx == -1) {
-      int hi = has_amp ? num_tokens - 1 : num_tokens;
-      if (fill_command(&line_out->left, tokens, 0, hi) == -1) {
-         DEBUG_PARSE("Failed to fill simple command");
-         return -1;
+   e->num_stages = num_pipes + 1;
+   e->is_pipeline = (num_pipes > 0);
+   e->stages = arena_alloc(p->arena, sizeof(Command) * e->num_stages);
+   if (!e->stages) {
+      DEBUG_PARSE("Out of memory for %d stages", e->num_stages);
+      e->num_stages = 0;
+      return -1;
+   }
+   DEBUG_PARSE("Command type: %s (%d stages)",
+               e->is_pipeline ? "pipeline" : "simple",
+               e->num_stages);
+
+   // Fill one stage per `|`-separated token range
+   int hi_end = has_amp ? num_tokens - 1 : num_tokens;
+   int stage_lo = 0;
+   for (int s = 0; s < e->num_stages; s++) {
+      int stage_hi = stage_lo;
+      while (stage_hi < hi_end && kinds[stage_hi] != TK_PIPE) {
+         stage_hi++;
       }
-      line_out->left.background = has_amp ? 1 : 0;
-
-      // Initialize right command to NULL/0 when not a pipeline
-      init_command(&line_out->right);
-
-      DEBUG_PARSE("├─ Simple Command:");
-      DEBUG_COMMAND(&line_out->left);
-   } else {
-      int left_lo = 0, left_hi = pipe_idx;
-      int right_lo = pipe_idx + 1;
-      int right_hi = num_tokens;
-      if (left_hi <= left_lo || right_hi <= right_lo) {
-         DEBUG_PARSE("Invalid pipeline structure");
+      if (fill_command(&e->stages[s], words, kinds, stage_lo, stage_hi, p->arena) == -1) {
+         DEBUG_PARSE("Failed to fill stage %d", s);
          return -1;
       }
-      if (fill_command(&line_out->left, tokens, left_lo, left_hi) == -1) {
-         DEBUG_PARSE("Failed to fill left command in pipeline");
-         return -1;
+      // Pipelines can't be background
+      e->stages[s].background = e->is_pipeline ? 0 : has_amp;
+      if (stage_hi < hi_end) e->stages[s].pipe_size = pipe_token_size(words[stage_hi]);
+      DEBUG_PARSE("├─ Stage %d:", s);
+      DEBUG_COMMAND(&e->stages[s]);
+      stage_lo = stage_hi + 1;
+   }
+   return 0;
+}
+
+/**
+ * @brief Parse a list into a chain of elements
+ *
+ * @param p
+ * @param first Element to start the chain with
+ * @param nested Inside a compound command: the list ends at the keyword that closes it, and
+ *        running out of tokens means the command continues on the next line
+ * @return 0 on success, PARSE_INCOMPLETE or -1 on invalid
+ */
+static int parse_list(Parser* p, Line* first, int nested) {
+   Line* e = first;
+   skip_newlines(p);
+   if (at_list_end(p)) return nested && p->pos == p->num_tokens ? PARSE_INCOMPLETE : -1;
+
+   while (1) {
+      int r = parse_element(p, e);
+      if (r != 0) return r;
+      if (p->pos == p->num_tokens) return 0;
+
+      TokenKind sep = p->kinds[p->pos];
+      if (sep == TK_DSEMI || !is_separator(sep)) return nested ? 0 : -1;
+      p->pos++;
+      skip_newlines(p);
+      if (sep == TK_AND || sep == TK_OR) {
+         // `&&` and `||` need a command after them
+         if (at_list_end(p)) return nested && p->pos == p->num_tokens ? PARSE_INCOMPLETE : -1;
+      } else if (at_list_end(p)) {
+         return 0;
       }
-      if (fill_command(&line_out->right, tokens, right_lo, right_hi) == -1) {
-         DEBUG_PARSE("Failed to fill right command in pipeline");
+
+      e->op = sep == TK_AND ? LIST_AND : sep == TK_OR ? LIST_OR : LIST_SEQ;
+      e->next = new_line(p);
+      if (!e->next) {
+         DEBUG_PARSE("Out of memory for a list element");
+         e->op = LIST_END;
          return -1;
       }
-      line_out->left.background = 0;  // Pipelines can't be background
-      line_out->right.background = 0; // Pipelines can't be background
-      DEBUG_PARSE("├─ Left Command (Pipeline):");
-      DEBUG_COMMAND(&line_out->left);
-      DEBUG_PARSE("├─ Right Command (Pipeline):");
-      DEBUG_COMMAND(&line_out->right);
+      e = e->next;
+   }
+}
+
+/**
+ * @brief Parse a line into a Line whose arena has just been reset
+ *
+ * @param line
+ * @param line_out
+ * @return 0 on success, PARSE_INCOMPLETE or -1 on invalid
+ */
+static int parse_into(const char* line, Line* line_out) {
+   line_out->stages = NULL;
+   line_out->num_stages = 0;
+   line_out->compound = NULL;
+   line_out->next = NULL;
+
+   DEBUG_PARSE("Parsing line: \"%s\"", line);
+
+   // Parse the line
+   size_t len = strlen(line);
+   if (len >= parse_line_max()) {
+      DEBUG_PARSE("Line too long (%zu characters)", len);
+      return -1;
+   }
+
+   // The copy is tokenized, so the Line needs nothing but its arena
+   Parser p = {0};
+   p.text = line;
+   p.arena = &line_out->arena;
+   char* copy = arena_strndup(p.arena, line, len);
+   size_t count = lex_count(line, len);
+   p.tokens = arena_alloc(p.arena, sizeof(char*) * (count + 1));
+   p.kinds = arena_alloc(p.arena, sizeof(TokenKind) * (count + 1));
+   if (!copy || !p.tokens || !p.kinds) {
+      DEBUG_PARSE("Out of memory for a %zu character line", len);
+      return -1;
+   }
+   p.line = copy;
+   // Every token's kind is known from here on; nothing below classifies text again
+   p.num_tokens = (int)lex_line(copy, len, p.tokens, p.kinds);
+
+   if (p.num_tokens == 0) {
+      DEBUG_PARSE("No tokens found");
+      return -1;
+   }
+
+   DEBUG_PARSE("┌─ Tokenization Results (%d tokens)", p.num_tokens);
+   for (int i = 0; i < p.num_tokens; i++) {
+      DEBUG_PARSE("│  [%d] \"%s\"", i, p.tokens[i]);
+   }
+   DEBUG_PARSE("└─ End Tokenization");
+
+   int r = parse_list(&p, line_out, 0);
+   if (r != 0) return r;
+   if (p.pos < p.num_tokens) {
+      DEBUG_PARSE("Unexpected \"%s\" at token %d", p.tokens[p.pos], p.pos);
+      return -1;
    }
 
    DEBUG_PARSE("Parsing completed successfully");
    return 0;
 }
 
-int tokenize_line(char* line, char* tokens[], int* num_tokens) {
-   if (!line || !tokens || !num_tokens) return -1;
+// ============================================================================
+// Public Functions
+// ============================================================================
 
-   int n = 0;
-   char* ptr = line;
+void init_command(Command* cmd) {
+   if (!cmd) return;
 
-   while (*ptr) {
-      // Skip leading whitespace
-      while (*ptr == ' ' || *ptr == '\t') {
-         ptr++;
-      }
+   cmd->in_file = NULL;
+   cmd->out_file = NULL;
+   cmd->err_file = NULL;
+   cmd->background = 0;
+   cmd->pipe_size = 0;
+   cmd->expand = 0;
+   cmd->assign = 0;
+   cmd->argv = NULL;
+}
 
-      if (*ptr == '\0') break;
+void line_free(Line* line) {
+   if (!line) return;
+
+   arena_free(&line->arena);
+   line->stages = NULL;
+   line->num_stages = 0;
+   line->is_pipeline = 0;
+   line->original = NULL;
+   line->compound = NULL;
+   line->op = LIST_END;
+   line->next = NULL;
+}
 
-      if (n >= MAX_TOKENS) return -1;
-      tokens[n++] = ptr; // Start of the token
+size_t parse_line_max(void) {
+   static size_t max;
+   if (max == 0) {
+      long arg_max = sysconf(_SC_ARG_MAX);
+      max = arg_max > 0 ? (size_t)arg_max : _POSIX_ARG_MAX;
+   }
+   return max;
+}
 
-      // Run to the end of the token
-      int i = 0;
-      while (*ptr && *ptr != ' ' && *ptr != '\t') {
-         ptr++;
-         i++;
-         if (i > MAX_TOKEN_LEN) return -1; // allow length <= MAX_TOKEN_LEN (30), reject 31+
-      }
+int parse_line(const char* line, Line* line_out) {
+   // Check for NULL input
+   if (!line || !line_out) {
+      return -1;
+   }
 
-      // End of the token
-      if (*ptr == ' ' || *ptr == '\t') {
-         *ptr = '\0';
-         ptr++;
-      }
+   // Whatever the last line parsed into this Line used is handed out again
+   arena_reset(&line_out->arena);
+   int r = parse_into(line, line_out);
+   if (r != 0) line_free(line_out);
+   return r;
+}
+
+long parse_size(const char* s) {
+   if (!s || !*s) return -1;
+
+   long value = 0;
+   const char* p = s;
+   while (*p >= '0' && *p <= '9') {
+      if (value > (LONG_MAX - 9) / 10) return -1;
+      value = value * 10 + (*p - '0');
+      p++;
+   }
+   if (p == s) return -1;
+
+   long scale = 1;
+   switch (*p) {
+   case '\0':
+      return value;
+   case 'k':
+   case 'K':
+      scale = 1L << 10;
+      break;
+   case 'm':
+   case 'M':
+      scale = 1L << 20;
+      break;
+   case 'g':
+   case 'G':
+      scale = 1L << 30;
+      break;
+   default:
+      return -1;
    }
-   *num_tokens = n;
+   if (p[1] != '\0' || value > LONG_MAX / scale) return -1;
+   return value * scale;
+}
+
+double parse_duration(const char* s) {
+   if (!s || !((*s >= '0' && *s <= '9') || *s == '.')) return -1;
+
+   char* end;
+   double value = strtod(s, &end);
+   if (end == s) return -1;
+   switch (*end) {
+   case '\0':
+   case 's':
+      break;
+   case 'm':
+      value *= 60;
+      break;
+   case 'h':
+      value *= 3600;
+      break;
+   case 'd':
+      value *= 86400;
+      break;
+   default:
+      return -1;
+   }
+   // Also keeps inf out
+   if ((*end && end[1] != '\0') || value > 1e9) return -1;
+   return value;
+}
+
+int tokenize_line(char* line, char* tokens[], int* num_tokens) {
+   if (!line || !tokens || !num_tokens) return -1;
+
+   *num_tokens = (int)lex_line(line, strlen(line), tokens, NULL);
    return 0;
 }
@@ -0,0 +1,236 @@
+/**
+ * @file pathcache.c
+ * @author Nathan Lemma
+ * @brief Command hash table for the YASH shell
+ * @date 10-17-2026
+ * @details This file contains the bash-style command hash table. Each entry maps argv[0] to the
+ * absolute path found on PATH (or to "not found"), so a loop running the same command thousands
+ * of times scans PATH once instead of issuing a failed execve() per PATH directory per launch.
+ */
+
+// ============================================================================
+// Includes
+// ============================================================================
+
+#include "../include/pathcache.h"
+#include "../include/debug.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// ============================================================================
+// Constants
+// ============================================================================
+
+/** @brief Number of hash buckets (power of two) */
+#define PATHCACHE_BUCKETS 64
+
+// ============================================================================
+// Data Structures
+// ============================================================================
+
+/**
+ * @brief One remembered command
+ */
+typedef struct PathEntry {
+   char* name;             ///< Command name (hash key)
+   char* path;             ///< Resolved absolute path, NULL for a negative entry
+   unsigned hits;          ///< Number of lookups served by this entry
+   struct PathEntry* next; ///< Next entry in the bucket chain
+} PathEntry;
+
+// ============================================================================
+// Static Globals
+// ============================================================================
+
+static PathEntry* buckets[PATHCACHE_BUCKETS];
+static char* cached_path_env; ///< PATH value the table was built against
+
+// ============================================================================
+// Static Functions
+// ============================================================================
+
+/**
+ * @brief FNV-1a hash of a command name
+ *
+ * @param s
+ * @return unsigned
+ */
+static unsigned hash_name(const char* s) {
+   unsigned h = 2166136261u;
+   while (*s) {
+      h ^= (unsigned char)*s++;
+      h *= 16777619u;
+   }
+   return h & (PATHCACHE_BUCKETS - 1);
+}
+
+/**
+ * @brief Drop the table if PATH no longer matches what it was built against
+ */
+static void check_path_env(void) {
+   const char* cur = getenv("PATH");
+   if (cur && cached_path_env && strcmp(cur, cached_path_env) == 0) return;
+   if (!cur && !cached_path_env) return;
+
+   DEBUG_EXEC("PATH changed, dropping command hash table");
+   pathcache_clear();
+   cached_path_env = cur ? strdup(cur) : NULL;
+}
+
+/**
+ * @brief Search PATH for an executable regular file called @p name
+ *
+ * @param name
+ * @return Newly allocated path, or NULL if not found
+ */
+static char* search_path(const char* name) {
+   const char* p = cached_path_env ? cached_path_env : "/usr/bin:/bin";
+   size_t name_len = strlen(name);
+
+   while (1) {
+      const char* end = strchr(p, ':');
+      size_t dir_len = end ? (size_t)(end - p) : strlen(p);
+
+      // An empty PATH component means the current directory
+      const char* dir = dir_len ? p : ".";
+      if (!dir_len) dir_len = 1;
+
+      char* candidate = malloc(dir_len + 1 + name_len + 1);
+      if (!candidate) return NULL;
+      memcpy(candidate, dir, dir_len);
+      candidate[dir_len] = '/';
+      memcpy(candidate + dir_len + 1, name, name_len + 1);
+
+      struct stat st;
+      if (stat(candidate, &st) == 0 && S_ISREG(st.st_mode) && access(candidate, X_OK) == 0) {
+         return candidate;
+      }
+      free(candidate);
+
+      if (!end) return NULL;
+      p = end + 1;
+   }
+}
+
+/**
+ * @brief Find the entry for @p name in its bucket
+ *
+ * @param name
+ * @param prev_out Set to the link pointing at the entry (for unlinking), may be NULL
+ * @return PathEntry* or NULL
+ */
+static PathEntry* find_entry(const char* name, PathEntry*** prev_out) {
+   PathEntry** link = &buckets[hash_name(name)];
+   while (*link) {
+      if (strcmp((*link)->name, name) == 0) {
+         if (prev_out) *prev_out = link;
+         return *link;
+      }
+      link = &(*link)->next;
+   }
+   return NULL;
+}
+
+/**
+ * @brief Resolve @p name and insert a fresh entry
+ *
+ * @param name
+ * @return The new entry, or NULL on allocation failure
+ */
+static PathEntry* insert_entry(const char* name) {
+   PathEntry* e = calloc(1, sizeof(*e));
+   if (!e) return NULL;
+   e->name = strdup(name);
+   if (!e->name) {
+      free(e);
+      return NULL;
+   }
+   e->path = search_path(name);
+
+   unsigned b = hash_name(name);
+   e->next = buckets[b];
+   buckets[b] = e;
+   return e;
+}
+
+/**
+ * @brief Free one entry
+ * @param e
+ */
+static void free_entry(PathEntry* e) {
+   free(e->name);
+   free(e->path);
+   free(e);
+}
+
+// ============================================================================
+// Public Functions
+// ============================================================================
+
+const char* pathcache_lookup(const char* name) {
+   if (!name || !*name) return NULL;
+   if (strchr(name, '/')) return name;
+
+   check_path_env();
+
+   PathEntry* e = find_entry(name, NULL);
+   if (!e) {
+      e = insert_entry(name);
+      if (!e) return NULL;
+   }
+   e->hits++;
+   return e->path;
+}
+
+int pathcache_add(const char* name) {
+   if (!name || !*name || strchr(name, '/')) return -1;
+
+   check_path_env();
+   pathcache_forget(name);
+
+   PathEntry* e = insert_entry(name);
+   return (e && e->path) ? 0 : -1;
+}
+
+void pathcache_forget(const char* name) {
+   PathEntry** link = NULL;
+   PathEntry* e = find_entry(name, &link);
+   if (!e) return;
+   *link = e->next;
+   free_entry(e);
+}
+
+void pathcache_clear(void) {
+   for (int i = 0; i < PATHCACHE_BUCKETS; i++) {
+      PathEntry* e = buckets[i];
+      while (e) {
+         PathEntry* next = e->next;
+         free_entry(e);
+         e = next;
+      }
+      buckets[i] = NULL;
+   }
+   free(cached_path_env);
+   cached_path_env = NULL;
+}
+
+void pathcache_print(void) {
+   int printed_header = 0;
+   for (int i = 0; i < PATHCACHE_BUCKETS; i++) {
+      for (PathEntry* e = buckets[i]; e; e = e->next) {
+         if (!printed_header) {
+            printf("hits\tcommand\n");
+            printed_header = 1;
+         }
+         if (e->path) {
+            printf("%4u\t%s\n", e->hits, e->path);
+         } else {
+            printf("%4u\t%s (not found)\n", e->hits, e->name);
+         }
+      }
+   }
+   if (!printed_header) printf("hash: hash table empty\n");
+}
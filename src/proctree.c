@@ -0,0 +1,199 @@
+/**
+ * @file proctree.c
+ * @author Nathan Lemma
+ * @brief Process tree walking for the YASH shell
+ * @date 10-17-2026
+ * @details This file contains the helpers that find a process's children and whole subtree, and
+ * a live process's CPU time. On
+ * Linux the children come from /proc/PID/task/TID/children (one small read per thread) or, on
+ * kernels built without it, from a scan of every /proc/[pid]/stat. Other systems have no cheap way
+ * to list children, so the tree is just its roots there.
+ */
+
+// ============================================================================
+// Includes
+// ============================================================================
+
+#include "../include/proctree.h"
+#include "../include/debug.h"
+#include <dirent.h>
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// ============================================================================
+// Static Functions
+// ============================================================================
+
+#ifdef __linux__
+/**
+ * @brief Fields of /proc/PID/stat that follow the command name
+ * @param pid
+ * @param buf Receives the file (512 bytes)
+ * @return Text from the state field on, NULL if the process is gone
+ */
+static const char* read_stat(pid_t pid, char* buf) {
+   char path[64];
+   snprintf(path, sizeof(path), "/proc/%d/stat", (int)pid);
+   FILE* f = fopen(path, "re");
+   if (!f) return NULL;
+   size_t n = fread(buf, 1, 511, f);
+   fclose(f);
+   buf[n] = '\0';
+
+   // "pid (comm) state ppid ..."; comm may itself contain spaces and parentheses
+   char* end = strrchr(buf, ')');
+   return end ? end + 1 : NULL;
+}
+
+/**
+ * @brief Parent of a process, from /proc/PID/stat
+ * @param pid
+ * @return The parent pid, -1 if the process is gone
+ */
+static pid_t parent_of(pid_t pid) {
+   char buf[512];
+   const char* fields = read_stat(pid, buf);
+   int ppid;
+   if (!fields || sscanf(fields, " %*c %d", &ppid) != 1) return -1;
+   return ppid;
+}
+
+/**
+ * @brief Children listed in /proc/PID/task/TID/children, for every thread of @p pid
+ * @param pid
+ * @param out
+ * @param max
+ * @return Number of children, -1 if the kernel does not provide the files
+ */
+static int children_from_tasks(pid_t pid, pid_t* out, int max) {
+   char path[64];
+   snprintf(path, sizeof(path), "/proc/%d/task", (int)pid);
+   DIR* tasks = opendir(path);
+   if (!tasks) return -1;
+
+   int n = 0;
+   int found = 0;
+   struct dirent* d;
+   while ((d = readdir(tasks))) {
+      if (d->d_name[0] == '.') continue;
+      char file[320];
+      snprintf(file, sizeof(file), "/proc/%d/task/%s/children", (int)pid, d->d_name);
+      FILE* f = fopen(file, "re");
+      if (!f) continue;
+      found = 1;
+      int child;
+      while (fscanf(f, "%d", &child) == 1) {
+         if (n < max) out[n] = child;
+         n++;
+      }
+      fclose(f);
+   }
+   closedir(tasks);
+   return found ? n : -1;
+}
+
+/**
+ * @brief Children found by scanning every process's parent
+ * @param pid
+ * @param out
+ * @param max
+ * @return Number of children
+ */
+static int children_from_scan(pid_t pid, pid_t* out, int max) {
+   DIR* proc = opendir("/proc");
+   if (!proc) return 0;
+
+   int n = 0;
+   struct dirent* d;
+   while ((d = readdir(proc))) {
+      char* end;
+      long candidate = strtol(d->d_name, &end, 10);
+      if (end == d->d_name || *end || parent_of((pid_t)candidate) != pid) continue;
+      if (n < max) out[n] = (pid_t)candidate;
+      n++;
+   }
+   closedir(proc);
+   return n;
+}
+#endif
+
+// ============================================================================
+// Public Functions
+// ============================================================================
+
+int proctree_children(pid_t pid, pid_t* out, int max) {
+#ifdef __linux__
+   int n = children_from_tasks(pid, out, max);
+   return n >= 0 ? n : children_from_scan(pid, out, max);
+#else
+   (void)pid;
+   (void)out;
+   (void)max;
+   return 0;
+#endif
+}
+
+pid_t* proctree_freeze(const pid_t* roots, int n, int* count) {
+   int cap = n > 16 ? n * 2 : 32;
+   pid_t* tree = malloc(cap * sizeof(pid_t));
+   if (!tree) return NULL;
+   memcpy(tree, roots, n * sizeof(pid_t));
+   int len = n;
+
+   // Breadth first; the list doubles as the queue
+   for (int i = 0; i < len; i++) {
+      if (kill(tree[i], SIGSTOP) == -1 && errno == ESRCH) continue;
+
+      int k;
+      while ((k = proctree_children(tree[i], tree + len, cap - len)) > cap - len) {
+         pid_t* grown = realloc(tree, (cap * 2 + k) * sizeof(pid_t));
+         if (!grown) {
+            free(tree);
+            return NULL;
+         }
+         tree = grown;
+         cap = cap * 2 + k;
+      }
+      // Append the new ones in place; a root can also be a descendant of another root
+      int base = len;
+      for (int c = 0; c < k; c++) {
+         pid_t child = tree[base + c];
+         int seen = 0;
+         for (int j = 0; j < len && !seen; j++) {
+            seen = tree[j] == child;
+         }
+         if (!seen) tree[len++] = child;
+      }
+   }
+   DEBUG_JOBS("froze %d processes from %d roots", len, n);
+   *count = len;
+   return tree;
+}
+
+double proctree_cpu_seconds(pid_t pid) {
+#ifdef __linux__
+   char buf[512];
+   const char* fields = read_stat(pid, buf);
+   unsigned long utime, stime;
+   long cutime, cstime;
+   // state ppid pgrp session tty_nr tpgid flags minflt cminflt majflt cmajflt, then the times
+   if (!fields || sscanf(fields,
+                         " %*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu %ld %ld",
+                         &utime,
+                         &stime,
+                         &cutime,
+                         &cstime) != 4) {
+      return 0;
+   }
+   static long ticks = 0;
+   if (ticks == 0) ticks = sysconf(_SC_CLK_TCK);
+   return ((double)(utime + stime) + (double)(cutime + cstime)) / (double)ticks;
+#else
+   (void)pid;
+   return 0;
+#endif
+}
@@ -0,0 +1,280 @@
+/**
+ * @file queue.c
+ * @author Nathan Lemma
+ * @brief Batch job queue for the YASH shell
+ * @date 10-17-2026
+ * @details This file contains the batch queue and the `submit` and `queue` builtins. Entries are
+ * kept on one list in submission order. A submitted line is parsed again from its own copy of the
+ * text, so it outlives the shell's input buffer. The scheduler runs from the main loop: it picks
+ * the pending entry with the highest priority and, once admission control allows, starts it
+ * through execute_line() as a background job. A job-table hook marks the entry finished when that
+ * job is reaped.
+ */
+
+// ============================================================================
+// Includes
+// ============================================================================
+
+#include "../include/queue.h"
+#include "../include/admit.h"
+#include "../include/debug.h"
+#include "../include/exec.h"
+#include "../include/jobs.h"
+#include "../include/options.h"
+#include "../include/parse.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// ============================================================================
+// Constants
+// ============================================================================
+
+/** @brief Exit status of an entry whose command could not be started */
+#define QUEUE_NOT_STARTED 127
+
+// ============================================================================
+// Static Globals
+// ============================================================================
+
+static QueueEntry* queue_head; ///< Lowest id
+static QueueEntry* queue_tail; ///< Highest id
+static int next_id = 1;        ///< Id of the next entry submitted
+static int counts[3];          ///< Entries per QueueState
+
+// ============================================================================
+// Static Functions
+// ============================================================================
+
+/**
+ * @brief CLOCK_MONOTONIC in seconds
+ * @return double
+ */
+static double now_seconds(void) {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Release what a pending entry holds for launching
+ * @param e
+ */
+static void drop_line(QueueEntry* e) {
+   if (e->line) line_free(e->line);
+   free(e->line);
+   e->line = NULL;
+}
+
+/**
+ * @brief Job-table hook: mark the running entry whose job just finished
+ * @param pgid
+ * @param exit_code
+ */
+static void entry_done(pid_t pgid, int exit_code) {
+   for (QueueEntry* e = queue_head; e; e = e->next) {
+      if (e->state != QUEUE_RUNNING || e->pgid != pgid) continue;
+      e->state = QUEUE_FINISHED;
+      e->exit_code = exit_code;
+      e->finished = now_seconds();
+      counts[QUEUE_RUNNING]--;
+      counts[QUEUE_FINISHED]++;
+      DEBUG_JOBS("queue entry %d finished with %d", e->id, exit_code);
+      return;
+   }
+}
+
+/**
+ * @brief The pending entry to start next
+ * @return Highest priority, earliest submitted; NULL if nothing is pending
+ */
+static QueueEntry* next_pending(void) {
+   QueueEntry* best = NULL;
+   for (QueueEntry* e = queue_head; e && counts[QUEUE_PENDING] > 0; e = e->next) {
+      if (e->state == QUEUE_PENDING && (!best || e->priority > best->priority)) best = e;
+   }
+   return best;
+}
+
+/**
+ * @brief Launch a pending entry as a background job
+ * @param e
+ */
+static void start_entry(QueueEntry* e) {
+   // A launch that adds no background job (command not found, bad class) never ran
+   pid_t before = jobs_last_background();
+   e->started = now_seconds();
+   admit_launch(e->line);
+   pid_t pgid = jobs_last_background();
+   drop_line(e);
+
+   counts[QUEUE_PENDING]--;
+   if (pgid == before) {
+      e->state = QUEUE_FINISHED;
+      e->exit_code = QUEUE_NOT_STARTED;
+      e->finished = e->started;
+      counts[QUEUE_FINISHED]++;
+      return;
+   }
+   e->state = QUEUE_RUNNING;
+   e->pgid = pgid;
+   counts[QUEUE_RUNNING]++;
+   DEBUG_JOBS("queue entry %d started as group %d", e->id, (int)pgid);
+}
+
+// ============================================================================
+// Public Functions
+// ============================================================================
+
+int queue_submit(const Line* line) {
+   const char* text = line->original + line->submit_at;
+   QueueEntry* e = calloc(1, sizeof(QueueEntry));
+   char* cmdline = strdup(text);
+   Line* parsed = calloc(1, sizeof(Line));
+   if (!e || !cmdline || !parsed) {
+      fprintf(stderr, "submit: %s\n", strerror(ENOMEM));
+      free(e);
+      free(cmdline);
+      free(parsed);
+      return -1;
+   }
+
+   // The whole line parsed already, so a second parse only fails on a nested `submit`; a compound
+   // command runs in the shell, which an entry started later in the background can't do
+   if (parse_line(cmdline, parsed) != 0 || parsed->submit_at || parsed->compound) {
+      fprintf(stderr, "submit: %s: cannot queue this command\n", cmdline);
+      line_free(parsed);
+      free(e);
+      free(cmdline);
+      free(parsed);
+      return -1;
+   }
+   // Every entry runs in the background; the queue keeps the wall times that `time` would print
+   parsed->timed = 0;
+   for (int i = 0; i < parsed->num_stages; i++) {
+      parsed->stages[i].background = 1;
+   }
+
+   e->id = next_id++;
+   e->priority = line->priority;
+   e->state = QUEUE_PENDING;
+   e->cmdline = cmdline;
+   e->line = parsed;
+   e->submitted = now_seconds();
+   if (queue_tail) {
+      queue_tail->next = e;
+   } else {
+      queue_head = e;
+   }
+   queue_tail = e;
+   counts[QUEUE_PENDING]++;
+
+   jobs_set_done_hook(entry_done);
+   DEBUG_JOBS("queued entry %d (priority %d): %s", e->id, e->priority, e->cmdline);
+   return e->id;
+}
+
+int queue_schedule(void) {
+   int limit = shell_options.queue_limit;
+   if (limit <= 0) limit = (int)sysconf(_SC_NPROCESSORS_ONLN);
+   if (limit <= 0) limit = 1;
+
+   // Entries wait for admission control too, but are never held as Pending jobs
+   int started = 0;
+   while (counts[QUEUE_RUNNING] < limit && counts[QUEUE_PENDING] > 0 && admit_ok()) {
+      QueueEntry* e = next_pending();
+      if (!e) break;
+      start_entry(e);
+      started++;
+   }
+   return started;
+}
+
+int queue_count(QueueState state) {
+   return counts[state];
+}
+
+const QueueEntry* queue_find(int id) {
+   for (QueueEntry* e = queue_head; e; e = e->next) {
+      if (e->id == id) return e;
+   }
+   return NULL;
+}
+
+int queue_clear_finished(void) {
+   int dropped = 0;
+   QueueEntry** link = &queue_head;
+   queue_tail = NULL;
+   while (*link) {
+      QueueEntry* e = *link;
+      if (e->state != QUEUE_FINISHED) {
+         queue_tail = e;
+         link = &e->next;
+         continue;
+      }
+      *link = e->next;
+      free(e->cmdline);
+      free(e);
+      dropped++;
+   }
+   counts[QUEUE_FINISHED] = 0;
+   return dropped;
+}
+
+void queue_print(void) {
+   double now = now_seconds();
+   printf("%-4s %5s  %-9s %9s %9s  %s\n", "ID", "PRI", "STATE", "WAIT", "WALL", "COMMAND");
+   for (const QueueEntry* e = queue_head; e; e = e->next) {
+      char state[16];
+      char wall[16] = "-";
+      double waited = (e->state == QUEUE_PENDING ? now : e->started) - e->submitted;
+      if (e->state == QUEUE_PENDING) {
+         snprintf(state, sizeof(state), "pending");
+      } else if (e->state == QUEUE_RUNNING) {
+         snprintf(state, sizeof(state), "running");
+         snprintf(wall, sizeof(wall), "%.3fs", now - e->started);
+      } else {
+         snprintf(state, sizeof(state), "exit %d", e->exit_code);
+         snprintf(wall, sizeof(wall), "%.3fs", e->finished - e->started);
+      }
+      printf("%-4d %5d  %-9s %8.3fs %9s  %s\n",
+             e->id,
+             e->priority,
+             state,
+             waited,
+             wall,
+             e->cmdline);
+   }
+   int limit = shell_options.queue_limit;
+   printf("%d pending, %d running, %d finished (limit %d%s)\n",
+          counts[QUEUE_PENDING],
+          counts[QUEUE_RUNNING],
+          counts[QUEUE_FINISHED],
+          limit > 0 ? limit : (int)sysconf(_SC_NPROCESSORS_ONLN),
+          limit > 0 ? "" : ", one per CPU");
+}
+
+int builtin_submit(char* const argv[]) {
+   if (argv[1] && strcmp(argv[1], "-p") == 0 && argv[2] && argv[3]) {
+      fprintf(stderr, "submit: %s: invalid priority\n", argv[2]);
+   } else {
+      fprintf(stderr, "submit: usage: submit [-p PRIORITY] command [arg...]\n");
+   }
+   return 2;
+}
+
+int builtin_queue(char* const argv[]) {
+   if (!argv[1]) {
+      queue_print();
+      return 0;
+   }
+   if (strcmp(argv[1], "-c") == 0 && !argv[2]) {
+      queue_clear_finished();
+      return 0;
+   }
+   fprintf(stderr, "queue: usage: queue [-c]\n");
+   return 2;
+}
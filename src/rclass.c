@@ -0,0 +1,448 @@
+/**
+ * @file rclass.c
+ * @author Nathan Lemma
+ * @brief Resource classes for jobs in the YASH shell
+ * @date 10-17-2026
+ * @details This file contains the parser for `key=value` class specs, the table of named classes
+ * defined with `class -d`, and rclass_apply(), which a forked child calls just before exec. I/O
+ * priority, OOM score and CPU affinity are Linux-only; elsewhere a class that sets them is
+ * reported and the command is not run.
+ */
+
+// ============================================================================
+// Includes
+// ============================================================================
+
+#define _GNU_SOURCE // sched_setaffinity / CPU_SET on Linux
+
+#include "../include/rclass.h"
+#include "../include/parse.h"
+#include "../include/yash.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sched.h>
+#include <sys/syscall.h>
+#endif
+
+// ============================================================================
+// Constants
+// ============================================================================
+
+/** @brief Most named classes that can be defined */
+#define RCLASS_MAX_DEFS 16
+
+/** @brief Default level for `io=be` and `io=rt` (the kernel's own default) */
+#define IOPRIO_DEFAULT_LEVEL 4
+
+/** @brief Shift of the class in an ioprio value */
+#define IOPRIO_CLASS_SHIFT 13
+
+// ============================================================================
+// Data Structures
+// ============================================================================
+
+/**
+ * @brief A `key=` that maps to setrlimit()
+ */
+typedef struct RlimitKey {
+   const char* key; ///< Spec key
+   int resource;    ///< RLIMIT_* constant
+   int is_size;     ///< Value takes a K/M/G suffix
+} RlimitKey;
+
+/**
+ * @brief A class defined with `class -d`
+ */
+typedef struct RclassDef {
+   char name[RCLASS_NAME_MAX + 1]; ///< Class name, empty when the slot is free
+   ResourceClass rc;               ///< Settings
+} RclassDef;
+
+// ============================================================================
+// Static Globals
+// ============================================================================
+
+static const RlimitKey rlimit_keys[] = {
+#ifdef RLIMIT_AS
+    {"as", RLIMIT_AS, 1},
+#endif
+#ifdef RLIMIT_CORE
+    {"core", RLIMIT_CORE, 1},
+#endif
+#ifdef RLIMIT_CPU
+    {"cpu", RLIMIT_CPU, 0},
+#endif
+#ifdef RLIMIT_DATA
+    {"data", RLIMIT_DATA, 1},
+#endif
+#ifdef RLIMIT_FSIZE
+    {"fsize", RLIMIT_FSIZE, 1},
+#endif
+#ifdef RLIMIT_MEMLOCK
+    {"memlock", RLIMIT_MEMLOCK, 1},
+#endif
+#ifdef RLIMIT_NOFILE
+    {"nofile", RLIMIT_NOFILE, 0},
+#endif
+#ifdef RLIMIT_NPROC
+    {"nproc", RLIMIT_NPROC, 0},
+#endif
+#ifdef RLIMIT_RSS
+    {"rss", RLIMIT_RSS, 1},
+#endif
+#ifdef RLIMIT_STACK
+    {"stack", RLIMIT_STACK, 1},
+#endif
+};
+
+static RclassDef defs[RCLASS_MAX_DEFS];
+
+// ============================================================================
+// Static Functions
+// ============================================================================
+
+/**
+ * @brief Parse a whole string as an int in [lo, hi]
+ *
+ * @param s
+ * @param lo
+ * @param hi
+ * @param out
+ * @return 0 on success, -1 if @p s is not a number in range
+ */
+static int parse_int(const char* s, long lo, long hi, int* out) {
+   char* end;
+   errno = 0;
+   long v = strtol(s, &end, 10);
+   if (errno || end == s || *end != '\0' || v < lo || v > hi) return -1;
+   *out = (int)v;
+   return 0;
+}
+
+/**
+ * @brief Parse `idle`, `be[:N]` or `rt[:N]`
+ *
+ * @param s
+ * @param rc
+ * @return 0 on success, -1 on failure
+ */
+static int parse_io(const char* s, ResourceClass* rc) {
+   int level = IOPRIO_DEFAULT_LEVEL;
+   const char* colon = strchr(s, ':');
+   size_t len = colon ? (size_t)(colon - s) : strlen(s);
+
+   if (len == 4 && strncmp(s, "idle", 4) == 0 && !colon) {
+      rc->io_class = 3;
+      level = 0;
+   } else if (len == 2 && strncmp(s, "be", 2) == 0) {
+      rc->io_class = 2;
+   } else if (len == 2 && strncmp(s, "rt", 2) == 0) {
+      rc->io_class = 1;
+   } else {
+      return -1;
+   }
+   if (colon && parse_int(colon + 1, 0, 7, &level) == -1) return -1;
+
+   rc->io_level = level;
+   rc->fields |= RCLASS_IOPRIO;
+   return 0;
+}
+
+/**
+ * @brief Parse a CPU list such as `0-3,8,10-11`
+ *
+ * @param s
+ * @param rc
+ * @return 0 on success, -1 on failure
+ */
+static int parse_cpus(const char* s, ResourceClass* rc) {
+   const int max_cpu = RCLASS_CPU_WORDS * 64 - 1;
+   memset(rc->cpus, 0, sizeof(rc->cpus));
+
+   const char* p = s;
+   while (*p) {
+      char* end;
+      long lo = strtol(p, &end, 10);
+      if (end == p || lo < 0 || lo > max_cpu) return -1;
+      long hi = lo;
+      p = end;
+      if (*p == '-') {
+         hi = strtol(p + 1, &end, 10);
+         if (end == p + 1 || hi < lo || hi > max_cpu) return -1;
+         p = end;
+      }
+      for (long c = lo; c <= hi; c++) {
+         rc->cpus[c / 64] |= 1ULL << (c % 64);
+      }
+      if (*p == ',') {
+         p++;
+         if (*p == '\0') return -1;
+      } else if (*p != '\0') {
+         return -1;
+      }
+   }
+   if (p == s) return -1;
+
+   rc->fields |= RCLASS_CPUS;
+   return 0;
+}
+
+/**
+ * @brief Parse an rlimit value: a number (with K/M/G for sizes) or `unlimited`
+ *
+ * @param key
+ * @param s
+ * @param rc
+ * @return 0 on success, -1 on failure
+ */
+static int parse_limit(const RlimitKey* key, const char* s, ResourceClass* rc) {
+   rlim_t value;
+   if (strcmp(s, "unlimited") == 0) {
+      value = RLIM_INFINITY;
+   } else {
+      long v = key->is_size ? parse_size(s) : -1;
+      if (!key->is_size) {
+         int n;
+         if (parse_int(s, 0, INT_MAX, &n) == 0) v = n;
+      }
+      if (v < 0) return -1;
+      value = (rlim_t)v;
+   }
+
+   // A later word for the same resource replaces the earlier one
+   for (int i = 0; i < rc->num_limits; i++) {
+      if (rc->limits[i].resource == key->resource) {
+         rc->limits[i].value = value;
+         return 0;
+      }
+   }
+   if (rc->num_limits >= RCLASS_MAX_LIMITS) return -1;
+   rc->limits[rc->num_limits].resource = key->resource;
+   rc->limits[rc->num_limits].value = value;
+   rc->num_limits++;
+   return 0;
+}
+
+/**
+ * @brief Apply one `key=value` word to a class
+ *
+ * @param word
+ * @param rc
+ * @return 0 on success, -1 on an unknown key or bad value
+ */
+static int parse_word(const char* word, ResourceClass* rc) {
+   const char* eq = strchr(word, '=');
+   if (!eq || eq == word) return -1;
+   size_t len = (size_t)(eq - word);
+   const char* value = eq + 1;
+
+   if (len == 4 && strncmp(word, "nice", 4) == 0) {
+      if (parse_int(value, -20, 19, &rc->nice) == -1) return -1;
+      rc->fields |= RCLASS_NICE;
+      return 0;
+   }
+   if (len == 2 && strncmp(word, "io", 2) == 0) return parse_io(value, rc);
+   if (len == 3 && strncmp(word, "oom", 3) == 0) {
+      if (parse_int(value, -1000, 1000, &rc->oom_score_adj) == -1) return -1;
+      rc->fields |= RCLASS_OOM;
+      return 0;
+   }
+   if (len == 4 && strncmp(word, "cpus", 4) == 0) return parse_cpus(value, rc);
+
+   for (size_t i = 0; i < sizeof(rlimit_keys) / sizeof(rlimit_keys[0]); i++) {
+      if (strlen(rlimit_keys[i].key) == len && strncmp(word, rlimit_keys[i].key, len) == 0) {
+         return parse_limit(&rlimit_keys[i], value, rc);
+      }
+   }
+   return -1;
+}
+
+/**
+ * @brief Spec key of an rlimit resource, for messages
+ *
+ * @param resource RLIMIT_* constant
+ * @return The key, or "limit" if it is not one of ours
+ */
+static const char* limit_name(int resource) {
+   for (size_t i = 0; i < sizeof(rlimit_keys) / sizeof(rlimit_keys[0]); i++) {
+      if (rlimit_keys[i].resource == resource) return rlimit_keys[i].key;
+   }
+   return "limit";
+}
+
+/**
+ * @brief Find a defined class
+ *
+ * @param name
+ * @return The definition, or NULL
+ */
+static RclassDef* find_def(const char* name) {
+   for (int i = 0; i < RCLASS_MAX_DEFS; i++) {
+      if (defs[i].name[0] && strcmp(defs[i].name, name) == 0) return &defs[i];
+   }
+   return NULL;
+}
+
+/**
+ * @brief Set a class's label to its spec words joined by spaces
+ *
+ * @param rc
+ * @param words
+ */
+static void set_label(ResourceClass* rc, char* const words[]) {
+   size_t used = 0;
+   rc->label[0] = '\0';
+   for (int i = 0; words[i] && used < sizeof(rc->label) - 1; i++) {
+      int n = snprintf(rc->label + used, sizeof(rc->label) - used, "%s%s", i ? " " : "", words[i]);
+      if (n < 0) break;
+      used += (size_t)n;
+   }
+}
+
+#ifdef __linux__
+/**
+ * @brief Write this process's OOM score adjustment
+ *
+ * @param value
+ * @return 0 on success, -1 on failure with errno set
+ */
+static int set_oom_score_adj(int value) {
+   int fd = open("/proc/self/oom_score_adj", O_WRONLY | O_CLOEXEC);
+   if (fd < 0) return -1;
+   char buf[16];
+   int len = snprintf(buf, sizeof(buf), "%d", value);
+   ssize_t n = write(fd, buf, (size_t)len);
+   int saved = errno;
+   close(fd);
+   errno = saved;
+   return n == len ? 0 : -1;
+}
+#endif
+
+// ============================================================================
+// Public Functions
+// ============================================================================
+
+int rclass_parse(char* const words[], ResourceClass* rc, const char** bad) {
+   memset(rc, 0, sizeof(*rc));
+   if (bad) *bad = NULL;
+   if (!words) return 0;
+
+   int i = 0;
+   if (words[0] && !strchr(words[0], '=')) {
+      const RclassDef* def = find_def(words[0]);
+      if (!def) {
+         if (bad) *bad = words[0];
+         return -1;
+      }
+      *rc = def->rc;
+      i = 1;
+   }
+   for (; words[i]; i++) {
+      if (parse_word(words[i], rc) == -1) {
+         if (bad) *bad = words[i];
+         return -1;
+      }
+   }
+
+   set_label(rc, words);
+   return 0;
+}
+
+int rclass_define(const char* name, char* const words[], const char** bad) {
+   if (bad) *bad = name;
+   if (!name || !*name || strchr(name, '=') || strlen(name) > RCLASS_NAME_MAX) {
+      errno = EINVAL;
+      return -1;
+   }
+
+   ResourceClass rc;
+   if (rclass_parse(words, &rc, bad) == -1) return -1;
+
+   RclassDef* def = find_def(name);
+   for (int i = 0; !def && i < RCLASS_MAX_DEFS; i++) {
+      if (!defs[i].name[0]) def = &defs[i];
+   }
+   if (!def) {
+      if (bad) *bad = name;
+      errno = ENOSPC;
+      return -1;
+   }
+
+   snprintf(def->name, sizeof(def->name), "%s", name);
+   def->rc = rc;
+   return 0;
+}
+
+void rclass_print(void) {
+   for (int i = 0; i < RCLASS_MAX_DEFS; i++) {
+      if (defs[i].name[0]) printf("%s\t%s\n", defs[i].name, defs[i].rc.label);
+   }
+}
+
+int rclass_apply(const ResourceClass* rc) {
+   int result = 0;
+
+   // Limits first: a failure there should not leave the process half-reniced for nothing
+   for (int i = 0; i < rc->num_limits; i++) {
+      struct rlimit lim = {rc->limits[i].value, rc->limits[i].value};
+      if (setrlimit(rc->limits[i].resource, &lim) == -1) {
+         const char* key = limit_name(rc->limits[i].resource);
+         fprintf(stderr, "class: %s: %s\n", key, strerror(errno));
+         return -1;
+      }
+   }
+
+   if ((rc->fields & RCLASS_NICE) && setpriority(PRIO_PROCESS, 0, rc->nice) == -1) {
+      fprintf(stderr, "class: nice=%d: %s\n", rc->nice, strerror(errno));
+      result = -1;
+   }
+
+#ifdef __linux__
+#ifdef SYS_ioprio_set
+   if (rc->fields & RCLASS_IOPRIO) {
+      int prio = rc->io_class << IOPRIO_CLASS_SHIFT | rc->io_level;
+      if (syscall(SYS_ioprio_set, 1 /* IOPRIO_WHO_PROCESS */, 0, prio) == -1) {
+         fprintf(stderr, "class: io: %s\n", strerror(errno));
+         result = -1;
+      }
+   }
+#else
+   if (rc->fields & RCLASS_IOPRIO) {
+      fprintf(stderr, "class: io: %s\n", strerror(ENOSYS));
+      result = -1;
+   }
+#endif
+
+   if ((rc->fields & RCLASS_OOM) && set_oom_score_adj(rc->oom_score_adj) == -1) {
+      fprintf(stderr, "class: oom=%d: %s\n", rc->oom_score_adj, strerror(errno));
+      result = -1;
+   }
+
+   if (rc->fields & RCLASS_CPUS) {
+      cpu_set_t set;
+      CPU_ZERO(&set);
+      for (int c = 0; c < RCLASS_CPU_WORDS * 64 && c < CPU_SETSIZE; c++) {
+         if (rc->cpus[c / 64] & (1ULL << (c % 64))) CPU_SET(c, &set);
+      }
+      if (sched_setaffinity(0, sizeof(set), &set) == -1) {
+         fprintf(stderr, "class: cpus: %s\n", strerror(errno));
+         result = -1;
+      }
+   }
+#else
+   if (rc->fields & (RCLASS_IOPRIO | RCLASS_OOM | RCLASS_CPUS)) {
+      fprintf(stderr, "class: io, oom and cpus are only supported on Linux\n");
+      result = -1;
+   }
+#endif
+
+   return result;
+}
@@ -12,13 +12,15 @@
 
 #include "../include/signals.h"
 #include "../include/debug.h"
+#include "../include/events.h"
 #include "../include/yash.h"
 
 // ============================================================================
 // Globals
 // ============================================================================
 
-volatile sig_atomic_t child_status_changed = 0;
+volatile sig_atomic_t shell_interrupted = 0;
+volatile sig_atomic_t shell_stop_signal = 0;
 pid_t foreground_pgid = 0;
 
 // ============================================================================
@@ -27,11 +29,13 @@ pid_t foreground_pgid = 0;
 
 void sigchld_handler(int sig) {
    (void)sig; // Suppress unused parameter warning
-   child_status_changed = 1;
+   events_notify_child(); // Only reached on the self-pipe path; signalfd keeps SIGCHLD blocked
 }
 
 void sigint_handler(int sig) {
    (void)sig; // Suppress unused parameter warning
+   shell_interrupted = 1; // Stops a builtin running inside the shell
+   shell_stop_signal = SIGINT;
    DEBUG_PRINT("SIGINT handler called, foreground_pgid = %d", foreground_pgid);
    if (foreground_pgid > 0) {
       DEBUG_PRINT("Sending SIGINT to process group %d", -foreground_pgid);
@@ -43,6 +47,7 @@ void sigint_handler(int sig) {
 
 void sigtstp_handler(int sig) {
    (void)sig; // Suppress unused parameter warning
+   shell_stop_signal = SIGTSTP; // Stops a copy running inside the shell, which hands off the rest
    DEBUG_PRINT("SIGTSTP handler called, foreground_pgid = %d", foreground_pgid);
    if (foreground_pgid > 0) {
       DEBUG_PRINT("Sending SIGTSTP to process group %d", -foreground_pgid);
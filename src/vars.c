@@ -0,0 +1,355 @@
+/**
+ * @file vars.c
+ * @author Nathan Lemma
+ * @brief Shell parameters and word expansion for the YASH shell
+ * @date 10-17-2026
+ * @details This file contains the shell variable table, the positional parameters, the last exit
+ * status and the `$` expansion of words. Expansion measures each word before writing it, so an
+ * expanded word costs one arena allocation and a word without a `$` costs nothing.
+ */
+
+// ============================================================================
+// Includes
+// ============================================================================
+
+#include "../include/vars.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ============================================================================
+// Constants
+// ============================================================================
+
+/** @brief Longest decimal a status or parameter count expands to */
+#define NUMBER_MAX_LEN 11
+
+/** @brief Number of hash buckets for shell variables (power of two) */
+#define VARS_BUCKETS 64
+
+// ============================================================================
+// Data Structures
+// ============================================================================
+
+/**
+ * @brief One shell variable
+ */
+typedef struct Var {
+   char* name;       ///< Variable name (hash key)
+   char* value;      ///< Current value
+   struct Var* next; ///< Next variable in the bucket chain
+} Var;
+
+// ============================================================================
+// Static Globals
+// ============================================================================
+
+static int last_status;         ///< `$?`
+static char* const* positional; ///< `$0`, `$1`... of the running function
+static Var* buckets[VARS_BUCKETS];
+
+// ============================================================================
+// Static Functions
+// ============================================================================
+
+/**
+ * @brief FNV-1a hash of the first @p len bytes of a name
+ */
+static unsigned hash_name(const char* s, size_t len) {
+   unsigned h = 2166136261u;
+   for (size_t i = 0; i < len; i++) {
+      h ^= (unsigned char)s[i];
+      h *= 16777619u;
+   }
+   return h & (VARS_BUCKETS - 1);
+}
+
+/**
+ * @brief Find a shell variable by the first @p len bytes of a name
+ * @return The variable, NULL if there is none
+ */
+static Var* find_var(const char* name, size_t len) {
+   for (Var* v = buckets[hash_name(name, len)]; v; v = v->next) {
+      if (strncmp(v->name, name, len) == 0 && v->name[len] == '\0') return v;
+   }
+   return NULL;
+}
+
+/**
+ * @brief Value of the variable named by the first @p len bytes of @p name
+ * @return The shell variable's value, else the environment's, NULL if unset
+ */
+static const char* lookup(const char* name, size_t len) {
+   Var* v = find_var(name, len);
+   if (v) return v->value;
+
+   char key[256];
+   if (len >= sizeof(key)) return NULL;
+   memcpy(key, name, len);
+   key[len] = '\0';
+   return getenv(key);
+}
+
+/**
+ * @brief Take a variable out of the shell's table
+ * @param name
+ */
+static void remove_var(const char* name) {
+   size_t len = strlen(name);
+   for (Var** link = &buckets[hash_name(name, len)]; *link; link = &(*link)->next) {
+      Var* v = *link;
+      if (strcmp(v->name, name) == 0) {
+         *link = v->next;
+         free(v->name);
+         free(v->value);
+         free(v);
+         return;
+      }
+   }
+}
+
+/**
+ * @brief Number of positional parameters, `$#`
+ */
+static int count_args(void) {
+   int n = 0;
+   while (positional && positional[n + 1]) {
+      n++;
+   }
+   return n;
+}
+
+/**
+ * @brief Value of the parameter named at @p p (just after a `$`)
+ *
+ * @param p
+ * @param number Scratch space for a numeric value
+ * @param value Receives the value, NULL if unset
+ * @return Bytes of the parameter's name consumed, 0 if @p p does not start one
+ */
+static size_t parameter(const char* p, char number[NUMBER_MAX_LEN + 1], const char** value) {
+   *value = NULL;
+   if (*p == '?') {
+      snprintf(number, NUMBER_MAX_LEN + 1, "%d", last_status);
+      *value = number;
+      return 1;
+   }
+   if (*p == '#') {
+      snprintf(number, NUMBER_MAX_LEN + 1, "%d", count_args());
+      *value = number;
+      return 1;
+   }
+   if (*p >= '0' && *p <= '9') {
+      int i = *p - '0';
+      if (!positional) {
+         *value = i == 0 ? "yash" : NULL;
+      } else if (i <= count_args()) {
+         *value = positional[i];
+      }
+      return 1;
+   }
+   // `$@` and `$*` are handled by the caller, which joins the parameters
+   if (*p == '{') {
+      const char* end = strchr(p + 1, '}');
+      if (!end || !vars_is_name(p + 1, end - p - 1)) return 0;
+      *value = lookup(p + 1, end - p - 1);
+      return end - p + 1;
+   }
+   size_t len = 0;
+   while (vars_is_name(p, len + 1)) {
+      len++;
+   }
+   if (len > 0) *value = lookup(p, len);
+   return len;
+}
+
+/**
+ * @brief Expand a word into @p out, or only measure it
+ *
+ * @param word
+ * @param out NULL to only measure
+ * @return Length of the expansion
+ */
+static size_t expand_into(const char* word, char* out) {
+   size_t n = 0;
+   char number[NUMBER_MAX_LEN + 1];
+   for (const char* p = word; *p; p++) {
+      if (*p != '$') {
+         if (out) out[n] = *p;
+         n++;
+         continue;
+      }
+      if (p[1] == '@' || p[1] == '*') {
+         for (int i = 1; positional && i <= count_args(); i++) {
+            size_t len = strlen(positional[i]);
+            if (out) {
+               if (i > 1) out[n] = ' ';
+               memcpy(out + n + (i > 1), positional[i], len);
+            }
+            n += len + (i > 1);
+         }
+         p++;
+         continue;
+      }
+      const char* value;
+      size_t used = parameter(p + 1, number, &value);
+      if (used == 0) {
+         // Not a parameter: the `$` stays
+         if (out) out[n] = '$';
+         n++;
+         continue;
+      }
+      if (value) {
+         size_t len = strlen(value);
+         if (out) memcpy(out + n, value, len);
+         n += len;
+      }
+      p += used;
+   }
+   return n;
+}
+
+/**
+ * @brief Whether a character separates the fields of an expanded word
+ */
+static int is_field_blank(char c) {
+   return c == ' ' || c == '\t' || c == '\n';
+}
+
+// ============================================================================
+// Public Functions
+// ============================================================================
+
+void vars_set_status(int status) {
+   last_status = status & 0xff;
+}
+
+int vars_status(void) {
+   return last_status;
+}
+
+int vars_is_name(const char* s, size_t len) {
+   if (len == 0 || (s[0] >= '0' && s[0] <= '9')) return 0;
+   for (size_t i = 0; i < len; i++) {
+      char c = s[i];
+      int alpha = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+      if (!alpha && !(c >= '0' && c <= '9')) return 0;
+   }
+   return 1;
+}
+
+int vars_set(const char* name, const char* value) {
+   // An exported variable stays in the environment only
+   if (getenv(name)) return setenv(name, value, 1) == 0 ? 0 : -1;
+
+   size_t len = strlen(name);
+   Var* v = find_var(name, len);
+   char* copy = strdup(value);
+   if (!copy) return -1;
+   if (v) {
+      free(v->value);
+      v->value = copy;
+      return 0;
+   }
+
+   v = malloc(sizeof(Var));
+   if (!v || !(v->name = strdup(name))) {
+      free(v);
+      free(copy);
+      return -1;
+   }
+   v->value = copy;
+   unsigned b = hash_name(name, len);
+   v->next = buckets[b];
+   buckets[b] = v;
+   return 0;
+}
+
+const char* vars_get(const char* name) {
+   Var* v = find_var(name, strlen(name));
+   return v ? v->value : getenv(name);
+}
+
+void vars_unset(const char* name) {
+   remove_var(name);
+   unsetenv(name);
+}
+
+int vars_export(const char* name, const char* value) {
+   if (!value) value = vars_get(name);
+   if (setenv(name, value ? value : "", 1) == -1) return -1;
+
+   // The environment holds it from now on
+   remove_var(name);
+   return 0;
+}
+
+char* const* vars_set_args(char* const* args) {
+   char* const* old = positional;
+   positional = args;
+   return old;
+}
+
+char* const* vars_args(void) {
+   return positional;
+}
+
+char* vars_expand(char* word, Arena* arena) {
+   if (!strchr(word, '$')) return word;
+
+   size_t len = expand_into(word, NULL);
+   char* out = arena_alloc(arena, len + 1);
+   if (!out) return NULL;
+   expand_into(word, out);
+   out[len] = '\0';
+   return out;
+}
+
+char** vars_expand_words(char* const words[], Arena* arena) {
+   int n = 0;
+   while (words[n]) {
+      n++;
+   }
+   char** expanded = arena_alloc(arena, sizeof(char*) * (n + 1));
+   if (!expanded) return NULL;
+
+   // Expand every word first, counting the fields they split into
+   int fields = 0;
+   for (int i = 0; i < n; i++) {
+      if (!strchr(words[i], '$')) {
+         expanded[i] = words[i];
+         fields++;
+         continue;
+      }
+      expanded[i] = vars_expand(words[i], arena);
+      if (!expanded[i]) return NULL;
+      for (const char* p = expanded[i]; *p; p++) {
+         if (!is_field_blank(*p) && (p == expanded[i] || is_field_blank(p[-1]))) fields++;
+      }
+   }
+
+   char** out = arena_alloc(arena, sizeof(char*) * (fields + 1));
+   if (!out) return NULL;
+   int k = 0;
+   for (int i = 0; i < n; i++) {
+      if (expanded[i] == words[i]) {
+         out[k++] = words[i];
+         continue;
+      }
+      // The expanded copy is the arena's, so the fields are cut out of it in place
+      char* p = expanded[i];
+      while (*p) {
+         while (is_field_blank(*p)) {
+            p++;
+         }
+         if (!*p) break;
+         out[k++] = p;
+         while (*p && !is_field_blank(*p)) {
+            p++;
+         }
+         if (*p) *p++ = '\0';
+      }
+   }
+   out[k] = NULL;
+   return out;
+}
@@ -0,0 +1,37 @@
+#!/bin/bash
+# Builtin dispatch benchmark.
+#
+# Feeds COUNT lines of `true` to yash and to dash and prints invocations per second for both.
+# A smaller run of `/bin/true` through yash shows what each line cost before `true` was a
+# builtin.
+#
+# Usage: tests/bench/bench_builtins.sh [count] [yash_binary]
+
+set -e
+
+COUNT=${1:-100000}
+YASH=${2:-./yash}
+EXTERNAL=$((COUNT / 50))
+
+DIR=$(mktemp -d)
+trap 'rm -rf "$DIR"' EXIT
+yes true | head -n "$COUNT" > "$DIR/builtin"
+yes /bin/true | head -n "$EXTERNAL" > "$DIR/external"
+
+run() {
+   local label=$1 shell=$2 script=$3 count=$4
+   local start end
+   start=$(date +%s.%N)
+   "$shell" < "$script" > /dev/null
+   end=$(date +%s.%N)
+   awk -v l="$label" -v s="$start" -v e="$end" -v n="$count" \
+      'BEGIN { printf "%-16s %10.0f cmds/s (%d in %.2fs)\n", l, n / (e - s), n, e - s }'
+}
+
+run "yash true" "$YASH" "$DIR/builtin" "$COUNT"
+if command -v dash > /dev/null; then
+   run "dash true" dash "$DIR/builtin" "$COUNT"
+else
+   echo "dash not installed, skipping"
+fi
+run "yash /bin/true" "$YASH" "$DIR/external" "$EXTERNAL"
@@ -0,0 +1,44 @@
+#!/bin/bash
+# Builtin cat benchmark.
+#
+# Runs the same yash script with the in-process `cat` and with `/bin/cat` (a path, so the
+# builtin is bypassed): COUNT copies of a 4 KB file, then one SIZE_MB file through
+# `cat | wc -c`, and prints the time for each.
+#
+# Usage: tests/bench/bench_cat.sh [size_mb] [count] [yash_binary]
+
+set -e
+
+SIZE_MB=${1:-1024}
+COUNT=${2:-2000}
+YASH=${3:-./yash}
+
+DIR=$(mktemp -d)
+trap 'rm -rf "$DIR"' EXIT
+head -c 4096 /dev/urandom > "$DIR/small"
+head -c $((SIZE_MB * 1024 * 1024)) /dev/zero > "$DIR/big"
+
+run() {
+   local label=$1 script=$2
+   local start end
+   start=$(date +%s.%N)
+   "$YASH" < "$script" > /dev/null
+   end=$(date +%s.%N)
+   awk -v l="$label" -v s="$start" -v e="$end" 'BEGIN { printf "%-10s %8.2fs\n", l, e - s }'
+}
+
+for cat in cat /bin/cat; do
+   name=${cat//\//_}
+   for _ in $(seq "$COUNT"); do
+      echo "$cat $DIR/small > $DIR/out"
+   done > "$DIR/small$name"
+   echo "$cat $DIR/big | wc -c" > "$DIR/big$name"
+done
+
+echo "$COUNT x 4 KB copies"
+run "builtin" "$DIR/smallcat"
+run "/bin/cat" "$DIR/small_bin_cat"
+
+echo "$SIZE_MB MB through cat | wc -c"
+run "builtin" "$DIR/bigcat"
+run "/bin/cat" "$DIR/big_bin_cat"
@@ -0,0 +1,127 @@
+/**
+ * @file bench_jobs.c
+ * @brief Job table benchmark
+ * @details Fills the job table with many concurrent background jobs (10,000 by default, each a
+ * three-stage pipeline), then times the operations the shell performs on it: adding a job,
+ * looking one up by id, updating one by pgid, applying a wait status to the job owning a pid, and
+ * reaping the finished ones. Every operation should cost the same no matter how many jobs there
+ * are, so the per-operation times are printed for a small and a full table. The pids are made
+ * up; no processes are started.
+ *
+ * Usage: bench_jobs [jobs] [lookups]
+ */
+
+#include "../../include/jobs.h"
+#include "../../include/yash.h"
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+/** @brief First made-up pgid */
+#define PGID_BASE 1000000
+
+/** @brief Stages per job */
+#define STAGES 3
+
+/** @brief Wait status of a process stopped by SIGTSTP (the encoding every Unix uses) */
+#define STOPPED_STATUS (0x7f | SIGTSTP << 8)
+
+/**
+ * @brief Nanoseconds elapsed since @p start
+ */
+static double elapsed_ns(const struct timespec* start) {
+   struct timespec now;
+   clock_gettime(CLOCK_MONOTONIC, &now);
+   return (double)(now.tv_sec - start->tv_sec) * 1e9 + (double)(now.tv_nsec - start->tv_nsec);
+}
+
+/**
+ * @brief Fill a fresh table with @p n jobs and time each phase
+ */
+static void run(int n, int lookups) {
+   struct timespec start;
+   char cmd[64];
+
+   jobs_init();
+   clock_gettime(CLOCK_MONOTONIC, &start);
+   for (int i = 0; i < n; i++) {
+      pid_t pids[STAGES];
+      for (int k = 0; k < STAGES; k++) {
+         pids[k] = PGID_BASE + STAGES * i + k;
+      }
+      snprintf(cmd, sizeof(cmd), "sleep 1000 # job %d &", i);
+      if (jobs_add(pids[0], pids, STAGES, cmd, 1) == -1) {
+         fprintf(stderr, "jobs_add failed at %d\n", i);
+         exit(1);
+      }
+   }
+   double add = elapsed_ns(&start) / n;
+
+   // Ids and pgids spread over the whole table
+   volatile pid_t sink = 0;
+   clock_gettime(CLOCK_MONOTONIC, &start);
+   for (int i = 0; i < lookups; i++) {
+      sink += jobs_get_pgid(1 + (int)((unsigned)i * 2654435761u % (unsigned)n));
+   }
+   double by_id = elapsed_ns(&start) / lookups;
+
+   clock_gettime(CLOCK_MONOTONIC, &start);
+   for (int i = 0; i < lookups; i++) {
+      pid_t pgid = PGID_BASE + STAGES * (pid_t)((unsigned)i * 2654435761u % (unsigned)n);
+      jobs_mark(pgid, (i & 1) ? JOB_RUNNING : JOB_STOPPED);
+   }
+   double by_pgid = elapsed_ns(&start) / lookups;
+
+   // Every stage of every job stops, as after a Ctrl-Z of the whole group
+   clock_gettime(CLOCK_MONOTONIC, &start);
+   for (int i = 0; i < n * STAGES; i++) {
+      jobs_process_event(PGID_BASE + i, STOPPED_STATUS, NULL);
+   }
+   double by_pid = elapsed_ns(&start) / (n * STAGES);
+
+   // Every stage of one job in ten exits, then they are reaped as the prompt would
+   for (int i = 0; i < n; i += 10) {
+      for (int k = 0; k < STAGES; k++) {
+         jobs_process_event(PGID_BASE + STAGES * i + k, 0, NULL);
+      }
+   }
+   fflush(stdout);
+   int saved = dup(STDOUT_FILENO);
+   int devnull = open("/dev/null", O_WRONLY);
+   dup2(devnull, STDOUT_FILENO);
+   clock_gettime(CLOCK_MONOTONIC, &start);
+   jobs_reap_done_and_print();
+   fflush(stdout);
+   double reap = elapsed_ns(&start) / ((n + 9) / 10);
+   dup2(saved, STDOUT_FILENO);
+   close(saved);
+   close(devnull);
+
+   printf("%6d jobs: add %6.1f ns  get by id %5.1f ns  mark by pgid %5.1f ns  "
+          "event by pid %5.1f ns  reap %6.1f ns/job\n",
+          n,
+          add,
+          by_id,
+          by_pgid,
+          by_pid,
+          reap);
+   (void)sink;
+}
+
+int main(int argc, char* argv[]) {
+   int n = argc > 1 ? atoi(argv[1]) : 10000;
+   int lookups = argc > 2 ? atoi(argv[2]) : 1000000;
+   if (n < 20 || lookups < 1) {
+      fprintf(stderr, "usage: bench_jobs [jobs >= 20] [lookups]\n");
+      return 1;
+   }
+
+   // 20 was the old fixed capacity
+   run(20, lookups);
+   run(n, lookups);
+   jobs_init();
+   return 0;
+}
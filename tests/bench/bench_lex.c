@@ -0,0 +1,118 @@
+/**
+ * @file bench_lex.c
+ * @brief Lexer throughput benchmark
+ * @details Tokenizes a 1 KB, a 64 KB and a 1 MB command line (the same pipeline of short words
+ * bench_parse uses) with each lexer implementation the CPU supports and reports MB/s for lex_line()
+ * alone and for the whole parse_line() built on it.
+ *
+ * Usage: bench_lex [seconds per case]
+ */
+
+#include "../../include/lex.h"
+#include "../../include/parse.h"
+#include "../../include/yash.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * @brief Seconds elapsed since @p start
+ */
+static double elapsed(const struct timespec* start) {
+   struct timespec now;
+   clock_gettime(CLOCK_MONOTONIC, &now);
+   return (double)(now.tv_sec - start->tv_sec) + (double)(now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/**
+ * @brief Build a command line of about @p size bytes
+ * @return Heap allocated line
+ */
+static char* make_line(size_t size) {
+   char* line = malloc(size + 64);
+   if (!line) {
+      perror("malloc");
+      exit(1);
+   }
+   size_t pos = (size_t)sprintf(line, "grep -F");
+   // Stays under size, so the 1 MB line fits an ARG_MAX of exactly 1 MB
+   for (int i = 0; pos < size - 48; i++) {
+      pos += (size_t)sprintf(line + pos, " word%d", i);
+   }
+   sprintf(line + pos, " < in.txt | sort | wc -l > out.txt");
+   return line;
+}
+
+/**
+ * @brief Lex or parse @p text for about @p seconds and return MB/s
+ * @param text
+ * @param seconds
+ * @param parse Time parse_line() instead of lex_line()
+ */
+static double run(const char* text, double seconds, int parse) {
+   size_t len = strlen(text);
+   size_t max = lex_count(text, len);
+   char* work = malloc(len + 1);
+   char** tokens = malloc((max + 1) * sizeof(char*));
+   TokenKind* kinds = malloc((max + 1) * sizeof(TokenKind));
+   if (!work || !tokens || !kinds) {
+      perror("malloc");
+      exit(1);
+   }
+   Line line;
+   memset(&line, 0, sizeof(line));
+
+   long count = 0;
+   struct timespec start;
+   clock_gettime(CLOCK_MONOTONIC, &start);
+   double spent = 0;
+   while (spent < seconds) {
+      // The lexer writes into its input, so every pass starts from a fresh copy
+      for (int i = 0; i < 16; i++) {
+         memcpy(work, text, len + 1);
+         if (parse) {
+            if (parse_line(work, &line) != 0) {
+               fprintf(stderr, "parse_line failed\n");
+               exit(1);
+            }
+         } else if (lex_line(work, len, tokens, kinds) != max) {
+            fprintf(stderr, "lex_line miscounted\n");
+            exit(1);
+         }
+      }
+      count += 16;
+      spent = elapsed(&start);
+   }
+   line_free(&line);
+   free(kinds);
+   free(tokens);
+   free(work);
+   return (double)len * count / spent / 1e6;
+}
+
+int main(int argc, char* argv[]) {
+   double seconds = argc > 1 ? atof(argv[1]) : 1.0;
+   if (seconds <= 0) {
+      fprintf(stderr, "usage: bench_lex [seconds per case]\n");
+      return 1;
+   }
+
+   const size_t sizes[] = {1 << 10, 64 << 10, 1 << 20};
+   const LexBackend backends[] = {LEX_SCALAR, LEX_SSE2, LEX_AVX2};
+   for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+      char* text = make_line(sizes[i]);
+      for (size_t b = 0; b < sizeof(backends) / sizeof(backends[0]); b++) {
+         if (lex_use(backends[b]) == -1) continue;
+         double lex = run(text, seconds, 0);
+         double parse = run(text, seconds, 1);
+         printf("%8zu bytes, %-6s lex %8.1f MB/s  parse_line %8.1f MB/s\n",
+                strlen(text),
+                lex_name(),
+                lex,
+                parse);
+      }
+      free(text);
+   }
+   return 0;
+}
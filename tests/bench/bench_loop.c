@@ -0,0 +1,110 @@
+/**
+ * @file bench_loop.c
+ * @brief Loop execution benchmark
+ * @details Runs a million-iteration loop (six nested `for` loops over ten words each) parsed once,
+ * with a body that runs a builtin (`true`) and one that assigns an expanded variable (`x=$a`),
+ * and reports iterations per second. For comparison the same body is also parsed again on every
+ * iteration, which is what running it without a parsed body would cost.
+ *
+ * Usage: bench_loop [levels]
+ */
+
+#include "../../include/exec.h"
+#include "../../include/parse.h"
+#include "../../include/vars.h"
+#include "../../include/yash.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/** @brief Words each nested loop goes over */
+#define LOOP_WORDS "0 1 2 3 4 5 6 7 8 9"
+
+/**
+ * @brief Seconds elapsed since @p start
+ */
+static double elapsed(const struct timespec* start) {
+   struct timespec now;
+   clock_gettime(CLOCK_MONOTONIC, &now);
+   return (double)(now.tv_sec - start->tv_sec) + (double)(now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/**
+ * @brief Run @p body @p count (10^levels) times from one parse and print the rate
+ */
+static void run_parsed(const char* body, int levels, long count) {
+   char text[1024];
+   size_t pos = 0;
+   for (int i = 0; i < levels; i++) {
+      pos += (size_t)snprintf(text + pos, sizeof(text) - pos, "for i%d in %s ; do ", i, LOOP_WORDS);
+   }
+   pos += (size_t)snprintf(text + pos, sizeof(text) - pos, "%s", body);
+   for (int i = 0; i < levels; i++) {
+      pos += (size_t)snprintf(text + pos, sizeof(text) - pos, " ; done");
+   }
+
+   Line line;
+   memset(&line, 0, sizeof(line));
+   if (parse_line(text, &line) != 0) {
+      fprintf(stderr, "parse_line failed\n");
+      exit(1);
+   }
+
+   struct timespec start;
+   clock_gettime(CLOCK_MONOTONIC, &start);
+   execute_line(&line);
+   double spent = elapsed(&start);
+   line_free(&line);
+
+   printf("%-8s parsed once    %12.0f iterations/s  %8.1f ns/iteration\n",
+          body,
+          count / spent,
+          spent / count * 1e9);
+}
+
+/**
+ * @brief Parse and run @p body @p count times and print the rate
+ */
+static void run_reparsed(const char* body, long count) {
+   Line line;
+   memset(&line, 0, sizeof(line));
+
+   struct timespec start;
+   clock_gettime(CLOCK_MONOTONIC, &start);
+   for (long i = 0; i < count; i++) {
+      if (parse_line(body, &line) != 0) {
+         fprintf(stderr, "parse_line failed\n");
+         exit(1);
+      }
+      execute_line(&line);
+   }
+   double spent = elapsed(&start);
+   line_free(&line);
+
+   printf("%-8s parsed each   %12.0f iterations/s  %8.1f ns/iteration\n",
+          body,
+          count / spent,
+          spent / count * 1e9);
+}
+
+int main(int argc, char* argv[]) {
+   int levels = argc > 1 ? atoi(argv[1]) : 6;
+   if (levels < 1 || levels > 9) {
+      fprintf(stderr, "usage: bench_loop [levels 1-9]\n");
+      return 1;
+   }
+
+   long count = 1;
+   for (int i = 0; i < levels; i++) {
+      count *= 10;
+   }
+
+   vars_set("a", "value");
+   const char* bodies[] = {"true", "x=$a"};
+   for (size_t i = 0; i < sizeof(bodies) / sizeof(bodies[0]); i++) {
+      run_parsed(bodies[i], levels, count);
+      run_reparsed(bodies[i], count);
+   }
+   return 0;
+}
@@ -0,0 +1,117 @@
+/**
+ * @file bench_parse.c
+ * @brief Parser throughput benchmark
+ * @details Parses a 1 KB, a 64 KB and a 1 MB command line (a pipeline of short words with a
+ * redirection, the shape `xargs`-style generated lines take) over and over and reports MB/s and
+ * lines per second. Each size is timed three ways: reusing one Line, so its arena is warm and no
+ * memory is allocated; with a fresh Line released after every parse, which pays for the arena's
+ * malloc() calls each time; and through the parsed-line cache, as the shell's main loop does, where
+ * every parse after the first is a hit that only hashes and compares the text.
+ *
+ * Usage: bench_parse [seconds per case]
+ */
+
+#include "../../include/linecache.h"
+#include "../../include/parse.h"
+#include "../../include/yash.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * @brief Seconds elapsed since @p start
+ */
+static double elapsed(const struct timespec* start) {
+   struct timespec now;
+   clock_gettime(CLOCK_MONOTONIC, &now);
+   return (double)(now.tv_sec - start->tv_sec) + (double)(now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/**
+ * @brief Build a command line of about @p size bytes
+ * @return Heap allocated line
+ */
+static char* make_line(size_t size) {
+   char* line = malloc(size + 64);
+   if (!line) {
+      perror("malloc");
+      exit(1);
+   }
+   size_t pos = (size_t)sprintf(line, "grep -F");
+   // Stays under size, so the 1 MB line fits an ARG_MAX of exactly 1 MB
+   for (int i = 0; pos < size - 48; i++) {
+      pos += (size_t)sprintf(line + pos, " word%d", i);
+   }
+   sprintf(line + pos, " < in.txt | sort | wc -l > out.txt");
+   return line;
+}
+
+/**
+ * @brief How run() parses
+ */
+typedef enum {
+   PARSE_REUSED, ///< parse_line() into one Line throughout
+   PARSE_FRESH,  ///< parse_line() into a Line released after every parse
+   PARSE_CACHED, ///< linecache_parse()
+} ParseMode;
+
+/**
+ * @brief Parse @p text for about @p seconds and print the rate
+ * @param text
+ * @param seconds
+ * @param mode
+ */
+static void run(const char* text, double seconds, ParseMode mode) {
+   static const char* const names[] = {"reused Line", "fresh Line", "line cache"};
+   size_t len = strlen(text);
+   Line line;
+   memset(&line, 0, sizeof(line));
+   linecache_clear();
+
+   long count = 0;
+   struct timespec start;
+   clock_gettime(CLOCK_MONOTONIC, &start);
+   double spent = 0;
+   while (spent < seconds) {
+      // The line is tokenized in a copy in the arena, so text is parsed as it is every time
+      for (int i = 0; i < 16; i++) {
+         Line* parsed = &line;
+         int result =
+             mode == PARSE_CACHED ? linecache_parse(text, &parsed) : parse_line(text, &line);
+         if (result != 0) {
+            fprintf(stderr, "parse_line failed\n");
+            exit(1);
+         }
+         if (mode == PARSE_FRESH) line_free(&line);
+      }
+      count += 16;
+      spent = elapsed(&start);
+   }
+   line_free(&line);
+   linecache_clear();
+
+   printf("%8zu bytes, %-11s %8.1f MB/s  %10.0f lines/s\n",
+          len,
+          names[mode],
+          (double)len * count / spent / 1e6,
+          count / spent);
+}
+
+int main(int argc, char* argv[]) {
+   double seconds = argc > 1 ? atof(argv[1]) : 1.0;
+   if (seconds <= 0) {
+      fprintf(stderr, "usage: bench_parse [seconds per case]\n");
+      return 1;
+   }
+
+   const size_t sizes[] = {1 << 10, 64 << 10, 1 << 20};
+   for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+      char* text = make_line(sizes[i]);
+      run(text, seconds, PARSE_REUSED);
+      run(text, seconds, PARSE_FRESH);
+      run(text, seconds, PARSE_CACHED);
+      free(text);
+   }
+   return 0;
+}
@@ -0,0 +1,33 @@
+#!/bin/bash
+# 16-stage pipeline throughput benchmark.
+#
+# Streams SIZE_MB megabytes through `head | cat x 14 | wc -c` as one native yash
+# pipeline, then through /bin/sh running the same chain, and prints MB/s for both.
+#
+# Usage: tests/bench/bench_pipeline.sh [size_mb] [yash_binary]
+
+set -e
+
+SIZE_MB=${1:-1024}
+YASH=${2:-./yash}
+BYTES=$((SIZE_MB * 1024 * 1024))
+
+CHAIN="head -c $BYTES /dev/zero"
+for _ in $(seq 14); do
+   CHAIN="$CHAIN | cat"
+done
+CHAIN="$CHAIN | wc -c"
+
+run() {
+   local label=$1 shell=$2
+   local start end
+   start=$(date +%s.%N)
+   echo "$CHAIN" | "$shell" > /dev/null
+   end=$(date +%s.%N)
+   awk -v l="$label" -v s="$start" -v e="$end" -v mb="$SIZE_MB" \
+      'BEGIN { printf "%-8s %8.1f MB/s (%.2fs)\n", l, mb / (e - s), e - s }'
+}
+
+echo "16-stage chain, $SIZE_MB MB"
+run "yash" "$YASH"
+run "sh" /bin/sh
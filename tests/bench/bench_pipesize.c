@@ -0,0 +1,98 @@
+/**
+ * @file bench_pipesize.c
+ * @brief Pipe capacity benchmark
+ * @details Streams a large amount of data (10 GB by default) through `head | cat | wc -c` in a
+ * yash child under each pipe size mode and reports wall time and the context switches of the
+ * shell and every stage (collected through RUSAGE_CHILDREN), relative to the kernel default.
+ *
+ * Usage: bench_pipesize [size_gb] [yash_binary]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * @brief Context switches (voluntary + involuntary) of all waited-for descendants so far
+ */
+static long child_switches(void) {
+   struct rusage ru;
+   getrusage(RUSAGE_CHILDREN, &ru);
+   return ru.ru_nvcsw + ru.ru_nivcsw;
+}
+
+/**
+ * @brief Run one yash session that sets @p mode and streams @p bytes through the pipeline
+ *
+ * @param yash Path to the shell
+ * @param mode Value for `set -o pipesize=`
+ * @param bytes Bytes to stream
+ * @param seconds Wall time (out)
+ * @return Context switches used by the session
+ */
+static long run(const char* yash, const char* mode, long long bytes, double* seconds) {
+   int in[2];
+   if (pipe(in) < 0) {
+      perror("pipe");
+      exit(1);
+   }
+
+   fflush(stdout);
+   long before = child_switches();
+   struct timespec start, end;
+   clock_gettime(CLOCK_MONOTONIC, &start);
+
+   pid_t pid = fork();
+   if (pid < 0) {
+      perror("fork");
+      exit(1);
+   }
+   if (pid == 0) {
+      dup2(in[0], STDIN_FILENO);
+      close(in[0]);
+      close(in[1]);
+      if (!freopen("/dev/null", "w", stdout)) _exit(1);
+      execl(yash, yash, (char*)NULL);
+      _exit(127);
+   }
+   close(in[0]);
+
+   char script[256];
+   int len = snprintf(script,
+                      sizeof(script),
+                      "set -o pipesize=%s\nhead -c %lld /dev/zero | cat | wc -c\n",
+                      mode,
+                      bytes);
+   if (write(in[1], script, len) != len) perror("write");
+   close(in[1]);
+   waitpid(pid, NULL, 0);
+
+   clock_gettime(CLOCK_MONOTONIC, &end);
+   *seconds = (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+   return child_switches() - before;
+}
+
+int main(int argc, char* argv[]) {
+   double gb = argc > 1 ? atof(argv[1]) : 10.0;
+   const char* yash = argc > 2 ? argv[2] : "./yash";
+   long long bytes = (long long)(gb * 1024 * 1024 * 1024);
+   const char* modes[] = {"default", "256K", "1M", "adaptive"};
+   int num_modes = (int)(sizeof(modes) / sizeof(modes[0]));
+
+   printf("Streaming %.1f GB through head | cat | wc -c\n", gb);
+   printf("%-10s %10s %14s %14s\n", "pipesize", "seconds", "ctx switches", "saved");
+
+   long baseline = 0;
+   for (int i = 0; i < num_modes; i++) {
+      double seconds;
+      long switches = run(yash, modes[i], bytes, &seconds);
+      if (i == 0) baseline = switches;
+      printf("%-10s %10.2f %14ld %14ld\n", modes[i], seconds, switches, baseline - switches);
+   }
+   return 0;
+}
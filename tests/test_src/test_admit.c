@@ -0,0 +1,95 @@
+#include "../../include/admit.h"
+#include "../../include/exec.h"
+#include "../../include/jobs.h"
+#include "../../include/options.h"
+#include "../../include/parse.h"
+#include "../../include/yash.h"
+#include "unity.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// setUp and tearDown are defined in test_runner.c
+
+// ============================================================================
+// Helpers
+// ============================================================================
+
+/**
+ * @brief Parse and run one line as the main loop would
+ */
+static void run_line(const char* text) {
+   char buf[256];
+   snprintf(buf, sizeof(buf), "%s", text);
+   Line line;
+   memset(&line, 0, sizeof(line));
+   TEST_ASSERT_EQUAL(0, parse_line(buf, &line));
+   TEST_ASSERT_EQUAL(0, execute_line(&line));
+   line_free(&line);
+}
+
+// ============================================================================
+// Tests
+// ============================================================================
+
+void test_admit_threshold_options(void) {
+   TEST_ASSERT_EQUAL(0, options_set("admitcpu=25", 1));
+   TEST_ASSERT_TRUE(shell_options.admit_cpu == 25);
+   TEST_ASSERT_EQUAL(0, options_set("admitload=1.5", 1));
+   TEST_ASSERT_TRUE(shell_options.admit_load == 1.5);
+   TEST_ASSERT_EQUAL(-1, options_set("admitmem=0", 1));
+   TEST_ASSERT_EQUAL(-1, options_set("admitmem=lots", 1));
+   TEST_ASSERT_EQUAL(-1, options_set("admitmem", 1));
+
+   TEST_ASSERT_EQUAL(0, options_set("admitcpu", 0));
+   TEST_ASSERT_EQUAL(0, options_set("admitload", 0));
+   TEST_ASSERT_TRUE(shell_options.admit_cpu == 0 && shell_options.admit_load == 0);
+   TEST_ASSERT_EQUAL(1, admit_ok());
+}
+
+void test_admit_holds_background_job_until_pressure_drops(void) {
+   Pressure p;
+   admit_sample(&p);
+   if (p.load <= 0) TEST_IGNORE_MESSAGE("no load average to hold jobs on");
+   jobs_init();
+
+   // The load is at least half of what it is now for the rest of the test
+   char spec[64];
+   snprintf(spec, sizeof(spec), "admitload=%g", p.load / 2);
+   TEST_ASSERT_EQUAL(0, options_set(spec, 1));
+   TEST_ASSERT_EQUAL(0, admit_ok());
+
+   unlink("/tmp/yash_admit_never");
+   run_line("sleep 0.1 &");
+   run_line("echo never > /tmp/yash_admit_never &");
+   TEST_ASSERT_EQUAL(2, admit_held());
+   TEST_ASSERT_EQUAL(JOB_PENDING, jobs_get_status(1));
+   TEST_ASSERT_EQUAL(JOB_PENDING, jobs_get_status(2));
+   TEST_ASSERT_EQUAL(0, jobs_get_pgid(1));
+
+   // Dropping a held job finishes it without running it
+   TEST_ASSERT_EQUAL(0, admit_cancel(2, 143));
+   TEST_ASSERT_EQUAL(143, jobs_reap_job(2));
+   TEST_ASSERT_NULL(fopen("/tmp/yash_admit_never", "r"));
+
+   // Once nothing holds it back the job starts under its own number
+   struct timespec pause = {0, 20 * 1000 * 1000};
+   nanosleep(&pause, NULL);
+   TEST_ASSERT_EQUAL(0, options_set("admitload", 0));
+   TEST_ASSERT_TRUE(admit_release() == 0);
+   TEST_ASSERT_EQUAL(0, admit_held());
+   TEST_ASSERT_EQUAL(JOB_RUNNING, jobs_get_status(1));
+   TEST_ASSERT_TRUE(jobs_get_pgid(1) > 0);
+   TEST_ASSERT_TRUE(jobs_held_seconds(1) >= 0.015);
+
+   struct timespec tick = {0, 10 * 1000 * 1000};
+   for (int i = 0; i < 200 && jobs_get_status(1) != JOB_DONE; i++) {
+      nanosleep(&tick, NULL);
+      jobs_collect();
+   }
+   TEST_ASSERT_EQUAL(0, jobs_reap_job(1));
+   jobs_init();
+}
+
+// Test functions are called from test_runner.c
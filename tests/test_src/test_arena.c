@@ -0,0 +1,58 @@
+#include "../../include/arena.h"
+#include "unity.h"
+#include <stdint.h>
+#include <string.h>
+
+// setUp and tearDown are defined in test_runner.c
+
+// ============================================================================
+// Tests
+// ============================================================================
+
+void test_arena_alloc_aligns_and_grows(void) {
+   Arena arena = {0};
+
+   char* a = arena_alloc(&arena, 1);
+   char* b = arena_alloc(&arena, 3);
+   TEST_ASSERT_NOT_NULL(a);
+   TEST_ASSERT_NOT_NULL(b);
+   TEST_ASSERT_EQUAL(0, (uintptr_t)a % 16);
+   TEST_ASSERT_EQUAL(0, (uintptr_t)b % 16);
+   TEST_ASSERT_TRUE(b >= a + 1);
+
+   // Larger than any block so far: a new block of at least that size
+   char* big = arena_alloc(&arena, 100000);
+   TEST_ASSERT_NOT_NULL(big);
+   memset(big, 'x', 100000);
+   TEST_ASSERT_TRUE(arena.total >= 100000 + 4096);
+
+   char* copy = arena_strndup(&arena, "hello world", 5);
+   TEST_ASSERT_EQUAL_STRING("hello", copy);
+
+   arena_free(&arena);
+   TEST_ASSERT_NULL(arena.head);
+   TEST_ASSERT_EQUAL(0, arena.total);
+}
+
+void test_arena_reset_keeps_one_block(void) {
+   Arena arena = {0};
+   for (int i = 0; i < 100; i++) {
+      TEST_ASSERT_NOT_NULL(arena_alloc(&arena, 1000));
+   }
+   size_t total = arena.total;
+
+   // The blocks are merged into one, so the same allocations fit again without growing
+   arena_reset(&arena);
+   ArenaBlock* block = arena.head;
+   TEST_ASSERT_NOT_NULL(block);
+   TEST_ASSERT_EQUAL(total, arena.total);
+   for (int i = 0; i < 100; i++) {
+      TEST_ASSERT_NOT_NULL(arena_alloc(&arena, 1000));
+   }
+   TEST_ASSERT_EQUAL_PTR(block, arena.head);
+   TEST_ASSERT_EQUAL(total, arena.total);
+
+   arena_free(&arena);
+}
+
+// Test functions are called from test_runner.c
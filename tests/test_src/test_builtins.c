@@ -0,0 +1,330 @@
+#include "../../include/builtins.h"
+#include "../../include/jobs.h"
+#include "unity.h"
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+// setUp and tearDown are defined in test_runner.c
+
+// ============================================================================
+// Helpers
+// ============================================================================
+
+/**
+ * @brief Run a builtin by name and return its status
+ */
+static int run(char* const argv[]) {
+   const Builtin* b = builtin_find(argv[0]);
+   TEST_ASSERT_NOT_NULL_MESSAGE(b, argv[0]);
+   return b->run(argv);
+}
+
+/**
+ * @brief Run a builtin with stdout captured into buf
+ */
+static void run_captured(char* const argv[], char* buf, size_t len) {
+   char path[] = "/tmp/yash_builtin_XXXXXX";
+   int fd = mkstemp(path);
+   TEST_ASSERT_TRUE(fd >= 0);
+
+   fflush(stdout);
+   int saved = dup(STDOUT_FILENO);
+   dup2(fd, STDOUT_FILENO);
+   run(argv);
+   fflush(stdout);
+   dup2(saved, STDOUT_FILENO);
+   close(saved);
+
+   lseek(fd, 0, SEEK_SET);
+   ssize_t n = read(fd, buf, len - 1);
+   buf[n > 0 ? n : 0] = '\0';
+   close(fd);
+   unlink(path);
+}
+
+/**
+ * @brief Start a child that sleeps for @p ms and exits with @p code, as background job
+ * @return The job id
+ */
+static int start_job(int ms, int code) {
+   pid_t pid = fork();
+   if (pid == 0) {
+      struct timespec ts = {ms / 1000, (ms % 1000) * 1000000L};
+      nanosleep(&ts, NULL);
+      _exit(code);
+   }
+   return jobs_add(pid, &pid, 1, "sleeper &", 1);
+}
+
+/**
+ * @brief Milliseconds on the monotonic clock
+ */
+static long now_ms(void) {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// ============================================================================
+// Registry Tests
+// ============================================================================
+
+void test_builtin_table_is_perfect(void) {
+   // Every entry must sit in the slot its name hashes to, or builtin_find() cannot see it
+   for (unsigned slot = 0; slot < BUILTIN_SLOTS; slot++) {
+      const Builtin* b = builtin_at(slot);
+      if (!b) continue;
+      char msg[128];
+      snprintf(msg, sizeof(msg), "\"%s\" belongs in slot %u", b->name, builtin_slot(b->name));
+      TEST_ASSERT_EQUAL_UINT_MESSAGE(slot, builtin_slot(b->name), msg);
+      TEST_ASSERT_EQUAL_PTR(b, builtin_find(b->name));
+   }
+}
+
+void test_builtin_find_known_names(void) {
+   const char* names[] = {":",      "[",     "bg",       "break",  "cd",    "class",  "continue",
+                          "dag",    "echo",  "exit",     "export", "false", "fg",     "hash",
+                          "jobs",   "kill",  "parallel", "pwd",    "queue", "return", "set",
+                          "submit", "test",  "true",     "printf", "unset", "wait",   "xargs"};
+   for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+      const Builtin* b = builtin_find(names[i]);
+      TEST_ASSERT_NOT_NULL_MESSAGE(b, names[i]);
+      TEST_ASSERT_EQUAL_STRING(names[i], b->name);
+   }
+
+   // cat is chosen per command by builtin_cat_eligible(), not through the table
+   const char* others[] = {"", "cat", "ls", "tru", "truee", "TRUE", "/bin/true"};
+   for (size_t i = 0; i < sizeof(others) / sizeof(others[0]); i++) {
+      TEST_ASSERT_NULL_MESSAGE(builtin_find(others[i]), others[i]);
+   }
+   TEST_ASSERT_NULL(builtin_find(NULL));
+}
+
+// ============================================================================
+// Builtin Behaviour Tests
+// ============================================================================
+
+void test_builtin_true_false(void) {
+   char* t[] = {"true", NULL};
+   char* f[] = {"false", "ignored", NULL};
+   char* colon[] = {":", "anything", NULL};
+   TEST_ASSERT_EQUAL(0, run(t));
+   TEST_ASSERT_EQUAL(1, run(f));
+   TEST_ASSERT_EQUAL(0, run(colon));
+}
+
+void test_builtin_test_expressions(void) {
+   struct {
+      char* argv[8];
+      int status;
+   } cases[] = {
+       {{"test", NULL}, 1},
+       {{"test", "x", NULL}, 0},
+       {{"test", "", NULL}, 1},
+       {{"test", "-n", NULL}, 0},
+       {{"test", "-z", "", NULL}, 0},
+       {{"test", "a", "=", "a", NULL}, 0},
+       {{"test", "a", "!=", "a", NULL}, 1},
+       {{"test", "!", "=", "x", NULL}, 1},
+       {{"test", "!", "-z", "x", NULL}, 0},
+       {{"test", "3", "-lt", "10", NULL}, 0},
+       {{"test", "10", "-le", "3", NULL}, 1},
+       {{"test", "-d", "/", "-a", "-e", "/", NULL}, 0},
+       {{"test", "-f", "/", "-o", "1", "-eq", "1", NULL}, 0},
+       {{"test", "(", "1", "-gt", "2", ")", NULL}, 1},
+       {{"[", "-d", "/", "]", NULL}, 0},
+       {{"[", "]", NULL}, 1},
+       {{"[", "-d", "/", NULL}, 2},
+       {{"test", "x", "-eq", "1", NULL}, 2},
+       {{"test", "a", "b", NULL}, 2},
+   };
+
+   // Keep the diagnostics for the error cases out of the test output
+   fflush(stderr);
+   int saved = dup(STDERR_FILENO);
+   int devnull = open("/dev/null", O_WRONLY);
+   dup2(devnull, STDERR_FILENO);
+   close(devnull);
+
+   int statuses[sizeof(cases) / sizeof(cases[0])];
+   for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+      statuses[i] = run(cases[i].argv);
+   }
+
+   dup2(saved, STDERR_FILENO);
+   close(saved);
+
+   for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+      char msg[32];
+      snprintf(msg, sizeof(msg), "case %zu", i);
+      TEST_ASSERT_EQUAL_MESSAGE(cases[i].status, statuses[i], msg);
+   }
+}
+
+void test_builtin_echo_output(void) {
+   char out[256];
+   char* plain[] = {"echo", "hello", "world", NULL};
+   char* no_newline[] = {"echo", "-n", "a", "b", NULL};
+   char* empty[] = {"echo", NULL};
+
+   run_captured(plain, out, sizeof(out));
+   TEST_ASSERT_EQUAL_STRING("hello world\n", out);
+   run_captured(no_newline, out, sizeof(out));
+   TEST_ASSERT_EQUAL_STRING("a b", out);
+   run_captured(empty, out, sizeof(out));
+   TEST_ASSERT_EQUAL_STRING("\n", out);
+}
+
+void test_builtin_printf_output(void) {
+   char out[256];
+   char* mixed[] = {"printf", "%s=%d|%5s|%x|%%\\n", "a", "42", "hi", "255", NULL};
+   char* reuse[] = {"printf", "[%s]", "one", "two", "three", NULL};
+   char* padded[] = {"printf", "%-4s|%04d|%.2s|%*d", "ab", "7", "xyz", "3", "5", NULL};
+   char* escapes[] = {"printf", "%b|\\101\\t", "x\\ny", NULL};
+
+   run_captured(mixed, out, sizeof(out));
+   TEST_ASSERT_EQUAL_STRING("a=42|   hi|ff|%\n", out);
+   run_captured(reuse, out, sizeof(out));
+   TEST_ASSERT_EQUAL_STRING("[one][two][three]", out);
+   run_captured(padded, out, sizeof(out));
+   TEST_ASSERT_EQUAL_STRING("ab  |0007|xy|  5", out);
+   run_captured(escapes, out, sizeof(out));
+   TEST_ASSERT_EQUAL_STRING("x\ny|A\t", out);
+}
+
+void test_builtin_cd_and_pwd(void) {
+   char start[4096];
+   TEST_ASSERT_NOT_NULL(getcwd(start, sizeof(start)));
+
+   char* to_root[] = {"cd", "/", NULL};
+   TEST_ASSERT_EQUAL(0, run(to_root));
+   TEST_ASSERT_EQUAL_STRING("/", getenv("PWD"));
+   TEST_ASSERT_EQUAL_STRING(start, getenv("OLDPWD"));
+
+   char out[4096 + 2];
+   char* pwd[] = {"pwd", NULL};
+   run_captured(pwd, out, sizeof(out));
+   TEST_ASSERT_EQUAL_STRING("/\n", out);
+
+   // `cd -` goes back and prints where it went
+   char* back[] = {"cd", "-", NULL};
+   run_captured(back, out, sizeof(out));
+   char expected[4096 + 2];
+   snprintf(expected, sizeof(expected), "%s\n", start);
+   TEST_ASSERT_EQUAL_STRING(expected, out);
+
+   fflush(stderr);
+   int saved = dup(STDERR_FILENO);
+   int devnull = open("/dev/null", O_WRONLY);
+   dup2(devnull, STDERR_FILENO);
+   close(devnull);
+   char* missing[] = {"cd", "/yash/no/such/dir", NULL};
+   int status = run(missing);
+   dup2(saved, STDERR_FILENO);
+   close(saved);
+
+   TEST_ASSERT_EQUAL(1, status);
+   char now[4096];
+   TEST_ASSERT_NOT_NULL(getcwd(now, sizeof(now)));
+   TEST_ASSERT_EQUAL_STRING(start, now);
+}
+
+// ============================================================================
+// wait Tests
+// ============================================================================
+
+void test_builtin_wait_returns_job_status(void) {
+   jobs_init();
+   int a = start_job(50, 3);
+   int b = start_job(10, 0);
+
+   char* one[] = {"wait", "%1", NULL};
+   TEST_ASSERT_EQUAL(1, a);
+   TEST_ASSERT_EQUAL(3, run(one));
+
+   // A waited-for job is gone, with no Done notice left behind
+   TEST_ASSERT_EQUAL(-1, jobs_get_pgid(a));
+   char* all[] = {"wait", NULL};
+   TEST_ASSERT_EQUAL(0, run(all));
+   TEST_ASSERT_EQUAL(-1, jobs_get_pgid(b));
+   TEST_ASSERT_EQUAL(0, jobs_count());
+
+   fflush(stderr);
+   int saved = dup(STDERR_FILENO);
+   int devnull = open("/dev/null", O_WRONLY);
+   dup2(devnull, STDERR_FILENO);
+   close(devnull);
+   char* unknown[] = {"wait", "%7", NULL};
+   int unknown_status = run(unknown);
+   char* bad[] = {"wait", "-t", "soon", NULL};
+   int bad_status = run(bad);
+   dup2(saved, STDERR_FILENO);
+   close(saved);
+   TEST_ASSERT_EQUAL(127, unknown_status);
+   TEST_ASSERT_EQUAL(2, bad_status);
+}
+
+void test_builtin_fg_returns_job_status(void) {
+   jobs_init();
+
+   // Stopped once before fg, again after the first fg, then exits with 5
+   pid_t pid = fork();
+   if (pid == 0) {
+      setpgid(0, 0);
+      raise(SIGSTOP);
+      raise(SIGTSTP);
+      _exit(5);
+   }
+   setpgid(pid, pid);
+   int st;
+   TEST_ASSERT_EQUAL(pid, waitpid(pid, &st, WUNTRACED));
+   TEST_ASSERT_TRUE(WIFSTOPPED(st));
+   int id = jobs_add(pid, &pid, 1, "stopper", 0);
+   jobs_mark(pid, JOB_STOPPED);
+
+   fflush(stdout);
+   int saved = dup(STDOUT_FILENO);
+   int devnull = open("/dev/null", O_WRONLY);
+   dup2(devnull, STDOUT_FILENO);
+   close(devnull);
+   char* fg[] = {"fg", NULL};
+   int stopped_status = run(fg);
+   JobStatus stopped = jobs_get_status(id);
+   int done_status = run(fg);
+   fflush(stdout);
+   dup2(saved, STDOUT_FILENO);
+   close(saved);
+
+   TEST_ASSERT_EQUAL(128 + SIGTSTP, stopped_status);
+   TEST_ASSERT_EQUAL(JOB_STOPPED, stopped);
+   TEST_ASSERT_EQUAL(5, done_status);
+   TEST_ASSERT_EQUAL(0, jobs_count());
+}
+
+void test_builtin_wait_next_and_timeout(void) {
+   jobs_init();
+   int slow = start_job(5000, 0);
+   start_job(20, 9);
+
+   // -n returns with the first job to finish
+   long start = now_ms();
+   char* next[] = {"wait", "-n", NULL};
+   TEST_ASSERT_EQUAL(9, run(next));
+   TEST_ASSERT_EQUAL(1, jobs_count());
+
+   char* timed[] = {"wait", "-t", "0.1", NULL};
+   TEST_ASSERT_EQUAL(124, run(timed));
+   TEST_ASSERT_TRUE(now_ms() - start < 2000);
+   TEST_ASSERT_EQUAL(JOB_RUNNING, jobs_get_status(slow));
+
+   kill(jobs_get_pgid(slow), SIGKILL);
+   char* killed[] = {"wait", NULL};
+   TEST_ASSERT_EQUAL(0, run(killed));
+   TEST_ASSERT_EQUAL(0, jobs_count());
+}
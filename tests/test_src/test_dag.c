@@ -0,0 +1,142 @@
+#include "../../include/dag.h"
+#include "../../include/jobs.h"
+#include "unity.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+// setUp and tearDown are defined in test_runner.c
+
+// ============================================================================
+// Helpers
+// ============================================================================
+
+/**
+ * @brief Write a task file
+ */
+static void write_file(const char* path, const char* text) {
+   FILE* f = fopen(path, "w");
+   TEST_ASSERT_NOT_NULL(f);
+   fputs(text, f);
+   fclose(f);
+}
+
+/**
+ * @brief Load a task file with stderr discarded
+ * @return As dag_load()
+ */
+static int load_quietly(const char* path, Dag* dag) {
+   int null = open("/dev/null", O_WRONLY);
+   int saved_err = dup(STDERR_FILENO);
+   dup2(null, STDERR_FILENO);
+   int result = dag_load(path, dag);
+   dup2(saved_err, STDERR_FILENO);
+   close(saved_err);
+   close(null);
+   return result;
+}
+
+/**
+ * @brief Index of a task by name
+ */
+static int task_index(const Dag* dag, const char* name) {
+   for (int i = 0; i < dag->num_tasks; i++) {
+      if (strcmp(dag->tasks[i].name, name) == 0) return i;
+   }
+   TEST_FAIL_MESSAGE("no such task");
+   return -1;
+}
+
+// ============================================================================
+// Tests
+// ============================================================================
+
+void test_dag_runs_independent_tasks_in_parallel(void) {
+   jobs_init();
+   unlink("/tmp/yash_dag_a");
+   unlink("/tmp/yash_dag_b");
+   write_file("/tmp/yash_dag_run",
+              "# c reads what b copied from a\n"
+              "c: b\n"
+              "\tcat /tmp/yash_dag_b\n"
+              "b: a slow\n"
+              "\tcat /tmp/yash_dag_a > /tmp/yash_dag_b\n"
+              "a:\n"
+              "\tsleep 0.2 > /tmp/yash_dag_a\n"
+              "slow:\n"
+              "    sleep 0.2\n"
+              "all: c\n");
+   Dag dag;
+   TEST_ASSERT_EQUAL(0, dag_load("/tmp/yash_dag_run", &dag));
+   TEST_ASSERT_EQUAL(5, dag.num_tasks);
+   TEST_ASSERT_NULL(dag.tasks[task_index(&dag, "all")].cmdline);
+
+   TEST_ASSERT_EQUAL(0, dag_run(&dag, 2));
+   TEST_ASSERT_EQUAL(5, dag.counts[DAG_DONE]);
+   const DagTask* a = &dag.tasks[task_index(&dag, "a")];
+   const DagTask* b = &dag.tasks[task_index(&dag, "b")];
+   const DagTask* slow = &dag.tasks[task_index(&dag, "slow")];
+   // a and slow share the two slots; b waits for both
+   TEST_ASSERT_TRUE(slow->started < a->finished && a->started < slow->finished);
+   TEST_ASSERT_TRUE(b->started >= a->finished && b->started >= slow->finished);
+
+   // The critical path runs through one of the two sleeps
+   const DagTask* c = &dag.tasks[task_index(&dag, "c")];
+   TEST_ASSERT_EQUAL(task_index(&dag, "b"), c->path_prev);
+   TEST_ASSERT_TRUE(b->path_prev == task_index(&dag, "a") ||
+                    b->path_prev == task_index(&dag, "slow"));
+   TEST_ASSERT_TRUE(c->path >= 0.15);
+   TEST_ASSERT_EQUAL(0, jobs_count());
+   dag_free(&dag);
+   jobs_init();
+}
+
+void test_dag_failure_cancels_downstream_tasks(void) {
+   jobs_init();
+   unlink("/tmp/yash_dag_never");
+   write_file("/tmp/yash_dag_fail",
+              "fails:\n"
+              "\tfalse\n"
+              "after: fails\n"
+              "\techo x > /tmp/yash_dag_never\n"
+              "later: after\n"
+              "\ttrue\n"
+              "other:\n"
+              "\ttrue\n"
+              "missing:\n"
+              "\tyash_no_such_command_xyz\n");
+   Dag dag;
+   TEST_ASSERT_EQUAL(0, dag_load("/tmp/yash_dag_fail", &dag));
+   TEST_ASSERT_EQUAL(1, dag_run(&dag, 4));
+
+   TEST_ASSERT_EQUAL(DAG_FAILED, dag.tasks[task_index(&dag, "fails")].state);
+   TEST_ASSERT_EQUAL(1, dag.tasks[task_index(&dag, "fails")].exit_code);
+   TEST_ASSERT_EQUAL(DAG_CANCELLED, dag.tasks[task_index(&dag, "after")].state);
+   TEST_ASSERT_EQUAL(DAG_CANCELLED, dag.tasks[task_index(&dag, "later")].state);
+   TEST_ASSERT_EQUAL(DAG_DONE, dag.tasks[task_index(&dag, "other")].state);
+   TEST_ASSERT_EQUAL(127, dag.tasks[task_index(&dag, "missing")].exit_code);
+   TEST_ASSERT_NULL(fopen("/tmp/yash_dag_never", "r"));
+   dag_free(&dag);
+   jobs_init();
+}
+
+void test_dag_rejects_bad_task_files(void) {
+   Dag dag;
+   write_file("/tmp/yash_dag_bad", "a: b\n\ttrue\nb: a\n\ttrue\n");
+   TEST_ASSERT_EQUAL(-1, load_quietly("/tmp/yash_dag_bad", &dag));
+   write_file("/tmp/yash_dag_bad", "a: nowhere\n");
+   TEST_ASSERT_EQUAL(-1, load_quietly("/tmp/yash_dag_bad", &dag));
+   write_file("/tmp/yash_dag_bad", "a:\na:\n");
+   TEST_ASSERT_EQUAL(-1, load_quietly("/tmp/yash_dag_bad", &dag));
+   write_file("/tmp/yash_dag_bad", "a:\n\ttrue\n\ttrue\n");
+   TEST_ASSERT_EQUAL(-1, load_quietly("/tmp/yash_dag_bad", &dag));
+   write_file("/tmp/yash_dag_bad", "a:\n\ttrue |\n");
+   TEST_ASSERT_EQUAL(-1, load_quietly("/tmp/yash_dag_bad", &dag));
+   TEST_ASSERT_EQUAL(-1, load_quietly("/tmp/yash_dag_no_such_file", &dag));
+
+   write_file("/tmp/yash_dag_bad", "\n# only a comment\n a: b\n");
+   TEST_ASSERT_EQUAL(-1, load_quietly("/tmp/yash_dag_bad", &dag));
+}
+
+// Test functions are called from test_runner.c
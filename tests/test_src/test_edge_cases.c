@@ -2,6 +2,7 @@
 #include "../../include/yash.h"
 #include "unity.h"
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <time.h>
 
@@ -19,6 +20,8 @@ void test_parse_null_input(void) {
 
    // This should fail because input is NULL
    TEST_ASSERT_EQUAL(-1, result);
+
+   line_free(&parsed_line);
 }
 
 void test_parse_null_output(void) {
@@ -39,6 +42,8 @@ void test_parse_empty_input(void) {
 
    // Empty input should return -1 (invalid)
    TEST_ASSERT_EQUAL(-1, result);
+
+   line_free(&parsed_line);
 }
 
 void test_parse_whitespace_only(void) {
@@ -50,6 +55,8 @@ void test_parse_whitespace_only(void) {
 
    // Whitespace-only input should return -1 (invalid)
    TEST_ASSERT_EQUAL(-1, result);
+
+   line_free(&parsed_line);
 }
 
 // Removed test_parse_newline_only - testing edge cases, not core functionality
@@ -61,10 +68,12 @@ void test_parse_whitespace_only(void) {
 // Removed test_parse_max_length - testing buffer limits, not core functionality
 
 void test_parse_over_max_length(void) {
-   // Create a line longer than MAX_CMDLINE
-   char line[MAX_CMDLINE + 10];
-   memset(line, 'a', MAX_CMDLINE + 9);
-   line[MAX_CMDLINE + 9] = '\0';
+   // Create a line longer than the system's ARG_MAX
+   size_t len = parse_line_max() + 9;
+   char* line = malloc(len + 1);
+   TEST_ASSERT_NOT_NULL(line);
+   memset(line, 'a', len);
+   line[len] = '\0';
 
    Line parsed_line;
    memset(&parsed_line, 0, sizeof(parsed_line));
@@ -73,21 +82,19 @@ void test_parse_over_max_length(void) {
 
    // This should fail because it's too long
    TEST_ASSERT_EQUAL(-1, result);
+
+   line_free(&parsed_line);
+   free(line);
 }
 
 // Removed test_parse_max_tokens - testing token limits, not core functionality
 
 void test_parse_over_max_tokens(void) {
-   // Create a line with more than MAX_TOKENS tokens (but within MAX_CMDLINE limit)
-   // Use single character tokens to fit within the buffer
-   char line[MAX_CMDLINE];
+   // More than the 2000 tokens that once were the limit, as single character tokens
+   char line[2010 * 2 + 1];
    int pos = 0;
-   for (int i = 0; i < MAX_TOKENS + 10; i++) { // Try to exceed MAX_TOKENS
-      if (pos + 2 < MAX_CMDLINE) {             // "a " = 2 chars
-         pos += snprintf(line + pos, MAX_CMDLINE - pos, "a ");
-      } else {
-         break; // Stop if we're running out of space
-      }
+   for (int i = 0; i < 2010; i++) {
+      pos += snprintf(line + pos, sizeof(line) - pos, "a ");
    }
 
    Line parsed_line;
@@ -95,44 +102,53 @@ void test_parse_over_max_tokens(void) {
 
    int result = parse_line(line, &parsed_line);
 
-   // This should fail because it has too many tokens
-   TEST_ASSERT_EQUAL(-1, result);
+   // Token counts are only bounded by the line length now
+   TEST_ASSERT_EQUAL(0, result);
+   TEST_ASSERT_EQUAL_STRING("a", parsed_line.stages[0].argv[2009]);
+   TEST_ASSERT_NULL(parsed_line.stages[0].argv[2010]);
+
+   line_free(&parsed_line);
 }
 
 void test_parse_max_token_length(void) {
-   // Create a token of exactly MAX_TOKEN_LEN characters
-   char long_token[MAX_TOKEN_LEN + 1];
-   memset(long_token, 'a', MAX_TOKEN_LEN);
-   long_token[MAX_TOKEN_LEN] = '\0';
+   // Create a token of 30 characters, the old maximum
+   char long_token[31];
+   memset(long_token, 'a', 30);
+   long_token[30] = '\0';
 
-   char line[MAX_CMDLINE];
-   snprintf(line, MAX_CMDLINE, "ls %s", long_token);
+   char line[64];
+   snprintf(line, sizeof(line), "ls %s", long_token);
 
    Line parsed_line;
    memset(&parsed_line, 0, sizeof(parsed_line));
 
    int result = parse_line(line, &parsed_line);
 
-   // This should succeed because the token is exactly the maximum length
+   // This should succeed because the token is exactly the old maximum length
    TEST_ASSERT_EQUAL(0, result);
+
+   line_free(&parsed_line);
 }
 
 void test_parse_over_max_token_length(void) {
-   // Create a token longer than MAX_TOKEN_LEN
-   char long_token[MAX_TOKEN_LEN + 10];
-   memset(long_token, 'a', MAX_TOKEN_LEN + 9);
-   long_token[MAX_TOKEN_LEN + 9] = '\0';
+   // Create a token far longer than the old 30 character maximum
+   char long_token[4097];
+   memset(long_token, 'a', sizeof(long_token) - 1);
+   long_token[sizeof(long_token) - 1] = '\0';
 
-   char line[MAX_CMDLINE];
-   snprintf(line, MAX_CMDLINE, "ls %s", long_token);
+   char line[sizeof(long_token) + 3];
+   snprintf(line, sizeof(line), "ls %s", long_token);
 
    Line parsed_line;
    memset(&parsed_line, 0, sizeof(parsed_line));
 
    int result = parse_line(line, &parsed_line);
 
-   // This should fail because the token is too long
-   TEST_ASSERT_EQUAL(-1, result);
+   // Tokens are only bounded by the line length now
+   TEST_ASSERT_EQUAL(0, result);
+   TEST_ASSERT_EQUAL_STRING(long_token, parsed_line.stages[0].argv[1]);
+
+   line_free(&parsed_line);
 }
 
 // ============================================================================
@@ -151,6 +167,7 @@ void test_parse_invalid_starting_tokens(void) {
 
       // All of these should fail because they start with invalid tokens
       TEST_ASSERT_EQUAL(-1, result);
+      line_free(&parsed_line);
    }
 }
 
@@ -171,6 +188,7 @@ void test_parse_malformed_redirections(void) {
 
       // All of these should fail because of malformed redirections
       TEST_ASSERT_EQUAL(-1, result);
+      line_free(&parsed_line);
    }
 }
 
@@ -178,7 +196,7 @@ void test_parse_malformed_pipes(void) {
    // Test malformed pipes
    char malformed_commands[][30] = {"ls | | grep test",
                                     "ls | | | grep test",
-                                    "ls | grep | test",
+                                    "ls | grep | | test",
                                     "| ls | grep test",
                                     "ls | grep test |"};
 
@@ -190,13 +208,14 @@ void test_parse_malformed_pipes(void) {
 
       // All of these should fail because of malformed pipes
       TEST_ASSERT_EQUAL(-1, result);
+      line_free(&parsed_line);
    }
 }
 
 void test_parse_malformed_background(void) {
    // Test malformed background execution
    char malformed_commands[][30] = {
-       "ls & &", "ls & & &", "ls & grep test", "& ls", "ls & | grep test"};
+       "ls & &", "ls & & &", "ls & && grep test", "& ls", "ls & | grep test"};
 
    for (int i = 0; i < 5; i++) {
       Line parsed_line;
@@ -206,6 +225,7 @@ void test_parse_malformed_background(void) {
 
       // All of these should fail because of malformed background execution
       TEST_ASSERT_EQUAL(-1, result);
+      line_free(&parsed_line);
    }
 }
 
@@ -225,12 +245,14 @@ void test_parse_special_characters(void) {
    TEST_ASSERT_EQUAL(0, result);
    TEST_ASSERT_EQUAL_STRING("ls -la | grep 'test file' > output-123_456.txt", parsed_line.original);
    TEST_ASSERT_EQUAL(1, parsed_line.is_pipeline);
-   TEST_ASSERT_EQUAL_STRING("ls", parsed_line.left.argv[0]);
-   TEST_ASSERT_EQUAL_STRING("-la", parsed_line.left.argv[1]);
-   TEST_ASSERT_EQUAL_STRING("grep", parsed_line.right.argv[0]);
-   TEST_ASSERT_EQUAL_STRING("'test", parsed_line.right.argv[1]);
-   TEST_ASSERT_EQUAL_STRING("file'", parsed_line.right.argv[2]);
-   TEST_ASSERT_EQUAL_STRING("output-123_456.txt", parsed_line.right.out_file);
+   TEST_ASSERT_EQUAL_STRING("ls", parsed_line.stages[0].argv[0]);
+   TEST_ASSERT_EQUAL_STRING("-la", parsed_line.stages[0].argv[1]);
+   TEST_ASSERT_EQUAL_STRING("grep", parsed_line.stages[1].argv[0]);
+   TEST_ASSERT_EQUAL_STRING("'test", parsed_line.stages[1].argv[1]);
+   TEST_ASSERT_EQUAL_STRING("file'", parsed_line.stages[1].argv[2]);
+   TEST_ASSERT_EQUAL_STRING("output-123_456.txt", parsed_line.stages[1].out_file);
+
+   line_free(&parsed_line);
 }
 
 // Removed test_parse_quoted_strings - quotes not supported per project spec
@@ -255,16 +277,20 @@ void test_parse_memory_safety(void) {
    TEST_ASSERT_EQUAL_STRING("ls -la | grep test > output.txt", parsed_line.original);
 
    // Test that pointers are valid
-   TEST_ASSERT_NOT_NULL(parsed_line.left.argv[0]);
-   TEST_ASSERT_NOT_NULL(parsed_line.right.argv[0]);
-   TEST_ASSERT_NOT_NULL(parsed_line.right.out_file);
+   TEST_ASSERT_NOT_NULL(parsed_line.stages[0].argv[0]);
+   TEST_ASSERT_NOT_NULL(parsed_line.stages[1].argv[0]);
+   TEST_ASSERT_NOT_NULL(parsed_line.stages[1].out_file);
+
+   line_free(&parsed_line);
 }
 
 void test_parse_buffer_overflow_protection(void) {
    // Test that parsing protects against buffer overflows
-   char line[MAX_CMDLINE + 100];
-   memset(line, 'a', MAX_CMDLINE + 99);
-   line[MAX_CMDLINE + 99] = '\0';
+   size_t len = parse_line_max() + 99;
+   char* line = malloc(len + 1);
+   TEST_ASSERT_NOT_NULL(line);
+   memset(line, 'a', len);
+   line[len] = '\0';
 
    Line parsed_line;
    memset(&parsed_line, 0, sizeof(parsed_line));
@@ -273,6 +299,9 @@ void test_parse_buffer_overflow_protection(void) {
 
    // This should fail because the line is too long
    TEST_ASSERT_EQUAL(-1, result);
+
+   line_free(&parsed_line);
+   free(line);
 }
 
 // ============================================================================
@@ -296,6 +325,7 @@ void test_parse_error_recovery(void) {
 
       // All of these should parse successfully
       TEST_ASSERT_EQUAL(0, result);
+      line_free(&parsed_line);
    }
 }
 
@@ -324,6 +354,7 @@ void test_parse_partial_commands(void) {
       } else {
          TEST_ASSERT_EQUAL(0, result);
       }
+      line_free(&parsed_line);
    }
 }
 
@@ -342,6 +373,7 @@ void test_parse_performance_simple(void) {
    for (int i = 0; i < 1000; i++) {
       int result = parse_line(line, &parsed_line);
       TEST_ASSERT_EQUAL(0, result);
+      line_free(&parsed_line);
    }
 
    clock_t end = clock();
@@ -374,6 +406,7 @@ void test_parse_integration_edge_cases(void) {
 
       // All of these should succeed
       TEST_ASSERT_EQUAL(0, result);
+      line_free(&parsed_line);
    }
 }
 
@@ -0,0 +1,114 @@
+#include "../../include/events.h"
+#include "../../include/signals.h"
+#include "unity.h"
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+// setUp and tearDown are defined in test_runner.c
+
+// ============================================================================
+// Helpers
+// ============================================================================
+
+/**
+ * @brief Undo events_init() so later tests see the usual signal state
+ */
+static void restore_sigchld(const struct sigaction* saved) {
+   sigset_t mask;
+   sigemptyset(&mask);
+   sigaddset(&mask, SIGCHLD);
+   sigprocmask(SIG_UNBLOCK, &mask, NULL);
+   sigaction(SIGCHLD, saved, NULL);
+}
+
+// ============================================================================
+// Event Loop Tests
+// ============================================================================
+
+void test_events_child_exit_wakes_wait(void) {
+   // The self-pipe path needs the shell's handler; the signalfd path never runs it
+   struct sigaction sa = {0}, saved;
+   sa.sa_handler = sigchld_handler;
+   sigemptyset(&sa.sa_mask);
+   sigaction(SIGCHLD, &sa, &saved);
+
+   int in[2];
+   TEST_ASSERT_EQUAL(0, pipe(in));
+   TEST_ASSERT_EQUAL(0, events_init(in[0]));
+   TEST_ASSERT_EQUAL(0, events_wait(0));
+
+   pid_t pid = fork();
+   if (pid == 0) _exit(0);
+   int ready = events_wait(5000);
+   TEST_ASSERT_EQUAL(EVENT_CHILD, ready);
+   waitpid(pid, NULL, 0);
+
+   // Consumed by the wait that reported it
+   TEST_ASSERT_EQUAL(0, events_wait(0));
+
+   // Input and a child together
+   pid = fork();
+   if (pid == 0) _exit(0);
+   waitpid(pid, NULL, 0);
+   TEST_ASSERT_EQUAL(1, write(in[1], "x", 1));
+   TEST_ASSERT_EQUAL(EVENT_INPUT | EVENT_CHILD, events_wait(-1));
+   TEST_ASSERT_EQUAL(EVENT_INPUT, events_wait(0));
+
+   close(in[0]);
+   close(in[1]);
+   restore_sigchld(&saved);
+}
+
+void test_events_regular_file_input_is_ready(void) {
+   // epoll refuses regular files; reading from one must still never block
+   char path[] = "/tmp/yash_events_XXXXXX";
+   int fd = mkstemp(path);
+   TEST_ASSERT_TRUE(fd >= 0);
+   unlink(path);
+
+   struct sigaction saved;
+   sigaction(SIGCHLD, NULL, &saved);
+   TEST_ASSERT_EQUAL(0, events_init(fd));
+   TEST_ASSERT_EQUAL(EVENT_INPUT, events_wait(-1));
+
+   close(fd);
+   restore_sigchld(&saved);
+}
+
+void test_events_timer_wakes_wait(void) {
+   int in[2];
+   TEST_ASSERT_EQUAL(0, pipe(in));
+   struct sigaction saved;
+   sigaction(SIGCHLD, NULL, &saved);
+   TEST_ASSERT_EQUAL(0, events_init(in[0]));
+
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   double start = (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+   events_set_timer(start + 0.05);
+   TEST_ASSERT_EQUAL(0, events_wait(0));
+   TEST_ASSERT_EQUAL(EVENT_TIMER, events_wait(5000));
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   TEST_ASSERT_TRUE((double)ts.tv_sec + (double)ts.tv_nsec / 1e9 >= start + 0.05);
+
+   // One shot
+   TEST_ASSERT_EQUAL(0, events_wait(0));
+
+   // Foreground waits see it too, and a disarmed timer never fires
+   events_set_timer(start);
+   TEST_ASSERT_EQUAL(EVENT_TIMER, events_wait_child(1000));
+   events_set_timer(start + 0.05);
+   events_set_timer(0);
+   TEST_ASSERT_EQUAL(0, events_wait(100));
+
+   close(in[0]);
+   close(in[1]);
+   restore_sigchld(&saved);
+}
+
+// Test functions are called from test_runner.c
@@ -0,0 +1,222 @@
+#include "../../include/builtins.h"
+#include "../../include/exec.h"
+#include "../../include/fdcopy.h"
+#include "../../include/parse.h"
+#include "../../include/signals.h"
+#include "../../include/vars.h"
+#include "unity.h"
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// setUp and tearDown are defined in test_runner.c
+
+// ============================================================================
+// Helpers
+// ============================================================================
+
+/** @brief Payload size; fits in a default pipe so no reader process is needed */
+#define PAYLOAD 40000
+
+/**
+ * @brief Fill buf with a recognisable pattern
+ */
+static void fill_pattern(char* buf, size_t len) {
+   for (size_t i = 0; i < len; i++) {
+      buf[i] = (char)('a' + i % 26);
+   }
+}
+
+/**
+ * @brief Create a temp file holding len pattern bytes, rewound, and return its fd
+ */
+static int pattern_file(char* path, size_t len) {
+   char* buf = malloc(len);
+   fill_pattern(buf, len);
+   int fd = mkstemp(path);
+   TEST_ASSERT_TRUE(fd >= 0);
+   TEST_ASSERT_EQUAL((ssize_t)len, write(fd, buf, len));
+   lseek(fd, 0, SEEK_SET);
+   free(buf);
+   return fd;
+}
+
+/**
+ * @brief Read len bytes back from fd (from offset 0 when seekable) and compare with the pattern
+ */
+static void assert_pattern(int fd, size_t len) {
+   char* want = malloc(len);
+   char* got = calloc(1, len + 1);
+   fill_pattern(want, len);
+   lseek(fd, 0, SEEK_SET);
+   size_t have = 0;
+   ssize_t n;
+   while (have <= len && (n = read(fd, got + have, len + 1 - have)) > 0) {
+      have += n;
+   }
+   TEST_ASSERT_EQUAL(len, have);
+   TEST_ASSERT_EQUAL_MEMORY(want, got, len);
+   free(want);
+   free(got);
+}
+
+/**
+ * @brief Parse a command line into its first stage
+ */
+static void parse_first(const char* text, Line* line) {
+   // The words point into it after parse_line() returns
+   static char buf[256];
+   snprintf(buf, sizeof(buf), "%s", text);
+   memset(line, 0, sizeof(*line));
+   TEST_ASSERT_EQUAL(0, parse_line(buf, line));
+}
+
+// ============================================================================
+// Copy Engine Tests
+// ============================================================================
+
+void test_fdcopy_file_to_file(void) {
+   char in_path[] = "/tmp/yash_fdcopy_XXXXXX";
+   char out_path[] = "/tmp/yash_fdcopy_XXXXXX";
+   int in_fd = pattern_file(in_path, PAYLOAD);
+   int out_fd = mkstemp(out_path);
+
+   FdCopyMethod method;
+   TEST_ASSERT_EQUAL(PAYLOAD, fd_copy(in_fd, out_fd, NULL, &method));
+#ifdef __linux__
+   // tmpfs and most local filesystems take copy_file_range; others fall back to read/write
+   TEST_ASSERT_TRUE(method == FDCOPY_COPY_FILE_RANGE || method == FDCOPY_READ_WRITE);
+#endif
+   assert_pattern(out_fd, PAYLOAD);
+
+   close(in_fd);
+   close(out_fd);
+   unlink(in_path);
+   unlink(out_path);
+}
+
+void test_fdcopy_file_to_pipe_and_back(void) {
+   char in_path[] = "/tmp/yash_fdcopy_XXXXXX";
+   char out_path[] = "/tmp/yash_fdcopy_XXXXXX";
+   int in_fd = pattern_file(in_path, PAYLOAD);
+   int out_fd = mkstemp(out_path);
+   int p[2];
+   TEST_ASSERT_EQUAL(0, pipe(p));
+
+   FdCopyMethod method;
+   TEST_ASSERT_EQUAL(PAYLOAD, fd_copy(in_fd, p[1], NULL, &method));
+#ifdef __linux__
+   TEST_ASSERT_EQUAL(FDCOPY_SPLICE, method);
+#endif
+   close(p[1]);
+
+   TEST_ASSERT_EQUAL(PAYLOAD, fd_copy(p[0], out_fd, NULL, &method));
+#ifdef __linux__
+   TEST_ASSERT_EQUAL(FDCOPY_SPLICE, method);
+#endif
+   assert_pattern(out_fd, PAYLOAD);
+
+   close(p[0]);
+   close(in_fd);
+   close(out_fd);
+   unlink(in_path);
+   unlink(out_path);
+}
+
+void test_fdcopy_cancelled(void) {
+   char in_path[] = "/tmp/yash_fdcopy_XXXXXX";
+   int in_fd = pattern_file(in_path, PAYLOAD);
+   int p[2];
+   TEST_ASSERT_EQUAL(0, pipe(p));
+
+   volatile sig_atomic_t cancel = 1;
+   TEST_ASSERT_EQUAL(-1, fd_copy(in_fd, p[1], &cancel, NULL));
+
+   close(p[0]);
+   close(p[1]);
+   close(in_fd);
+   unlink(in_path);
+}
+
+// ============================================================================
+// Builtin cat Tests
+// ============================================================================
+
+void test_builtin_cat_eligible(void) {
+   Line line;
+
+   parse_first("cat a b", &line);
+   TEST_ASSERT_TRUE(builtin_cat_eligible(&line.stages[0]));
+   line_free(&line);
+
+   parse_first("cat < a", &line);
+   TEST_ASSERT_TRUE(builtin_cat_eligible(&line.stages[0]));
+   line_free(&line);
+
+   // These still run /bin/cat
+   const char* external[] = {"cat", "cat -n a", "cat a -", "cat a &", "/bin/cat a", "tac a"};
+   for (size_t i = 0; i < sizeof(external) / sizeof(external[0]); i++) {
+      parse_first(external[i], &line);
+      TEST_ASSERT_FALSE_MESSAGE(builtin_cat_eligible(&line.stages[0]), external[i]);
+      line_free(&line);
+   }
+}
+
+void test_builtin_cat_concatenates(void) {
+   char a_path[] = "/tmp/yash_fdcopy_XXXXXX";
+   char b_path[] = "/tmp/yash_fdcopy_XXXXXX";
+   char out_path[] = "/tmp/yash_fdcopy_XXXXXX";
+   close(pattern_file(a_path, PAYLOAD / 2));
+   close(mkstemp(b_path));
+   int out_fd = mkstemp(out_path);
+
+   // a twice with an empty b between them, and a missing file that is reported but skipped
+   char* argv[] = {"cat", a_path, b_path, "/tmp/yash_fdcopy_missing", a_path, NULL};
+   Redirects fds = {-1, out_fd, open("/dev/null", O_WRONLY)};
+   TEST_ASSERT_EQUAL(1, builtin_cat(argv, &fds, NULL));
+   TEST_ASSERT_EQUAL(PAYLOAD, lseek(out_fd, 0, SEEK_END));
+
+   close(fds.err_fd);
+   close(out_fd);
+   unlink(a_path);
+   unlink(b_path);
+   unlink(out_path);
+}
+
+void test_builtin_cat_interrupted(void) {
+   struct sigaction sa, saved;
+   memset(&sa, 0, sizeof(sa));
+   sa.sa_handler = sigint_handler;
+   sigemptyset(&sa.sa_mask);
+   sa.sa_flags = SA_RESTART;
+   sigaction(SIGINT, &sa, &saved);
+
+   // Ctrl-C while the shell copies an endless input
+   pid_t killer = fork();
+   if (killer == 0) {
+      struct timespec delay = {0, 100000000L};
+      nanosleep(&delay, NULL);
+      kill(getppid(), SIGINT);
+      _exit(0);
+   }
+
+   // The copy fails as a killed cat would, so `&&` does not go on
+   vars_unset("yash_next");
+   char text[] = "cat /dev/zero > /dev/null && yash_next=ran";
+   Line line;
+   memset(&line, 0, sizeof(line));
+   TEST_ASSERT_EQUAL(0, parse_line(text, &line));
+   TEST_ASSERT_EQUAL(0, execute_line(&line));
+   line_free(&line);
+   waitpid(killer, NULL, 0);
+   sigaction(SIGINT, &saved, NULL);
+
+   TEST_ASSERT_EQUAL(128 + SIGINT, vars_status());
+   TEST_ASSERT_NULL(vars_get("yash_next"));
+   shell_interrupted = 0;
+   vars_set_status(0);
+}
@@ -25,16 +25,18 @@ void test_parse_background_with_all_redirections(void) {
    TEST_ASSERT_EQUAL_STRING("find /usr -name '*.h' -type f > headers.txt 2> errors.log &",
                             parsed_line.original);
    TEST_ASSERT_EQUAL(0, parsed_line.is_pipeline);
-   TEST_ASSERT_EQUAL_STRING("find", parsed_line.left.argv[0]);
-   TEST_ASSERT_EQUAL_STRING("/usr", parsed_line.left.argv[1]);
-   TEST_ASSERT_EQUAL_STRING("-name", parsed_line.left.argv[2]);
-   TEST_ASSERT_EQUAL_STRING("'*.h'", parsed_line.left.argv[3]);
-   TEST_ASSERT_EQUAL_STRING("-type", parsed_line.left.argv[4]);
-   TEST_ASSERT_EQUAL_STRING("f", parsed_line.left.argv[5]);
-   TEST_ASSERT_NULL(parsed_line.left.in_file);
-   TEST_ASSERT_EQUAL_STRING("headers.txt", parsed_line.left.out_file);
-   TEST_ASSERT_EQUAL_STRING("errors.log", parsed_line.left.err_file);
-   TEST_ASSERT_EQUAL(1, parsed_line.left.background);
+   TEST_ASSERT_EQUAL_STRING("find", parsed_line.stages[0].argv[0]);
+   TEST_ASSERT_EQUAL_STRING("/usr", parsed_line.stages[0].argv[1]);
+   TEST_ASSERT_EQUAL_STRING("-name", parsed_line.stages[0].argv[2]);
+   TEST_ASSERT_EQUAL_STRING("'*.h'", parsed_line.stages[0].argv[3]);
+   TEST_ASSERT_EQUAL_STRING("-type", parsed_line.stages[0].argv[4]);
+   TEST_ASSERT_EQUAL_STRING("f", parsed_line.stages[0].argv[5]);
+   TEST_ASSERT_NULL(parsed_line.stages[0].in_file);
+   TEST_ASSERT_EQUAL_STRING("headers.txt", parsed_line.stages[0].out_file);
+   TEST_ASSERT_EQUAL_STRING("errors.log", parsed_line.stages[0].err_file);
+   TEST_ASSERT_EQUAL(1, parsed_line.stages[0].background);
+
+   line_free(&parsed_line);
 }
 
 void test_parse_pipe_with_mixed_redirections(void) {
@@ -50,19 +52,21 @@ void test_parse_pipe_with_mixed_redirections(void) {
    TEST_ASSERT_EQUAL(1, parsed_line.is_pipeline);
 
    // Left command (cat)
-   TEST_ASSERT_EQUAL_STRING("cat", parsed_line.left.argv[0]);
-   TEST_ASSERT_EQUAL_STRING("input.txt", parsed_line.left.in_file);
-   TEST_ASSERT_NULL(parsed_line.left.out_file);
-   TEST_ASSERT_NULL(parsed_line.left.err_file);
-   TEST_ASSERT_EQUAL(0, parsed_line.left.background);
+   TEST_ASSERT_EQUAL_STRING("cat", parsed_line.stages[0].argv[0]);
+   TEST_ASSERT_EQUAL_STRING("input.txt", parsed_line.stages[0].in_file);
+   TEST_ASSERT_NULL(parsed_line.stages[0].out_file);
+   TEST_ASSERT_NULL(parsed_line.stages[0].err_file);
+   TEST_ASSERT_EQUAL(0, parsed_line.stages[0].background);
 
    // Right command (grep)
-   TEST_ASSERT_EQUAL_STRING("grep", parsed_line.right.argv[0]);
-   TEST_ASSERT_EQUAL_STRING("test", parsed_line.right.argv[1]);
-   TEST_ASSERT_NULL(parsed_line.right.in_file);
-   TEST_ASSERT_EQUAL_STRING("output.txt", parsed_line.right.out_file);
-   TEST_ASSERT_EQUAL_STRING("error.txt", parsed_line.right.err_file);
-   TEST_ASSERT_EQUAL(0, parsed_line.right.background);
+   TEST_ASSERT_EQUAL_STRING("grep", parsed_line.stages[1].argv[0]);
+   TEST_ASSERT_EQUAL_STRING("test", parsed_line.stages[1].argv[1]);
+   TEST_ASSERT_NULL(parsed_line.stages[1].in_file);
+   TEST_ASSERT_EQUAL_STRING("output.txt", parsed_line.stages[1].out_file);
+   TEST_ASSERT_EQUAL_STRING("error.txt", parsed_line.stages[1].err_file);
+   TEST_ASSERT_EQUAL(0, parsed_line.stages[1].background);
+
+   line_free(&parsed_line);
 }
 
 // ============================================================================
@@ -81,11 +85,12 @@ void test_parse_job_control_commands(void) {
       TEST_ASSERT_EQUAL(0, result);
       TEST_ASSERT_EQUAL_STRING(job_commands[i], parsed_line.original);
       TEST_ASSERT_EQUAL(0, parsed_line.is_pipeline);
-      TEST_ASSERT_EQUAL_STRING(job_commands[i], parsed_line.left.argv[0]);
-      TEST_ASSERT_NULL(parsed_line.left.in_file);
-      TEST_ASSERT_NULL(parsed_line.left.out_file);
-      TEST_ASSERT_NULL(parsed_line.left.err_file);
-      TEST_ASSERT_EQUAL(0, parsed_line.left.background);
+      TEST_ASSERT_EQUAL_STRING(job_commands[i], parsed_line.stages[0].argv[0]);
+      TEST_ASSERT_NULL(parsed_line.stages[0].in_file);
+      TEST_ASSERT_NULL(parsed_line.stages[0].out_file);
+      TEST_ASSERT_NULL(parsed_line.stages[0].err_file);
+      TEST_ASSERT_EQUAL(0, parsed_line.stages[0].background);
+      line_free(&parsed_line);
    }
 }
 
@@ -100,14 +105,16 @@ void test_parse_background_job_with_redirections(void) {
    TEST_ASSERT_EQUAL_STRING("grep -r 'pattern' /usr/include > results.txt 2> errors.log &",
                             parsed_line.original);
    TEST_ASSERT_EQUAL(0, parsed_line.is_pipeline);
-   TEST_ASSERT_EQUAL_STRING("grep", parsed_line.left.argv[0]);
-   TEST_ASSERT_EQUAL_STRING("-r", parsed_line.left.argv[1]);
-   TEST_ASSERT_EQUAL_STRING("'pattern'", parsed_line.left.argv[2]);
-   TEST_ASSERT_EQUAL_STRING("/usr/include", parsed_line.left.argv[3]);
-   TEST_ASSERT_NULL(parsed_line.left.in_file);
-   TEST_ASSERT_EQUAL_STRING("results.txt", parsed_line.left.out_file);
-   TEST_ASSERT_EQUAL_STRING("errors.log", parsed_line.left.err_file);
-   TEST_ASSERT_EQUAL(1, parsed_line.left.background);
+   TEST_ASSERT_EQUAL_STRING("grep", parsed_line.stages[0].argv[0]);
+   TEST_ASSERT_EQUAL_STRING("-r", parsed_line.stages[0].argv[1]);
+   TEST_ASSERT_EQUAL_STRING("'pattern'", parsed_line.stages[0].argv[2]);
+   TEST_ASSERT_EQUAL_STRING("/usr/include", parsed_line.stages[0].argv[3]);
+   TEST_ASSERT_NULL(parsed_line.stages[0].in_file);
+   TEST_ASSERT_EQUAL_STRING("results.txt", parsed_line.stages[0].out_file);
+   TEST_ASSERT_EQUAL_STRING("errors.log", parsed_line.stages[0].err_file);
+   TEST_ASSERT_EQUAL(1, parsed_line.stages[0].background);
+
+   line_free(&parsed_line);
 }
 
 // ============================================================================
@@ -128,6 +135,7 @@ void test_parse_development_commands(void) {
 
       // All these commands should work
       TEST_ASSERT_EQUAL(0, result);
+      line_free(&parsed_line);
    }
 }
 
@@ -139,13 +147,13 @@ void test_parse_development_commands(void) {
 
 void test_parse_stress_many_arguments(void) {
    // Create a command with many arguments
-   char line[MAX_CMDLINE];
+   char line[1024];
    int pos = 0;
-   pos += snprintf(line + pos, MAX_CMDLINE - pos, "grep");
+   pos += snprintf(line + pos, sizeof(line) - pos, "grep");
    for (int i = 0; i < 50; i++) {
-      pos += snprintf(line + pos, MAX_CMDLINE - pos, " arg%d", i);
+      pos += snprintf(line + pos, sizeof(line) - pos, " arg%d", i);
    }
-   pos += snprintf(line + pos, MAX_CMDLINE - pos, " > output.txt");
+   pos += snprintf(line + pos, sizeof(line) - pos, " > output.txt");
 
    Line parsed_line;
    memset(&parsed_line, 0, sizeof(parsed_line));
@@ -155,8 +163,10 @@ void test_parse_stress_many_arguments(void) {
    // This should succeed because it's a valid command
    TEST_ASSERT_EQUAL(0, result);
    TEST_ASSERT_EQUAL(0, parsed_line.is_pipeline);
-   TEST_ASSERT_EQUAL_STRING("grep", parsed_line.left.argv[0]);
-   TEST_ASSERT_EQUAL_STRING("output.txt", parsed_line.left.out_file);
+   TEST_ASSERT_EQUAL_STRING("grep", parsed_line.stages[0].argv[0]);
+   TEST_ASSERT_EQUAL_STRING("output.txt", parsed_line.stages[0].out_file);
+
+   line_free(&parsed_line);
 }
 
 void test_parse_stress_many_redirections(void) {
@@ -170,6 +180,8 @@ void test_parse_stress_many_redirections(void) {
 
    // This should fail because of duplicate redirections
    TEST_ASSERT_EQUAL(-1, result);
+
+   line_free(&parsed_line);
 }
 
 // ============================================================================
@@ -194,6 +206,7 @@ void test_parse_recovery_from_errors(void) {
 
       // All of these should parse successfully
       TEST_ASSERT_EQUAL(0, result);
+      line_free(&parsed_line);
    }
 }
 
@@ -218,6 +231,7 @@ void test_parse_performance_integration(void) {
 
          int result = parse_line(commands[i], &parsed_line);
          TEST_ASSERT_EQUAL(0, result);
+         line_free(&parsed_line);
       }
    }
 
@@ -263,8 +277,9 @@ void test_parse_feature_combinations(void) {
       TEST_ASSERT_EQUAL(test_cases[i].expected_result, result);
       if (result == 0) {
          TEST_ASSERT_EQUAL(test_cases[i].is_pipeline, parsed_line.is_pipeline);
-         TEST_ASSERT_EQUAL(test_cases[i].background, parsed_line.left.background);
+         TEST_ASSERT_EQUAL(test_cases[i].background, parsed_line.stages[0].background);
       }
+      line_free(&parsed_line);
    }
 }
 
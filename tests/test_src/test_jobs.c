@@ -1,8 +1,17 @@
+#include "../../include/exec.h"
+#include "../../include/jobs.h"
+#include "../../include/options.h"
 #include "../../include/parse.h"
+#include "../../include/vars.h"
 #include "../../include/yash.h"
 #include "unity.h"
+#include <fcntl.h>
+#include <signal.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
 
 // setUp and tearDown are defined in test_runner.c
 
@@ -22,11 +31,13 @@ void test_parse_background_with_multiple_redirections(void) {
    TEST_ASSERT_EQUAL(0, result);
    TEST_ASSERT_EQUAL_STRING("cat < input.txt > output.txt 2> error.txt &", parsed_line.original);
    TEST_ASSERT_EQUAL(0, parsed_line.is_pipeline);
-   TEST_ASSERT_EQUAL_STRING("cat", parsed_line.left.argv[0]);
-   TEST_ASSERT_EQUAL_STRING("input.txt", parsed_line.left.in_file);
-   TEST_ASSERT_EQUAL_STRING("output.txt", parsed_line.left.out_file);
-   TEST_ASSERT_EQUAL_STRING("error.txt", parsed_line.left.err_file);
-   TEST_ASSERT_EQUAL(1, parsed_line.left.background);
+   TEST_ASSERT_EQUAL_STRING("cat", parsed_line.stages[0].argv[0]);
+   TEST_ASSERT_EQUAL_STRING("input.txt", parsed_line.stages[0].in_file);
+   TEST_ASSERT_EQUAL_STRING("output.txt", parsed_line.stages[0].out_file);
+   TEST_ASSERT_EQUAL_STRING("error.txt", parsed_line.stages[0].err_file);
+   TEST_ASSERT_EQUAL(1, parsed_line.stages[0].background);
+
+   line_free(&parsed_line);
 }
 
 void test_parse_background_with_arguments(void) {
@@ -39,16 +50,18 @@ void test_parse_background_with_arguments(void) {
    TEST_ASSERT_EQUAL(0, result);
    TEST_ASSERT_EQUAL_STRING("find . -name '*.c' -type f > results.txt &", parsed_line.original);
    TEST_ASSERT_EQUAL(0, parsed_line.is_pipeline);
-   TEST_ASSERT_EQUAL_STRING("find", parsed_line.left.argv[0]);
-   TEST_ASSERT_EQUAL_STRING(".", parsed_line.left.argv[1]);
-   TEST_ASSERT_EQUAL_STRING("-name", parsed_line.left.argv[2]);
-   TEST_ASSERT_EQUAL_STRING("'*.c'", parsed_line.left.argv[3]);
-   TEST_ASSERT_EQUAL_STRING("-type", parsed_line.left.argv[4]);
-   TEST_ASSERT_EQUAL_STRING("f", parsed_line.left.argv[5]);
-   TEST_ASSERT_NULL(parsed_line.left.in_file);
-   TEST_ASSERT_EQUAL_STRING("results.txt", parsed_line.left.out_file);
-   TEST_ASSERT_NULL(parsed_line.left.err_file);
-   TEST_ASSERT_EQUAL(1, parsed_line.left.background);
+   TEST_ASSERT_EQUAL_STRING("find", parsed_line.stages[0].argv[0]);
+   TEST_ASSERT_EQUAL_STRING(".", parsed_line.stages[0].argv[1]);
+   TEST_ASSERT_EQUAL_STRING("-name", parsed_line.stages[0].argv[2]);
+   TEST_ASSERT_EQUAL_STRING("'*.c'", parsed_line.stages[0].argv[3]);
+   TEST_ASSERT_EQUAL_STRING("-type", parsed_line.stages[0].argv[4]);
+   TEST_ASSERT_EQUAL_STRING("f", parsed_line.stages[0].argv[5]);
+   TEST_ASSERT_NULL(parsed_line.stages[0].in_file);
+   TEST_ASSERT_EQUAL_STRING("results.txt", parsed_line.stages[0].out_file);
+   TEST_ASSERT_NULL(parsed_line.stages[0].err_file);
+   TEST_ASSERT_EQUAL(1, parsed_line.stages[0].background);
+
+   line_free(&parsed_line);
 }
 
 // ============================================================================
@@ -65,11 +78,13 @@ void test_parse_jobs_command(void) {
    TEST_ASSERT_EQUAL(0, result);
    TEST_ASSERT_EQUAL_STRING("jobs", parsed_line.original);
    TEST_ASSERT_EQUAL(0, parsed_line.is_pipeline);
-   TEST_ASSERT_EQUAL_STRING("jobs", parsed_line.left.argv[0]);
-   TEST_ASSERT_NULL(parsed_line.left.in_file);
-   TEST_ASSERT_NULL(parsed_line.left.out_file);
-   TEST_ASSERT_NULL(parsed_line.left.err_file);
-   TEST_ASSERT_EQUAL(0, parsed_line.left.background);
+   TEST_ASSERT_EQUAL_STRING("jobs", parsed_line.stages[0].argv[0]);
+   TEST_ASSERT_NULL(parsed_line.stages[0].in_file);
+   TEST_ASSERT_NULL(parsed_line.stages[0].out_file);
+   TEST_ASSERT_NULL(parsed_line.stages[0].err_file);
+   TEST_ASSERT_EQUAL(0, parsed_line.stages[0].background);
+
+   line_free(&parsed_line);
 }
 
 void test_parse_fg_command(void) {
@@ -82,11 +97,13 @@ void test_parse_fg_command(void) {
    TEST_ASSERT_EQUAL(0, result);
    TEST_ASSERT_EQUAL_STRING("fg", parsed_line.original);
    TEST_ASSERT_EQUAL(0, parsed_line.is_pipeline);
-   TEST_ASSERT_EQUAL_STRING("fg", parsed_line.left.argv[0]);
-   TEST_ASSERT_NULL(parsed_line.left.in_file);
-   TEST_ASSERT_NULL(parsed_line.left.out_file);
-   TEST_ASSERT_NULL(parsed_line.left.err_file);
-   TEST_ASSERT_EQUAL(0, parsed_line.left.background);
+   TEST_ASSERT_EQUAL_STRING("fg", parsed_line.stages[0].argv[0]);
+   TEST_ASSERT_NULL(parsed_line.stages[0].in_file);
+   TEST_ASSERT_NULL(parsed_line.stages[0].out_file);
+   TEST_ASSERT_NULL(parsed_line.stages[0].err_file);
+   TEST_ASSERT_EQUAL(0, parsed_line.stages[0].background);
+
+   line_free(&parsed_line);
 }
 
 void test_parse_bg_command(void) {
@@ -99,11 +116,13 @@ void test_parse_bg_command(void) {
    TEST_ASSERT_EQUAL(0, result);
    TEST_ASSERT_EQUAL_STRING("bg", parsed_line.original);
    TEST_ASSERT_EQUAL(0, parsed_line.is_pipeline);
-   TEST_ASSERT_EQUAL_STRING("bg", parsed_line.left.argv[0]);
-   TEST_ASSERT_NULL(parsed_line.left.in_file);
-   TEST_ASSERT_NULL(parsed_line.left.out_file);
-   TEST_ASSERT_NULL(parsed_line.left.err_file);
-   TEST_ASSERT_EQUAL(0, parsed_line.left.background);
+   TEST_ASSERT_EQUAL_STRING("bg", parsed_line.stages[0].argv[0]);
+   TEST_ASSERT_NULL(parsed_line.stages[0].in_file);
+   TEST_ASSERT_NULL(parsed_line.stages[0].out_file);
+   TEST_ASSERT_NULL(parsed_line.stages[0].err_file);
+   TEST_ASSERT_EQUAL(0, parsed_line.stages[0].background);
+
+   line_free(&parsed_line);
 }
 
 // ============================================================================
@@ -119,6 +138,8 @@ void test_parse_background_missing_command(void) {
 
    // This should fail because there's no command before &
    TEST_ASSERT_EQUAL(-1, result);
+
+   line_free(&parsed_line);
 }
 
 void test_parse_background_with_pipe(void) {
@@ -130,6 +151,8 @@ void test_parse_background_with_pipe(void) {
 
    // This should fail because pipes and background execution are mutually exclusive
    TEST_ASSERT_EQUAL(-1, result);
+
+   line_free(&parsed_line);
 }
 
 void test_parse_background_pipe_left(void) {
@@ -141,6 +164,8 @@ void test_parse_background_pipe_left(void) {
 
    // This should fail because pipes and background execution are mutually exclusive
    TEST_ASSERT_EQUAL(-1, result);
+
+   line_free(&parsed_line);
 }
 
 void test_parse_background_pipe_right(void) {
@@ -152,6 +177,8 @@ void test_parse_background_pipe_right(void) {
 
    // This should fail because pipes and background execution are mutually exclusive
    TEST_ASSERT_EQUAL(-1, result);
+
+   line_free(&parsed_line);
 }
 
 void test_parse_background_duplicate_ampersand(void) {
@@ -163,6 +190,8 @@ void test_parse_background_duplicate_ampersand(void) {
 
    // This should fail because there are multiple & symbols
    TEST_ASSERT_EQUAL(-1, result);
+
+   line_free(&parsed_line);
 }
 
 void test_parse_background_ampersand_not_last(void) {
@@ -172,8 +201,16 @@ void test_parse_background_ampersand_not_last(void) {
 
    int result = parse_line(line, &parsed_line);
 
-   // This should fail because & is not the last token
-   TEST_ASSERT_EQUAL(-1, result);
+   // A `&` that is not the last token ends a background element of a list
+   TEST_ASSERT_EQUAL(0, result);
+   TEST_ASSERT_EQUAL(1, parsed_line.stages[0].background);
+   TEST_ASSERT_EQUAL_STRING("ls &", parsed_line.original);
+   TEST_ASSERT_EQUAL(LIST_SEQ, parsed_line.op);
+   TEST_ASSERT_NOT_NULL(parsed_line.next);
+   TEST_ASSERT_EQUAL(0, parsed_line.next->stages[0].background);
+   TEST_ASSERT_EQUAL_STRING("grep test", parsed_line.next->original);
+
+   line_free(&parsed_line);
 }
 
 // ============================================================================
@@ -189,9 +226,11 @@ void test_parse_jobs_with_arguments(void) {
 
    // For now, treat jobs as a regular command (will be built-in later)
    TEST_ASSERT_EQUAL(0, result);
-   TEST_ASSERT_EQUAL_STRING("jobs", parsed_line.left.argv[0]);
-   TEST_ASSERT_EQUAL_STRING("arg1", parsed_line.left.argv[1]);
-   TEST_ASSERT_EQUAL_STRING("arg2", parsed_line.left.argv[2]);
+   TEST_ASSERT_EQUAL_STRING("jobs", parsed_line.stages[0].argv[0]);
+   TEST_ASSERT_EQUAL_STRING("arg1", parsed_line.stages[0].argv[1]);
+   TEST_ASSERT_EQUAL_STRING("arg2", parsed_line.stages[0].argv[2]);
+
+   line_free(&parsed_line);
 }
 
 void test_parse_fg_with_arguments(void) {
@@ -203,9 +242,11 @@ void test_parse_fg_with_arguments(void) {
 
    // For now, treat fg as a regular command (will be built-in later)
    TEST_ASSERT_EQUAL(0, result);
-   TEST_ASSERT_EQUAL_STRING("fg", parsed_line.left.argv[0]);
-   TEST_ASSERT_EQUAL_STRING("arg1", parsed_line.left.argv[1]);
-   TEST_ASSERT_EQUAL_STRING("arg2", parsed_line.left.argv[2]);
+   TEST_ASSERT_EQUAL_STRING("fg", parsed_line.stages[0].argv[0]);
+   TEST_ASSERT_EQUAL_STRING("arg1", parsed_line.stages[0].argv[1]);
+   TEST_ASSERT_EQUAL_STRING("arg2", parsed_line.stages[0].argv[2]);
+
+   line_free(&parsed_line);
 }
 
 void test_parse_bg_with_arguments(void) {
@@ -217,9 +258,11 @@ void test_parse_bg_with_arguments(void) {
 
    // For now, treat bg as a regular command (will be built-in later)
    TEST_ASSERT_EQUAL(0, result);
-   TEST_ASSERT_EQUAL_STRING("bg", parsed_line.left.argv[0]);
-   TEST_ASSERT_EQUAL_STRING("arg1", parsed_line.left.argv[1]);
-   TEST_ASSERT_EQUAL_STRING("arg2", parsed_line.left.argv[2]);
+   TEST_ASSERT_EQUAL_STRING("bg", parsed_line.stages[0].argv[0]);
+   TEST_ASSERT_EQUAL_STRING("arg1", parsed_line.stages[0].argv[1]);
+   TEST_ASSERT_EQUAL_STRING("arg2", parsed_line.stages[0].argv[2]);
+
+   line_free(&parsed_line);
 }
 
 void test_parse_jobs_with_redirection(void) {
@@ -231,8 +274,10 @@ void test_parse_jobs_with_redirection(void) {
 
    // For now, treat jobs as a regular command (will be built-in later)
    TEST_ASSERT_EQUAL(0, result);
-   TEST_ASSERT_EQUAL_STRING("jobs", parsed_line.left.argv[0]);
-   TEST_ASSERT_EQUAL_STRING("output.txt", parsed_line.left.out_file);
+   TEST_ASSERT_EQUAL_STRING("jobs", parsed_line.stages[0].argv[0]);
+   TEST_ASSERT_EQUAL_STRING("output.txt", parsed_line.stages[0].out_file);
+
+   line_free(&parsed_line);
 }
 
 void test_parse_fg_with_redirection(void) {
@@ -244,8 +289,10 @@ void test_parse_fg_with_redirection(void) {
 
    // For now, treat fg as a regular command (will be built-in later)
    TEST_ASSERT_EQUAL(0, result);
-   TEST_ASSERT_EQUAL_STRING("fg", parsed_line.left.argv[0]);
-   TEST_ASSERT_EQUAL_STRING("output.txt", parsed_line.left.out_file);
+   TEST_ASSERT_EQUAL_STRING("fg", parsed_line.stages[0].argv[0]);
+   TEST_ASSERT_EQUAL_STRING("output.txt", parsed_line.stages[0].out_file);
+
+   line_free(&parsed_line);
 }
 
 void test_parse_bg_with_redirection(void) {
@@ -257,8 +304,10 @@ void test_parse_bg_with_redirection(void) {
 
    // For now, treat bg as a regular command (will be built-in later)
    TEST_ASSERT_EQUAL(0, result);
-   TEST_ASSERT_EQUAL_STRING("bg", parsed_line.left.argv[0]);
-   TEST_ASSERT_EQUAL_STRING("output.txt", parsed_line.left.out_file);
+   TEST_ASSERT_EQUAL_STRING("bg", parsed_line.stages[0].argv[0]);
+   TEST_ASSERT_EQUAL_STRING("output.txt", parsed_line.stages[0].out_file);
+
+   line_free(&parsed_line);
 }
 
 void test_parse_jobs_with_background(void) {
@@ -270,8 +319,10 @@ void test_parse_jobs_with_background(void) {
 
    // For now, treat jobs as a regular command (will be built-in later)
    TEST_ASSERT_EQUAL(0, result);
-   TEST_ASSERT_EQUAL_STRING("jobs", parsed_line.left.argv[0]);
-   TEST_ASSERT_EQUAL(1, parsed_line.left.background);
+   TEST_ASSERT_EQUAL_STRING("jobs", parsed_line.stages[0].argv[0]);
+   TEST_ASSERT_EQUAL(1, parsed_line.stages[0].background);
+
+   line_free(&parsed_line);
 }
 
 void test_parse_fg_with_background(void) {
@@ -283,8 +334,10 @@ void test_parse_fg_with_background(void) {
 
    // For now, treat fg as a regular command (will be built-in later)
    TEST_ASSERT_EQUAL(0, result);
-   TEST_ASSERT_EQUAL_STRING("fg", parsed_line.left.argv[0]);
-   TEST_ASSERT_EQUAL(1, parsed_line.left.background);
+   TEST_ASSERT_EQUAL_STRING("fg", parsed_line.stages[0].argv[0]);
+   TEST_ASSERT_EQUAL(1, parsed_line.stages[0].background);
+
+   line_free(&parsed_line);
 }
 
 void test_parse_bg_with_background(void) {
@@ -296,8 +349,10 @@ void test_parse_bg_with_background(void) {
 
    // For now, treat bg as a regular command (will be built-in later)
    TEST_ASSERT_EQUAL(0, result);
-   TEST_ASSERT_EQUAL_STRING("bg", parsed_line.left.argv[0]);
-   TEST_ASSERT_EQUAL(1, parsed_line.left.background);
+   TEST_ASSERT_EQUAL_STRING("bg", parsed_line.stages[0].argv[0]);
+   TEST_ASSERT_EQUAL(1, parsed_line.stages[0].background);
+
+   line_free(&parsed_line);
 }
 
 // ============================================================================
@@ -305,22 +360,27 @@ void test_parse_bg_with_background(void) {
 // ============================================================================
 
 void test_parse_background_max_arguments(void) {
-   // Create a background command with maximum arguments
-   char line[MAX_CMDLINE];
+   // Create a background command with the old maximum of 64 arguments
+   char line[1024];
    int pos = 0;
-   pos += snprintf(line + pos, MAX_CMDLINE - pos, "cmd");
-   for (int i = 0; i < MAX_ARGS - 1; i++) {
-      pos += snprintf(line + pos, MAX_CMDLINE - pos, " arg%d", i);
+   pos += snprintf(line + pos, sizeof(line) - pos, "cmd");
+   for (int i = 0; i < 64 - 1; i++) {
+      pos += snprintf(line + pos, sizeof(line) - pos, " arg%d", i);
    }
-   pos += snprintf(line + pos, MAX_CMDLINE - pos, " &");
+   pos += snprintf(line + pos, sizeof(line) - pos, " &");
 
    Line parsed_line;
    memset(&parsed_line, 0, sizeof(parsed_line));
 
    int result = parse_line(line, &parsed_line);
 
-   // This should fail because it exceeds MAX_ARGS
-   TEST_ASSERT_EQUAL(-1, result);
+   // Arguments are no longer capped, and the & still applies
+   TEST_ASSERT_EQUAL(0, result);
+   TEST_ASSERT_EQUAL(1, parsed_line.stages[0].background);
+   TEST_ASSERT_EQUAL_STRING("arg62", parsed_line.stages[0].argv[63]);
+   TEST_ASSERT_NULL(parsed_line.stages[0].argv[64]);
+
+   line_free(&parsed_line);
 }
 
 void test_parse_background_single_character_command(void) {
@@ -333,11 +393,13 @@ void test_parse_background_single_character_command(void) {
    TEST_ASSERT_EQUAL(0, result);
    TEST_ASSERT_EQUAL_STRING("a &", parsed_line.original);
    TEST_ASSERT_EQUAL(0, parsed_line.is_pipeline);
-   TEST_ASSERT_EQUAL_STRING("a", parsed_line.left.argv[0]);
-   TEST_ASSERT_NULL(parsed_line.left.in_file);
-   TEST_ASSERT_NULL(parsed_line.left.out_file);
-   TEST_ASSERT_NULL(parsed_line.left.err_file);
-   TEST_ASSERT_EQUAL(1, parsed_line.left.background);
+   TEST_ASSERT_EQUAL_STRING("a", parsed_line.stages[0].argv[0]);
+   TEST_ASSERT_NULL(parsed_line.stages[0].in_file);
+   TEST_ASSERT_NULL(parsed_line.stages[0].out_file);
+   TEST_ASSERT_NULL(parsed_line.stages[0].err_file);
+   TEST_ASSERT_EQUAL(1, parsed_line.stages[0].background);
+
+   line_free(&parsed_line);
 }
 
 void test_parse_background_empty_arguments(void) {
@@ -350,11 +412,13 @@ void test_parse_background_empty_arguments(void) {
    TEST_ASSERT_EQUAL(0, result);
    TEST_ASSERT_EQUAL_STRING("cmd &", parsed_line.original);
    TEST_ASSERT_EQUAL(0, parsed_line.is_pipeline);
-   TEST_ASSERT_EQUAL_STRING("cmd", parsed_line.left.argv[0]);
-   TEST_ASSERT_NULL(parsed_line.left.in_file);
-   TEST_ASSERT_NULL(parsed_line.left.out_file);
-   TEST_ASSERT_NULL(parsed_line.left.err_file);
-   TEST_ASSERT_EQUAL(1, parsed_line.left.background);
+   TEST_ASSERT_EQUAL_STRING("cmd", parsed_line.stages[0].argv[0]);
+   TEST_ASSERT_NULL(parsed_line.stages[0].in_file);
+   TEST_ASSERT_NULL(parsed_line.stages[0].out_file);
+   TEST_ASSERT_NULL(parsed_line.stages[0].err_file);
+   TEST_ASSERT_EQUAL(1, parsed_line.stages[0].background);
+
+   line_free(&parsed_line);
 }
 
 // ============================================================================
@@ -370,6 +434,8 @@ void test_parse_background_complex_command(void) {
 
    // This should fail because pipes and background execution are mutually exclusive
    TEST_ASSERT_EQUAL(-1, result);
+
+   line_free(&parsed_line);
 }
 
 void test_parse_jobs_background_with_all_redirections(void) {
@@ -382,11 +448,13 @@ void test_parse_jobs_background_with_all_redirections(void) {
    TEST_ASSERT_EQUAL(0, result);
    TEST_ASSERT_EQUAL_STRING("cat < input.txt > output.txt 2> error.txt &", parsed_line.original);
    TEST_ASSERT_EQUAL(0, parsed_line.is_pipeline);
-   TEST_ASSERT_EQUAL_STRING("cat", parsed_line.left.argv[0]);
-   TEST_ASSERT_EQUAL_STRING("input.txt", parsed_line.left.in_file);
-   TEST_ASSERT_EQUAL_STRING("output.txt", parsed_line.left.out_file);
-   TEST_ASSERT_EQUAL_STRING("error.txt", parsed_line.left.err_file);
-   TEST_ASSERT_EQUAL(1, parsed_line.left.background);
+   TEST_ASSERT_EQUAL_STRING("cat", parsed_line.stages[0].argv[0]);
+   TEST_ASSERT_EQUAL_STRING("input.txt", parsed_line.stages[0].in_file);
+   TEST_ASSERT_EQUAL_STRING("output.txt", parsed_line.stages[0].out_file);
+   TEST_ASSERT_EQUAL_STRING("error.txt", parsed_line.stages[0].err_file);
+   TEST_ASSERT_EQUAL(1, parsed_line.stages[0].background);
+
+   line_free(&parsed_line);
 }
 
 void test_parse_background_with_long_command(void) {
@@ -402,17 +470,339 @@ void test_parse_background_with_long_command(void) {
                             "results.txt 2> errors.log &",
                             parsed_line.original);
    TEST_ASSERT_EQUAL(0, parsed_line.is_pipeline);
-   TEST_ASSERT_EQUAL_STRING("grep", parsed_line.left.argv[0]);
-   TEST_ASSERT_EQUAL_STRING("-r", parsed_line.left.argv[1]);
-   TEST_ASSERT_EQUAL_STRING("-i", parsed_line.left.argv[2]);
-   TEST_ASSERT_EQUAL_STRING("'pattern'", parsed_line.left.argv[3]);
-   TEST_ASSERT_EQUAL_STRING("/usr/include", parsed_line.left.argv[4]);
-   TEST_ASSERT_EQUAL_STRING("--include='*.h'", parsed_line.left.argv[5]);
-   TEST_ASSERT_EQUAL_STRING("--exclude='*.c'", parsed_line.left.argv[6]);
-   TEST_ASSERT_NULL(parsed_line.left.in_file);
-   TEST_ASSERT_EQUAL_STRING("results.txt", parsed_line.left.out_file);
-   TEST_ASSERT_EQUAL_STRING("errors.log", parsed_line.left.err_file);
-   TEST_ASSERT_EQUAL(1, parsed_line.left.background);
+   TEST_ASSERT_EQUAL_STRING("grep", parsed_line.stages[0].argv[0]);
+   TEST_ASSERT_EQUAL_STRING("-r", parsed_line.stages[0].argv[1]);
+   TEST_ASSERT_EQUAL_STRING("-i", parsed_line.stages[0].argv[2]);
+   TEST_ASSERT_EQUAL_STRING("'pattern'", parsed_line.stages[0].argv[3]);
+   TEST_ASSERT_EQUAL_STRING("/usr/include", parsed_line.stages[0].argv[4]);
+   TEST_ASSERT_EQUAL_STRING("--include='*.h'", parsed_line.stages[0].argv[5]);
+   TEST_ASSERT_EQUAL_STRING("--exclude='*.c'", parsed_line.stages[0].argv[6]);
+   TEST_ASSERT_NULL(parsed_line.stages[0].in_file);
+   TEST_ASSERT_EQUAL_STRING("results.txt", parsed_line.stages[0].out_file);
+   TEST_ASSERT_EQUAL_STRING("errors.log", parsed_line.stages[0].err_file);
+   TEST_ASSERT_EQUAL(1, parsed_line.stages[0].background);
+
+   line_free(&parsed_line);
+}
+
+// ============================================================================
+// Resource Accounting Tests
+// ============================================================================
+
+void test_parse_time_keyword(void) {
+   char line[] = "time ls -l | wc -l";
+   Line parsed_line;
+   memset(&parsed_line, 0, sizeof(parsed_line));
+
+   TEST_ASSERT_EQUAL(0, parse_line(line, &parsed_line));
+   TEST_ASSERT_EQUAL(1, parsed_line.timed);
+   TEST_ASSERT_EQUAL(2, parsed_line.num_stages);
+   TEST_ASSERT_EQUAL_STRING("ls", parsed_line.stages[0].argv[0]);
+   TEST_ASSERT_EQUAL_STRING("time ls -l | wc -l", parsed_line.original);
+   line_free(&parsed_line);
+
+   // On its own `time` is just a word
+   char alone[] = "time";
+   TEST_ASSERT_EQUAL(0, parse_line(alone, &parsed_line));
+   TEST_ASSERT_EQUAL(0, parsed_line.timed);
+   TEST_ASSERT_EQUAL_STRING("time", parsed_line.stages[0].argv[0]);
+   line_free(&parsed_line);
+}
+
+void test_parse_timeout_prefix(void) {
+   char line[] = "time timeout -k 1 -c 2.5 10m sleep 1 | cat";
+   Line parsed_line;
+   memset(&parsed_line, 0, sizeof(parsed_line));
+
+   TEST_ASSERT_EQUAL(0, parse_line(line, &parsed_line));
+   TEST_ASSERT_EQUAL(1, parsed_line.timed);
+   TEST_ASSERT_TRUE(parsed_line.budget.wall == 600);
+   TEST_ASSERT_TRUE(parsed_line.budget.cpu == 2.5);
+   TEST_ASSERT_TRUE(parsed_line.budget.grace == 1);
+   TEST_ASSERT_EQUAL(2, parsed_line.num_stages);
+   TEST_ASSERT_EQUAL_STRING("sleep", parsed_line.stages[0].argv[0]);
+   line_free(&parsed_line);
+
+   // A CPU budget alone, with the default grace
+   char cpu_only[] = "timeout -c 1 yes &";
+   TEST_ASSERT_EQUAL(0, parse_line(cpu_only, &parsed_line));
+   TEST_ASSERT_TRUE(parsed_line.budget.wall == 0);
+   TEST_ASSERT_TRUE(parsed_line.budget.cpu == 1);
+   TEST_ASSERT_TRUE(parsed_line.budget.grace == TIMEOUT_GRACE_DEFAULT);
+   TEST_ASSERT_EQUAL_STRING("yes", parsed_line.stages[0].argv[0]);
+   TEST_ASSERT_EQUAL(1, parsed_line.stages[0].background);
+   line_free(&parsed_line);
+
+   // Anything else is an ordinary command named timeout
+   char bad[] = "timeout soon ls";
+   TEST_ASSERT_EQUAL(0, parse_line(bad, &parsed_line));
+   TEST_ASSERT_TRUE(parsed_line.budget.wall == 0);
+   TEST_ASSERT_EQUAL_STRING("timeout", parsed_line.stages[0].argv[0]);
+   line_free(&parsed_line);
+}
+
+void test_parse_duration(void) {
+   TEST_ASSERT_TRUE(parse_duration("30") == 30);
+   TEST_ASSERT_TRUE(parse_duration("0.5s") == 0.5);
+   TEST_ASSERT_TRUE(parse_duration("2m") == 120);
+   TEST_ASSERT_TRUE(parse_duration("1h") == 3600);
+   TEST_ASSERT_TRUE(parse_duration("1d") == 86400);
+   TEST_ASSERT_TRUE(parse_duration("") == -1);
+   TEST_ASSERT_TRUE(parse_duration("-1") == -1);
+   TEST_ASSERT_TRUE(parse_duration("5x") == -1);
+   TEST_ASSERT_TRUE(parse_duration("5ms") == -1);
+   TEST_ASSERT_TRUE(parse_duration("inf") == -1);
+}
+
+void test_jobs_budget_kills_overrunning_job(void) {
+   jobs_init();
+
+   // Ignores SIGTERM, so only the SIGKILL after the grace period ends it
+   pid_t pid = fork();
+   if (pid == 0) {
+      setpgid(0, 0);
+      signal(SIGTERM, SIG_IGN);
+      while (1) {
+         pause();
+      }
+   }
+   setpgid(pid, pid);
+   int id = jobs_add(pid, &pid, 1, "stubborn &", 1);
+   Budget limit = {0.05, 0, 0.05};
+   JobBudget budget;
+   jobs_budget_start(&budget, &limit);
+   jobs_set_budget(pid, &budget);
+
+   // Sleep from one deadline to the next, as the prompt does
+   int checks = 0;
+   double due;
+   while ((due = jobs_enforce_budgets()) > 0 && checks++ < 10) {
+      struct timespec now;
+      clock_gettime(CLOCK_MONOTONIC, &now);
+      double left = due - ((double)now.tv_sec + (double)now.tv_nsec / 1e9);
+      if (left > 0) {
+         struct timespec ts = {(time_t)left, (long)((left - (double)(time_t)left) * 1e9) + 1};
+         nanosleep(&ts, NULL);
+      }
+   }
+   TEST_ASSERT_EQUAL(2, checks); // Woken for the deadline and for the end of the grace period
+
+   struct timespec tick = {0, 10000000};
+   for (int i = 0; i < 200 && jobs_get_status(id) != JOB_DONE; i++) {
+      nanosleep(&tick, NULL);
+      jobs_collect();
+   }
+   TEST_ASSERT_EQUAL(JOB_DONE, jobs_get_status(id));
+   TEST_ASSERT_EQUAL(124, jobs_reap_job(id));
+   TEST_ASSERT_EQUAL(0, jobs_enforce_budgets());
+}
+
+void test_jobs_budget_foreground_status(void) {
+   jobs_init();
+
+   // The SIGTERM that ends the command must not show through as 143
+   char line[] = "timeout 0.05 sleep 5";
+   Line parsed_line;
+   memset(&parsed_line, 0, sizeof(parsed_line));
+   TEST_ASSERT_EQUAL(0, parse_line(line, &parsed_line));
+   int saved = dup(STDERR_FILENO);
+   int null_fd = open("/dev/null", O_WRONLY);
+   dup2(null_fd, STDERR_FILENO);
+   TEST_ASSERT_EQUAL(0, execute_line(&parsed_line));
+   dup2(saved, STDERR_FILENO);
+   close(saved);
+   close(null_fd);
+   TEST_ASSERT_EQUAL(BUDGET_EXIT_CODE, vars_status());
+
+   line_free(&parsed_line);
+   vars_set_status(0);
+}
+
+void test_jobs_usage_merge(void) {
+   JobUsage a = {1.5, 0.25, 1000, 3, 4, 20.0};
+   JobUsage b = {0.5, 0.75, 4000, 1, 1, 10.0};
+   jobs_usage_merge(&a, &b);
+
+   TEST_ASSERT_TRUE(a.user == 2.0);
+   TEST_ASSERT_TRUE(a.sys == 1.0);
+   TEST_ASSERT_EQUAL(4000, a.max_rss); // largest stage, not the sum
+   TEST_ASSERT_EQUAL(4, a.nvcsw);
+   TEST_ASSERT_EQUAL(5, a.nivcsw);
+   TEST_ASSERT_TRUE(a.started == 10.0); // earliest start
+}
+
+void test_jobs_wait_collects_usage(void) {
+   pid_t pid = fork();
+   TEST_ASSERT_TRUE(pid >= 0);
+   if (pid == 0) {
+      // Burn a little CPU so there is something to account for
+      volatile unsigned long x = 0;
+      for (unsigned long i = 0; i < 50000000UL; i++) {
+         x += i;
+      }
+      _exit(0);
+   }
+
+   JobUsage usage = {0};
+   int status = 0;
+   TEST_ASSERT_EQUAL(pid, jobs_wait(pid, &status, 0, &usage));
+   TEST_ASSERT_TRUE(WIFEXITED(status));
+   TEST_ASSERT_TRUE(usage.user + usage.sys > 0);
+   TEST_ASSERT_TRUE(usage.max_rss > 0);
+}
+
+// ============================================================================
+// Job Table Tests
+// ============================================================================
+
+/**
+ * @brief Run jobs_reap_done_and_print() with its "Done" lines discarded
+ */
+static void reap_quietly(void) {
+   fflush(stdout);
+   int saved = dup(STDOUT_FILENO);
+   int devnull = open("/dev/null", O_WRONLY);
+   dup2(devnull, STDOUT_FILENO);
+   close(devnull);
+   jobs_reap_done_and_print();
+   fflush(stdout);
+   dup2(saved, STDOUT_FILENO);
+   close(saved);
+}
+
+void test_jobs_table_grows(void) {
+   // Well past the old fixed table of 20; the pgids are never signalled
+   const int n = 5000;
+   jobs_init();
+   for (int i = 0; i < n; i++) {
+      char cmd[32];
+      snprintf(cmd, sizeof(cmd), "job%d &", i);
+      TEST_ASSERT_EQUAL(i + 1, jobs_add(100000 + i, NULL, 0, cmd, 1));
+   }
+   TEST_ASSERT_EQUAL(n, jobs_count());
+   TEST_ASSERT_EQUAL(100000 + 1234, jobs_get_pgid(1235));
+   TEST_ASSERT_EQUAL_STRING("job1234 &", jobs_get_cmdline(1235));
+   TEST_ASSERT_EQUAL(n, jobs_pick_most_recent_for_fg());
+   TEST_ASSERT_EQUAL(-1, jobs_pick_most_recent_stopped_for_bg());
+
+   // Finish every even job; the rest keep their ids
+   for (int i = 0; i < n; i += 2) {
+      jobs_mark(100000 + i, JOB_DONE);
+   }
+   reap_quietly();
+   TEST_ASSERT_EQUAL(n / 2, jobs_count());
+   TEST_ASSERT_EQUAL(-1, jobs_get_pgid(1));
+   TEST_ASSERT_EQUAL(100001, jobs_get_pgid(2));
+
+   jobs_mark(100001, JOB_STOPPED);
+   TEST_ASSERT_EQUAL(2, jobs_pick_most_recent_stopped_for_bg());
+   jobs_init();
+   TEST_ASSERT_EQUAL(0, jobs_count());
+}
+
+void test_jobs_ids_follow_highest_live_job(void) {
+   jobs_init();
+   TEST_ASSERT_EQUAL(1, jobs_add(501, NULL, 0, "a &", 1));
+   TEST_ASSERT_EQUAL(2, jobs_add(502, NULL, 0, "b &", 1));
+   TEST_ASSERT_EQUAL(3, jobs_add(503, NULL, 0, "c &", 1));
+
+   // Like bash: a freed id is reused only once nothing above it is left
+   jobs_mark(502, JOB_DONE);
+   reap_quietly();
+   TEST_ASSERT_EQUAL(4, jobs_add(504, NULL, 0, "d &", 1));
+   jobs_mark(503, JOB_DONE);
+   jobs_mark(504, JOB_DONE);
+   reap_quietly();
+   TEST_ASSERT_EQUAL(2, jobs_add(505, NULL, 0, "e &", 1));
+
+   // A pgid that is done no longer matches, so a reused pgid finds the new job
+   jobs_mark(505, JOB_DONE);
+   TEST_ASSERT_EQUAL(3, jobs_add(505, NULL, 0, "f &", 1));
+   jobs_mark(505, JOB_STOPPED);
+   TEST_ASSERT_EQUAL(3, jobs_pick_most_recent_stopped_for_bg());
+   jobs_init();
+}
+
+void test_jobs_process_event_tracks_every_stage(void) {
+   // Wait statuses are built by hand; the pids are never signalled
+   const int stopped = 0x7f | SIGTSTP << 8;
+   pid_t pids[] = {601, 602, 603};
+   jobs_init();
+   TEST_ASSERT_EQUAL(1, jobs_add(601, pids, 3, "a | b | c &", 1));
+
+   // The group leader exiting first leaves the job running (the old getpgid() lookup lost it)
+   jobs_process_event(601, 0, NULL);
+   TEST_ASSERT_EQUAL(JOB_RUNNING, jobs_get_status(1));
+
+   // Stopped only once every live stage has stopped
+   jobs_process_event(602, stopped, NULL);
+   TEST_ASSERT_EQUAL(JOB_RUNNING, jobs_get_status(1));
+   jobs_process_event(603, stopped, NULL);
+   TEST_ASSERT_EQUAL(JOB_STOPPED, jobs_get_status(1));
+
+   // Done when the last stage goes, however it went
+   jobs_mark(601, JOB_RUNNING);
+   jobs_process_event(602, 0, NULL);
+   TEST_ASSERT_EQUAL(JOB_RUNNING, jobs_get_status(1));
+   jobs_process_event(603, SIGKILL, NULL);
+   TEST_ASSERT_EQUAL(JOB_DONE, jobs_get_status(1));
+
+   // A reaped pid belongs to nobody
+   TEST_ASSERT_EQUAL(2, jobs_add(700, NULL, 0, "d &", 1));
+   jobs_process_event(603, stopped, NULL);
+   TEST_ASSERT_EQUAL(JOB_RUNNING, jobs_get_status(2));
+   reap_quietly();
+   TEST_ASSERT_EQUAL(1, jobs_count());
+   jobs_init();
+}
+
+void test_jobs_adopt_orphaned_grandchild(void) {
+   if (options_set("subreaper", 1) == -1) TEST_IGNORE_MESSAGE("no child subreapers here");
+   jobs_init();
+
+   // The child starts a grandchild in its own group and exits, orphaning it
+   int fds[2];
+   TEST_ASSERT_EQUAL(0, pipe(fds));
+   pid_t child = fork();
+   if (child == 0) {
+      setpgid(0, 0);
+      pid_t grandchild = fork();
+      if (grandchild == 0) {
+         pause();
+         _exit(0);
+      }
+      TEST_ASSERT_EQUAL(sizeof(pid_t), write(fds[1], &grandchild, sizeof(pid_t)));
+      _exit(0);
+   }
+   setpgid(child, child);
+   pid_t grandchild;
+   TEST_ASSERT_EQUAL(sizeof(pid_t), read(fds[0], &grandchild, sizeof(pid_t)));
+   close(fds[0]);
+   close(fds[1]);
+   int id = jobs_add(child, &child, 1, "daemonize &", 1);
+
+   // Until the child has been reaped and its orphan handed to us
+   struct timespec tick = {0, 10000000};
+   pid_t live = 0;
+   for (int i = 0; i < 200 && live != grandchild; i++) {
+      nanosleep(&tick, NULL);
+      jobs_collect();
+      if (jobs_live_pids(id, &live, 1) != 1) live = 0;
+   }
+   TEST_ASSERT_EQUAL(grandchild, live);
+   TEST_ASSERT_EQUAL(JOB_RUNNING, jobs_get_status(id));
+
+   // The job is done once the orphan is too, and its exit went through the normal reaping
+   kill(grandchild, SIGKILL);
+   for (int i = 0; i < 200 && jobs_get_status(id) != JOB_DONE; i++) {
+      nanosleep(&tick, NULL);
+      jobs_collect();
+   }
+   TEST_ASSERT_EQUAL(JOB_DONE, jobs_get_status(id));
+   TEST_ASSERT_EQUAL(0, jobs_reap_job(id));
+
+   options_set("subreaper", 0);
+   jobs_init();
 }
 
 // Test functions are called from test_runner.c
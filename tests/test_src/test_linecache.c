@@ -0,0 +1,129 @@
+#include "../../include/funcs.h"
+#include "../../include/linecache.h"
+#include "../../include/options.h"
+#include "../../include/parse.h"
+#include "../../include/yash.h"
+#include "unity.h"
+#include <string.h>
+
+// setUp and tearDown are defined in test_runner.c
+
+// ============================================================================
+// Helpers
+// ============================================================================
+
+/**
+ * @brief Parse through the cache, expecting success
+ */
+static Line* cached(const char* text) {
+   Line* line;
+   TEST_ASSERT_EQUAL_MESSAGE(0, linecache_parse(text, &line), text);
+   TEST_ASSERT_NOT_NULL(line);
+   return line;
+}
+
+/**
+ * @brief Hits and misses since @p before
+ */
+static void assert_counts(const LineCacheStats* before, unsigned long hits, unsigned long misses) {
+   LineCacheStats now;
+   linecache_stats(&now);
+   TEST_ASSERT_EQUAL(hits, now.hits - before->hits);
+   TEST_ASSERT_EQUAL(misses, now.misses - before->misses);
+}
+
+// ============================================================================
+// Tests
+// ============================================================================
+
+void test_linecache_hit_reuses_parsed_line(void) {
+   LineCacheStats before;
+   linecache_clear();
+   shell_options.line_cache = 4;
+   linecache_stats(&before);
+
+   Line* first = cached("cat < in | sort > out ; echo done");
+   TEST_ASSERT_EQUAL(first, cached("cat < in | sort > out ; echo done"));
+   TEST_ASSERT_EQUAL_STRING("sort", first->stages[1].argv[0]);
+   TEST_ASSERT_EQUAL_STRING("echo done", first->next->original);
+   assert_counts(&before, 1, 1);
+
+   // The same text with anything changed is another line
+   TEST_ASSERT_NOT_EQUAL(first, cached("cat < in | sort > out ; echo done "));
+   assert_counts(&before, 1, 2);
+
+   // Invalid and unfinished lines are not kept
+   Line* line;
+   TEST_ASSERT_EQUAL(-1, linecache_parse("ls | | wc", &line));
+   TEST_ASSERT_NULL(line);
+   TEST_ASSERT_EQUAL(PARSE_INCOMPLETE, linecache_parse("while true ; do", &line));
+   LineCacheStats now;
+   linecache_stats(&now);
+   TEST_ASSERT_EQUAL(2, now.lines);
+
+   linecache_clear();
+   shell_options.line_cache = LINECACHE_DEFAULT_SIZE;
+}
+
+void test_linecache_evicts_least_recently_used(void) {
+   LineCacheStats before;
+   linecache_clear();
+   TEST_ASSERT_EQUAL(0, options_set("linecache=2", 1));
+   TEST_ASSERT_EQUAL(-1, options_set("linecache=-1", 1));
+   TEST_ASSERT_EQUAL(2, shell_options.line_cache);
+   linecache_stats(&before);
+
+   cached("echo a");
+   cached("echo b");
+   cached("echo a");
+   cached("echo c");
+   assert_counts(&before, 1, 3);
+
+   // b was used least recently, so c took its place
+   cached("echo a");
+   cached("echo b");
+   assert_counts(&before, 2, 4);
+
+   // A smaller limit takes effect at the next lookup
+   shell_options.line_cache = 1;
+   cached("echo b");
+   LineCacheStats now;
+   linecache_stats(&now);
+   TEST_ASSERT_EQUAL(1, now.lines);
+   assert_counts(&before, 3, 4);
+
+   // Turned off, lines are parsed every time and nothing is counted
+   TEST_ASSERT_EQUAL(0, options_set("linecache", 0));
+   TEST_ASSERT_EQUAL_STRING("b", cached("echo b")->stages[0].argv[1]);
+   linecache_stats(&now);
+   TEST_ASSERT_EQUAL(0, now.lines);
+   assert_counts(&before, 3, 4);
+
+   linecache_clear();
+   TEST_ASSERT_EQUAL(0, options_set("linecache", 1));
+   TEST_ASSERT_EQUAL(LINECACHE_DEFAULT_SIZE, shell_options.line_cache);
+}
+
+void test_linecache_invalidated_by_function_change(void) {
+   LineCacheStats before;
+   linecache_clear();
+   linecache_stats(&before);
+
+   Line* line = cached("yash_lc a b");
+   TEST_ASSERT_EQUAL(line, cached("yash_lc a b"));
+   assert_counts(&before, 1, 1);
+
+   TEST_ASSERT_EQUAL(0, funcs_define("yash_lc", "yash_lc() { true ; }"));
+   cached("yash_lc a b");
+   assert_counts(&before, 1, 2);
+   cached("yash_lc a b");
+   assert_counts(&before, 2, 2);
+
+   TEST_ASSERT_EQUAL(0, funcs_unset("yash_lc"));
+   cached("yash_lc a b");
+   assert_counts(&before, 2, 3);
+
+   linecache_clear();
+}
+
+// Test functions are called from test_runner.c
@@ -0,0 +1,223 @@
+#include "../../include/parallel.h"
+#include "unity.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// setUp and tearDown are defined in test_runner.c
+
+// ============================================================================
+// Helpers
+// ============================================================================
+
+/**
+ * @brief Source of `sleep 0.1` tasks that checks how many run at once
+ */
+typedef struct SleepTasks {
+   int total;    ///< Tasks to hand out
+   int running;  ///< Started and not reported done
+   int peak;     ///< Largest value of running
+   int finished; ///< Reported done
+} SleepTasks;
+
+static int sleep_next(void* ctx, int task, Command* cmd) {
+   SleepTasks* t = ctx;
+   if (task >= t->total) return -1;
+   static char* argv[] = {"sleep", "0.1", NULL};
+   cmd->argv = argv;
+   if (++t->running > t->peak) t->peak = t->running;
+   return 1;
+}
+
+static void sleep_done(void* ctx, int task, int status, double seconds) {
+   SleepTasks* t = ctx;
+   (void)task;
+   TEST_ASSERT_EQUAL(0, status);
+   TEST_ASSERT_TRUE(seconds >= 0.05);
+   t->running--;
+   t->finished++;
+}
+
+/**
+ * @brief Run a fan-out builtin with stdout captured into buf and stderr discarded
+ * @param run builtin_parallel or builtin_xargs
+ * @param argv
+ * @param input File to use as stdin, NULL to keep the test runner's
+ * @return Its exit status
+ */
+static int run_captured(int (*run)(char* const[]),
+                        char* const argv[],
+                        const char* input,
+                        char* buf,
+                        size_t len) {
+   char path[] = "/tmp/yash_parallel_XXXXXX";
+   int fd = mkstemp(path);
+   TEST_ASSERT_TRUE(fd >= 0);
+   int null = open("/dev/null", O_WRONLY);
+   int in = input ? open(input, O_RDONLY) : -1;
+
+   fflush(stdout);
+   int saved_in = dup(STDIN_FILENO);
+   int saved_out = dup(STDOUT_FILENO);
+   int saved_err = dup(STDERR_FILENO);
+   if (in != -1) dup2(in, STDIN_FILENO);
+   dup2(fd, STDOUT_FILENO);
+   dup2(null, STDERR_FILENO);
+   int status = run(argv);
+   fflush(stdout);
+   dup2(saved_in, STDIN_FILENO);
+   dup2(saved_out, STDOUT_FILENO);
+   dup2(saved_err, STDERR_FILENO);
+   close(saved_in);
+   close(saved_out);
+   close(saved_err);
+   close(null);
+   if (in != -1) close(in);
+
+   lseek(fd, 0, SEEK_SET);
+   ssize_t n = read(fd, buf, len - 1);
+   buf[n > 0 ? n : 0] = '\0';
+   close(fd);
+   unlink(path);
+   return status;
+}
+
+/**
+ * @brief Run `parallel` with stdout captured into buf and stderr discarded
+ * @return Its exit status
+ */
+static int run_parallel(char* const argv[], char* buf, size_t len) {
+   return run_captured(builtin_parallel, argv, NULL, buf, len);
+}
+
+/**
+ * @brief Run `xargs` on the given input with stdout captured into buf and stderr discarded
+ * @return Its exit status
+ */
+static int run_xargs(char* const argv[], const char* input, char* buf, size_t len) {
+   FILE* f = fopen("/tmp/yash_xargs_in", "w");
+   TEST_ASSERT_NOT_NULL(f);
+   fputs(input, f);
+   fclose(f);
+   int status = run_captured(builtin_xargs, argv, "/tmp/yash_xargs_in", buf, len);
+   unlink("/tmp/yash_xargs_in");
+   return status;
+}
+
+// ============================================================================
+// Fan-out Tests
+// ============================================================================
+
+void test_fanout_bounds_concurrency(void) {
+   SleepTasks t = {6, 0, 0, 0};
+   FanoutSource src = {sleep_next, sleep_done, &t};
+   FanoutStats stats;
+   TEST_ASSERT_EQUAL(0, fanout_run(&src, 2, 0, -1, &stats));
+
+   TEST_ASSERT_EQUAL(6, t.finished);
+   TEST_ASSERT_EQUAL(2, t.peak);
+   TEST_ASSERT_EQUAL(6, stats.started);
+   TEST_ASSERT_EQUAL(0, stats.failed);
+   // Never more than two at once, so at least three rounds
+   TEST_ASSERT_TRUE(stats.seconds >= 0.3);
+}
+
+void test_parallel_keeps_input_order(void) {
+   // The first value finishes last
+   char* argv[] = {"parallel", "-k", "-j",  "3",  "sh", "-c", "sleep $0; echo $0",
+                   ":::",      "0.2", "0", "0.1", NULL};
+   char out[64];
+   TEST_ASSERT_EQUAL(0, run_parallel(argv, out, sizeof(out)));
+   TEST_ASSERT_EQUAL_STRING("0.2\n0\n0.1\n", out);
+}
+
+void test_parallel_substitutes_and_counts_failures(void) {
+   char* argv[] = {"parallel", "-k", "echo", "x{}y{}", ":::", "1", "2", NULL};
+   char out[64];
+   TEST_ASSERT_EQUAL(0, run_parallel(argv, out, sizeof(out)));
+   TEST_ASSERT_EQUAL_STRING("x1y1\nx2y2\n", out);
+
+   char* failing[] = {"parallel", "-j", "2", "sh", "-c", "exit $0", ":::", "0", "3", "1", NULL};
+   TEST_ASSERT_EQUAL(2, run_parallel(failing, out, sizeof(out)));
+
+   char* usage[] = {"parallel", "-j", "2", NULL};
+   TEST_ASSERT_EQUAL(2, run_parallel(usage, out, sizeof(out)));
+}
+
+// ============================================================================
+// xargs Tests
+// ============================================================================
+
+void test_xargs_batches_past_arg_max(void) {
+   // Far more than one exec can take, so it has to be split
+   long arg_max = sysconf(_SC_ARG_MAX);
+   if (arg_max <= 0 || arg_max > 16 * 1024 * 1024) TEST_IGNORE_MESSAGE("ARG_MAX too large");
+   int items = (int)(arg_max / 8);
+   char* input = malloc((size_t)items * 8 + 1);
+   TEST_ASSERT_NOT_NULL(input);
+   char* p = input;
+   for (int i = 0; i < items; i++) {
+      p += sprintf(p, "%06d\n", i % 1000000);
+   }
+
+   char* argv[] = {"xargs", "-P", "2", "sh", "-c", "echo $#", "sh", NULL};
+   char out[4096];
+   FILE* f = fopen("/tmp/yash_xargs_in", "w");
+   TEST_ASSERT_NOT_NULL(f);
+   fputs(input, f);
+   fclose(f);
+   free(input);
+   TEST_ASSERT_EQUAL(0, run_captured(builtin_xargs, argv, "/tmp/yash_xargs_in", out, sizeof(out)));
+   unlink("/tmp/yash_xargs_in");
+
+   int batches = 0;
+   int total = 0;
+   for (char* save = NULL, *line = strtok_r(out, "\n", &save); line;
+        line = strtok_r(NULL, "\n", &save)) {
+      total += atoi(line);
+      batches++;
+   }
+   TEST_ASSERT_EQUAL(items, total);
+   // Each item takes 15 bytes of the argument area (6 digits, NUL, pointer): two runs, or three
+   TEST_ASSERT_TRUE(batches >= 2 && batches <= 3);
+}
+
+void test_xargs_quotes_and_limits(void) {
+   char out[256];
+   char* pairs[] = {"xargs", "-n", "2", NULL};
+   TEST_ASSERT_EQUAL(0, run_xargs(pairs, "a 'b c'\n d\\ e \"f\"g\n\n", out, sizeof(out)));
+   TEST_ASSERT_EQUAL_STRING("a b c\nd e fg\n", out);
+
+   // -s counts strings, NULs and pointers: "echo" takes 13 + 8 (NULL) bytes, each item 10
+   char* sized[] = {"xargs", "-s", "41", "echo", NULL};
+   TEST_ASSERT_EQUAL(0, run_xargs(sized, "a b c d e", out, sizeof(out)));
+   TEST_ASSERT_EQUAL_STRING("a b\nc d\ne\n", out);
+
+   char* nul[] = {"xargs", "-0", NULL};
+   FILE* f = fopen("/tmp/yash_xargs_nul", "w");
+   TEST_ASSERT_NOT_NULL(f);
+   fwrite("x y\0z\0", 1, 6, f);
+   fclose(f);
+   TEST_ASSERT_EQUAL(0, run_captured(builtin_xargs, nul, "/tmp/yash_xargs_nul", out, sizeof(out)));
+   unlink("/tmp/yash_xargs_nul");
+   TEST_ASSERT_EQUAL_STRING("x y z\n", out);
+
+   char* skip[] = {"xargs", "-r", "echo", "never", NULL};
+   TEST_ASSERT_EQUAL(0, run_xargs(skip, "\n", out, sizeof(out)));
+   TEST_ASSERT_EQUAL_STRING("", out);
+
+   char* failing[] = {"xargs", "-n", "1", "sh", "-c", "exit $0", NULL};
+   TEST_ASSERT_EQUAL(123, run_xargs(failing, "0 1 0", out, sizeof(out)));
+   char* missing[] = {"xargs", "yash_no_such_command_xyz", NULL};
+   TEST_ASSERT_EQUAL(127, run_xargs(missing, "a", out, sizeof(out)));
+
+   // Nothing runs when an item cannot fit, or the input does not split
+   char* tight[] = {"xargs", "-s", "35", "echo", NULL};
+   TEST_ASSERT_EQUAL(1, run_xargs(tight, "fits much-too-long", out, sizeof(out)));
+   TEST_ASSERT_EQUAL_STRING("", out);
+   TEST_ASSERT_EQUAL(1, run_xargs(pairs, "a 'b", out, sizeof(out)));
+}
+
+// Test functions are called from test_runner.c
@@ -1,18 +1,26 @@
+#include "../../include/lex.h"
 #include "../../include/parse.h"
 #include "../../include/yash.h"
 #include "unity.h"
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 // setUp and tearDown are defined in test_runner.c
 
+/** @brief Token array size for the short lines tokenized here */
+#define TEST_TOKENS 64
+
+/** @brief Words in the lines that used to be over the old 2000-token cap */
+#define MANY_TOKENS 5000
+
 // ============================================================================
 // Basic Tokenization Tests
 // ============================================================================
 
 void test_tokenize_simple_command(void) {
    char line[] = "ls -la";
-   char* tokens[MAX_TOKENS];
+   char* tokens[TEST_TOKENS];
    int num_tokens = 0;
 
    int result = tokenize_line(line, tokens, &num_tokens);
@@ -25,7 +33,7 @@ void test_tokenize_simple_command(void) {
 
 void test_tokenize_command_with_spaces(void) {
    char line[] = "  echo   hello   world  ";
-   char* tokens[MAX_TOKENS];
+   char* tokens[TEST_TOKENS];
    int num_tokens = 0;
 
    int result = tokenize_line(line, tokens, &num_tokens);
@@ -39,7 +47,7 @@ void test_tokenize_command_with_spaces(void) {
 
 void test_tokenize_empty_line(void) {
    char line[] = "";
-   char* tokens[MAX_TOKENS];
+   char* tokens[TEST_TOKENS];
    int num_tokens = 0;
 
    int result = tokenize_line(line, tokens, &num_tokens);
@@ -50,7 +58,7 @@ void test_tokenize_empty_line(void) {
 
 void test_tokenize_whitespace_only(void) {
    char line[] = "   \t  \t  ";
-   char* tokens[MAX_TOKENS];
+   char* tokens[TEST_TOKENS];
    int num_tokens = 0;
 
    int result = tokenize_line(line, tokens, &num_tokens);
@@ -65,7 +73,7 @@ void test_tokenize_whitespace_only(void) {
 
 void test_tokenize_input_redirection(void) {
    char line[] = "cat < input.txt";
-   char* tokens[MAX_TOKENS];
+   char* tokens[TEST_TOKENS];
    int num_tokens = 0;
 
    int result = tokenize_line(line, tokens, &num_tokens);
@@ -79,7 +87,7 @@ void test_tokenize_input_redirection(void) {
 
 void test_tokenize_output_redirection(void) {
    char line[] = "ls > output.txt";
-   char* tokens[MAX_TOKENS];
+   char* tokens[TEST_TOKENS];
    int num_tokens = 0;
 
    int result = tokenize_line(line, tokens, &num_tokens);
@@ -93,7 +101,7 @@ void test_tokenize_output_redirection(void) {
 
 void test_tokenize_error_redirection(void) {
    char line[] = "ls 2> error.txt";
-   char* tokens[MAX_TOKENS];
+   char* tokens[TEST_TOKENS];
    int num_tokens = 0;
 
    int result = tokenize_line(line, tokens, &num_tokens);
@@ -107,7 +115,7 @@ void test_tokenize_error_redirection(void) {
 
 void test_tokenize_multiple_redirections(void) {
    char line[] = "cat < input.txt > output.txt 2> error.txt";
-   char* tokens[MAX_TOKENS];
+   char* tokens[TEST_TOKENS];
    int num_tokens = 0;
 
    int result = tokenize_line(line, tokens, &num_tokens);
@@ -129,7 +137,7 @@ void test_tokenize_multiple_redirections(void) {
 
 void test_tokenize_simple_pipe(void) {
    char line[] = "ls | grep test";
-   char* tokens[MAX_TOKENS];
+   char* tokens[TEST_TOKENS];
    int num_tokens = 0;
 
    int result = tokenize_line(line, tokens, &num_tokens);
@@ -144,7 +152,7 @@ void test_tokenize_simple_pipe(void) {
 
 void test_tokenize_pipe_with_redirections(void) {
    char line[] = "cat < input.txt | grep test > output.txt";
-   char* tokens[MAX_TOKENS];
+   char* tokens[TEST_TOKENS];
    int num_tokens = 0;
 
    int result = tokenize_line(line, tokens, &num_tokens);
@@ -167,7 +175,7 @@ void test_tokenize_pipe_with_redirections(void) {
 
 void test_tokenize_background_command(void) {
    char line[] = "sleep 5 &";
-   char* tokens[MAX_TOKENS];
+   char* tokens[TEST_TOKENS];
    int num_tokens = 0;
 
    int result = tokenize_line(line, tokens, &num_tokens);
@@ -181,7 +189,7 @@ void test_tokenize_background_command(void) {
 
 void test_tokenize_background_with_redirection(void) {
    char line[] = "ls > output.txt &";
-   char* tokens[MAX_TOKENS];
+   char* tokens[TEST_TOKENS];
    int num_tokens = 0;
 
    int result = tokenize_line(line, tokens, &num_tokens);
@@ -199,49 +207,50 @@ void test_tokenize_background_with_redirection(void) {
 // ============================================================================
 
 void test_tokenize_max_tokens(void) {
-   // Create a line with exactly MAX_TOKENS tokens
-   char line[MAX_CMDLINE];
-   int pos = 0;
-   for (int i = 0; i < MAX_TOKENS - 1; i++) {
-      pos += snprintf(line + pos, MAX_CMDLINE - pos, "token%d ", i);
-   }
-   snprintf(line + pos, MAX_CMDLINE - pos, "token%d", MAX_TOKENS - 1);
-
-   char* tokens[MAX_TOKENS];
+   // A line packed with one-letter words holds the most tokens its length allows
+   char line[] = "a b c d e f g";
+   char* tokens[sizeof(line) / 2]; // (strlen(line) + 1) / 2
    int num_tokens = 0;
 
    int result = tokenize_line(line, tokens, &num_tokens);
 
    TEST_ASSERT_EQUAL(0, result);
-   TEST_ASSERT_EQUAL(MAX_TOKENS, num_tokens);
+   TEST_ASSERT_EQUAL(7, num_tokens);
+   TEST_ASSERT_EQUAL_STRING("g", tokens[6]);
 }
 
 void test_tokenize_too_many_tokens(void) {
-   // Create a line with more than MAX_TOKENS tokens
-   char line[MAX_CMDLINE];
-   int pos = 0;
-   for (int i = 0; i < MAX_TOKENS; i++) {
-      pos += snprintf(line + pos, MAX_CMDLINE - pos, "token%d ", i);
+   // There is no token count limit any more
+   size_t size = MANY_TOKENS * 12;
+   char* line = malloc(size);
+   char** tokens = malloc(MANY_TOKENS * sizeof(char*));
+   TEST_ASSERT_NOT_NULL(line);
+   TEST_ASSERT_NOT_NULL(tokens);
+   size_t pos = 0;
+   for (int i = 0; i < MANY_TOKENS; i++) {
+      pos += snprintf(line + pos, size - pos, "token%d ", i);
    }
 
-   char* tokens[MAX_TOKENS];
    int num_tokens = 0;
-
    int result = tokenize_line(line, tokens, &num_tokens);
 
-   TEST_ASSERT_EQUAL(-1, result);
+   TEST_ASSERT_EQUAL(0, result);
+   TEST_ASSERT_EQUAL(MANY_TOKENS, num_tokens);
+   TEST_ASSERT_EQUAL_STRING("token4999", tokens[MANY_TOKENS - 1]);
+   free(tokens);
+   free(line);
 }
 
 void test_tokenize_max_token_length(void) {
-   // Create a token of exactly MAX_TOKEN_LEN characters
-   char long_token[MAX_TOKEN_LEN + 1];
-   memset(long_token, 'a', MAX_TOKEN_LEN);
-   long_token[MAX_TOKEN_LEN] = '\0';
+   // Tokens are as long as the line lets them be
+   char long_token[4097];
+   memset(long_token, 'a', sizeof(long_token) - 1);
+   long_token[sizeof(long_token) - 1] = '\0';
 
-   char line[MAX_CMDLINE];
-   snprintf(line, MAX_CMDLINE, "ls %s", long_token);
+   char line[sizeof(long_token) + 3];
+   snprintf(line, sizeof(line), "ls %s", long_token);
 
-   char* tokens[MAX_TOKENS];
+   char* tokens[TEST_TOKENS];
    int num_tokens = 0;
 
    int result = tokenize_line(line, tokens, &num_tokens);
@@ -253,7 +262,7 @@ void test_tokenize_max_token_length(void) {
 }
 
 void test_tokenize_null_parameters(void) {
-   char* tokens[MAX_TOKENS];
+   char* tokens[TEST_TOKENS];
    int num_tokens = 0;
 
    // Test with NULL line
@@ -275,7 +284,7 @@ void test_tokenize_null_parameters(void) {
 
 void test_tokenize_complex_command(void) {
    char line[] = "find . -name '*.c' | grep -v test | wc -l > count.txt 2> errors.log &";
-   char* tokens[MAX_TOKENS];
+   char* tokens[TEST_TOKENS];
    int num_tokens = 0;
 
    int result = tokenize_line(line, tokens, &num_tokens);
@@ -313,13 +322,17 @@ void test_parse_line_simple_command(void) {
 
    TEST_ASSERT_EQUAL(0, result);
    TEST_ASSERT_EQUAL_STRING("ls -la", parsed_line.original);
+
+   line_free(&parsed_line);
 }
 
 void test_parse_line_too_long(void) {
-   // Create a line that's too long (over MAX_CMDLINE)
-   char line[MAX_CMDLINE + 10];
-   memset(line, 'a', MAX_CMDLINE + 9);
-   line[MAX_CMDLINE + 9] = '\0';
+   // A line of parse_line_max() characters has no room for its terminator under ARG_MAX
+   size_t max = parse_line_max();
+   char* line = malloc(max + 1);
+   TEST_ASSERT_NOT_NULL(line);
+   memset(line, 'a', max);
+   line[max] = '\0';
 
    Line parsed_line;
    memset(&parsed_line, 0, sizeof(parsed_line));
@@ -327,6 +340,63 @@ void test_parse_line_too_long(void) {
    int result = parse_line(line, &parsed_line);
 
    TEST_ASSERT_EQUAL(-1, result);
+   TEST_ASSERT_NULL(parsed_line.arena.head);
+
+   // One character shorter fits
+   memset(line, 'a', max);
+   line[max - 1] = '\0';
+   TEST_ASSERT_EQUAL(0, parse_line(line, &parsed_line));
+   TEST_ASSERT_EQUAL(max - 1, strlen(parsed_line.stages[0].argv[0]));
+
+   line_free(&parsed_line);
+   free(line);
+}
+
+void test_parse_line_many_args(void) {
+   // Far past the old caps of 64 arguments and 2000 characters
+   size_t size = MANY_TOKENS * 12;
+   char* line = malloc(size);
+   TEST_ASSERT_NOT_NULL(line);
+   size_t pos = snprintf(line, size, "echo");
+   for (int i = 0; i < MANY_TOKENS; i++) {
+      pos += snprintf(line + pos, size - pos, " arg%d", i);
+   }
+   snprintf(line + pos, size - pos, " | wc -l");
+
+   Line parsed_line;
+   memset(&parsed_line, 0, sizeof(parsed_line));
+   TEST_ASSERT_EQUAL(0, parse_line(line, &parsed_line));
+   TEST_ASSERT_EQUAL(2, parsed_line.num_stages);
+   TEST_ASSERT_EQUAL_STRING("arg4999", parsed_line.stages[0].argv[MANY_TOKENS]);
+   TEST_ASSERT_NULL(parsed_line.stages[0].argv[MANY_TOKENS + 1]);
+   TEST_ASSERT_EQUAL_STRING("wc", parsed_line.stages[1].argv[0]);
+   TEST_ASSERT_EQUAL(0, strncmp(parsed_line.original, "echo arg0 arg1 ", 15));
+
+   line_free(&parsed_line);
+   free(line);
+}
+
+void test_parse_line_reuses_arena(void) {
+   char first[] = "cat < in.txt | sort | uniq -c > out.txt";
+   char second[] = "ls -la";
+   Line parsed_line;
+   memset(&parsed_line, 0, sizeof(parsed_line));
+
+   TEST_ASSERT_EQUAL(0, parse_line(first, &parsed_line));
+   ArenaBlock* block = parsed_line.arena.head;
+   size_t total = parsed_line.arena.total;
+   TEST_ASSERT_NOT_NULL(block);
+
+   // The next line into the same Line is served from the same memory
+   TEST_ASSERT_EQUAL(0, parse_line(second, &parsed_line));
+   TEST_ASSERT_EQUAL_PTR(block, parsed_line.arena.head);
+   TEST_ASSERT_EQUAL(total, parsed_line.arena.total);
+   TEST_ASSERT_EQUAL_STRING("ls -la", parsed_line.original);
+   TEST_ASSERT_EQUAL_STRING("-la", parsed_line.stages[0].argv[1]);
+   TEST_ASSERT_NULL(parsed_line.stages[0].in_file);
+
+   line_free(&parsed_line);
+   TEST_ASSERT_NULL(parsed_line.arena.head);
 }
 
 void test_parse_line_empty(void) {
@@ -337,6 +407,8 @@ void test_parse_line_empty(void) {
    int result = parse_line(line, &parsed_line);
 
    TEST_ASSERT_EQUAL(-1, result);
+
+   line_free(&parsed_line);
 }
 
 void test_parse_line_whitespace_only(void) {
@@ -347,6 +419,207 @@ void test_parse_line_whitespace_only(void) {
    int result = parse_line(line, &parsed_line);
 
    TEST_ASSERT_EQUAL(-1, result);
+
+   line_free(&parsed_line);
+}
+
+// ============================================================================
+// Command List Tests
+// ============================================================================
+
+void test_parse_line_list(void) {
+   char line[] = "make ; make test && echo ok || echo failed > log 2> err ; sleep 5 & ls | wc -l";
+   Line parsed_line;
+   memset(&parsed_line, 0, sizeof(parsed_line));
+
+   TEST_ASSERT_EQUAL(0, parse_line(line, &parsed_line));
+
+   const char* originals[] = {
+       "make", "make test", "echo ok", "echo failed > log 2> err", "sleep 5 &", "ls | wc -l"};
+   const ListOp ops[] = {LIST_SEQ, LIST_AND, LIST_OR, LIST_SEQ, LIST_SEQ, LIST_END};
+   const Line* e = &parsed_line;
+   for (int i = 0; i < 6; i++) {
+      TEST_ASSERT_NOT_NULL(e);
+      TEST_ASSERT_EQUAL_STRING(originals[i], e->original);
+      TEST_ASSERT_EQUAL(ops[i], e->op);
+      e = e->next;
+   }
+   TEST_ASSERT_NULL(e);
+
+   e = parsed_line.next->next->next;
+   TEST_ASSERT_EQUAL_STRING("log", e->stages[0].out_file);
+   TEST_ASSERT_EQUAL_STRING("err", e->stages[0].err_file);
+   TEST_ASSERT_EQUAL(1, e->next->stages[0].background);
+   TEST_ASSERT_EQUAL(1, e->next->next->is_pipeline);
+   TEST_ASSERT_EQUAL(0, e->next->next->stages[0].background);
+
+   line_free(&parsed_line);
+}
+
+void test_parse_line_list_prefixes_per_element(void) {
+   char line[] = "time true ; submit -p 2 sleep 1 && timeout 5 sleep 2 ;";
+   Line parsed_line;
+   memset(&parsed_line, 0, sizeof(parsed_line));
+
+   TEST_ASSERT_EQUAL(0, parse_line(line, &parsed_line));
+
+   const Line* submit = parsed_line.next;
+   TEST_ASSERT_EQUAL(1, parsed_line.timed);
+   TEST_ASSERT_EQUAL(0, submit->timed);
+   TEST_ASSERT_EQUAL(2, submit->priority);
+   TEST_ASSERT_EQUAL_STRING("sleep 1", submit->original + submit->submit_at);
+   TEST_ASSERT_TRUE(submit->next->budget.wall == 5);
+   TEST_ASSERT_EQUAL_STRING("sleep", submit->next->stages[0].argv[0]);
+   // A trailing `;` ends the list
+   TEST_ASSERT_EQUAL(LIST_END, submit->next->op);
+
+   line_free(&parsed_line);
+}
+
+void test_parse_line_list_invalid(void) {
+   char lines[][32] = {"; ls", "ls ; ; pwd", "ls &&", "ls || || pwd", "ls && & pwd", "&& ls"};
+
+   for (int i = 0; i < 6; i++) {
+      Line parsed_line;
+      memset(&parsed_line, 0, sizeof(parsed_line));
+      TEST_ASSERT_EQUAL_MESSAGE(-1, parse_line(lines[i], &parsed_line), lines[i]);
+      TEST_ASSERT_NULL(parsed_line.next);
+      line_free(&parsed_line);
+   }
+}
+
+void test_parse_line_marks_expansions(void) {
+   char line[] = "echo $? | cat > out.$? ; echo plain";
+   Line parsed_line;
+   memset(&parsed_line, 0, sizeof(parsed_line));
+
+   TEST_ASSERT_EQUAL(0, parse_line(line, &parsed_line));
+   TEST_ASSERT_EQUAL(1, parsed_line.stages[0].expand);
+   TEST_ASSERT_EQUAL(1, parsed_line.stages[1].expand);
+   TEST_ASSERT_EQUAL(0, parsed_line.next->stages[0].expand);
+
+   line_free(&parsed_line);
+}
+
+void test_parse_line_marks_assignments(void) {
+   char lines[][32] = {"x=1 y=$x", "x=1 echo", "echo x=1", "1x=2", "x=1 > f"};
+   const int want[] = {1, 0, 0, 0, 0};
+
+   for (int i = 0; i < 5; i++) {
+      Line parsed_line;
+      memset(&parsed_line, 0, sizeof(parsed_line));
+      TEST_ASSERT_EQUAL(0, parse_line(lines[i], &parsed_line));
+      TEST_ASSERT_EQUAL_MESSAGE(want[i], parsed_line.stages[0].assign, lines[i]);
+      line_free(&parsed_line);
+   }
+}
+
+// ============================================================================
+// Compound Command Tests
+// ============================================================================
+
+void test_parse_for_loop(void) {
+   const char* text = "for i in a $x c ; do echo $i ; done ; echo after";
+   Line parsed_line;
+   memset(&parsed_line, 0, sizeof(parsed_line));
+
+   TEST_ASSERT_EQUAL(0, parse_line(text, &parsed_line));
+
+   const Compound* c = parsed_line.compound;
+   TEST_ASSERT_NOT_NULL(c);
+   TEST_ASSERT_EQUAL(CC_FOR, c->kind);
+   TEST_ASSERT_EQUAL(0, parsed_line.num_stages);
+   TEST_ASSERT_EQUAL_STRING("for i in a $x c ; do echo $i ; done", parsed_line.original);
+   TEST_ASSERT_EQUAL_STRING("i", c->name);
+   TEST_ASSERT_EQUAL_STRING("a", c->words[0]);
+   TEST_ASSERT_EQUAL_STRING("$x", c->words[1]);
+   TEST_ASSERT_EQUAL_STRING("c", c->words[2]);
+   TEST_ASSERT_NULL(c->words[3]);
+   TEST_ASSERT_EQUAL(1, c->expand);
+   TEST_ASSERT_EQUAL_STRING("$i", c->body->stages[0].argv[1]);
+   TEST_ASSERT_NULL(c->body->next);
+   TEST_ASSERT_EQUAL(LIST_SEQ, parsed_line.op);
+   TEST_ASSERT_EQUAL_STRING("echo after", parsed_line.next->original);
+
+   line_free(&parsed_line);
+}
+
+void test_parse_if_and_case(void) {
+   const char* text = "if a ; then b ; elif c \n then d ; else e ; fi ; "
+                      "case $x in a | b) f ;; (*.c) ;; * ) g ; h \n esac";
+   Line parsed_line;
+   memset(&parsed_line, 0, sizeof(parsed_line));
+
+   TEST_ASSERT_EQUAL(0, parse_line(text, &parsed_line));
+
+   const Compound* c = parsed_line.compound;
+   TEST_ASSERT_EQUAL(CC_IF, c->kind);
+   TEST_ASSERT_EQUAL_STRING("a", c->cond->stages[0].argv[0]);
+   TEST_ASSERT_EQUAL_STRING("b", c->body->stages[0].argv[0]);
+   const Compound* elif = c->orelse->compound;
+   TEST_ASSERT_EQUAL(CC_IF, elif->kind);
+   TEST_ASSERT_EQUAL_STRING("c", elif->cond->stages[0].argv[0]);
+   TEST_ASSERT_EQUAL_STRING("e", elif->orelse->stages[0].argv[0]);
+
+   c = parsed_line.next->compound;
+   TEST_ASSERT_EQUAL(CC_CASE, c->kind);
+   TEST_ASSERT_EQUAL_STRING("$x", c->words[0]);
+   const CaseArm* arm = c->arms;
+   TEST_ASSERT_EQUAL_STRING("a", arm->patterns[0]);
+   TEST_ASSERT_EQUAL_STRING("b", arm->patterns[1]);
+   TEST_ASSERT_NULL(arm->patterns[2]);
+   TEST_ASSERT_EQUAL_STRING("f", arm->body->stages[0].argv[0]);
+   arm = arm->next;
+   TEST_ASSERT_EQUAL_STRING("*.c", arm->patterns[0]);
+   TEST_ASSERT_NULL(arm->body);
+   arm = arm->next;
+   TEST_ASSERT_EQUAL_STRING("*", arm->patterns[0]);
+   TEST_ASSERT_EQUAL_STRING("h", arm->body->next->stages[0].argv[0]);
+   TEST_ASSERT_NULL(arm->next);
+
+   line_free(&parsed_line);
+}
+
+void test_parse_function_definitions(void) {
+   const char* texts[] = {"f() { echo $1 ; }", "function f { true ; }", "f () \n { : ; }"};
+
+   for (int i = 0; i < 3; i++) {
+      Line parsed_line;
+      memset(&parsed_line, 0, sizeof(parsed_line));
+      TEST_ASSERT_EQUAL_MESSAGE(0, parse_line(texts[i], &parsed_line), texts[i]);
+      TEST_ASSERT_EQUAL(CC_FUNC, parsed_line.compound->kind);
+      TEST_ASSERT_EQUAL_STRING("f", parsed_line.compound->name);
+      TEST_ASSERT_NOT_NULL(parsed_line.compound->body);
+      TEST_ASSERT_EQUAL_STRING(texts[i], parsed_line.original);
+      line_free(&parsed_line);
+   }
+}
+
+void test_parse_compound_incomplete_and_invalid(void) {
+   const char* incomplete[] = {"while true ; do",
+                               "for i in a b",
+                               "if a ; then b \n elif c ; then",
+                               "case x in a) b ;;",
+                               "f() {",
+                               "{ a &&"};
+   const char* invalid[] = {"done",
+                            "echo a ; fi",
+                            "for 1 in a ; do b ; done",
+                            "if a ; then b ; fi &",
+                            "{ a ; } | cat",
+                            "case x in a) b ;; ;; esac",
+                            "while ; do a ; done"};
+   Line parsed_line;
+   memset(&parsed_line, 0, sizeof(parsed_line));
+
+   for (size_t i = 0; i < sizeof(incomplete) / sizeof(incomplete[0]); i++) {
+      int result = parse_line(incomplete[i], &parsed_line);
+      TEST_ASSERT_EQUAL_MESSAGE(PARSE_INCOMPLETE, result, incomplete[i]);
+   }
+   for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+      TEST_ASSERT_EQUAL_MESSAGE(-1, parse_line(invalid[i], &parsed_line), invalid[i]);
+   }
+   line_free(&parsed_line);
 }
 
 // ============================================================================
@@ -363,9 +636,11 @@ void test_parse_background_simple_command(void) {
    TEST_ASSERT_EQUAL(0, result);
    TEST_ASSERT_EQUAL_STRING("ls -la &", parsed_line.original);
    TEST_ASSERT_EQUAL(0, parsed_line.is_pipeline);
-   TEST_ASSERT_EQUAL_STRING("ls", parsed_line.left.argv[0]);
-   TEST_ASSERT_EQUAL_STRING("-la", parsed_line.left.argv[1]);
-   TEST_ASSERT_EQUAL(1, parsed_line.left.background);
+   TEST_ASSERT_EQUAL_STRING("ls", parsed_line.stages[0].argv[0]);
+   TEST_ASSERT_EQUAL_STRING("-la", parsed_line.stages[0].argv[1]);
+   TEST_ASSERT_EQUAL(1, parsed_line.stages[0].background);
+
+   line_free(&parsed_line);
 }
 
 void test_parse_background_with_redirection(void) {
@@ -378,9 +653,11 @@ void test_parse_background_with_redirection(void) {
    TEST_ASSERT_EQUAL(0, result);
    TEST_ASSERT_EQUAL_STRING("ls > output.txt &", parsed_line.original);
    TEST_ASSERT_EQUAL(0, parsed_line.is_pipeline);
-   TEST_ASSERT_EQUAL_STRING("ls", parsed_line.left.argv[0]);
-   TEST_ASSERT_EQUAL_STRING("output.txt", parsed_line.left.out_file);
-   TEST_ASSERT_EQUAL(1, parsed_line.left.background);
+   TEST_ASSERT_EQUAL_STRING("ls", parsed_line.stages[0].argv[0]);
+   TEST_ASSERT_EQUAL_STRING("output.txt", parsed_line.stages[0].out_file);
+   TEST_ASSERT_EQUAL(1, parsed_line.stages[0].background);
+
+   line_free(&parsed_line);
 }
 
 void test_parse_background_with_pipe_fails(void) {
@@ -391,6 +668,125 @@ void test_parse_background_with_pipe_fails(void) {
    int result = parse_line(line, &parsed_line);
 
    TEST_ASSERT_EQUAL(-1, result);
+
+   line_free(&parsed_line);
+}
+
+// ============================================================================
+// Lexer Tests
+// ============================================================================
+
+/**
+ * @brief Lex a copy of @p text with the lexer in use
+ *
+ * @param text
+ * @param copy Receives the lexed copy (strlen(text) + 1 bytes)
+ * @param offsets Receives where each token starts
+ * @param kinds Receives each token's kind
+ * @return Number of tokens
+ */
+static size_t lex_copy(const char* text, char* copy, size_t* offsets, TokenKind* kinds) {
+   size_t len = strlen(text);
+   memcpy(copy, text, len + 1);
+   char* tokens[256];
+   size_t n = lex_line(copy, len, tokens, kinds);
+   TEST_ASSERT_EQUAL(n, lex_count(text, len));
+   for (size_t i = 0; i < n; i++) {
+      offsets[i] = (size_t)(tokens[i] - copy);
+   }
+   return n;
+}
+
+void test_lex_token_kinds(void) {
+   const char* text = "cat < a > b 2> c |[1M] d | e & 2>x |x << >& 2 ; && || ;; \n &&& |||";
+   const TokenKind want[] = {TK_WORD,
+                             TK_REDIR_IN,
+                             TK_WORD,
+                             TK_REDIR_OUT,
+                             TK_WORD,
+                             TK_REDIR_ERR,
+                             TK_WORD,
+                             TK_PIPE,
+                             TK_WORD,
+                             TK_PIPE,
+                             TK_WORD,
+                             TK_AMP,
+                             TK_WORD,
+                             TK_WORD,
+                             TK_WORD,
+                             TK_WORD,
+                             TK_WORD,
+                             TK_SEMI,
+                             TK_AND,
+                             TK_OR,
+                             TK_DSEMI,
+                             TK_NEWLINE,
+                             TK_WORD,
+                             TK_WORD};
+   char copy[80];
+   size_t offsets[32];
+   TokenKind kinds[32];
+
+   size_t n = lex_copy(text, copy, offsets, kinds);
+
+   TEST_ASSERT_EQUAL(sizeof(want) / sizeof(want[0]), n);
+   for (size_t i = 0; i < n; i++) {
+      TEST_ASSERT_EQUAL_MESSAGE(want[i], kinds[i], copy + offsets[i]);
+   }
+}
+
+void test_lex_backends_agree(void) {
+   // Tokens that straddle the 64-byte blocks of the vector paths, and lines ending on a block
+   const char* fixed[] = {
+       "",
+       " \t ",
+       "x",
+       "ls -la",
+       "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa",
+       "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa",
+       "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa b",
+       "cat < in.txt | grep -v test |[64K] sort -u > out.txt 2> err.txt &",
+       "                                                               | x",
+   };
+   const char alphabet[] = " \t\n<>|&;2[]ab";
+   char text[301];
+   char want_copy[301], got_copy[301];
+   size_t want_offsets[301], got_offsets[301];
+   TokenKind want_kinds[301], got_kinds[301];
+   const LexBackend vector[] = {LEX_SSE2, LEX_AVX2};
+   int tested = 0;
+
+   srand(22);
+   for (int round = 0; round < 2000; round++) {
+      int nfixed = (int)(sizeof(fixed) / sizeof(fixed[0]));
+      if (round < nfixed) {
+         snprintf(text, sizeof(text), "%s", fixed[round]);
+      } else {
+         int len = rand() % 300;
+         for (int i = 0; i < len; i++) {
+            text[i] = alphabet[rand() % (sizeof(alphabet) - 1)];
+         }
+         text[len] = '\0';
+      }
+
+      TEST_ASSERT_EQUAL(0, lex_use(LEX_SCALAR));
+      size_t want = lex_copy(text, want_copy, want_offsets, want_kinds);
+      for (size_t b = 0; b < sizeof(vector) / sizeof(vector[0]); b++) {
+         if (lex_use(vector[b]) == -1) continue;
+         tested = 1;
+         size_t got = lex_copy(text, got_copy, got_offsets, got_kinds);
+         TEST_ASSERT_EQUAL_MESSAGE(want, got, text);
+         TEST_ASSERT_EQUAL_MEMORY_MESSAGE(want_copy, got_copy, strlen(text) + 1, text);
+         for (size_t i = 0; i < want; i++) {
+            TEST_ASSERT_EQUAL_MESSAGE(want_offsets[i], got_offsets[i], text);
+            TEST_ASSERT_EQUAL_MESSAGE(want_kinds[i], got_kinds[i], text);
+         }
+      }
+   }
+
+   // Back to the default choice for the tests that follow
+   if (lex_use(LEX_AVX2) == -1 && lex_use(LEX_SSE2) == -1) lex_use(LEX_SCALAR);
+   if (!tested) TEST_IGNORE_MESSAGE("No vector lexer on this CPU");
 }
 
 // Test functions are called from test_runner.c
@@ -0,0 +1,113 @@
+#include "../../include/pathcache.h"
+#include "unity.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// setUp and tearDown are defined in test_runner.c
+
+// ============================================================================
+// Helpers
+// ============================================================================
+
+/**
+ * @brief Create an executable file dir/name and return its path in out
+ */
+static void make_executable(const char* dir, const char* name, char* out, size_t out_len) {
+   snprintf(out, out_len, "%s/%s", dir, name);
+   FILE* f = fopen(out, "w");
+   TEST_ASSERT_NOT_NULL(f);
+   fputs("#!/bin/sh\n", f);
+   fclose(f);
+   chmod(out, 0755);
+}
+
+// ============================================================================
+// Command Hash Table Tests
+// ============================================================================
+
+void test_pathcache_slash_names_bypass_table(void) {
+   const char* name = "/bin/sh";
+   TEST_ASSERT_EQUAL_PTR(name, pathcache_lookup(name));
+   TEST_ASSERT_EQUAL_STRING("./yash", pathcache_lookup("./yash"));
+}
+
+void test_pathcache_resolves_and_remembers(void) {
+   char dir[] = "/tmp/yash_pathcache_XXXXXX";
+   TEST_ASSERT_NOT_NULL(mkdtemp(dir));
+   char exe[256];
+   make_executable(dir, "yash_test_cmd", exe, sizeof(exe));
+
+   char* saved = getenv("PATH") ? strdup(getenv("PATH")) : NULL;
+   setenv("PATH", dir, 1);
+
+   const char* first = pathcache_lookup("yash_test_cmd");
+   TEST_ASSERT_NOT_NULL(first);
+   TEST_ASSERT_EQUAL_STRING(exe, first);
+   // Second lookup is served from the table (same storage)
+   TEST_ASSERT_EQUAL_PTR(first, pathcache_lookup("yash_test_cmd"));
+
+   unlink(exe);
+   rmdir(dir);
+   if (saved) setenv("PATH", saved, 1);
+   free(saved);
+   pathcache_clear();
+}
+
+void test_pathcache_negative_entry(void) {
+   char dir[] = "/tmp/yash_pathcache_XXXXXX";
+   TEST_ASSERT_NOT_NULL(mkdtemp(dir));
+
+   char* saved = getenv("PATH") ? strdup(getenv("PATH")) : NULL;
+   setenv("PATH", dir, 1);
+
+   TEST_ASSERT_NULL(pathcache_lookup("yash_missing_cmd"));
+
+   // The miss is remembered until the entry is dropped
+   char exe[256];
+   make_executable(dir, "yash_missing_cmd", exe, sizeof(exe));
+   TEST_ASSERT_NULL(pathcache_lookup("yash_missing_cmd"));
+   pathcache_forget("yash_missing_cmd");
+   TEST_ASSERT_EQUAL_STRING(exe, pathcache_lookup("yash_missing_cmd"));
+
+   unlink(exe);
+   rmdir(dir);
+   if (saved) setenv("PATH", saved, 1);
+   free(saved);
+   pathcache_clear();
+}
+
+void test_pathcache_path_change_invalidates(void) {
+   char dir_a[] = "/tmp/yash_pathcache_XXXXXX";
+   char dir_b[] = "/tmp/yash_pathcache_XXXXXX";
+   TEST_ASSERT_NOT_NULL(mkdtemp(dir_a));
+   TEST_ASSERT_NOT_NULL(mkdtemp(dir_b));
+   char exe_a[256], exe_b[256];
+   make_executable(dir_a, "yash_test_cmd", exe_a, sizeof(exe_a));
+   make_executable(dir_b, "yash_test_cmd", exe_b, sizeof(exe_b));
+
+   char* saved = getenv("PATH") ? strdup(getenv("PATH")) : NULL;
+   setenv("PATH", dir_a, 1);
+   TEST_ASSERT_EQUAL_STRING(exe_a, pathcache_lookup("yash_test_cmd"));
+   setenv("PATH", dir_b, 1);
+   TEST_ASSERT_EQUAL_STRING(exe_b, pathcache_lookup("yash_test_cmd"));
+
+   unlink(exe_a);
+   unlink(exe_b);
+   rmdir(dir_a);
+   rmdir(dir_b);
+   if (saved) setenv("PATH", saved, 1);
+   free(saved);
+   pathcache_clear();
+}
+
+void test_pathcache_add_reports_missing(void) {
+   TEST_ASSERT_EQUAL(0, pathcache_add("sh"));
+   TEST_ASSERT_EQUAL(-1, pathcache_add("yash_definitely_missing_cmd"));
+   TEST_ASSERT_EQUAL(-1, pathcache_add("/bin/sh"));
+   pathcache_clear();
+}
+
+// Test functions are called from test_runner.c
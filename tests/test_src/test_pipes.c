@@ -22,19 +22,21 @@ void test_parse_simple_pipe(void) {
    TEST_ASSERT_EQUAL(1, parsed_line.is_pipeline);
 
    // Left command (ls)
-   TEST_ASSERT_EQUAL_STRING("ls", parsed_line.left.argv[0]);
-   TEST_ASSERT_NULL(parsed_line.left.in_file);
-   TEST_ASSERT_NULL(parsed_line.left.out_file);
-   TEST_ASSERT_NULL(parsed_line.left.err_file);
-   TEST_ASSERT_EQUAL(0, parsed_line.left.background);
+   TEST_ASSERT_EQUAL_STRING("ls", parsed_line.stages[0].argv[0]);
+   TEST_ASSERT_NULL(parsed_line.stages[0].in_file);
+   TEST_ASSERT_NULL(parsed_line.stages[0].out_file);
+   TEST_ASSERT_NULL(parsed_line.stages[0].err_file);
+   TEST_ASSERT_EQUAL(0, parsed_line.stages[0].background);
 
    // Right command (grep)
-   TEST_ASSERT_EQUAL_STRING("grep", parsed_line.right.argv[0]);
-   TEST_ASSERT_EQUAL_STRING("test", parsed_line.right.argv[1]);
-   TEST_ASSERT_NULL(parsed_line.right.in_file);
-   TEST_ASSERT_NULL(parsed_line.right.out_file);
-   TEST_ASSERT_NULL(parsed_line.right.err_file);
-   TEST_ASSERT_EQUAL(0, parsed_line.right.background);
+   TEST_ASSERT_EQUAL_STRING("grep", parsed_line.stages[1].argv[0]);
+   TEST_ASSERT_EQUAL_STRING("test", parsed_line.stages[1].argv[1]);
+   TEST_ASSERT_NULL(parsed_line.stages[1].in_file);
+   TEST_ASSERT_NULL(parsed_line.stages[1].out_file);
+   TEST_ASSERT_NULL(parsed_line.stages[1].err_file);
+   TEST_ASSERT_EQUAL(0, parsed_line.stages[1].background);
+
+   line_free(&parsed_line);
 }
 
 void test_parse_pipe_with_arguments(void) {
@@ -49,31 +51,116 @@ void test_parse_pipe_with_arguments(void) {
    TEST_ASSERT_EQUAL(1, parsed_line.is_pipeline);
 
    // Left command (cat)
-   TEST_ASSERT_EQUAL_STRING("cat", parsed_line.left.argv[0]);
-   TEST_ASSERT_EQUAL_STRING("file.txt", parsed_line.left.argv[1]);
-   TEST_ASSERT_NULL(parsed_line.left.in_file);
-   TEST_ASSERT_NULL(parsed_line.left.out_file);
-   TEST_ASSERT_NULL(parsed_line.left.err_file);
-   TEST_ASSERT_EQUAL(0, parsed_line.left.background);
+   TEST_ASSERT_EQUAL_STRING("cat", parsed_line.stages[0].argv[0]);
+   TEST_ASSERT_EQUAL_STRING("file.txt", parsed_line.stages[0].argv[1]);
+   TEST_ASSERT_NULL(parsed_line.stages[0].in_file);
+   TEST_ASSERT_NULL(parsed_line.stages[0].out_file);
+   TEST_ASSERT_NULL(parsed_line.stages[0].err_file);
+   TEST_ASSERT_EQUAL(0, parsed_line.stages[0].background);
 
    // Right command (grep)
-   TEST_ASSERT_EQUAL_STRING("grep", parsed_line.right.argv[0]);
-   TEST_ASSERT_EQUAL_STRING("-i", parsed_line.right.argv[1]);
-   TEST_ASSERT_EQUAL_STRING("pattern", parsed_line.right.argv[2]);
-   TEST_ASSERT_NULL(parsed_line.right.in_file);
-   TEST_ASSERT_NULL(parsed_line.right.out_file);
-   TEST_ASSERT_NULL(parsed_line.right.err_file);
-   TEST_ASSERT_EQUAL(0, parsed_line.right.background);
+   TEST_ASSERT_EQUAL_STRING("grep", parsed_line.stages[1].argv[0]);
+   TEST_ASSERT_EQUAL_STRING("-i", parsed_line.stages[1].argv[1]);
+   TEST_ASSERT_EQUAL_STRING("pattern", parsed_line.stages[1].argv[2]);
+   TEST_ASSERT_NULL(parsed_line.stages[1].in_file);
+   TEST_ASSERT_NULL(parsed_line.stages[1].out_file);
+   TEST_ASSERT_NULL(parsed_line.stages[1].err_file);
+   TEST_ASSERT_EQUAL(0, parsed_line.stages[1].background);
+
+   line_free(&parsed_line);
 }
 
-void test_parse_multi_pipe_rejected(void) {
+void test_parse_multi_pipe(void) {
    char line[] = "cat file.txt | grep -i pattern | wc -l";
    Line parsed_line;
    memset(&parsed_line, 0, sizeof(parsed_line));
 
    int result = parse_line(line, &parsed_line);
 
-   TEST_ASSERT_EQUAL(-1, result);
+   TEST_ASSERT_EQUAL(0, result);
+   TEST_ASSERT_EQUAL(1, parsed_line.is_pipeline);
+   TEST_ASSERT_EQUAL(3, parsed_line.num_stages);
+   TEST_ASSERT_EQUAL_STRING("cat", parsed_line.stages[0].argv[0]);
+   TEST_ASSERT_EQUAL_STRING("file.txt", parsed_line.stages[0].argv[1]);
+   TEST_ASSERT_EQUAL_STRING("grep", parsed_line.stages[1].argv[0]);
+   TEST_ASSERT_EQUAL_STRING("pattern", parsed_line.stages[1].argv[2]);
+   TEST_ASSERT_EQUAL_STRING("wc", parsed_line.stages[2].argv[0]);
+   TEST_ASSERT_EQUAL_STRING("-l", parsed_line.stages[2].argv[1]);
+   TEST_ASSERT_NULL(parsed_line.stages[2].argv[2]);
+
+   line_free(&parsed_line);
+}
+
+void test_parse_sixteen_stage_pipe(void) {
+   // seq feeding 15 cat stages
+   char line[256];
+   int pos = snprintf(line, sizeof(line), "seq 100000");
+   for (int i = 0; i < 15; i++) {
+      pos += snprintf(line + pos, sizeof(line) - pos, " | cat");
+   }
+   Line parsed_line;
+   memset(&parsed_line, 0, sizeof(parsed_line));
+
+   int result = parse_line(line, &parsed_line);
+
+   TEST_ASSERT_EQUAL(0, result);
+   TEST_ASSERT_EQUAL(16, parsed_line.num_stages);
+   TEST_ASSERT_EQUAL_STRING("seq", parsed_line.stages[0].argv[0]);
+   for (int i = 1; i < 16; i++) {
+      TEST_ASSERT_EQUAL_STRING("cat", parsed_line.stages[i].argv[0]);
+      TEST_ASSERT_NULL(parsed_line.stages[i].argv[1]);
+      TEST_ASSERT_EQUAL(0, parsed_line.stages[i].background);
+   }
+
+   line_free(&parsed_line);
+}
+
+void test_parse_pipe_size(void) {
+   char line[] = "cat big.log |[1M] grep error |[64K] wc -l | sort";
+   Line parsed_line;
+   memset(&parsed_line, 0, sizeof(parsed_line));
+
+   int result = parse_line(line, &parsed_line);
+
+   TEST_ASSERT_EQUAL(0, result);
+   TEST_ASSERT_EQUAL(4, parsed_line.num_stages);
+   TEST_ASSERT_EQUAL(1L << 20, parsed_line.stages[0].pipe_size);
+   TEST_ASSERT_EQUAL(64L << 10, parsed_line.stages[1].pipe_size);
+   TEST_ASSERT_EQUAL(0, parsed_line.stages[2].pipe_size);
+   TEST_ASSERT_EQUAL(0, parsed_line.stages[3].pipe_size);
+   TEST_ASSERT_EQUAL_STRING("grep", parsed_line.stages[1].argv[0]);
+   TEST_ASSERT_EQUAL_STRING("error", parsed_line.stages[1].argv[1]);
+   TEST_ASSERT_NULL(parsed_line.stages[1].argv[2]);
+
+   line_free(&parsed_line);
+}
+
+void test_parse_pipe_size_malformed(void) {
+   const char* bad_lines[] = {
+       "cat |[] wc", "cat |[abc] wc", "cat |[1M wc", "cat |[0] wc", "cat |[-4K] wc", "cat |[1M]",
+   };
+   int num_bad = (int)(sizeof(bad_lines) / sizeof(bad_lines[0]));
+
+   for (int i = 0; i < num_bad; i++) {
+      char line[64];
+      snprintf(line, sizeof(line), "%s", bad_lines[i]);
+      Line parsed_line;
+      memset(&parsed_line, 0, sizeof(parsed_line));
+      TEST_ASSERT_EQUAL_MESSAGE(-1, parse_line(line, &parsed_line), bad_lines[i]);
+      line_free(&parsed_line);
+   }
+}
+
+void test_parse_size_suffixes(void) {
+   TEST_ASSERT_EQUAL(4096, parse_size("4096"));
+   TEST_ASSERT_EQUAL(256L << 10, parse_size("256K"));
+   TEST_ASSERT_EQUAL(256L << 10, parse_size("256k"));
+   TEST_ASSERT_EQUAL(1L << 20, parse_size("1M"));
+   TEST_ASSERT_EQUAL(1L << 30, parse_size("1G"));
+   TEST_ASSERT_EQUAL(-1, parse_size(""));
+   TEST_ASSERT_EQUAL(-1, parse_size("M"));
+   TEST_ASSERT_EQUAL(-1, parse_size("12X"));
+   TEST_ASSERT_EQUAL(-1, parse_size("1MB"));
 }
 
 void test_parse_pipe_with_redirections(void) {
@@ -88,19 +175,21 @@ void test_parse_pipe_with_redirections(void) {
    TEST_ASSERT_EQUAL(1, parsed_line.is_pipeline);
 
    // Left command (cat)
-   TEST_ASSERT_EQUAL_STRING("cat", parsed_line.left.argv[0]);
-   TEST_ASSERT_EQUAL_STRING("input.txt", parsed_line.left.in_file);
-   TEST_ASSERT_NULL(parsed_line.left.out_file);
-   TEST_ASSERT_NULL(parsed_line.left.err_file);
-   TEST_ASSERT_EQUAL(0, parsed_line.left.background);
+   TEST_ASSERT_EQUAL_STRING("cat", parsed_line.stages[0].argv[0]);
+   TEST_ASSERT_EQUAL_STRING("input.txt", parsed_line.stages[0].in_file);
+   TEST_ASSERT_NULL(parsed_line.stages[0].out_file);
+   TEST_ASSERT_NULL(parsed_line.stages[0].err_file);
+   TEST_ASSERT_EQUAL(0, parsed_line.stages[0].background);
 
    // Right command (grep)
-   TEST_ASSERT_EQUAL_STRING("grep", parsed_line.right.argv[0]);
-   TEST_ASSERT_EQUAL_STRING("test", parsed_line.right.argv[1]);
-   TEST_ASSERT_NULL(parsed_line.right.in_file);
-   TEST_ASSERT_EQUAL_STRING("output.txt", parsed_line.right.out_file);
-   TEST_ASSERT_NULL(parsed_line.right.err_file);
-   TEST_ASSERT_EQUAL(0, parsed_line.right.background);
+   TEST_ASSERT_EQUAL_STRING("grep", parsed_line.stages[1].argv[0]);
+   TEST_ASSERT_EQUAL_STRING("test", parsed_line.stages[1].argv[1]);
+   TEST_ASSERT_NULL(parsed_line.stages[1].in_file);
+   TEST_ASSERT_EQUAL_STRING("output.txt", parsed_line.stages[1].out_file);
+   TEST_ASSERT_NULL(parsed_line.stages[1].err_file);
+   TEST_ASSERT_EQUAL(0, parsed_line.stages[1].background);
+
+   line_free(&parsed_line);
 }
 
 void test_parse_pipe_both_commands_redirections(void) {
@@ -116,19 +205,21 @@ void test_parse_pipe_both_commands_redirections(void) {
    TEST_ASSERT_EQUAL(1, parsed_line.is_pipeline);
 
    // Left command (cat)
-   TEST_ASSERT_EQUAL_STRING("cat", parsed_line.left.argv[0]);
-   TEST_ASSERT_EQUAL_STRING("input1.txt", parsed_line.left.in_file);
-   TEST_ASSERT_NULL(parsed_line.left.out_file);
-   TEST_ASSERT_NULL(parsed_line.left.err_file);
-   TEST_ASSERT_EQUAL(0, parsed_line.left.background);
+   TEST_ASSERT_EQUAL_STRING("cat", parsed_line.stages[0].argv[0]);
+   TEST_ASSERT_EQUAL_STRING("input1.txt", parsed_line.stages[0].in_file);
+   TEST_ASSERT_NULL(parsed_line.stages[0].out_file);
+   TEST_ASSERT_NULL(parsed_line.stages[0].err_file);
+   TEST_ASSERT_EQUAL(0, parsed_line.stages[0].background);
 
    // Right command (grep)
-   TEST_ASSERT_EQUAL_STRING("grep", parsed_line.right.argv[0]);
-   TEST_ASSERT_EQUAL_STRING("test", parsed_line.right.argv[1]);
-   TEST_ASSERT_EQUAL_STRING("input2.txt", parsed_line.right.in_file);
-   TEST_ASSERT_EQUAL_STRING("output.txt", parsed_line.right.out_file);
-   TEST_ASSERT_EQUAL_STRING("error.txt", parsed_line.right.err_file);
-   TEST_ASSERT_EQUAL(0, parsed_line.right.background);
+   TEST_ASSERT_EQUAL_STRING("grep", parsed_line.stages[1].argv[0]);
+   TEST_ASSERT_EQUAL_STRING("test", parsed_line.stages[1].argv[1]);
+   TEST_ASSERT_EQUAL_STRING("input2.txt", parsed_line.stages[1].in_file);
+   TEST_ASSERT_EQUAL_STRING("output.txt", parsed_line.stages[1].out_file);
+   TEST_ASSERT_EQUAL_STRING("error.txt", parsed_line.stages[1].err_file);
+   TEST_ASSERT_EQUAL(0, parsed_line.stages[1].background);
+
+   line_free(&parsed_line);
 }
 
 // ============================================================================
@@ -144,6 +235,8 @@ void test_parse_pipe_missing_left_command(void) {
 
    // This should fail because there's no command before the pipe
    TEST_ASSERT_EQUAL(-1, result);
+
+   line_free(&parsed_line);
 }
 
 void test_parse_pipe_missing_right_command(void) {
@@ -155,6 +248,8 @@ void test_parse_pipe_missing_right_command(void) {
 
    // This should fail because there's no command after the pipe
    TEST_ASSERT_EQUAL(-1, result);
+
+   line_free(&parsed_line);
 }
 
 void test_parse_pipe_missing_both_commands(void) {
@@ -166,6 +261,8 @@ void test_parse_pipe_missing_both_commands(void) {
 
    // This should fail because there are no commands
    TEST_ASSERT_EQUAL(-1, result);
+
+   line_free(&parsed_line);
 }
 
 void test_parse_pipe_with_background(void) {
@@ -177,6 +274,8 @@ void test_parse_pipe_with_background(void) {
 
    // This should fail because pipes and background execution are mutually exclusive
    TEST_ASSERT_EQUAL(-1, result);
+
+   line_free(&parsed_line);
 }
 
 void test_parse_pipe_background_left_command(void) {
@@ -188,6 +287,8 @@ void test_parse_pipe_background_left_command(void) {
 
    // This should fail because pipes and background execution are mutually exclusive
    TEST_ASSERT_EQUAL(-1, result);
+
+   line_free(&parsed_line);
 }
 
 void test_parse_pipe_background_right_command(void) {
@@ -199,6 +300,8 @@ void test_parse_pipe_background_right_command(void) {
 
    // This should fail because pipes and background execution are mutually exclusive
    TEST_ASSERT_EQUAL(-1, result);
+
+   line_free(&parsed_line);
 }
 
 // ============================================================================
@@ -217,25 +320,27 @@ void test_parse_pipe_complex_left_command(void) {
    TEST_ASSERT_EQUAL(1, parsed_line.is_pipeline);
 
    // Left command (find)
-   TEST_ASSERT_EQUAL_STRING("find", parsed_line.left.argv[0]);
-   TEST_ASSERT_EQUAL_STRING(".", parsed_line.left.argv[1]);
-   TEST_ASSERT_EQUAL_STRING("-name", parsed_line.left.argv[2]);
-   TEST_ASSERT_EQUAL_STRING("'*.c'", parsed_line.left.argv[3]);
-   TEST_ASSERT_EQUAL_STRING("-type", parsed_line.left.argv[4]);
-   TEST_ASSERT_EQUAL_STRING("f", parsed_line.left.argv[5]);
-   TEST_ASSERT_NULL(parsed_line.left.in_file);
-   TEST_ASSERT_NULL(parsed_line.left.out_file);
-   TEST_ASSERT_NULL(parsed_line.left.err_file);
-   TEST_ASSERT_EQUAL(0, parsed_line.left.background);
+   TEST_ASSERT_EQUAL_STRING("find", parsed_line.stages[0].argv[0]);
+   TEST_ASSERT_EQUAL_STRING(".", parsed_line.stages[0].argv[1]);
+   TEST_ASSERT_EQUAL_STRING("-name", parsed_line.stages[0].argv[2]);
+   TEST_ASSERT_EQUAL_STRING("'*.c'", parsed_line.stages[0].argv[3]);
+   TEST_ASSERT_EQUAL_STRING("-type", parsed_line.stages[0].argv[4]);
+   TEST_ASSERT_EQUAL_STRING("f", parsed_line.stages[0].argv[5]);
+   TEST_ASSERT_NULL(parsed_line.stages[0].in_file);
+   TEST_ASSERT_NULL(parsed_line.stages[0].out_file);
+   TEST_ASSERT_NULL(parsed_line.stages[0].err_file);
+   TEST_ASSERT_EQUAL(0, parsed_line.stages[0].background);
 
    // Right command (grep)
-   TEST_ASSERT_EQUAL_STRING("grep", parsed_line.right.argv[0]);
-   TEST_ASSERT_EQUAL_STRING("-v", parsed_line.right.argv[1]);
-   TEST_ASSERT_EQUAL_STRING("test", parsed_line.right.argv[2]);
-   TEST_ASSERT_NULL(parsed_line.right.in_file);
-   TEST_ASSERT_NULL(parsed_line.right.out_file);
-   TEST_ASSERT_NULL(parsed_line.right.err_file);
-   TEST_ASSERT_EQUAL(0, parsed_line.right.background);
+   TEST_ASSERT_EQUAL_STRING("grep", parsed_line.stages[1].argv[0]);
+   TEST_ASSERT_EQUAL_STRING("-v", parsed_line.stages[1].argv[1]);
+   TEST_ASSERT_EQUAL_STRING("test", parsed_line.stages[1].argv[2]);
+   TEST_ASSERT_NULL(parsed_line.stages[1].in_file);
+   TEST_ASSERT_NULL(parsed_line.stages[1].out_file);
+   TEST_ASSERT_NULL(parsed_line.stages[1].err_file);
+   TEST_ASSERT_EQUAL(0, parsed_line.stages[1].background);
+
+   line_free(&parsed_line);
 }
 
 void test_parse_pipe_complex_right_command(void) {
@@ -245,8 +350,14 @@ void test_parse_pipe_complex_right_command(void) {
 
    int result = parse_line(line, &parsed_line);
 
-   // Lab spec says only support one pipe, so multi-pipe should fail
-   TEST_ASSERT_EQUAL(-1, result);
+   TEST_ASSERT_EQUAL(0, result);
+   TEST_ASSERT_EQUAL(4, parsed_line.num_stages);
+   TEST_ASSERT_EQUAL_STRING("grep", parsed_line.stages[1].argv[0]);
+   TEST_ASSERT_EQUAL_STRING("'^[a-z]'", parsed_line.stages[1].argv[2]);
+   TEST_ASSERT_EQUAL_STRING("sort", parsed_line.stages[2].argv[0]);
+   TEST_ASSERT_EQUAL_STRING("uniq", parsed_line.stages[3].argv[0]);
+
+   line_free(&parsed_line);
 }
 
 // ============================================================================
@@ -265,19 +376,21 @@ void test_parse_pipe_input_redirection_left(void) {
    TEST_ASSERT_EQUAL(1, parsed_line.is_pipeline);
 
    // Left command (cat)
-   TEST_ASSERT_EQUAL_STRING("cat", parsed_line.left.argv[0]);
-   TEST_ASSERT_EQUAL_STRING("input.txt", parsed_line.left.in_file);
-   TEST_ASSERT_NULL(parsed_line.left.out_file);
-   TEST_ASSERT_NULL(parsed_line.left.err_file);
-   TEST_ASSERT_EQUAL(0, parsed_line.left.background);
+   TEST_ASSERT_EQUAL_STRING("cat", parsed_line.stages[0].argv[0]);
+   TEST_ASSERT_EQUAL_STRING("input.txt", parsed_line.stages[0].in_file);
+   TEST_ASSERT_NULL(parsed_line.stages[0].out_file);
+   TEST_ASSERT_NULL(parsed_line.stages[0].err_file);
+   TEST_ASSERT_EQUAL(0, parsed_line.stages[0].background);
 
    // Right command (grep)
-   TEST_ASSERT_EQUAL_STRING("grep", parsed_line.right.argv[0]);
-   TEST_ASSERT_EQUAL_STRING("test", parsed_line.right.argv[1]);
-   TEST_ASSERT_NULL(parsed_line.right.in_file);
-   TEST_ASSERT_NULL(parsed_line.right.out_file);
-   TEST_ASSERT_NULL(parsed_line.right.err_file);
-   TEST_ASSERT_EQUAL(0, parsed_line.right.background);
+   TEST_ASSERT_EQUAL_STRING("grep", parsed_line.stages[1].argv[0]);
+   TEST_ASSERT_EQUAL_STRING("test", parsed_line.stages[1].argv[1]);
+   TEST_ASSERT_NULL(parsed_line.stages[1].in_file);
+   TEST_ASSERT_NULL(parsed_line.stages[1].out_file);
+   TEST_ASSERT_NULL(parsed_line.stages[1].err_file);
+   TEST_ASSERT_EQUAL(0, parsed_line.stages[1].background);
+
+   line_free(&parsed_line);
 }
 
 void test_parse_pipe_output_redirection_right(void) {
@@ -292,19 +405,21 @@ void test_parse_pipe_output_redirection_right(void) {
    TEST_ASSERT_EQUAL(1, parsed_line.is_pipeline);
 
    // Left command (ls)
-   TEST_ASSERT_EQUAL_STRING("ls", parsed_line.left.argv[0]);
-   TEST_ASSERT_NULL(parsed_line.left.in_file);
-   TEST_ASSERT_NULL(parsed_line.left.out_file);
-   TEST_ASSERT_NULL(parsed_line.left.err_file);
-   TEST_ASSERT_EQUAL(0, parsed_line.left.background);
+   TEST_ASSERT_EQUAL_STRING("ls", parsed_line.stages[0].argv[0]);
+   TEST_ASSERT_NULL(parsed_line.stages[0].in_file);
+   TEST_ASSERT_NULL(parsed_line.stages[0].out_file);
+   TEST_ASSERT_NULL(parsed_line.stages[0].err_file);
+   TEST_ASSERT_EQUAL(0, parsed_line.stages[0].background);
 
    // Right command (grep)
-   TEST_ASSERT_EQUAL_STRING("grep", parsed_line.right.argv[0]);
-   TEST_ASSERT_EQUAL_STRING("test", parsed_line.right.argv[1]);
-   TEST_ASSERT_NULL(parsed_line.right.in_file);
-   TEST_ASSERT_EQUAL_STRING("output.txt", parsed_line.right.out_file);
-   TEST_ASSERT_NULL(parsed_line.right.err_file);
-   TEST_ASSERT_EQUAL(0, parsed_line.right.background);
+   TEST_ASSERT_EQUAL_STRING("grep", parsed_line.stages[1].argv[0]);
+   TEST_ASSERT_EQUAL_STRING("test", parsed_line.stages[1].argv[1]);
+   TEST_ASSERT_NULL(parsed_line.stages[1].in_file);
+   TEST_ASSERT_EQUAL_STRING("output.txt", parsed_line.stages[1].out_file);
+   TEST_ASSERT_NULL(parsed_line.stages[1].err_file);
+   TEST_ASSERT_EQUAL(0, parsed_line.stages[1].background);
+
+   line_free(&parsed_line);
 }
 
 void test_parse_pipe_error_redirection_right(void) {
@@ -319,19 +434,21 @@ void test_parse_pipe_error_redirection_right(void) {
    TEST_ASSERT_EQUAL(1, parsed_line.is_pipeline);
 
    // Left command (ls)
-   TEST_ASSERT_EQUAL_STRING("ls", parsed_line.left.argv[0]);
-   TEST_ASSERT_NULL(parsed_line.left.in_file);
-   TEST_ASSERT_NULL(parsed_line.left.out_file);
-   TEST_ASSERT_NULL(parsed_line.left.err_file);
-   TEST_ASSERT_EQUAL(0, parsed_line.left.background);
+   TEST_ASSERT_EQUAL_STRING("ls", parsed_line.stages[0].argv[0]);
+   TEST_ASSERT_NULL(parsed_line.stages[0].in_file);
+   TEST_ASSERT_NULL(parsed_line.stages[0].out_file);
+   TEST_ASSERT_NULL(parsed_line.stages[0].err_file);
+   TEST_ASSERT_EQUAL(0, parsed_line.stages[0].background);
 
    // Right command (grep)
-   TEST_ASSERT_EQUAL_STRING("grep", parsed_line.right.argv[0]);
-   TEST_ASSERT_EQUAL_STRING("test", parsed_line.right.argv[1]);
-   TEST_ASSERT_NULL(parsed_line.right.in_file);
-   TEST_ASSERT_NULL(parsed_line.right.out_file);
-   TEST_ASSERT_EQUAL_STRING("error.txt", parsed_line.right.err_file);
-   TEST_ASSERT_EQUAL(0, parsed_line.right.background);
+   TEST_ASSERT_EQUAL_STRING("grep", parsed_line.stages[1].argv[0]);
+   TEST_ASSERT_EQUAL_STRING("test", parsed_line.stages[1].argv[1]);
+   TEST_ASSERT_NULL(parsed_line.stages[1].in_file);
+   TEST_ASSERT_NULL(parsed_line.stages[1].out_file);
+   TEST_ASSERT_EQUAL_STRING("error.txt", parsed_line.stages[1].err_file);
+   TEST_ASSERT_EQUAL(0, parsed_line.stages[1].background);
+
+   line_free(&parsed_line);
 }
 
 void test_parse_pipe_all_redirections(void) {
@@ -347,19 +464,21 @@ void test_parse_pipe_all_redirections(void) {
    TEST_ASSERT_EQUAL(1, parsed_line.is_pipeline);
 
    // Left command (cat)
-   TEST_ASSERT_EQUAL_STRING("cat", parsed_line.left.argv[0]);
-   TEST_ASSERT_EQUAL_STRING("input1.txt", parsed_line.left.in_file);
-   TEST_ASSERT_NULL(parsed_line.left.out_file);
-   TEST_ASSERT_NULL(parsed_line.left.err_file);
-   TEST_ASSERT_EQUAL(0, parsed_line.left.background);
+   TEST_ASSERT_EQUAL_STRING("cat", parsed_line.stages[0].argv[0]);
+   TEST_ASSERT_EQUAL_STRING("input1.txt", parsed_line.stages[0].in_file);
+   TEST_ASSERT_NULL(parsed_line.stages[0].out_file);
+   TEST_ASSERT_NULL(parsed_line.stages[0].err_file);
+   TEST_ASSERT_EQUAL(0, parsed_line.stages[0].background);
 
    // Right command (grep)
-   TEST_ASSERT_EQUAL_STRING("grep", parsed_line.right.argv[0]);
-   TEST_ASSERT_EQUAL_STRING("test", parsed_line.right.argv[1]);
-   TEST_ASSERT_EQUAL_STRING("input2.txt", parsed_line.right.in_file);
-   TEST_ASSERT_EQUAL_STRING("output.txt", parsed_line.right.out_file);
-   TEST_ASSERT_EQUAL_STRING("error.txt", parsed_line.right.err_file);
-   TEST_ASSERT_EQUAL(0, parsed_line.right.background);
+   TEST_ASSERT_EQUAL_STRING("grep", parsed_line.stages[1].argv[0]);
+   TEST_ASSERT_EQUAL_STRING("test", parsed_line.stages[1].argv[1]);
+   TEST_ASSERT_EQUAL_STRING("input2.txt", parsed_line.stages[1].in_file);
+   TEST_ASSERT_EQUAL_STRING("output.txt", parsed_line.stages[1].out_file);
+   TEST_ASSERT_EQUAL_STRING("error.txt", parsed_line.stages[1].err_file);
+   TEST_ASSERT_EQUAL(0, parsed_line.stages[1].background);
+
+   line_free(&parsed_line);
 }
 
 // ============================================================================
@@ -375,11 +494,13 @@ void test_parse_pipe_invalid_characters(void) {
 
    // According to lab spec, arguments with spaces are valid
    TEST_ASSERT_EQUAL(0, result);
-   TEST_ASSERT_EQUAL_STRING("ls", parsed_line.left.argv[0]);
-   TEST_ASSERT_EQUAL_STRING("grep", parsed_line.right.argv[0]);
-   TEST_ASSERT_EQUAL_STRING("test", parsed_line.right.argv[1]);
-   TEST_ASSERT_EQUAL_STRING("with", parsed_line.right.argv[2]);
-   TEST_ASSERT_EQUAL_STRING("spaces", parsed_line.right.argv[3]);
+   TEST_ASSERT_EQUAL_STRING("ls", parsed_line.stages[0].argv[0]);
+   TEST_ASSERT_EQUAL_STRING("grep", parsed_line.stages[1].argv[0]);
+   TEST_ASSERT_EQUAL_STRING("test", parsed_line.stages[1].argv[1]);
+   TEST_ASSERT_EQUAL_STRING("with", parsed_line.stages[1].argv[2]);
+   TEST_ASSERT_EQUAL_STRING("spaces", parsed_line.stages[1].argv[3]);
+
+   line_free(&parsed_line);
 }
 
 void test_parse_pipe_malformed_redirection(void) {
@@ -391,6 +512,8 @@ void test_parse_pipe_malformed_redirection(void) {
 
    // This should fail because of malformed redirection
    TEST_ASSERT_EQUAL(-1, result);
+
+   line_free(&parsed_line);
 }
 
 void test_parse_pipe_duplicate_redirection(void) {
@@ -402,6 +525,8 @@ void test_parse_pipe_duplicate_redirection(void) {
 
    // This should fail because of duplicate output redirection
    TEST_ASSERT_EQUAL(-1, result);
+
+   line_free(&parsed_line);
 }
 
 // ============================================================================
@@ -420,18 +545,20 @@ void test_parse_pipe_empty_arguments(void) {
    TEST_ASSERT_EQUAL(1, parsed_line.is_pipeline);
 
    // Left command (ls)
-   TEST_ASSERT_EQUAL_STRING("ls", parsed_line.left.argv[0]);
-   TEST_ASSERT_NULL(parsed_line.left.in_file);
-   TEST_ASSERT_NULL(parsed_line.left.out_file);
-   TEST_ASSERT_NULL(parsed_line.left.err_file);
-   TEST_ASSERT_EQUAL(0, parsed_line.left.background);
+   TEST_ASSERT_EQUAL_STRING("ls", parsed_line.stages[0].argv[0]);
+   TEST_ASSERT_NULL(parsed_line.stages[0].in_file);
+   TEST_ASSERT_NULL(parsed_line.stages[0].out_file);
+   TEST_ASSERT_NULL(parsed_line.stages[0].err_file);
+   TEST_ASSERT_EQUAL(0, parsed_line.stages[0].background);
 
    // Right command (grep)
-   TEST_ASSERT_EQUAL_STRING("grep", parsed_line.right.argv[0]);
-   TEST_ASSERT_NULL(parsed_line.right.in_file);
-   TEST_ASSERT_NULL(parsed_line.right.out_file);
-   TEST_ASSERT_NULL(parsed_line.right.err_file);
-   TEST_ASSERT_EQUAL(0, parsed_line.right.background);
+   TEST_ASSERT_EQUAL_STRING("grep", parsed_line.stages[1].argv[0]);
+   TEST_ASSERT_NULL(parsed_line.stages[1].in_file);
+   TEST_ASSERT_NULL(parsed_line.stages[1].out_file);
+   TEST_ASSERT_NULL(parsed_line.stages[1].err_file);
+   TEST_ASSERT_EQUAL(0, parsed_line.stages[1].background);
+
+   line_free(&parsed_line);
 }
 
 void test_parse_pipe_single_character_commands(void) {
@@ -446,31 +573,33 @@ void test_parse_pipe_single_character_commands(void) {
    TEST_ASSERT_EQUAL(1, parsed_line.is_pipeline);
 
    // Left command (a)
-   TEST_ASSERT_EQUAL_STRING("a", parsed_line.left.argv[0]);
-   TEST_ASSERT_NULL(parsed_line.left.in_file);
-   TEST_ASSERT_NULL(parsed_line.left.out_file);
-   TEST_ASSERT_NULL(parsed_line.left.err_file);
-   TEST_ASSERT_EQUAL(0, parsed_line.left.background);
+   TEST_ASSERT_EQUAL_STRING("a", parsed_line.stages[0].argv[0]);
+   TEST_ASSERT_NULL(parsed_line.stages[0].in_file);
+   TEST_ASSERT_NULL(parsed_line.stages[0].out_file);
+   TEST_ASSERT_NULL(parsed_line.stages[0].err_file);
+   TEST_ASSERT_EQUAL(0, parsed_line.stages[0].background);
 
    // Right command (b)
-   TEST_ASSERT_EQUAL_STRING("b", parsed_line.right.argv[0]);
-   TEST_ASSERT_NULL(parsed_line.right.in_file);
-   TEST_ASSERT_NULL(parsed_line.right.out_file);
-   TEST_ASSERT_NULL(parsed_line.right.err_file);
-   TEST_ASSERT_EQUAL(0, parsed_line.right.background);
+   TEST_ASSERT_EQUAL_STRING("b", parsed_line.stages[1].argv[0]);
+   TEST_ASSERT_NULL(parsed_line.stages[1].in_file);
+   TEST_ASSERT_NULL(parsed_line.stages[1].out_file);
+   TEST_ASSERT_NULL(parsed_line.stages[1].err_file);
+   TEST_ASSERT_EQUAL(0, parsed_line.stages[1].background);
+
+   line_free(&parsed_line);
 }
 
 void test_parse_pipe_max_arguments(void) {
-   // Create a command with maximum arguments
-   char line[MAX_CMDLINE];
+   // Create a command with the old maximum of 64 arguments on both sides of the pipe
+   char line[1024];
    int pos = 0;
-   pos += snprintf(line + pos, MAX_CMDLINE - pos, "cmd1");
-   for (int i = 0; i < MAX_ARGS - 1; i++) {
-      pos += snprintf(line + pos, MAX_CMDLINE - pos, " arg%d", i);
+   pos += snprintf(line + pos, sizeof(line) - pos, "cmd1");
+   for (int i = 0; i < 64 - 1; i++) {
+      pos += snprintf(line + pos, sizeof(line) - pos, " arg%d", i);
    }
-   pos += snprintf(line + pos, MAX_CMDLINE - pos, " | cmd2");
-   for (int i = 0; i < MAX_ARGS - 1; i++) {
-      pos += snprintf(line + pos, MAX_CMDLINE - pos, " arg%d", i);
+   pos += snprintf(line + pos, sizeof(line) - pos, " | cmd2");
+   for (int i = 0; i < 64 - 1; i++) {
+      pos += snprintf(line + pos, sizeof(line) - pos, " arg%d", i);
    }
 
    Line parsed_line;
@@ -478,8 +607,15 @@ void test_parse_pipe_max_arguments(void) {
 
    int result = parse_line(line, &parsed_line);
 
-   // This should fail because it exceeds MAX_ARGS
-   TEST_ASSERT_EQUAL(-1, result);
+   // Arguments are no longer capped; each stage gets its own
+   TEST_ASSERT_EQUAL(0, result);
+   TEST_ASSERT_EQUAL(2, parsed_line.num_stages);
+   TEST_ASSERT_EQUAL_STRING("arg62", parsed_line.stages[0].argv[63]);
+   TEST_ASSERT_NULL(parsed_line.stages[0].argv[64]);
+   TEST_ASSERT_EQUAL_STRING("cmd2", parsed_line.stages[1].argv[0]);
+   TEST_ASSERT_NULL(parsed_line.stages[1].argv[64]);
+
+   line_free(&parsed_line);
 }
 
 // Test functions are called from test_runner.c
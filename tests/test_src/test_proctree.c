@@ -0,0 +1,88 @@
+#include "../../include/builtins.h"
+#include "../../include/proctree.h"
+#include "unity.h"
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// setUp and tearDown are defined in test_runner.c
+
+// ============================================================================
+// Helpers
+// ============================================================================
+
+/**
+ * @brief Whether @p pid is in the first @p n entries of @p pids
+ */
+static int contains(const pid_t* pids, int n, pid_t pid) {
+   for (int i = 0; i < n; i++) {
+      if (pids[i] == pid) return 1;
+   }
+   return 0;
+}
+
+// ============================================================================
+// Process Tree Tests
+// ============================================================================
+
+void test_proctree_children_of_shell(void) {
+   pid_t a = fork();
+   if (a == 0) pause();
+   pid_t b = fork();
+   if (b == 0) pause();
+
+   pid_t kids[64];
+   int n = proctree_children(getpid(), kids, 64);
+   kill(a, SIGKILL);
+   kill(b, SIGKILL);
+   waitpid(a, NULL, 0);
+   waitpid(b, NULL, 0);
+
+#ifdef __linux__
+   TEST_ASSERT_TRUE(n >= 2);
+   TEST_ASSERT_TRUE(contains(kids, n < 64 ? n : 64, a));
+   TEST_ASSERT_TRUE(contains(kids, n < 64 ? n : 64, b));
+#else
+   TEST_ASSERT_EQUAL(0, n);
+#endif
+}
+
+void test_kill_tree_reaches_detached_grandchild(void) {
+#ifndef __linux__
+   TEST_IGNORE_MESSAGE("process trees need /proc");
+#endif
+   // The grandchild holds the pipe open until it dies
+   int fds[2];
+   TEST_ASSERT_EQUAL(0, pipe(fds));
+   pid_t child = fork();
+   if (child == 0) {
+      if (fork() == 0) {
+         setsid(); // Out of reach of a process group kill
+         pause();
+         _exit(0);
+      }
+      close(fds[0]);
+      close(fds[1]);
+      pause();
+      _exit(0);
+   }
+   close(fds[1]);
+
+   // Give the grandchild time to exist
+   struct pollfd p = {fds[0], POLLIN, 0};
+   poll(&p, 1, 200);
+
+   char pid[16];
+   snprintf(pid, sizeof(pid), "%d", (int)child);
+   char* argv[] = {"kill", "-KILL", "-tree", pid, NULL};
+   TEST_ASSERT_EQUAL(0, builtin_find("kill")->run(argv));
+   waitpid(child, NULL, 0);
+
+   // EOF once every holder of the write end is gone
+   char c;
+   TEST_ASSERT_EQUAL(1, poll(&p, 1, 2000));
+   TEST_ASSERT_EQUAL(0, read(fds[0], &c, 1));
+   close(fds[0]);
+}
@@ -0,0 +1,134 @@
+#include "../../include/jobs.h"
+#include "../../include/options.h"
+#include "../../include/parse.h"
+#include "../../include/queue.h"
+#include "../../include/yash.h"
+#include "unity.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+// setUp and tearDown are defined in test_runner.c
+
+// ============================================================================
+// Helpers
+// ============================================================================
+
+/**
+ * @brief Parse a `submit` line and queue it
+ * @return The entry id
+ */
+static int submit(const char* text) {
+   char buf[256];
+   snprintf(buf, sizeof(buf), "%s", text);
+   Line line;
+   memset(&line, 0, sizeof(line));
+   TEST_ASSERT_EQUAL(0, parse_line(buf, &line));
+   TEST_ASSERT_TRUE(line.submit_at > 0);
+   int id = queue_submit(&line);
+   line_free(&line);
+   TEST_ASSERT_TRUE(id > 0);
+   return id;
+}
+
+/**
+ * @brief Reap and refill the queue until nothing is pending or running, as the main loop would
+ * @param limit Largest number of entries allowed to run at once
+ */
+static void drain(int limit) {
+   struct timespec tick = {0, 10 * 1000 * 1000};
+   for (int i = 0; i < 500 && queue_count(QUEUE_PENDING) + queue_count(QUEUE_RUNNING) > 0; i++) {
+      jobs_collect();
+      queue_schedule();
+      TEST_ASSERT_TRUE(queue_count(QUEUE_RUNNING) <= limit);
+      nanosleep(&tick, NULL);
+   }
+   TEST_ASSERT_EQUAL(0, queue_count(QUEUE_PENDING) + queue_count(QUEUE_RUNNING));
+}
+
+// ============================================================================
+// Tests
+// ============================================================================
+
+void test_parse_submit_prefix(void) {
+   char line[] = "submit -p 5 timeout 2 sleep 1 | cat";
+   Line parsed_line;
+   memset(&parsed_line, 0, sizeof(parsed_line));
+
+   TEST_ASSERT_EQUAL(0, parse_line(line, &parsed_line));
+   const char* queued = parsed_line.original + parsed_line.submit_at;
+   TEST_ASSERT_EQUAL_STRING("timeout 2 sleep 1 | cat", queued);
+   TEST_ASSERT_EQUAL(5, parsed_line.priority);
+   TEST_ASSERT_TRUE(parsed_line.budget.wall == 2);
+   TEST_ASSERT_EQUAL(2, parsed_line.num_stages);
+   TEST_ASSERT_EQUAL_STRING("sleep", parsed_line.stages[0].argv[0]);
+   line_free(&parsed_line);
+
+   // A bad priority leaves an ordinary command named submit (which reports it)
+   char bad[] = "submit -p high ls";
+   TEST_ASSERT_EQUAL(0, parse_line(bad, &parsed_line));
+   TEST_ASSERT_EQUAL(0, parsed_line.submit_at);
+   TEST_ASSERT_EQUAL_STRING("submit", parsed_line.stages[0].argv[0]);
+   line_free(&parsed_line);
+
+   char alone[] = "submit";
+   TEST_ASSERT_EQUAL(0, parse_line(alone, &parsed_line));
+   TEST_ASSERT_EQUAL(0, parsed_line.submit_at);
+   line_free(&parsed_line);
+}
+
+void test_queue_respects_limit_and_priority(void) {
+   jobs_init();
+   TEST_ASSERT_EQUAL(0, options_set("queuelimit=2", 1));
+
+   int first = submit("submit sleep 0.2");
+   int second = submit("submit sleep 0.2");
+   int third = submit("submit sleep 0.2");
+   int urgent = submit("submit -p 9 sleep 0.2");
+   TEST_ASSERT_EQUAL(4, queue_count(QUEUE_PENDING));
+
+   // The highest priority goes first, then submission order
+   TEST_ASSERT_EQUAL(2, queue_schedule());
+   TEST_ASSERT_EQUAL(QUEUE_RUNNING, queue_find(urgent)->state);
+   TEST_ASSERT_EQUAL(QUEUE_RUNNING, queue_find(first)->state);
+   TEST_ASSERT_EQUAL(QUEUE_PENDING, queue_find(second)->state);
+   TEST_ASSERT_EQUAL(2, jobs_count());
+   TEST_ASSERT_EQUAL(0, queue_schedule());
+
+   drain(2);
+   TEST_ASSERT_EQUAL(4, queue_count(QUEUE_FINISHED));
+   const QueueEntry* a = queue_find(first);
+   const QueueEntry* b = queue_find(second);
+   const QueueEntry* c = queue_find(third);
+   TEST_ASSERT_EQUAL(0, b->exit_code);
+   TEST_ASSERT_TRUE(b->started <= c->started);
+   // Nothing else starts until a slot is free
+   TEST_ASSERT_TRUE(b->started >= a->finished || b->started >= queue_find(urgent)->finished);
+   TEST_ASSERT_TRUE(c->finished - c->started >= 0.15);
+
+   TEST_ASSERT_EQUAL(4, queue_clear_finished());
+   TEST_ASSERT_NULL(queue_find(first));
+   TEST_ASSERT_EQUAL(0, options_set("queuelimit", 0));
+   jobs_init();
+}
+
+void test_queue_records_exit_status(void) {
+   jobs_init();
+   TEST_ASSERT_EQUAL(0, options_set("queuelimit=4", 1));
+
+   int fails = submit("submit false");
+   int piped = submit("submit sleep 0.05 | cat");
+   int missing = submit("submit yash_no_such_command_xyz");
+   drain(4);
+
+   TEST_ASSERT_EQUAL(1, queue_find(fails)->exit_code);
+   TEST_ASSERT_EQUAL(0, queue_find(piped)->exit_code);
+   TEST_ASSERT_TRUE(queue_find(piped)->finished - queue_find(piped)->started >= 0.04);
+   TEST_ASSERT_EQUAL(127, queue_find(missing)->exit_code);
+
+   TEST_ASSERT_EQUAL(3, queue_clear_finished());
+   TEST_ASSERT_EQUAL(0, options_set("queuelimit", 0));
+   jobs_init();
+}
+
+// Test functions are called from test_runner.c
@@ -0,0 +1,176 @@
+#include "../../include/launch.h"
+#include "../../include/parse.h"
+#include "../../include/rclass.h"
+#include "unity.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// setUp and tearDown are defined in test_runner.c
+
+// ============================================================================
+// Spec Parsing Tests
+// ============================================================================
+
+void test_rclass_parse_settings(void) {
+   char* words[] = {"nice=10", "io=be:6", "oom=300", "cpus=0-2,5", "nofile=256", "as=64M", NULL};
+   ResourceClass rc;
+   TEST_ASSERT_EQUAL(0, rclass_parse(words, &rc, NULL));
+
+   TEST_ASSERT_EQUAL(RCLASS_NICE | RCLASS_IOPRIO | RCLASS_OOM | RCLASS_CPUS, rc.fields);
+   TEST_ASSERT_EQUAL(10, rc.nice);
+   TEST_ASSERT_EQUAL(2, rc.io_class);
+   TEST_ASSERT_EQUAL(6, rc.io_level);
+   TEST_ASSERT_EQUAL(300, rc.oom_score_adj);
+   TEST_ASSERT_EQUAL_HEX64(0x27, rc.cpus[0]);
+   TEST_ASSERT_EQUAL(2, rc.num_limits);
+   TEST_ASSERT_EQUAL(RLIMIT_NOFILE, rc.limits[0].resource);
+   TEST_ASSERT_TRUE(rc.limits[0].value == 256);
+   TEST_ASSERT_TRUE(rc.limits[1].value == 64 << 20);
+   TEST_ASSERT_EQUAL_STRING("nice=10 io=be:6 oom=300 cpus=0-2,5 nofile=256 as=64M", rc.label);
+
+   // A later word for the same limit replaces the earlier one
+   char* twice[] = {"nofile=10", "nofile=unlimited", NULL};
+   TEST_ASSERT_EQUAL(0, rclass_parse(twice, &rc, NULL));
+   TEST_ASSERT_EQUAL(1, rc.num_limits);
+   TEST_ASSERT_TRUE(rc.limits[0].value == RLIM_INFINITY);
+}
+
+void test_rclass_parse_rejects_bad_words(void) {
+   const char* bad_words[] = {"nice=20",
+                              "nice=x",
+                              "io=fast",
+                              "io=be:8",
+                              "io=idle:3",
+                              "oom=2000",
+                              "cpus=",
+                              "cpus=3-1",
+                              "cpus=1,",
+                              "nofile=-1",
+                              "nofile=4K",
+                              "as=1T",
+                              "colour=red",
+                              "=5"};
+   for (size_t i = 0; i < sizeof(bad_words) / sizeof(bad_words[0]); i++) {
+      char word[32];
+      snprintf(word, sizeof(word), "%s", bad_words[i]);
+      char* words[] = {"nice=1", word, NULL};
+      ResourceClass rc;
+      const char* bad = NULL;
+      TEST_ASSERT_EQUAL_MESSAGE(-1, rclass_parse(words, &rc, &bad), bad_words[i]);
+      TEST_ASSERT_EQUAL_PTR(word, bad);
+   }
+
+   // A leading word without `=` must name a defined class
+   char* unknown[] = {"yash_no_such_class", "nice=1", NULL};
+   ResourceClass rc;
+   const char* bad = NULL;
+   TEST_ASSERT_EQUAL(-1, rclass_parse(unknown, &rc, &bad));
+   TEST_ASSERT_EQUAL_STRING("yash_no_such_class", bad);
+}
+
+void test_rclass_define_and_use(void) {
+   char* batch[] = {"nice=15", "nofile=128", NULL};
+   TEST_ASSERT_EQUAL(0, rclass_define("test_batch", batch, NULL));
+
+   // Words after the name override the class
+   char* words[] = {"test_batch", "nice=5", NULL};
+   ResourceClass rc;
+   TEST_ASSERT_EQUAL(0, rclass_parse(words, &rc, NULL));
+   TEST_ASSERT_EQUAL(5, rc.nice);
+   TEST_ASSERT_EQUAL(1, rc.num_limits);
+   TEST_ASSERT_TRUE(rc.limits[0].value == 128);
+   TEST_ASSERT_EQUAL_STRING("test_batch nice=5", rc.label);
+
+   const char* bad;
+   TEST_ASSERT_EQUAL(-1, rclass_define("bad=name", batch, &bad));
+   TEST_ASSERT_EQUAL_STRING("bad=name", bad);
+}
+
+void test_parse_class_prefix(void) {
+   char buf[] = "time class test_batch nice=3 sleep 1 | cat";
+   Line line;
+   memset(&line, 0, sizeof(line));
+   TEST_ASSERT_EQUAL(0, parse_line(buf, &line));
+   TEST_ASSERT_EQUAL(1, line.timed);
+   TEST_ASSERT_EQUAL_STRING("test_batch", line.rclass[0]);
+   TEST_ASSERT_EQUAL_STRING("nice=3", line.rclass[1]);
+   TEST_ASSERT_NULL(line.rclass[2]);
+   TEST_ASSERT_EQUAL(2, line.num_stages);
+   TEST_ASSERT_EQUAL_STRING("sleep", line.stages[0].argv[0]);
+   line_free(&line);
+
+   // With no command left over, `class` is the builtin itself
+   char define[] = "class -d x nice=1";
+   TEST_ASSERT_EQUAL(0, parse_line(define, &line));
+   TEST_ASSERT_NULL(line.rclass[0]);
+   TEST_ASSERT_EQUAL_STRING("class", line.stages[0].argv[0]);
+   line_free(&line);
+
+   char bare[] = "class nice=1";
+   TEST_ASSERT_EQUAL(0, parse_line(bare, &line));
+   TEST_ASSERT_NULL(line.rclass[0]);
+   line_free(&line);
+}
+
+// ============================================================================
+// Apply Tests
+// ============================================================================
+
+void test_rclass_applied_before_exec(void) {
+   // Lowering limits and raising nice never needs privileges
+   char* words[] = {"nice=12", "nofile=64", "core=0", NULL};
+   ResourceClass rc;
+   TEST_ASSERT_EQUAL(0, rclass_parse(words, &rc, NULL));
+
+   // The child blocks on stdin until its priority has been checked
+   int in[2], out[2];
+   TEST_ASSERT_EQUAL(0, pipe(in));
+   TEST_ASSERT_EQUAL(0, pipe(out));
+   for (int i = 0; i < 2; i++) {
+      // Only the ends moved onto stdin / stdout may reach the child, or it never sees EOF
+      fcntl(in[i], F_SETFD, FD_CLOEXEC);
+      fcntl(out[i], F_SETFD, FD_CLOEXEC);
+   }
+   Command cmd;
+   init_command(&cmd);
+   char* argv[] = {"sh", "-c", "ulimit -n; ulimit -c; read x", NULL};
+   cmd.argv = argv;
+   Redirects fds = {in[0], out[1], -1};
+
+   pid_t pid = launch_command(&cmd, 0, &fds, &rc);
+   close(in[0]);
+   close(out[1]);
+   TEST_ASSERT_TRUE(pid > 0);
+
+   char buf[64] = {0};
+   size_t have = 0;
+   ssize_t n;
+   // Both ulimit lines, i.e. until a second newline shows up
+   while (strchr(buf, '\n') == strrchr(buf, '\n') &&
+          (n = read(out[0], buf + have, sizeof(buf) - 1 - have)) > 0) {
+      have += n;
+   }
+   errno = 0;
+   int prio = getpriority(PRIO_PROCESS, pid);
+   int prio_errno = errno;
+
+   close(in[1]);
+   close(out[0]);
+   int status;
+   waitpid(pid, &status, 0);
+
+   TEST_ASSERT_EQUAL(0, prio_errno);
+   TEST_ASSERT_EQUAL(12, prio);
+   TEST_ASSERT_TRUE(WIFEXITED(status));
+   TEST_ASSERT_EQUAL_STRING("64\n0\n", buf);
+
+   // The shell itself is untouched
+   struct rlimit lim;
+   getrlimit(RLIMIT_NOFILE, &lim);
+   TEST_ASSERT_TRUE(lim.rlim_cur != 64);
+}
@@ -1,8 +1,10 @@
+#include "../../include/launch.h"
 #include "../../include/parse.h"
 #include "../../include/yash.h"
 #include "unity.h"
 #include <fcntl.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
 #include <unistd.h>
@@ -23,11 +25,13 @@ void test_parse_input_redirection(void) {
    TEST_ASSERT_EQUAL(0, result);
    TEST_ASSERT_EQUAL_STRING("cat < input.txt", parsed_line.original);
    TEST_ASSERT_EQUAL(0, parsed_line.is_pipeline);
-   TEST_ASSERT_EQUAL_STRING("cat", parsed_line.left.argv[0]);
-   TEST_ASSERT_EQUAL_STRING("input.txt", parsed_line.left.in_file);
-   TEST_ASSERT_NULL(parsed_line.left.out_file);
-   TEST_ASSERT_NULL(parsed_line.left.err_file);
-   TEST_ASSERT_EQUAL(0, parsed_line.left.background);
+   TEST_ASSERT_EQUAL_STRING("cat", parsed_line.stages[0].argv[0]);
+   TEST_ASSERT_EQUAL_STRING("input.txt", parsed_line.stages[0].in_file);
+   TEST_ASSERT_NULL(parsed_line.stages[0].out_file);
+   TEST_ASSERT_NULL(parsed_line.stages[0].err_file);
+   TEST_ASSERT_EQUAL(0, parsed_line.stages[0].background);
+
+   line_free(&parsed_line);
 }
 
 void test_parse_output_redirection(void) {
@@ -40,11 +44,13 @@ void test_parse_output_redirection(void) {
    TEST_ASSERT_EQUAL(0, result);
    TEST_ASSERT_EQUAL_STRING("ls > output.txt", parsed_line.original);
    TEST_ASSERT_EQUAL(0, parsed_line.is_pipeline);
-   TEST_ASSERT_EQUAL_STRING("ls", parsed_line.left.argv[0]);
-   TEST_ASSERT_NULL(parsed_line.left.in_file);
-   TEST_ASSERT_EQUAL_STRING("output.txt", parsed_line.left.out_file);
-   TEST_ASSERT_NULL(parsed_line.left.err_file);
-   TEST_ASSERT_EQUAL(0, parsed_line.left.background);
+   TEST_ASSERT_EQUAL_STRING("ls", parsed_line.stages[0].argv[0]);
+   TEST_ASSERT_NULL(parsed_line.stages[0].in_file);
+   TEST_ASSERT_EQUAL_STRING("output.txt", parsed_line.stages[0].out_file);
+   TEST_ASSERT_NULL(parsed_line.stages[0].err_file);
+   TEST_ASSERT_EQUAL(0, parsed_line.stages[0].background);
+
+   line_free(&parsed_line);
 }
 
 void test_parse_error_redirection(void) {
@@ -57,11 +63,13 @@ void test_parse_error_redirection(void) {
    TEST_ASSERT_EQUAL(0, result);
    TEST_ASSERT_EQUAL_STRING("ls 2> error.txt", parsed_line.original);
    TEST_ASSERT_EQUAL(0, parsed_line.is_pipeline);
-   TEST_ASSERT_EQUAL_STRING("ls", parsed_line.left.argv[0]);
-   TEST_ASSERT_NULL(parsed_line.left.in_file);
-   TEST_ASSERT_NULL(parsed_line.left.out_file);
-   TEST_ASSERT_EQUAL_STRING("error.txt", parsed_line.left.err_file);
-   TEST_ASSERT_EQUAL(0, parsed_line.left.background);
+   TEST_ASSERT_EQUAL_STRING("ls", parsed_line.stages[0].argv[0]);
+   TEST_ASSERT_NULL(parsed_line.stages[0].in_file);
+   TEST_ASSERT_NULL(parsed_line.stages[0].out_file);
+   TEST_ASSERT_EQUAL_STRING("error.txt", parsed_line.stages[0].err_file);
+   TEST_ASSERT_EQUAL(0, parsed_line.stages[0].background);
+
+   line_free(&parsed_line);
 }
 
 void test_parse_multiple_redirections(void) {
@@ -74,11 +82,13 @@ void test_parse_multiple_redirections(void) {
    TEST_ASSERT_EQUAL(0, result);
    TEST_ASSERT_EQUAL_STRING("cat < input.txt > output.txt 2> error.txt", parsed_line.original);
    TEST_ASSERT_EQUAL(0, parsed_line.is_pipeline);
-   TEST_ASSERT_EQUAL_STRING("cat", parsed_line.left.argv[0]);
-   TEST_ASSERT_EQUAL_STRING("input.txt", parsed_line.left.in_file);
-   TEST_ASSERT_EQUAL_STRING("output.txt", parsed_line.left.out_file);
-   TEST_ASSERT_EQUAL_STRING("error.txt", parsed_line.left.err_file);
-   TEST_ASSERT_EQUAL(0, parsed_line.left.background);
+   TEST_ASSERT_EQUAL_STRING("cat", parsed_line.stages[0].argv[0]);
+   TEST_ASSERT_EQUAL_STRING("input.txt", parsed_line.stages[0].in_file);
+   TEST_ASSERT_EQUAL_STRING("output.txt", parsed_line.stages[0].out_file);
+   TEST_ASSERT_EQUAL_STRING("error.txt", parsed_line.stages[0].err_file);
+   TEST_ASSERT_EQUAL(0, parsed_line.stages[0].background);
+
+   line_free(&parsed_line);
 }
 
 void test_parse_redirection_with_arguments(void) {
@@ -91,13 +101,15 @@ void test_parse_redirection_with_arguments(void) {
    TEST_ASSERT_EQUAL(0, result);
    TEST_ASSERT_EQUAL_STRING("grep -i pattern < input.txt > output.txt", parsed_line.original);
    TEST_ASSERT_EQUAL(0, parsed_line.is_pipeline);
-   TEST_ASSERT_EQUAL_STRING("grep", parsed_line.left.argv[0]);
-   TEST_ASSERT_EQUAL_STRING("-i", parsed_line.left.argv[1]);
-   TEST_ASSERT_EQUAL_STRING("pattern", parsed_line.left.argv[2]);
-   TEST_ASSERT_EQUAL_STRING("input.txt", parsed_line.left.in_file);
-   TEST_ASSERT_EQUAL_STRING("output.txt", parsed_line.left.out_file);
-   TEST_ASSERT_NULL(parsed_line.left.err_file);
-   TEST_ASSERT_EQUAL(0, parsed_line.left.background);
+   TEST_ASSERT_EQUAL_STRING("grep", parsed_line.stages[0].argv[0]);
+   TEST_ASSERT_EQUAL_STRING("-i", parsed_line.stages[0].argv[1]);
+   TEST_ASSERT_EQUAL_STRING("pattern", parsed_line.stages[0].argv[2]);
+   TEST_ASSERT_EQUAL_STRING("input.txt", parsed_line.stages[0].in_file);
+   TEST_ASSERT_EQUAL_STRING("output.txt", parsed_line.stages[0].out_file);
+   TEST_ASSERT_NULL(parsed_line.stages[0].err_file);
+   TEST_ASSERT_EQUAL(0, parsed_line.stages[0].background);
+
+   line_free(&parsed_line);
 }
 
 // ============================================================================
@@ -113,6 +125,8 @@ void test_parse_redirection_missing_filename(void) {
 
    // This should fail because there's no filename after >
    TEST_ASSERT_EQUAL(-1, result);
+
+   line_free(&parsed_line);
 }
 
 void test_parse_redirection_missing_input_file(void) {
@@ -124,6 +138,8 @@ void test_parse_redirection_missing_input_file(void) {
 
    // This should fail because there's no filename after <
    TEST_ASSERT_EQUAL(-1, result);
+
+   line_free(&parsed_line);
 }
 
 void test_parse_redirection_missing_error_file(void) {
@@ -135,6 +151,8 @@ void test_parse_redirection_missing_error_file(void) {
 
    // This should fail because there's no filename after 2>
    TEST_ASSERT_EQUAL(-1, result);
+
+   line_free(&parsed_line);
 }
 
 void test_parse_redirection_invalid_order(void) {
@@ -146,6 +164,8 @@ void test_parse_redirection_invalid_order(void) {
 
    // This should fail because redirection comes before command
    TEST_ASSERT_EQUAL(-1, result);
+
+   line_free(&parsed_line);
 }
 
 void test_parse_redirection_duplicate_output(void) {
@@ -157,6 +177,8 @@ void test_parse_redirection_duplicate_output(void) {
 
    // This should fail because multiple output redirections are not allowed
    TEST_ASSERT_EQUAL(-1, result);
+
+   line_free(&parsed_line);
 }
 
 void test_parse_redirection_duplicate_input(void) {
@@ -168,6 +190,8 @@ void test_parse_redirection_duplicate_input(void) {
 
    // This should fail because multiple input redirections are not allowed
    TEST_ASSERT_EQUAL(-1, result);
+
+   line_free(&parsed_line);
 }
 
 void test_parse_redirection_duplicate_error(void) {
@@ -179,6 +203,8 @@ void test_parse_redirection_duplicate_error(void) {
 
    // This should fail because multiple error redirections are not allowed
    TEST_ASSERT_EQUAL(-1, result);
+
+   line_free(&parsed_line);
 }
 
 // ============================================================================
@@ -195,11 +221,13 @@ void test_parse_redirection_background(void) {
    TEST_ASSERT_EQUAL(0, result);
    TEST_ASSERT_EQUAL_STRING("ls > output.txt &", parsed_line.original);
    TEST_ASSERT_EQUAL(0, parsed_line.is_pipeline);
-   TEST_ASSERT_EQUAL_STRING("ls", parsed_line.left.argv[0]);
-   TEST_ASSERT_NULL(parsed_line.left.in_file);
-   TEST_ASSERT_EQUAL_STRING("output.txt", parsed_line.left.out_file);
-   TEST_ASSERT_NULL(parsed_line.left.err_file);
-   TEST_ASSERT_EQUAL(1, parsed_line.left.background);
+   TEST_ASSERT_EQUAL_STRING("ls", parsed_line.stages[0].argv[0]);
+   TEST_ASSERT_NULL(parsed_line.stages[0].in_file);
+   TEST_ASSERT_EQUAL_STRING("output.txt", parsed_line.stages[0].out_file);
+   TEST_ASSERT_NULL(parsed_line.stages[0].err_file);
+   TEST_ASSERT_EQUAL(1, parsed_line.stages[0].background);
+
+   line_free(&parsed_line);
 }
 
 void test_parse_multiple_redirections_background(void) {
@@ -212,11 +240,13 @@ void test_parse_multiple_redirections_background(void) {
    TEST_ASSERT_EQUAL(0, result);
    TEST_ASSERT_EQUAL_STRING("cat < input.txt > output.txt 2> error.txt &", parsed_line.original);
    TEST_ASSERT_EQUAL(0, parsed_line.is_pipeline);
-   TEST_ASSERT_EQUAL_STRING("cat", parsed_line.left.argv[0]);
-   TEST_ASSERT_EQUAL_STRING("input.txt", parsed_line.left.in_file);
-   TEST_ASSERT_EQUAL_STRING("output.txt", parsed_line.left.out_file);
-   TEST_ASSERT_EQUAL_STRING("error.txt", parsed_line.left.err_file);
-   TEST_ASSERT_EQUAL(1, parsed_line.left.background);
+   TEST_ASSERT_EQUAL_STRING("cat", parsed_line.stages[0].argv[0]);
+   TEST_ASSERT_EQUAL_STRING("input.txt", parsed_line.stages[0].in_file);
+   TEST_ASSERT_EQUAL_STRING("output.txt", parsed_line.stages[0].out_file);
+   TEST_ASSERT_EQUAL_STRING("error.txt", parsed_line.stages[0].err_file);
+   TEST_ASSERT_EQUAL(1, parsed_line.stages[0].background);
+
+   line_free(&parsed_line);
 }
 
 // ============================================================================
@@ -235,19 +265,21 @@ void test_parse_redirection_pipe_with_redirections(void) {
    TEST_ASSERT_EQUAL(1, parsed_line.is_pipeline);
 
    // Left command (cat)
-   TEST_ASSERT_EQUAL_STRING("cat", parsed_line.left.argv[0]);
-   TEST_ASSERT_EQUAL_STRING("input.txt", parsed_line.left.in_file);
-   TEST_ASSERT_NULL(parsed_line.left.out_file);
-   TEST_ASSERT_NULL(parsed_line.left.err_file);
-   TEST_ASSERT_EQUAL(0, parsed_line.left.background);
+   TEST_ASSERT_EQUAL_STRING("cat", parsed_line.stages[0].argv[0]);
+   TEST_ASSERT_EQUAL_STRING("input.txt", parsed_line.stages[0].in_file);
+   TEST_ASSERT_NULL(parsed_line.stages[0].out_file);
+   TEST_ASSERT_NULL(parsed_line.stages[0].err_file);
+   TEST_ASSERT_EQUAL(0, parsed_line.stages[0].background);
 
    // Right command (grep)
-   TEST_ASSERT_EQUAL_STRING("grep", parsed_line.right.argv[0]);
-   TEST_ASSERT_EQUAL_STRING("test", parsed_line.right.argv[1]);
-   TEST_ASSERT_NULL(parsed_line.right.in_file);
-   TEST_ASSERT_EQUAL_STRING("output.txt", parsed_line.right.out_file);
-   TEST_ASSERT_NULL(parsed_line.right.err_file);
-   TEST_ASSERT_EQUAL(0, parsed_line.right.background);
+   TEST_ASSERT_EQUAL_STRING("grep", parsed_line.stages[1].argv[0]);
+   TEST_ASSERT_EQUAL_STRING("test", parsed_line.stages[1].argv[1]);
+   TEST_ASSERT_NULL(parsed_line.stages[1].in_file);
+   TEST_ASSERT_EQUAL_STRING("output.txt", parsed_line.stages[1].out_file);
+   TEST_ASSERT_NULL(parsed_line.stages[1].err_file);
+   TEST_ASSERT_EQUAL(0, parsed_line.stages[1].background);
+
+   line_free(&parsed_line);
 }
 
 void test_parse_redirection_pipe_both_commands_redirections(void) {
@@ -263,19 +295,21 @@ void test_parse_redirection_pipe_both_commands_redirections(void) {
    TEST_ASSERT_EQUAL(1, parsed_line.is_pipeline);
 
    // Left command (cat)
-   TEST_ASSERT_EQUAL_STRING("cat", parsed_line.left.argv[0]);
-   TEST_ASSERT_EQUAL_STRING("input1.txt", parsed_line.left.in_file);
-   TEST_ASSERT_NULL(parsed_line.left.out_file);
-   TEST_ASSERT_NULL(parsed_line.left.err_file);
-   TEST_ASSERT_EQUAL(0, parsed_line.left.background);
+   TEST_ASSERT_EQUAL_STRING("cat", parsed_line.stages[0].argv[0]);
+   TEST_ASSERT_EQUAL_STRING("input1.txt", parsed_line.stages[0].in_file);
+   TEST_ASSERT_NULL(parsed_line.stages[0].out_file);
+   TEST_ASSERT_NULL(parsed_line.stages[0].err_file);
+   TEST_ASSERT_EQUAL(0, parsed_line.stages[0].background);
 
    // Right command (grep)
-   TEST_ASSERT_EQUAL_STRING("grep", parsed_line.right.argv[0]);
-   TEST_ASSERT_EQUAL_STRING("test", parsed_line.right.argv[1]);
-   TEST_ASSERT_EQUAL_STRING("input2.txt", parsed_line.right.in_file);
-   TEST_ASSERT_EQUAL_STRING("output.txt", parsed_line.right.out_file);
-   TEST_ASSERT_EQUAL_STRING("error.txt", parsed_line.right.err_file);
-   TEST_ASSERT_EQUAL(0, parsed_line.right.background);
+   TEST_ASSERT_EQUAL_STRING("grep", parsed_line.stages[1].argv[0]);
+   TEST_ASSERT_EQUAL_STRING("test", parsed_line.stages[1].argv[1]);
+   TEST_ASSERT_EQUAL_STRING("input2.txt", parsed_line.stages[1].in_file);
+   TEST_ASSERT_EQUAL_STRING("output.txt", parsed_line.stages[1].out_file);
+   TEST_ASSERT_EQUAL_STRING("error.txt", parsed_line.stages[1].err_file);
+   TEST_ASSERT_EQUAL(0, parsed_line.stages[1].background);
+
+   line_free(&parsed_line);
 }
 
 // ============================================================================
@@ -294,24 +328,29 @@ void test_parse_redirection_empty_filename(void) {
 
    // This should fail because filename is empty
    TEST_ASSERT_EQUAL(-1, result);
+
+   line_free(&parsed_line);
 }
 
 void test_parse_redirection_filename_too_long(void) {
-   // Create a filename that's too long
-   char long_filename[MAX_TOKEN_LEN + 10];
-   memset(long_filename, 'a', MAX_TOKEN_LEN + 9);
-   long_filename[MAX_TOKEN_LEN + 9] = '\0';
+   // Create a filename longer than the old 30 character token limit
+   char long_filename[40];
+   memset(long_filename, 'a', sizeof(long_filename) - 1);
+   long_filename[sizeof(long_filename) - 1] = '\0';
 
-   char line[MAX_CMDLINE];
-   snprintf(line, MAX_CMDLINE, "ls > %s", long_filename);
+   char line[64];
+   snprintf(line, sizeof(line), "ls > %s", long_filename);
 
    Line parsed_line;
    memset(&parsed_line, 0, sizeof(parsed_line));
 
    int result = parse_line(line, &parsed_line);
 
-   // This should fail because filename is too long
-   TEST_ASSERT_EQUAL(-1, result);
+   // Filenames are only bounded by the line length now
+   TEST_ASSERT_EQUAL(0, result);
+   TEST_ASSERT_EQUAL_STRING(long_filename, parsed_line.stages[0].out_file);
+
+   line_free(&parsed_line);
 }
 
 // ============================================================================
@@ -328,9 +367,11 @@ void test_parse_redirection_special_characters(void) {
    TEST_ASSERT_EQUAL(0, result);
    TEST_ASSERT_EQUAL_STRING("ls > output-123_456.txt", parsed_line.original);
    TEST_ASSERT_EQUAL(0, parsed_line.is_pipeline);
-   TEST_ASSERT_EQUAL_STRING("ls", parsed_line.left.argv[0]);
-   TEST_ASSERT_EQUAL_STRING("output-123_456.txt", parsed_line.left.out_file);
-   TEST_ASSERT_EQUAL(0, parsed_line.left.background);
+   TEST_ASSERT_EQUAL_STRING("ls", parsed_line.stages[0].argv[0]);
+   TEST_ASSERT_EQUAL_STRING("output-123_456.txt", parsed_line.stages[0].out_file);
+   TEST_ASSERT_EQUAL(0, parsed_line.stages[0].background);
+
+   line_free(&parsed_line);
 }
 
 // Removed test_parse_redirection_quoted_filename - quotes not supported per project spec
@@ -345,9 +386,11 @@ void test_parse_redirection_absolute_path(void) {
    TEST_ASSERT_EQUAL(0, result);
    TEST_ASSERT_EQUAL_STRING("ls > /tmp/output.txt", parsed_line.original);
    TEST_ASSERT_EQUAL(0, parsed_line.is_pipeline);
-   TEST_ASSERT_EQUAL_STRING("ls", parsed_line.left.argv[0]);
-   TEST_ASSERT_EQUAL_STRING("/tmp/output.txt", parsed_line.left.out_file);
-   TEST_ASSERT_EQUAL(0, parsed_line.left.background);
+   TEST_ASSERT_EQUAL_STRING("ls", parsed_line.stages[0].argv[0]);
+   TEST_ASSERT_EQUAL_STRING("/tmp/output.txt", parsed_line.stages[0].out_file);
+   TEST_ASSERT_EQUAL(0, parsed_line.stages[0].background);
+
+   line_free(&parsed_line);
 }
 
 void test_parse_redirection_relative_path(void) {
@@ -360,9 +403,11 @@ void test_parse_redirection_relative_path(void) {
    TEST_ASSERT_EQUAL(0, result);
    TEST_ASSERT_EQUAL_STRING("ls > ./output.txt", parsed_line.original);
    TEST_ASSERT_EQUAL(0, parsed_line.is_pipeline);
-   TEST_ASSERT_EQUAL_STRING("ls", parsed_line.left.argv[0]);
-   TEST_ASSERT_EQUAL_STRING("./output.txt", parsed_line.left.out_file);
-   TEST_ASSERT_EQUAL(0, parsed_line.left.background);
+   TEST_ASSERT_EQUAL_STRING("ls", parsed_line.stages[0].argv[0]);
+   TEST_ASSERT_EQUAL_STRING("./output.txt", parsed_line.stages[0].out_file);
+   TEST_ASSERT_EQUAL(0, parsed_line.stages[0].background);
+
+   line_free(&parsed_line);
 }
 
 // ============================================================================
@@ -378,6 +423,8 @@ void test_parse_redirection_malformed_input(void) {
 
    // This should fail because of malformed redirection
    TEST_ASSERT_EQUAL(-1, result);
+
+   line_free(&parsed_line);
 }
 
 void test_parse_redirection_malformed_error(void) {
@@ -389,6 +436,8 @@ void test_parse_redirection_malformed_error(void) {
 
    // This should fail because of malformed redirection
    TEST_ASSERT_EQUAL(-1, result);
+
+   line_free(&parsed_line);
 }
 
 void test_parse_redirection_mixed_redirections(void) {
@@ -401,11 +450,77 @@ void test_parse_redirection_mixed_redirections(void) {
    TEST_ASSERT_EQUAL(0, result);
    TEST_ASSERT_EQUAL_STRING("ls > output.txt 2> error.txt < input.txt", parsed_line.original);
    TEST_ASSERT_EQUAL(0, parsed_line.is_pipeline);
-   TEST_ASSERT_EQUAL_STRING("ls", parsed_line.left.argv[0]);
-   TEST_ASSERT_EQUAL_STRING("input.txt", parsed_line.left.in_file);
-   TEST_ASSERT_EQUAL_STRING("output.txt", parsed_line.left.out_file);
-   TEST_ASSERT_EQUAL_STRING("error.txt", parsed_line.left.err_file);
-   TEST_ASSERT_EQUAL(0, parsed_line.left.background);
+   TEST_ASSERT_EQUAL_STRING("ls", parsed_line.stages[0].argv[0]);
+   TEST_ASSERT_EQUAL_STRING("input.txt", parsed_line.stages[0].in_file);
+   TEST_ASSERT_EQUAL_STRING("output.txt", parsed_line.stages[0].out_file);
+   TEST_ASSERT_EQUAL_STRING("error.txt", parsed_line.stages[0].err_file);
+   TEST_ASSERT_EQUAL(0, parsed_line.stages[0].background);
+
+   line_free(&parsed_line);
+}
+
+// ============================================================================
+// Redirection Plan Tests
+// ============================================================================
+
+void test_redirects_open_all_targets(void) {
+   char dir[] = "/tmp/yash_redirect_XXXXXX";
+   TEST_ASSERT_NOT_NULL(mkdtemp(dir));
+   char in[64], out[64], err[64];
+   snprintf(in, sizeof(in), "%s/in", dir);
+   snprintf(out, sizeof(out), "%s/out", dir);
+   snprintf(err, sizeof(err), "%s/err", dir);
+   close(open(in, O_WRONLY | O_CREAT, 0644));
+
+   Command cmd;
+   memset(&cmd, 0, sizeof(cmd));
+   cmd.in_file = in;
+   cmd.out_file = out;
+   cmd.err_file = err;
+
+   Redirects fds;
+   TEST_ASSERT_EQUAL(0, redirects_open(&cmd, &fds, NULL));
+   TEST_ASSERT_TRUE(fds.in_fd >= 0);
+   TEST_ASSERT_TRUE(fds.out_fd >= 0);
+   TEST_ASSERT_TRUE(fds.err_fd >= 0);
+   // Nothing the shell opens may leak into the command it launches
+   TEST_ASSERT_TRUE(fcntl(fds.in_fd, F_GETFD) & FD_CLOEXEC);
+   TEST_ASSERT_TRUE(fcntl(fds.out_fd, F_GETFD) & FD_CLOEXEC);
+   TEST_ASSERT_TRUE(fcntl(fds.err_fd, F_GETFD) & FD_CLOEXEC);
+
+   redirects_close(&fds);
+   TEST_ASSERT_EQUAL(-1, fds.in_fd);
+   TEST_ASSERT_EQUAL(-1, fds.out_fd);
+   TEST_ASSERT_EQUAL(-1, fds.err_fd);
+
+   unlink(in);
+   unlink(out);
+   unlink(err);
+   rmdir(dir);
+}
+
+void test_redirects_open_reports_failed_target(void) {
+   char dir[] = "/tmp/yash_redirect_XXXXXX";
+   TEST_ASSERT_NOT_NULL(mkdtemp(dir));
+   char out[64], missing[64];
+   snprintf(out, sizeof(out), "%s/out", dir);
+   snprintf(missing, sizeof(missing), "%s/no/such/file", dir);
+
+   Command cmd;
+   memset(&cmd, 0, sizeof(cmd));
+   cmd.out_file = out;
+   cmd.err_file = missing;
+
+   Redirects fds;
+   const char* failed = NULL;
+   TEST_ASSERT_EQUAL(-1, redirects_open(&cmd, &fds, &failed));
+   TEST_ASSERT_EQUAL_PTR(missing, failed);
+   // The target opened before the failure is closed again
+   TEST_ASSERT_EQUAL(-1, fds.out_fd);
+   TEST_ASSERT_EQUAL(-1, fds.err_fd);
+
+   unlink(out);
+   rmdir(dir);
 }
 
 // Test functions are called from test_runner.c
@@ -24,9 +24,22 @@ extern void test_tokenize_null_parameters(void);
 extern void test_tokenize_complex_command(void);
 extern void test_parse_line_simple_command(void);
 extern void test_parse_line_too_long(void);
+extern void test_parse_line_many_args(void);
+extern void test_parse_line_reuses_arena(void);
 extern void test_parse_line_empty(void);
 extern void test_parse_line_whitespace_only(void);
 extern void test_parse_background_with_pipe_fails(void);
+extern void test_lex_token_kinds(void);
+extern void test_lex_backends_agree(void);
+extern void test_parse_line_list(void);
+extern void test_parse_line_list_prefixes_per_element(void);
+extern void test_parse_line_list_invalid(void);
+extern void test_parse_line_marks_expansions(void);
+extern void test_parse_line_marks_assignments(void);
+extern void test_parse_for_loop(void);
+extern void test_parse_if_and_case(void);
+extern void test_parse_function_definitions(void);
+extern void test_parse_compound_incomplete_and_invalid(void);
 
 // External test functions from test_redirection.c
 extern void test_parse_input_redirection(void);
@@ -53,11 +66,17 @@ extern void test_parse_redirection_relative_path(void);
 extern void test_parse_redirection_malformed_input(void);
 extern void test_parse_redirection_malformed_error(void);
 extern void test_parse_redirection_mixed_redirections(void);
+extern void test_redirects_open_all_targets(void);
+extern void test_redirects_open_reports_failed_target(void);
 
 // External test functions from test_pipes.c
 extern void test_parse_simple_pipe(void);
 extern void test_parse_pipe_with_arguments(void);
-extern void test_parse_multi_pipe_rejected(void);
+extern void test_parse_multi_pipe(void);
+extern void test_parse_sixteen_stage_pipe(void);
+extern void test_parse_pipe_size(void);
+extern void test_parse_pipe_size_malformed(void);
+extern void test_parse_size_suffixes(void);
 extern void test_parse_redirection_pipe_with_redirections(void);
 extern void test_parse_redirection_pipe_both_commands_redirections(void);
 extern void test_parse_pipe_missing_left_command(void);
@@ -106,6 +125,17 @@ extern void test_parse_background_empty_arguments(void);
 extern void test_parse_background_complex_command(void);
 extern void test_parse_jobs_background_with_all_redirections(void);
 extern void test_parse_background_with_long_command(void);
+extern void test_parse_time_keyword(void);
+extern void test_parse_timeout_prefix(void);
+extern void test_parse_duration(void);
+extern void test_jobs_budget_kills_overrunning_job(void);
+extern void test_jobs_budget_foreground_status(void);
+extern void test_jobs_usage_merge(void);
+extern void test_jobs_wait_collects_usage(void);
+extern void test_jobs_table_grows(void);
+extern void test_jobs_ids_follow_highest_live_job(void);
+extern void test_jobs_process_event_tracks_every_stage(void);
+extern void test_jobs_adopt_orphaned_grandchild(void);
 
 // External test functions from test_signals.c
 extern void test_signal_constants_defined(void);
@@ -151,7 +181,6 @@ extern void test_parse_performance_simple(void);
 extern void test_parse_integration_edge_cases(void);
 
 // External test functions from test_integration.c
-// Removed complex pipeline extern declaration
 extern void test_parse_jobs_background_with_all_redirections(void);
 extern void test_parse_pipe_with_mixed_redirections(void);
 extern void test_parse_job_control_commands(void);
@@ -164,6 +193,89 @@ extern void test_parse_recovery_from_errors(void);
 extern void test_parse_performance_integration(void);
 extern void test_parse_feature_combinations(void);
 
+// External test functions from test_pathcache.c
+extern void test_pathcache_slash_names_bypass_table(void);
+extern void test_pathcache_resolves_and_remembers(void);
+extern void test_pathcache_negative_entry(void);
+extern void test_pathcache_path_change_invalidates(void);
+extern void test_pathcache_add_reports_missing(void);
+
+// External test functions from test_fdcopy.c
+extern void test_fdcopy_file_to_file(void);
+extern void test_fdcopy_file_to_pipe_and_back(void);
+extern void test_fdcopy_cancelled(void);
+extern void test_builtin_cat_eligible(void);
+extern void test_builtin_cat_concatenates(void);
+extern void test_builtin_cat_interrupted(void);
+
+// External test functions from test_builtins.c
+extern void test_builtin_table_is_perfect(void);
+extern void test_builtin_find_known_names(void);
+extern void test_builtin_true_false(void);
+extern void test_builtin_test_expressions(void);
+extern void test_builtin_echo_output(void);
+extern void test_builtin_printf_output(void);
+extern void test_builtin_cd_and_pwd(void);
+extern void test_builtin_wait_returns_job_status(void);
+extern void test_builtin_fg_returns_job_status(void);
+extern void test_builtin_wait_next_and_timeout(void);
+
+// External test functions from test_rclass.c
+extern void test_rclass_parse_settings(void);
+extern void test_rclass_parse_rejects_bad_words(void);
+extern void test_rclass_define_and_use(void);
+extern void test_parse_class_prefix(void);
+extern void test_rclass_applied_before_exec(void);
+
+// External test functions from test_events.c
+extern void test_events_child_exit_wakes_wait(void);
+extern void test_events_regular_file_input_is_ready(void);
+extern void test_events_timer_wakes_wait(void);
+
+// External test functions from test_parallel.c
+extern void test_fanout_bounds_concurrency(void);
+extern void test_parallel_keeps_input_order(void);
+extern void test_parallel_substitutes_and_counts_failures(void);
+extern void test_xargs_batches_past_arg_max(void);
+extern void test_xargs_quotes_and_limits(void);
+
+// External test functions from test_queue.c
+extern void test_parse_submit_prefix(void);
+extern void test_queue_respects_limit_and_priority(void);
+extern void test_queue_records_exit_status(void);
+
+// External test functions from test_admit.c
+extern void test_admit_threshold_options(void);
+extern void test_admit_holds_background_job_until_pressure_drops(void);
+
+// External test functions from test_dag.c
+extern void test_dag_runs_independent_tasks_in_parallel(void);
+extern void test_dag_failure_cancels_downstream_tasks(void);
+extern void test_dag_rejects_bad_task_files(void);
+
+// External test functions from test_arena.c
+extern void test_arena_alloc_aligns_and_grows(void);
+extern void test_arena_reset_keeps_one_block(void);
+
+// External test functions from test_vars.c
+extern void test_vars_expand_status(void);
+extern void test_vars_set_and_expand(void);
+extern void test_vars_positional_parameters(void);
+extern void test_execute_list_short_circuits(void);
+extern void test_execute_loops(void);
+extern void test_execute_loop_interrupted(void);
+extern void test_execute_if_and_case(void);
+extern void test_execute_functions(void);
+
+// External test functions from test_linecache.c
+extern void test_linecache_hit_reuses_parsed_line(void);
+extern void test_linecache_evicts_least_recently_used(void);
+extern void test_linecache_invalidated_by_function_change(void);
+
+// External test functions from test_proctree.c
+extern void test_proctree_children_of_shell(void);
+extern void test_kill_tree_reaches_detached_grandchild(void);
+
 // External test functions from test_yash.c
 extern void test_command_initialization(void);
 extern void test_line_initialization(void);
@@ -190,9 +302,22 @@ int main(void) {
    RUN_TEST(test_tokenize_whitespace_only);
    RUN_TEST(test_parse_line_simple_command);
    RUN_TEST(test_parse_line_too_long);
+   RUN_TEST(test_parse_line_many_args);
+   RUN_TEST(test_parse_line_reuses_arena);
    RUN_TEST(test_parse_line_empty);
    RUN_TEST(test_parse_line_whitespace_only);
    RUN_TEST(test_parse_background_with_pipe_fails);
+   RUN_TEST(test_lex_token_kinds);
+   RUN_TEST(test_lex_backends_agree);
+   RUN_TEST(test_parse_line_list);
+   RUN_TEST(test_parse_line_list_prefixes_per_element);
+   RUN_TEST(test_parse_line_list_invalid);
+   RUN_TEST(test_parse_line_marks_expansions);
+   RUN_TEST(test_parse_line_marks_assignments);
+   RUN_TEST(test_parse_for_loop);
+   RUN_TEST(test_parse_if_and_case);
+   RUN_TEST(test_parse_function_definitions);
+   RUN_TEST(test_parse_compound_incomplete_and_invalid);
 
    // ============================================================================
    // Redirection Tests
@@ -225,6 +350,8 @@ int main(void) {
    RUN_TEST(test_parse_redirection_malformed_input);
    RUN_TEST(test_parse_redirection_malformed_error);
    RUN_TEST(test_parse_redirection_mixed_redirections);
+   RUN_TEST(test_redirects_open_all_targets);
+   RUN_TEST(test_redirects_open_reports_failed_target);
 
    // ============================================================================
    // Pipe Tests
@@ -233,7 +360,11 @@ int main(void) {
    RUN_TEST(test_tokenize_pipe_with_redirections);
    RUN_TEST(test_parse_simple_pipe);
    RUN_TEST(test_parse_pipe_with_arguments);
-   RUN_TEST(test_parse_multi_pipe_rejected);
+   RUN_TEST(test_parse_multi_pipe);
+   RUN_TEST(test_parse_sixteen_stage_pipe);
+   RUN_TEST(test_parse_pipe_size);
+   RUN_TEST(test_parse_pipe_size_malformed);
+   RUN_TEST(test_parse_size_suffixes);
    RUN_TEST(test_parse_redirection_pipe_with_redirections);
    RUN_TEST(test_parse_redirection_pipe_both_commands_redirections);
    RUN_TEST(test_parse_pipe_missing_left_command);
@@ -286,6 +417,17 @@ int main(void) {
    RUN_TEST(test_parse_background_complex_command);
    RUN_TEST(test_parse_jobs_background_with_all_redirections);
    RUN_TEST(test_parse_background_with_long_command);
+   RUN_TEST(test_parse_time_keyword);
+   RUN_TEST(test_parse_timeout_prefix);
+   RUN_TEST(test_parse_duration);
+   RUN_TEST(test_jobs_budget_kills_overrunning_job);
+   RUN_TEST(test_jobs_budget_foreground_status);
+   RUN_TEST(test_jobs_usage_merge);
+   RUN_TEST(test_jobs_wait_collects_usage);
+   RUN_TEST(test_jobs_table_grows);
+   RUN_TEST(test_jobs_ids_follow_highest_live_job);
+   RUN_TEST(test_jobs_process_event_tracks_every_stage);
+   RUN_TEST(test_jobs_adopt_orphaned_grandchild);
 
    // ============================================================================
    // Signal Tests
@@ -337,7 +479,6 @@ int main(void) {
    // ============================================================================
    // Integration Tests
    // ============================================================================
-   // Removed complex pipeline test - multi-pipe commands not supported per project spec
    RUN_TEST(test_parse_jobs_background_with_all_redirections);
    RUN_TEST(test_parse_pipe_with_mixed_redirections);
    RUN_TEST(test_parse_job_control_commands);
@@ -350,6 +491,115 @@ int main(void) {
    RUN_TEST(test_parse_performance_integration);
    RUN_TEST(test_parse_feature_combinations);
 
+   // ============================================================================
+   // Command Hash Table Tests
+   // ============================================================================
+   RUN_TEST(test_pathcache_slash_names_bypass_table);
+   RUN_TEST(test_pathcache_resolves_and_remembers);
+   RUN_TEST(test_pathcache_negative_entry);
+   RUN_TEST(test_pathcache_path_change_invalidates);
+   RUN_TEST(test_pathcache_add_reports_missing);
+
+   // ============================================================================
+   // Copy Engine and Builtin cat Tests
+   // ============================================================================
+   RUN_TEST(test_fdcopy_file_to_file);
+   RUN_TEST(test_fdcopy_file_to_pipe_and_back);
+   RUN_TEST(test_fdcopy_cancelled);
+   RUN_TEST(test_builtin_cat_eligible);
+   RUN_TEST(test_builtin_cat_concatenates);
+   RUN_TEST(test_builtin_cat_interrupted);
+
+   // ============================================================================
+   // Builtin Registry Tests
+   // ============================================================================
+   RUN_TEST(test_builtin_table_is_perfect);
+   RUN_TEST(test_builtin_find_known_names);
+   RUN_TEST(test_builtin_true_false);
+   RUN_TEST(test_builtin_test_expressions);
+   RUN_TEST(test_builtin_echo_output);
+   RUN_TEST(test_builtin_printf_output);
+   RUN_TEST(test_builtin_cd_and_pwd);
+   RUN_TEST(test_builtin_wait_returns_job_status);
+   RUN_TEST(test_builtin_fg_returns_job_status);
+   RUN_TEST(test_builtin_wait_next_and_timeout);
+
+   // ============================================================================
+   // Resource Class Tests
+   // ============================================================================
+   RUN_TEST(test_rclass_parse_settings);
+   RUN_TEST(test_rclass_parse_rejects_bad_words);
+   RUN_TEST(test_rclass_define_and_use);
+   RUN_TEST(test_parse_class_prefix);
+   RUN_TEST(test_rclass_applied_before_exec);
+
+   // ============================================================================
+   // Event Loop Tests
+   // ============================================================================
+   RUN_TEST(test_events_child_exit_wakes_wait);
+   RUN_TEST(test_events_regular_file_input_is_ready);
+   RUN_TEST(test_events_timer_wakes_wait);
+
+   // ============================================================================
+   // Fan-out Tests
+   // ============================================================================
+   RUN_TEST(test_fanout_bounds_concurrency);
+   RUN_TEST(test_parallel_keeps_input_order);
+   RUN_TEST(test_parallel_substitutes_and_counts_failures);
+   RUN_TEST(test_xargs_batches_past_arg_max);
+   RUN_TEST(test_xargs_quotes_and_limits);
+
+   // ============================================================================
+   // Batch Queue Tests
+   // ============================================================================
+   RUN_TEST(test_parse_submit_prefix);
+   RUN_TEST(test_queue_respects_limit_and_priority);
+   RUN_TEST(test_queue_records_exit_status);
+
+   // ============================================================================
+   // Admission Control Tests
+   // ============================================================================
+   RUN_TEST(test_admit_threshold_options);
+   RUN_TEST(test_admit_holds_background_job_until_pressure_drops);
+
+   // ============================================================================
+   // Dependency Graph Tests
+   // ============================================================================
+   RUN_TEST(test_dag_runs_independent_tasks_in_parallel);
+   RUN_TEST(test_dag_failure_cancels_downstream_tasks);
+   RUN_TEST(test_dag_rejects_bad_task_files);
+
+   // ============================================================================
+   // Arena Tests
+   // ============================================================================
+   RUN_TEST(test_arena_alloc_aligns_and_grows);
+   RUN_TEST(test_arena_reset_keeps_one_block);
+
+   // ============================================================================
+   // Command List and Parameter Tests
+   // ============================================================================
+   RUN_TEST(test_vars_expand_status);
+   RUN_TEST(test_vars_set_and_expand);
+   RUN_TEST(test_vars_positional_parameters);
+   RUN_TEST(test_execute_list_short_circuits);
+   RUN_TEST(test_execute_loops);
+   RUN_TEST(test_execute_loop_interrupted);
+   RUN_TEST(test_execute_if_and_case);
+   RUN_TEST(test_execute_functions);
+
+   // ============================================================================
+   // Parsed-Line Cache Tests
+   // ============================================================================
+   RUN_TEST(test_linecache_hit_reuses_parsed_line);
+   RUN_TEST(test_linecache_evicts_least_recently_used);
+   RUN_TEST(test_linecache_invalidated_by_function_change);
+
+   // ============================================================================
+   // Process Tree Tests
+   // ============================================================================
+   RUN_TEST(test_proctree_children_of_shell);
+   RUN_TEST(test_kill_tree_reaches_detached_grandchild);
+
    // ============================================================================
    // Core Data Structure Tests
    // ============================================================================
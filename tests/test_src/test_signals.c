@@ -278,13 +278,15 @@ void test_signal_integration_with_parsing(void) {
    int result = parse_line(line, &parsed_line);
 
    TEST_ASSERT_EQUAL(0, result);
-   TEST_ASSERT_EQUAL_STRING("sleep", parsed_line.left.argv[0]);
-   TEST_ASSERT_EQUAL_STRING("5", parsed_line.left.argv[1]);
+   TEST_ASSERT_EQUAL_STRING("sleep", parsed_line.stages[0].argv[0]);
+   TEST_ASSERT_EQUAL_STRING("5", parsed_line.stages[0].argv[1]);
 
    // Test that we can set up signal handling for this command
    signal(SIGINT, SIG_DFL);
    signal(SIGTSTP, SIG_DFL);
    TEST_ASSERT_TRUE(1);
+
+   line_free(&parsed_line);
 }
 
 void test_signal_integration_with_background(void) {
@@ -296,13 +298,15 @@ void test_signal_integration_with_background(void) {
    int result = parse_line(line, &parsed_line);
 
    TEST_ASSERT_EQUAL(0, result);
-   TEST_ASSERT_EQUAL_STRING("sleep", parsed_line.left.argv[0]);
-   TEST_ASSERT_EQUAL_STRING("5", parsed_line.left.argv[1]);
-   TEST_ASSERT_EQUAL(1, parsed_line.left.background);
+   TEST_ASSERT_EQUAL_STRING("sleep", parsed_line.stages[0].argv[0]);
+   TEST_ASSERT_EQUAL_STRING("5", parsed_line.stages[0].argv[1]);
+   TEST_ASSERT_EQUAL(1, parsed_line.stages[0].background);
 
    // Test that we can set up signal handling for background processes
    signal(SIGCHLD, SIG_DFL);
    TEST_ASSERT_TRUE(1);
+
+   line_free(&parsed_line);
 }
 
 void test_signal_integration_with_pipes(void) {
@@ -315,15 +319,17 @@ void test_signal_integration_with_pipes(void) {
 
    TEST_ASSERT_EQUAL(0, result);
    TEST_ASSERT_EQUAL(1, parsed_line.is_pipeline);
-   TEST_ASSERT_EQUAL_STRING("ls", parsed_line.left.argv[0]);
-   TEST_ASSERT_EQUAL_STRING("grep", parsed_line.right.argv[0]);
-   TEST_ASSERT_EQUAL_STRING("test", parsed_line.right.argv[1]);
+   TEST_ASSERT_EQUAL_STRING("ls", parsed_line.stages[0].argv[0]);
+   TEST_ASSERT_EQUAL_STRING("grep", parsed_line.stages[1].argv[0]);
+   TEST_ASSERT_EQUAL_STRING("test", parsed_line.stages[1].argv[1]);
 
    // Test that we can set up signal handling for pipelines
    signal(SIGINT, SIG_DFL);
    signal(SIGTSTP, SIG_DFL);
    signal(SIGCHLD, SIG_DFL);
    TEST_ASSERT_TRUE(1);
+
+   line_free(&parsed_line);
 }
 
 // ============================================================================
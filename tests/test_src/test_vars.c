@@ -0,0 +1,261 @@
+#include "../../include/exec.h"
+#include "../../include/parse.h"
+#include "../../include/signals.h"
+#include "../../include/vars.h"
+#include "../../include/yash.h"
+#include "unity.h"
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+// setUp and tearDown are defined in test_runner.c
+
+// ============================================================================
+// Helpers
+// ============================================================================
+
+/**
+ * @brief Parse and run one line as the main loop would
+ */
+static void run_line(const char* text) {
+   char buf[256];
+   snprintf(buf, sizeof(buf), "%s", text);
+   Line line;
+   memset(&line, 0, sizeof(line));
+   TEST_ASSERT_EQUAL(0, parse_line(buf, &line));
+   TEST_ASSERT_EQUAL(0, execute_line(&line));
+   line_free(&line);
+}
+
+/**
+ * @brief First line of a file, "" if it does not exist
+ */
+static const char* read_file(const char* path) {
+   static char buf[64];
+   buf[0] = '\0';
+   FILE* f = fopen(path, "r");
+   if (!f) return buf;
+   if (!fgets(buf, sizeof(buf), f)) buf[0] = '\0';
+   fclose(f);
+   return buf;
+}
+
+// ============================================================================
+// Tests
+// ============================================================================
+
+void test_vars_expand_status(void) {
+   Arena arena = {0};
+   char plain[] = "plain";
+   char word[] = "x$?y$?";
+
+   vars_set_status(300);
+   TEST_ASSERT_EQUAL(44, vars_status());
+
+   // Nothing to expand: the word itself comes back
+   TEST_ASSERT_EQUAL_PTR(plain, vars_expand(plain, &arena));
+
+   vars_set_status(127);
+   char* expanded = vars_expand(word, &arena);
+   TEST_ASSERT_EQUAL_STRING("x127y127", expanded);
+   TEST_ASSERT_EQUAL_STRING("x$?y$?", word);
+
+   vars_set_status(0);
+   arena_free(&arena);
+}
+
+void test_vars_set_and_expand(void) {
+   Arena arena = {0};
+   char word[] = "<$yash_v>${yash_v}x$yash_vx$-$";
+   char list[] = "$yash_w";
+   char* words[] = {"a", list, "b$yash_none", "$yash_none", NULL};
+
+   TEST_ASSERT_EQUAL(0, vars_set("yash_v", "1"));
+   TEST_ASSERT_EQUAL_STRING("<1>1x$-$", vars_expand(word, &arena));
+   TEST_ASSERT_NULL(getenv("yash_v"));
+
+   // Expanded words split at blanks; one that expands to nothing is dropped
+   TEST_ASSERT_EQUAL(0, vars_set("yash_w", " p \t q "));
+   char** out = vars_expand_words(words, &arena);
+   const char* want[] = {"a", "p", "q", "b"};
+   for (int i = 0; i < 4; i++) {
+      TEST_ASSERT_EQUAL_STRING(want[i], out[i]);
+   }
+   TEST_ASSERT_NULL(out[4]);
+   TEST_ASSERT_EQUAL_PTR(words[0], out[0]);
+
+   // An exported variable lives in the environment from then on
+   TEST_ASSERT_EQUAL(0, vars_export("yash_v", NULL));
+   TEST_ASSERT_EQUAL_STRING("1", getenv("yash_v"));
+   TEST_ASSERT_EQUAL(0, vars_set("yash_v", "2"));
+   TEST_ASSERT_EQUAL_STRING("2", getenv("yash_v"));
+   vars_unset("yash_v");
+   vars_unset("yash_w");
+   TEST_ASSERT_NULL(vars_get("yash_v"));
+   TEST_ASSERT_NULL(getenv("yash_v"));
+   TEST_ASSERT_NULL(vars_get("yash_w"));
+
+   arena_free(&arena);
+}
+
+void test_vars_positional_parameters(void) {
+   Arena arena = {0};
+   char* const args[] = {"f", "one", "two", NULL};
+   char word[] = "$0:$#:$1:$2:$3:$@";
+
+   char* const* saved = vars_set_args(args);
+   TEST_ASSERT_EQUAL_STRING("f:2:one:two::one two", vars_expand(word, &arena));
+   vars_set_args(saved);
+   TEST_ASSERT_EQUAL_STRING("yash:0::::", vars_expand(word, &arena));
+
+   arena_free(&arena);
+}
+
+void test_execute_list_short_circuits(void) {
+   unlink("/tmp/yash_list_a");
+   unlink("/tmp/yash_list_b");
+   unlink("/tmp/yash_list_c");
+
+   // `&&` skips on failure, `||` runs, and the skipped element leaves $? alone
+   run_line("false && echo skipped > /tmp/yash_list_a || echo $? > /tmp/yash_list_b");
+   TEST_ASSERT_NULL(fopen("/tmp/yash_list_a", "r"));
+   TEST_ASSERT_EQUAL_STRING("1\n", read_file("/tmp/yash_list_b"));
+
+   // `;` always goes on; a command that is not found exits with 127
+   run_line("yash_no_such_command ; echo $? > /tmp/yash_list_c ; true");
+   TEST_ASSERT_EQUAL_STRING("127\n", read_file("/tmp/yash_list_c"));
+   TEST_ASSERT_EQUAL(0, vars_status());
+
+   // A pipeline's status is its last stage's
+   run_line("true || echo skipped > /tmp/yash_list_a ; false | true");
+   TEST_ASSERT_NULL(fopen("/tmp/yash_list_a", "r"));
+   TEST_ASSERT_EQUAL(0, vars_status());
+   run_line("true | false");
+   TEST_ASSERT_EQUAL(1, vars_status());
+
+   unlink("/tmp/yash_list_b");
+   unlink("/tmp/yash_list_c");
+   vars_set_status(0);
+}
+
+void test_execute_loops(void) {
+   // Nested loops run their parsed bodies over and over; continue 2 skips to the outer loop
+   run_line("s= ; for i in 1 2 3 ; do for j in a b c ; do "
+            "if test $j = b ; then continue 2 ; fi ; s=$s$i$j ; done ; done");
+   TEST_ASSERT_EQUAL_STRING("1a2a3a", vars_get("s"));
+
+   run_line("n= ; while true ; do n=$n. ; case $n in ...) break ;; esac ; done");
+   TEST_ASSERT_EQUAL_STRING("...", vars_get("n"));
+   TEST_ASSERT_EQUAL(0, vars_status());
+
+   run_line("until test $n = .... ; do n=$n. ; done ; for i in $yash_none ; do n=x ; done");
+   TEST_ASSERT_EQUAL_STRING("....", vars_get("n"));
+   TEST_ASSERT_EQUAL(0, vars_status());
+
+   // `break` outside a loop is an error that stops nothing else
+   run_line("break ; r=$?");
+   TEST_ASSERT_EQUAL_STRING("1", vars_get("r"));
+
+   // A status of 130 is not a Ctrl-C: the loop and the list go on
+   run_line("yash_f() { return 130 ; } ; n= ; for i in 1 2 3 ; do yash_f ; n=$n$i ; done ; r=$?");
+   TEST_ASSERT_EQUAL_STRING("123", vars_get("n"));
+   TEST_ASSERT_EQUAL_STRING("0", vars_get("r"));
+
+   // A command that SIGINT killed stops both
+   FILE* f = fopen("/tmp/yash_sigint.sh", "w");
+   TEST_ASSERT_NOT_NULL(f);
+   fputs("kill -INT $$\n", f);
+   fclose(f);
+   vars_unset("r");
+   run_line("n= ; for i in 1 2 3 ; do n=$n$i ; sh /tmp/yash_sigint.sh ; done ; r=x");
+   TEST_ASSERT_EQUAL_STRING("1", vars_get("n"));
+   TEST_ASSERT_NULL(vars_get("r"));
+   TEST_ASSERT_EQUAL(128 + SIGINT, vars_status());
+   unlink("/tmp/yash_sigint.sh");
+
+   vars_unset("s");
+   vars_unset("n");
+   vars_unset("r");
+   vars_set_status(0);
+}
+
+void test_execute_loop_interrupted(void) {
+   struct sigaction sa, saved;
+   memset(&sa, 0, sizeof(sa));
+   sa.sa_handler = sigint_handler;
+   sigemptyset(&sa.sa_mask);
+   sigaction(SIGINT, &sa, &saved);
+
+   // Ctrl-C while the loop only runs builtins
+   pid_t killer = fork();
+   if (killer == 0) {
+      struct timespec delay = {0, 100000000L};
+      nanosleep(&delay, NULL);
+      kill(getppid(), SIGINT);
+      _exit(0);
+   }
+   run_line("while true ; do true ; done");
+   waitpid(killer, NULL, 0);
+   sigaction(SIGINT, &saved, NULL);
+
+   TEST_ASSERT_EQUAL(128 + SIGINT, vars_status());
+   shell_interrupted = 0;
+   vars_set_status(0);
+}
+
+void test_execute_if_and_case(void) {
+   run_line("if false ; then r=a ; elif true ; then r=b ; else r=c ; fi");
+   TEST_ASSERT_EQUAL_STRING("b", vars_get("r"));
+
+   // No branch taken: the status is 0, not the condition's
+   run_line("if false ; then r=a ; fi");
+   TEST_ASSERT_EQUAL(0, vars_status());
+
+   run_line("x=main.c ; case $x in *.h) r=h ;; *.c | *.cc) r=c ;; *) r=other ;; esac");
+   TEST_ASSERT_EQUAL_STRING("c", vars_get("r"));
+
+   vars_unset("r");
+   vars_unset("x");
+   vars_set_status(0);
+}
+
+void test_execute_functions(void) {
+   // The definition only defines; each call runs the body parsed when it was defined
+   run_line("yash_f() { r=$2$1$# ; return 4 ; r=late ; }");
+   TEST_ASSERT_NULL(vars_get("r"));
+   run_line("yash_f a b");
+   TEST_ASSERT_EQUAL_STRING("ba2", vars_get("r"));
+   TEST_ASSERT_EQUAL(4, vars_status());
+
+   // `$@` splits into one loop word per argument
+   run_line("function yash_g { r= ; for w in $@ ; do r=$r$w, ; done ; } ; yash_g 1 2 3");
+   TEST_ASSERT_EQUAL_STRING("1,2,3,", vars_get("r"));
+
+   // Redefining while running keeps the running body
+   run_line("yash_g() { yash_g() { r=new ; } ; r=old ; } ; yash_g");
+   TEST_ASSERT_EQUAL_STRING("old", vars_get("r"));
+   run_line("yash_g");
+   TEST_ASSERT_EQUAL_STRING("new", vars_get("r"));
+
+   // A function named cat feeding a pipeline runs instead of the shell's own copy
+   FILE* f = fopen("/tmp/yash_cat_in", "w");
+   TEST_ASSERT_NOT_NULL(f);
+   fputs("not the function\n", f);
+   fclose(f);
+   run_line("cat() { echo func ; } ; cat /tmp/yash_cat_in | wc -c > /tmp/yash_cat_out");
+   TEST_ASSERT_EQUAL_STRING("5\n", read_file("/tmp/yash_cat_out"));
+   unlink("/tmp/yash_cat_in");
+   unlink("/tmp/yash_cat_out");
+
+   run_line("unset -f yash_f yash_g cat ; yash_f");
+   TEST_ASSERT_EQUAL(127, vars_status());
+
+   vars_unset("r");
+   vars_set_status(0);
+}
+
+// Test functions are called from test_runner.c
@@ -1,5 +1,7 @@
+#include "../../include/parse.h"
 #include "../../include/yash.h"
 #include "unity.h"
+#include <limits.h>
 #include <string.h>
 
 // setUp and tearDown are defined in test_runner.c
@@ -9,7 +11,7 @@ void test_command_initialization(void) {
    memset(&cmd, 0, sizeof(cmd));
 
    // Test that command is properly initialized
-   TEST_ASSERT_NULL(cmd.argv[0]);
+   TEST_ASSERT_NULL(cmd.argv);
    TEST_ASSERT_NULL(cmd.in_file);
    TEST_ASSERT_NULL(cmd.out_file);
    TEST_ASSERT_NULL(cmd.err_file);
@@ -22,7 +24,8 @@ void test_line_initialization(void) {
 
    // Test that line is properly initialized
    TEST_ASSERT_EQUAL(0, line.is_pipeline);
-   TEST_ASSERT_EQUAL_STRING("", line.original);
+   TEST_ASSERT_NULL(line.original);
+   TEST_ASSERT_NULL(line.arena.head);
 }
 
 void test_token_kind_enum_values(void) {
@@ -33,15 +36,18 @@ void test_token_kind_enum_values(void) {
    TEST_ASSERT_EQUAL(3, TK_REDIR_ERR);
    TEST_ASSERT_EQUAL(4, TK_PIPE);
    TEST_ASSERT_EQUAL(5, TK_AMP);
+   TEST_ASSERT_EQUAL(6, TK_SEMI);
+   TEST_ASSERT_EQUAL(7, TK_AND);
+   TEST_ASSERT_EQUAL(8, TK_OR);
+   TEST_ASSERT_EQUAL(9, TK_NEWLINE);
+   TEST_ASSERT_EQUAL(10, TK_DSEMI);
 }
 
 void test_constants_values(void) {
    // Test that constants have expected values
-   TEST_ASSERT_EQUAL(2001, MAX_CMDLINE);
-   TEST_ASSERT_EQUAL(2000, MAX_TOKENS);
-   TEST_ASSERT_EQUAL(30, MAX_TOKEN_LEN);
-   TEST_ASSERT_EQUAL(64, MAX_ARGS);
-   TEST_ASSERT_EQUAL(20, MAX_JOBS);
+   TEST_ASSERT_EQUAL(16, RCLASS_MAX_WORDS);
+   // Lines are bounded by the system's ARG_MAX only
+   TEST_ASSERT_TRUE(parse_line_max() >= _POSIX_ARG_MAX);
 }
 
 // Test functions are called from test_runner.c